@@ -242,6 +242,7 @@ PlayRecorder::PlayRecorder() {
   take_screenshot = false;
   basedir = "./";
   f_takeScreenshot = nullptr;
+  exit_on_finish = true;
 }
 
 PlayRecorder * PlayRecorder::instance = NULL;
@@ -485,7 +486,9 @@ int PlayRecorder::proc(u32 framecount) {
 #endif
 
       printf("Test is finished\n");
-      exit(0);
+      if (exit_on_finish) {
+        exit(0);
+      }
       return -1; // Finish
     }
 
@@ -601,4 +604,9 @@ extern "C" {
     p->startPlay(dir,false, init);
   }
 
+  void PlayRecorder_setExitOnFinish( int enable ) {
+    PlayRecorder * p = PlayRecorder::getInstance();
+    p->setExitOnFinish(enable != 0);
+  }
+
 }
\ No newline at end of file
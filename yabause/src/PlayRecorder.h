@@ -60,6 +60,9 @@ private:
   string basedir;
 
   int screenshot_per_frame = 60*10;
+
+  // quit the process when the recording runs out
+  bool exit_on_finish;
   
 public:
   enum eStatus {
@@ -91,6 +94,8 @@ public:
 
   void setBaseDir( const char * dir){ basedir = dir; }
 
+  void setExitOnFinish(bool enable) { exit_on_finish = enable; }
+
 private: 
   eStatus mode_;  
 
@@ -2321,6 +2321,8 @@ void renderLoop()
 
             sprintf(last_state_filename, "%s/%s_%ld.yss", s_savepath, cdip->itemnum, t);
             ret = YabSaveCompressedState(last_state_filename);
+            if (ret == 0)
+                ret = YabSaveCompressedStateWait(); // the caller reads the file once signalled
 
             pthread_mutex_lock(&g_mtxFuncSync);
             pthread_cond_signal(&g_cndFuncSync);
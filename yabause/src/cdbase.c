@@ -54,9 +54,13 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 #include "cdbase.h"
 #include "error.h"
 #include "debug.h"
+#include "threads.h"
+#include "trace.h"
 
 static int LoadCHD(const char *chd_filename, FILE *iso_file);
 static int ISOCDReadSectorFADFromCHD(u32 FAD, void *buffer);
+static void CHDReadAheadFAD(u32 FAD);
+static void CHDFree(void);
 static int LoadBinCueMultiFile(const char *cuefilename, FILE *iso_file);
 static int LoadBinCue(const char *cuefilename, FILE *iso_file);
 int checkCHD(const char *filename );
@@ -1632,6 +1636,240 @@ void BuildTOC()
 #if (defined(IOS) || defined(ANDROID))
 #define stricmp strcasecmp
 #endif
+//////////////////////////////////////////////////////////////////////////////
+// Memory mapped image access
+//
+// Every image file is mapped read only once at ISOCDInit and a FAD -> track
+// table is built, so reading a sector is a table lookup plus memcpy instead
+// of a session/track search followed by fseek/fread.
+//////////////////////////////////////////////////////////////////////////////
+
+#if !defined(NX) && !defined(_WIN32) && !defined(_WINDOWS) && defined(__GNUC__)
+#define ISO_USE_MMAP 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define ISO_MAX_MAPS 100
+
+typedef struct
+{
+   FILE *fp;
+   const u8 *base;
+   size_t size;
+} iso_map_struct;
+
+track_info_struct *currentTrack = NULL;
+
+static iso_map_struct iso_maps[ISO_MAX_MAPS];
+static int iso_num_maps = 0;
+
+static const u8 **iso_track_map;     // per flattened track, NULL if not mapped
+static track_info_struct **iso_lut_tracks;
+static u8 *iso_fad_lut;              // FAD - iso_lut_base -> track index, 0xFF none
+static u32 iso_lut_base;
+static u32 iso_lut_count;
+
+static const u8 *ISOMapFile(FILE *fp)
+{
+#ifdef ISO_USE_MMAP
+   struct stat sb;
+   void *p;
+   int i;
+
+   for (i = 0; i < iso_num_maps; i++)
+   {
+      if (iso_maps[i].fp == fp)
+         return iso_maps[i].base;
+   }
+
+   if (iso_num_maps >= ISO_MAX_MAPS)
+      return NULL;
+
+   if (fstat(fileno(fp), &sb) != 0 || sb.st_size == 0)
+      return NULL;
+
+   p = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+   if (p == MAP_FAILED)
+   {
+      CDLOG("ISOMapFile: mmap failed, using stdio\n");
+      return NULL;
+   }
+#ifdef MADV_SEQUENTIAL
+   madvise(p, (size_t)sb.st_size, MADV_SEQUENTIAL);
+#endif
+
+   iso_maps[iso_num_maps].fp = fp;
+   iso_maps[iso_num_maps].base = (const u8 *)p;
+   iso_maps[iso_num_maps].size = (size_t)sb.st_size;
+   iso_num_maps++;
+   return (const u8 *)p;
+#else
+   return NULL;
+#endif
+}
+
+static size_t ISOMapSize(const u8 *base)
+{
+   int i;
+   for (i = 0; i < iso_num_maps; i++)
+   {
+      if (iso_maps[i].base == base)
+         return iso_maps[i].size;
+   }
+   return 0;
+}
+
+static void ISOUnmapAll(void)
+{
+#ifdef ISO_USE_MMAP
+   int i;
+   for (i = 0; i < iso_num_maps; i++)
+      munmap((void *)iso_maps[i].base, iso_maps[i].size);
+#endif
+   iso_num_maps = 0;
+   free(iso_track_map);
+   free(iso_lut_tracks);
+   free(iso_fad_lut);
+   iso_track_map = NULL;
+   iso_lut_tracks = NULL;
+   iso_fad_lut = NULL;
+   iso_lut_count = 0;
+}
+
+static void ISOBuildSectorMap(void)
+{
+   u32 fad_min = 0xFFFFFFFF, fad_max = 0;
+   int i, j, n = 0, total = 0;
+
+   ISOUnmapAll();
+
+   for (i = 0; i < disc.session_num; i++)
+      total += disc.session[i].track_num;
+
+   // Track indices are stored in a byte
+   if (total == 0 || total >= 0xFF)
+      return;
+
+   iso_track_map = (const u8 **)calloc(total, sizeof(u8 *));
+   iso_lut_tracks = (track_info_struct **)calloc(total, sizeof(track_info_struct *));
+   if (iso_track_map == NULL || iso_lut_tracks == NULL)
+   {
+      ISOUnmapAll();
+      return;
+   }
+
+   for (i = 0; i < disc.session_num; i++)
+   {
+      for (j = 0; j < disc.session[i].track_num; j++)
+      {
+         track_info_struct *track = &disc.session[i].track[j];
+         iso_lut_tracks[n] = track;
+         if (track->fp != NULL)
+            iso_track_map[n] = ISOMapFile(track->fp);
+         if (track->fad_start < fad_min) fad_min = track->fad_start;
+         if (track->fad_end > fad_max) fad_max = track->fad_end;
+         n++;
+      }
+   }
+
+   if (fad_max < fad_min)
+      return;
+
+   iso_lut_base = fad_min;
+   iso_lut_count = fad_max - fad_min + 1;
+   if ((iso_fad_lut = (u8 *)malloc(iso_lut_count)) == NULL)
+   {
+      iso_lut_count = 0;
+      return;
+   }
+   memset(iso_fad_lut, 0xFF, iso_lut_count);
+
+   // Same precedence as the linear search: the first track containing a FAD wins
+   for (i = n - 1; i >= 0; i--)
+   {
+      track_info_struct *track = iso_lut_tracks[i];
+      if (track->fad_end >= track->fad_start)
+         memset(iso_fad_lut + (track->fad_start - iso_lut_base), i, track->fad_end - track->fad_start + 1);
+   }
+}
+
+// Returns 1 when the sector was served from a mapping, 0 to fall back to stdio
+static int ISOReadMappedSector(u32 FAD, void *buffer)
+{
+   const u8 *base, *src;
+   track_info_struct *track;
+   size_t size, offset;
+   u8 idx;
+
+   if (FAD < iso_lut_base || FAD - iso_lut_base >= iso_lut_count)
+      return 0;
+
+   idx = iso_fad_lut[FAD - iso_lut_base];
+   if (idx == 0xFF || (base = iso_track_map[idx]) == NULL)
+      return 0;
+
+   track = iso_lut_tracks[idx];
+   size = ISOMapSize(base);
+   offset = (size_t)track->file_offset + (size_t)(FAD - track->fad_start) * track->sector_size;
+   src = base + offset;
+
+   if (track->sector_size == 2448)
+   {
+      if (!track->interleaved_sub)
+      {
+         if (offset + 2448 > size)
+            return 0;
+         memcpy(buffer, src, 2448);
+      }
+      else
+      {
+         static const u16 deint_offsets[] = {
+            0, 66, 125, 191, 100, 50, 150, 175, 8, 33, 58, 83,
+            108, 133, 158, 183, 16, 41, 25, 91, 116, 141, 166, 75,
+            24, 90, 149, 215, 124, 74, 174, 199, 32, 57, 82, 107,
+            132, 157, 182, 207, 40, 65, 49, 115, 140, 165, 190, 99,
+            48, 114, 173, 239, 148, 98, 198, 223, 56, 81, 106, 131,
+            156, 181, 206, 231, 64, 89, 73, 139, 164, 189, 214, 123,
+            72, 138, 197, 263, 172, 122, 222, 247, 80, 105, 130, 155,
+            180, 205, 230, 255, 88, 113, 97, 163, 188, 213, 238, 147
+         };
+         int i;
+
+         // The subcode of this sector is spread over the next three sectors
+         if (offset + 2448 * 3 > size)
+            return 0;
+         memcpy(buffer, src, 2352);
+         for (i = 0; i < 96; i++)
+         {
+            int k = deint_offsets[i];
+            ((u8 *)buffer)[2352 + i] = src[2352 + (k / 96) * 2448 + (k % 96)];
+         }
+      }
+   }
+   else if (track->sector_size == 2352)
+   {
+      if (offset + 2352 > size)
+         return 0;
+      memcpy(buffer, src, 2352);
+      memset((u8 *)buffer + 2352, 0, 96);
+   }
+   else if (track->sector_size == 2048)
+   {
+      if (offset + 2048 > size)
+         return 0;
+      memcpy(buffer, syncHdr, 12);
+      memset((u8 *)buffer + 12, 0, 4);
+      memcpy((u8 *)buffer + 0x10, src, 2048);
+      memset((u8 *)buffer + 0x10 + 2048, 0, 2448 - 0x10 - 2048);
+   }
+   else
+      return 0;
+
+   return 1;
+}
+
 //////////////////////////////////////////////////////////////////////////////
 
 static int ISOCDInit(const char * iso) {
@@ -1721,6 +1959,8 @@ static int ISOCDInit(const char * iso) {
    }
 
    BuildTOC();
+   if (imgtype != IMG_CHD)
+      ISOBuildSectorMap();
    return 0;
 }
 
@@ -1728,6 +1968,9 @@ static int ISOCDInit(const char * iso) {
 
 static void ISOCDDeInit(void) {
    int i, j, k;
+   CHDFree();
+   ISOUnmapAll();
+   currentTrack = NULL;
    if (disc.session)
    {
       for (i = 0; i < disc.session_num; i++)
@@ -1784,8 +2027,6 @@ static s32 ISOCDReadTOC(u32 * TOC) {
 
 //////////////////////////////////////////////////////////////////////////////
 
-track_info_struct *currentTrack = NULL;
-
 static int ISOCDReadSectorFAD(u32 FAD, void *buffer) {
    int i,j;
    size_t num_read = 0;
@@ -1798,6 +2039,9 @@ static int ISOCDReadSectorFAD(u32 FAD, void *buffer) {
      return ISOCDReadSectorFADFromCHD(FAD,buffer);
    }
 
+   if (ISOReadMappedSector(FAD, buffer))
+      return 1;
+
    memset(buffer, 0, 2448);
 
    for (i = 0; i < disc.session_num; i++)
@@ -1873,9 +2117,10 @@ static int ISOCDReadSectorFAD(u32 FAD, void *buffer) {
 
 //////////////////////////////////////////////////////////////////////////////
 
-static void ISOCDReadAheadFAD(UNUSED u32 FAD)
+static void ISOCDReadAheadFAD(u32 FAD)
 {
-	// No-op
+   if (IMG_CHD == imgtype)
+      CHDReadAheadFAD(FAD);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -1888,16 +2133,227 @@ static void ISOCDReadAheadFAD(UNUSED u32 FAD)
 #define CD_MAX_TRACKS           (99)    /* AFAIK the theoretical limit */
 #define CD_TRACK_PADDING 4
 
+#define CHD_EV_PREFETCH 1
+#define CHD_EV_QUIT     2
+#define CHD_EV_LOADED   3
+
+typedef struct ChdHunk_ {
+  int hunk_id;      // -1 when the slot is empty
+  int loading;      // owned by the prefetch thread while set
+  u32 last_use;
+  char * data;
+} ChdHunk;
+
 typedef struct ChdInfo_ {
   chd_file *chd;
   core_file * image_file;
   chd_header * header;
-  char * hunk_buffer;
-  int current_hunk_id;
+
+  // LRU cache of decompressed hunks. mtx guards the slots, chd_mtx
+  // serializes chd_read since libchdr isn't thread safe per file.
+  ChdHunk * hunks;
+  int num_hunks;
+  u32 use_clock;
+  YabMutex * mtx;
+  YabMutex * chd_mtx;
+
+  // Read-ahead thread, fed by ReadAheadFAD from Cs2 play/seek
+  YabEventQueue * prefetch_q;
+  int prefetch_running;
+  volatile int prefetch_hunk;
+  int prefetch_depth;
+
+  // The reader waits here for a hunk the prefetch thread is filling,
+  // waiting is set under mtx while it does
+  YabEventQueue * loaded_q;
+  int waiting;
+
+  ISOCDCHDStats stats;
 } ChdInfo;
 
 ChdInfo * pChdInfo = NULL;
 
+static int chd_cache_hunks = 32;
+static int chd_prefetch_hunks = 8;
+
+void ISOCDSetCHDCache(int hunks, int prefetch)
+{
+  if (hunks < 2) hunks = 2;
+  if (prefetch < 0) prefetch = 0;
+  if (prefetch > hunks / 2) prefetch = hunks / 2;
+  // Takes effect on the next image load
+  chd_cache_hunks = hunks;
+  chd_prefetch_hunks = prefetch;
+}
+
+void ISOCDGetCHDStats(ISOCDCHDStats * stats)
+{
+  if (pChdInfo == NULL) {
+    memset(stats, 0, sizeof(*stats));
+    return;
+  }
+  YabThreadLock(pChdInfo->mtx);
+  *stats = pChdInfo->stats;
+  YabThreadUnLock(pChdInfo->mtx);
+}
+
+// Caller holds mtx. Returns the slot holding hunkid or NULL.
+static ChdHunk * CHDFindHunk(int hunkid)
+{
+  int i;
+  for (i = 0; i < pChdInfo->num_hunks; i++) {
+    if (pChdInfo->hunks[i].hunk_id == hunkid)
+      return &pChdInfo->hunks[i];
+  }
+  return NULL;
+}
+
+// Caller holds mtx. Picks the least recently used slot that isn't being filled.
+static ChdHunk * CHDVictimHunk(void)
+{
+  ChdHunk * victim = NULL;
+  int i;
+  for (i = 0; i < pChdInfo->num_hunks; i++) {
+    ChdHunk * h = &pChdInfo->hunks[i];
+    if (h->loading)
+      continue;
+    if (h->hunk_id == -1)
+      return h;
+    if (victim == NULL || (s32)(h->last_use - victim->last_use) < 0)
+      victim = h;
+  }
+  return victim;
+}
+
+// Decompress hunkid into a cache slot. Caller holds mtx, which is released
+// while decompressing. Returns the slot or NULL.
+static ChdHunk * CHDLoadHunk(int hunkid)
+{
+  ChdHunk * h = CHDVictimHunk();
+  chd_error err;
+
+  if (h == NULL)
+    return NULL;
+
+  h->hunk_id = hunkid;
+  h->loading = 1;
+  YabThreadUnLock(pChdInfo->mtx);
+
+  YabThreadLock(pChdInfo->chd_mtx);
+  err = chd_read(pChdInfo->chd, hunkid, h->data);
+  YabThreadUnLock(pChdInfo->chd_mtx);
+
+  YabThreadLock(pChdInfo->mtx);
+  h->loading = 0;
+  if (pChdInfo->waiting) {
+    pChdInfo->waiting = 0;
+    YabAddEventQueue(pChdInfo->loaded_q, CHD_EV_LOADED);
+  }
+  if (err != CHDERR_NONE) {
+    h->hunk_id = -1;
+    return NULL;
+  }
+  h->last_use = pChdInfo->use_clock++;
+  return h;
+}
+
+static void * CHDPrefetchThread(void * arg)
+{
+  TraceThreadName("chd prefetch");
+
+  for (;;) {
+    int i, base;
+
+    if (YabWaitEventQueue(pChdInfo->prefetch_q) == CHD_EV_QUIT)
+      break;
+
+    base = pChdInfo->prefetch_hunk;
+    TRACE_BEGIN(TRACE_CD_PREFETCH);
+    YabThreadLock(pChdInfo->mtx);
+    for (i = 0; i < pChdInfo->prefetch_depth; i++) {
+      int hunkid = base + i;
+      if (hunkid >= (int)pChdInfo->header->totalhunks)
+        break;
+      // A newer request came in, restart from there
+      if (base != pChdInfo->prefetch_hunk)
+        break;
+      if (CHDFindHunk(hunkid) != NULL)
+        continue;
+      if (CHDLoadHunk(hunkid) != NULL)
+        pChdInfo->stats.prefetched++;
+    }
+    YabThreadUnLock(pChdInfo->mtx);
+    TRACE_END(TRACE_CD_PREFETCH);
+  }
+  return NULL;
+}
+
+static int CHDInitCache(void)
+{
+  int i;
+
+  pChdInfo->num_hunks = chd_cache_hunks;
+  pChdInfo->prefetch_depth = chd_prefetch_hunks;
+  pChdInfo->hunks = calloc(pChdInfo->num_hunks, sizeof(ChdHunk));
+  if (pChdInfo->hunks == NULL)
+    return -1;
+
+  for (i = 0; i < pChdInfo->num_hunks; i++) {
+    pChdInfo->hunks[i].hunk_id = -1;
+    pChdInfo->hunks[i].data = malloc(pChdInfo->header->hunkbytes);
+    if (pChdInfo->hunks[i].data == NULL)
+      return -1;
+  }
+
+  pChdInfo->mtx = YabThreadCreateMutex();
+  pChdInfo->chd_mtx = YabThreadCreateMutex();
+
+  pChdInfo->prefetch_running = 0;
+  pChdInfo->prefetch_hunk = -1;
+  if (pChdInfo->prefetch_depth > 0) {
+    pChdInfo->prefetch_q = YabThreadCreateQueue(4);
+    pChdInfo->loaded_q = YabThreadCreateQueue(2);
+    if (YabThreadStart(YAB_THREAD_CD_PREFETCH, "chd prefetch", CHDPrefetchThread, NULL) == 0)
+      pChdInfo->prefetch_running = 1;
+  }
+  return 0;
+}
+
+static void CHDFree(void)
+{
+  int i;
+
+  if (pChdInfo == NULL)
+    return;
+
+  if (pChdInfo->prefetch_running) {
+    YabAddEventQueue(pChdInfo->prefetch_q, CHD_EV_QUIT);
+    YabThreadWait(YAB_THREAD_CD_PREFETCH);
+  }
+  if (pChdInfo->prefetch_q)
+    YabThreadDestoryQueue(pChdInfo->prefetch_q);
+  if (pChdInfo->loaded_q)
+    YabThreadDestoryQueue(pChdInfo->loaded_q);
+
+  LOG("CHD cache: %u hits, %u misses, %u prefetched\n",
+    pChdInfo->stats.hits, pChdInfo->stats.misses, pChdInfo->stats.prefetched);
+
+  if (pChdInfo->hunks) {
+    for (i = 0; i < pChdInfo->num_hunks; i++)
+      free(pChdInfo->hunks[i].data);
+    free(pChdInfo->hunks);
+  }
+  if (pChdInfo->mtx)
+    YabThreadFreeMutex(pChdInfo->mtx);
+  if (pChdInfo->chd_mtx)
+    YabThreadFreeMutex(pChdInfo->chd_mtx);
+  if (pChdInfo->chd)
+    chd_close(pChdInfo->chd);
+
+  free(pChdInfo);
+  pChdInfo = NULL;
+}
+
 int checkCHD(const char *filename ) {
 
   chd_file *chd;
@@ -1927,9 +2383,7 @@ static int LoadCHD(const char *chd_filename, FILE *iso_file)
   u32 resulttag;
   u8 resultflags;
 
-  if (pChdInfo != NULL) {
-    free(pChdInfo);
-  }
+  CHDFree();
 
   pChdInfo = malloc(sizeof(ChdInfo));
   memset(pChdInfo, 0, sizeof(ChdInfo));
@@ -2110,17 +2564,17 @@ static int LoadCHD(const char *chd_filename, FILE *iso_file)
 
   memcpy(disc.session[0].track, trk, num_tracks * sizeof(track_info_struct));
 
-  pChdInfo->hunk_buffer = malloc(pChdInfo->header->hunkbytes);
-  chd_read(pChdInfo->chd, 0, pChdInfo->hunk_buffer);
-  pChdInfo->current_hunk_id = 0;
+  if (CHDInitCache() != 0) {
+    YabSetError(YAB_ERR_MEMORYALLOC, NULL);
+    return -1;
+  }
 
   return 0;
 }
 
 
-static int ISOCDReadSectorFADFromCHD(u32 FAD, void *buffer) {
+static track_info_struct * CHDFadToLba(u32 FAD, u32 * lba) {
   int i, j;
-  size_t num_read = 0;
   track_info_struct *track = NULL;
   u32 chdlba;
   u32 physlba;
@@ -2149,24 +2603,76 @@ static int ISOCDReadSectorFADFromCHD(u32 FAD, void *buffer) {
     }
   }
 
-  if (track == NULL)
+  *lba = chdlba;
+  return track;
+}
+
+static void CHDReadAheadFAD(u32 FAD) {
+  track_info_struct *track;
+  u32 chdlba;
+  int hunkid;
+
+  if (pChdInfo == NULL || !pChdInfo->prefetch_running)
+    return;
+
+  if ((track = CHDFadToLba(FAD, &chdlba)) == NULL)
+    return;
+
+  hunkid = (int)(((u64)chdlba * CD_FRAME_SIZE) / pChdInfo->header->hunkbytes);
+
+  // Only wake the thread when the stream moves into another hunk
+  if (hunkid == pChdInfo->prefetch_hunk)
+    return;
+  pChdInfo->prefetch_hunk = hunkid;
+  if (YaGetQueueSize(pChdInfo->prefetch_q) == 0)
+    YabAddEventQueue(pChdInfo->prefetch_q, CHD_EV_PREFETCH);
+}
+
+static int ISOCDReadSectorFADFromCHD(u32 FAD, void *buffer) {
+  track_info_struct *track;
+  ChdHunk *hunk;
+  u32 chdlba;
+  int hunkid, hunk_offset;
+  int i;
+
+  if ((track = CHDFadToLba(FAD, &chdlba)) == NULL)
   {
     CDLOG("Warning: Sector not found in track list");
     return 0;
   }
 
-  int hunkid = (chdlba*CD_FRAME_SIZE) / pChdInfo->header->hunkbytes ;
-  int hunk_offset =  (chdlba*CD_FRAME_SIZE) % pChdInfo->header->hunkbytes;
+  hunkid = (int)(((u64)chdlba * CD_FRAME_SIZE) / pChdInfo->header->hunkbytes);
+  hunk_offset = (int)(((u64)chdlba * CD_FRAME_SIZE) % pChdInfo->header->hunkbytes);
+
+  YabThreadLock(pChdInfo->mtx);
 
-  if (pChdInfo->current_hunk_id != hunkid) {
-    chd_read(pChdInfo->chd, hunkid, pChdInfo->hunk_buffer);
-    pChdInfo->current_hunk_id = hunkid;
+  hunk = CHDFindHunk(hunkid);
+  // Still being decompressed by the prefetch thread, wait for it
+  while (hunk != NULL && hunk->loading) {
+    pChdInfo->waiting = 1;
+    YabThreadUnLock(pChdInfo->mtx);
+    YabWaitEventQueue(pChdInfo->loaded_q);
+    YabThreadLock(pChdInfo->mtx);
+    hunk = CHDFindHunk(hunkid);
+  }
+
+  if (hunk != NULL) {
+    pChdInfo->stats.hits++;
+    hunk->last_use = pChdInfo->use_clock++;
+  }
+  else {
+    pChdInfo->stats.misses++;
+    if ((hunk = CHDLoadHunk(hunkid)) == NULL) {
+      YabThreadUnLock(pChdInfo->mtx);
+      return 0;
+    }
   }
 
+  // Copy out while holding the lock so the slot can't be recycled under us
   if (track->ctl_addr == 0x01) {
-    for (int i = 0; i < track->sector_size; i += 2) {
-      ((char*)buffer)[i] = pChdInfo->hunk_buffer[hunk_offset + i + 1];
-      ((char*)buffer)[i+1] = pChdInfo->hunk_buffer[hunk_offset + i];
+    for (i = 0; i < track->sector_size; i += 2) {
+      ((char*)buffer)[i] = hunk->data[hunk_offset + i + 1];
+      ((char*)buffer)[i+1] = hunk->data[hunk_offset + i];
     }
   }
   else {
@@ -2174,13 +2680,14 @@ static int ISOCDReadSectorFADFromCHD(u32 FAD, void *buffer) {
     if (track->sector_size == 2048)
     {
       memcpy(buffer, syncHdr, 12);
-      memcpy((char *)buffer + 0x10, pChdInfo->hunk_buffer + hunk_offset, track->sector_size);
+      memcpy((char *)buffer + 0x10, hunk->data + hunk_offset, track->sector_size);
     }
     else {
-      memcpy(buffer, pChdInfo->hunk_buffer + hunk_offset, track->sector_size);
+      memcpy(buffer, hunk->data + hunk_offset, track->sector_size);
     }
   }
 
+  YabThreadUnLock(pChdInfo->mtx);
   return 1;
 }
 
@@ -84,6 +84,19 @@ extern CDInterface ArchCD;
 
 extern CDInterface WebApiCD;
 
+typedef struct
+{
+        u32 hits;
+        u32 misses;
+        u32 prefetched;
+} ISOCDCHDStats;
+
+// Size of the decompressed hunk cache and how many hunks the read-ahead
+// thread keeps ahead of the current play position (0 disables it).
+// Applied when the next CHD image is opened.
+void ISOCDSetCHDCache(int hunks, int prefetch);
+void ISOCDGetCHDStats(ISOCDCHDStats * stats);
+
 
 #if defined (__cplusplus)
 }
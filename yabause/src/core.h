@@ -36,6 +36,14 @@ extern "C" {
 #endif
 #endif
 
+#ifndef THREAD_LOCAL
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+#endif
+
 #ifndef STDCALL
 #ifdef _MSC_VER
 #define STDCALL __stdcall
@@ -45,6 +45,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 #include <stdlib.h>
 #include "cs0.h"
 #include "error.h"
+#include "fastmem.h"
 #include "japmodem.h"
 #include "netlink.h"
 
@@ -1186,7 +1187,7 @@ int CartInit(const char * filename, int type)
       }
       case CART_DRAM8MBIT: // 8 Mbit Dram Cart
       {
-         if ((CartridgeArea->dram = T1MemoryInit(0x100000)) == NULL)
+         if ((CartridgeArea->dram = FastmemMemoryInit(0x100000)) == NULL)
             return -1;
 
          CartridgeArea->cartid = 0x5A;
@@ -1202,7 +1203,7 @@ int CartInit(const char * filename, int type)
       }
       case CART_DRAM32MBIT: // 32 Mbit Dram Cart
       {
-         if ((CartridgeArea->dram = T1MemoryInit(0x400000)) == NULL)
+         if ((CartridgeArea->dram = FastmemMemoryInit(0x400000)) == NULL)
             return -1;
 
          CartridgeArea->cartid = 0x5C;
@@ -1414,7 +1415,7 @@ void CartDeInit(void)
       }
 
       if (CartridgeArea->dram)
-         T1MemoryDeInit(CartridgeArea->dram);
+         FastmemMemoryDeInit(CartridgeArea->dram);
 
       free(CartridgeArea);
    }
@@ -0,0 +1,133 @@
+/*
+        Copyright 2026 agent(agent@local)
+
+This file is part of YabaSanshiro.
+
+        YabaSanshiro is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+YabaSanshiro is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+along with YabaSanshiro; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*! \file fastmem.c
+    \brief Host pointers for the plain ram pages (yabsys.use_fastmem).
+
+    The first access of a MappedMemory* call used to be a switch on the area
+    and a call through the handler lists, even for work ram. With fastmem
+    every 64KB page of the 28 bits the handler lists decode has a host
+    pointer, set for the rams that have nothing to do on an access but load
+    and store, mirrors included. One table lookup then says whether a page
+    can be loaded from or stored to directly, and how the area stores its
+    words.
+
+    Everything else goes through the handler lists as before, as do the VDP
+    rams' writes that have to mark what they dirtied.
+
+    The check sits at the top of MappedMemory*, the cpu cores still call
+    those. Neither the interpreter's handlers nor the dynarecs' emitted code
+    read the page table themselves.
+*/
+
+#include <stdlib.h>
+#include "fastmem.h"
+#include "yabause.h"
+
+u8 FastmemRead[0x10000];
+u8 FastmemWrite[0x10000];
+u8 *FastmemPage[0x1000];
+u32 FastmemCode[0x1000];
+
+// By page, what the tables get whenever the page isn't held
+static u8 *page_area[0x1000];
+static u8 page_read[0x1000];
+static u8 page_write[0x1000];
+static u8 page_hold[0x1000];
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Every address the handler lists take the page for: the cached and cache
+// through areas and the one at 0x80000000 memory.c reads the same way
+static void FastmemPublish(u16 page)
+{
+   static const u16 prefix[] = { 0x0000, 0x1000, 0x2000, 0x3000, 0x8000, 0x9000 };
+   u8 read = page_hold[page] ? FASTMEM_NONE : page_read[page];
+   u8 write = page_hold[page] ? FASTMEM_NONE : page_write[page];
+   int i;
+
+   for (i = 0; i < (int)(sizeof(prefix) / sizeof(prefix[0])); i++)
+   {
+      FastmemRead[prefix[i] | page] = read;
+      FastmemWrite[prefix[i] | page] = write;
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+u8 * FastmemMemoryInit(u32 size)
+{
+   return T1MemoryInit(size);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void FastmemMemoryDeInit(u8 *mem)
+{
+   int page;
+
+   for (page = 0; mem != NULL && page < 0x1000; page++)
+   {
+      if (page_area[page] == mem)
+      {
+         page_area[page] = NULL;
+         page_read[page] = FASTMEM_NONE;
+         page_write[page] = FASTMEM_NONE;
+         FastmemPage[page] = NULL;
+         FastmemPublish(page);
+      }
+   }
+
+   T1MemoryDeInit(mem);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void FastmemMap(u8 *mem, u32 offset, u32 size, u16 start, u16 end, int read, int write, u32 code)
+{
+   u32 page;
+
+   if (!yabsys.use_fastmem || mem == NULL || size == 0 || ((offset | size) & 0xFFFF) != 0)
+      return;
+
+   for (page = start; page <= end && page < 0x1000; page++)
+   {
+      u32 at = ((page - start) << 16) % size;
+
+      page_area[page] = mem;
+      page_read[page] = read;
+      page_write[page] = write;
+      FastmemPage[page] = mem + offset + at;
+      FastmemCode[page] = code + at;
+      FastmemPublish(page);
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void FastmemHoldPage(u16 page, int hold)
+{
+   page &= 0xFFF;
+   if (hold)
+      page_hold[page]++;
+   else if (page_hold[page] > 0)
+      page_hold[page]--;
+   FastmemPublish(page);
+}
@@ -0,0 +1,144 @@
+/*
+        Copyright 2026 agent(agent@local)
+
+This file is part of YabaSanshiro.
+
+        YabaSanshiro is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+YabaSanshiro is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+along with YabaSanshiro; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*! \file fastmem.h
+    \brief Host pointers for the plain ram pages (yabsys.use_fastmem).
+*/
+
+#ifndef FASTMEM_H
+#define FASTMEM_H
+
+#include "core.h"
+#include "memory.h"
+#include "sh2core.h"
+#include "sh2int.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// What the cpus can do straight on a page, by the way its ram is stored
+#define FASTMEM_NONE 0
+#define FASTMEM_T1   1
+#define FASTMEM_T2   2     // writes tell the block cache, work rams only
+
+// FastmemMemoryInit: size bytes for an area the cpus may reach through
+// fastmem, zeroed. Free with FastmemMemoryDeInit, which takes the area's
+// pages off the fast path first.
+u8 * FastmemMemoryInit(u32 size);
+void FastmemMemoryDeInit(u8 *mem);
+
+// FastmemMap: point the 64KB pages start to end at size bytes of mem from
+// offset, repeated when the pages are larger. read and write are FASTMEM_*,
+// code is the block cache offset of offset for FASTMEM_T2 writes. Does
+// nothing when fastmem is off.
+void FastmemMap(u8 *mem, u32 offset, u32 size, u16 start, u16 end, int read, int write, u32 code);
+
+// FastmemHoldPage: something put its own handler in front of page, send
+// the cpus through the handler lists until it lets go
+void FastmemHoldPage(u16 page, int hold);
+
+extern u8 FastmemRead[0x10000];     // by addr >> 16, only the areas that
+extern u8 FastmemWrite[0x10000];    // go to the handler lists are set
+extern u8 *FastmemPage[0x1000];     // by page, where its 64KB are
+extern u32 FastmemCode[0x1000];
+
+#define FASTMEM_PAGE(addr) FastmemPage[((addr) >> 16) & 0xFFF]
+
+static INLINE int FastmemReadByte(u32 addr, u8 *val)
+{
+   switch (FastmemRead[addr >> 16])
+   {
+      case FASTMEM_T1: *val = T1ReadByte(FASTMEM_PAGE(addr), addr & 0xFFFF); return 1;
+      case FASTMEM_T2: *val = T2ReadByte(FASTMEM_PAGE(addr), addr & 0xFFFF); return 1;
+   }
+   return 0;
+}
+
+static INLINE int FastmemReadWord(u32 addr, u16 *val)
+{
+   switch (FastmemRead[addr >> 16])
+   {
+      case FASTMEM_T1: *val = T1ReadWord(FASTMEM_PAGE(addr), addr & 0xFFFF); return 1;
+      case FASTMEM_T2: *val = T2ReadWord(FASTMEM_PAGE(addr), addr & 0xFFFF); return 1;
+   }
+   return 0;
+}
+
+static INLINE int FastmemReadLong(u32 addr, u32 *val)
+{
+   switch (FastmemRead[addr >> 16])
+   {
+      case FASTMEM_T1: *val = T1ReadLong(FASTMEM_PAGE(addr), addr & 0xFFFF); return 1;
+      case FASTMEM_T2: *val = T2ReadLong(FASTMEM_PAGE(addr), addr & 0xFFFF); return 1;
+   }
+   return 0;
+}
+
+static INLINE int FastmemWriteByte(u32 addr, u8 val)
+{
+   switch (FastmemWrite[addr >> 16])
+   {
+      case FASTMEM_T1:
+         T1WriteByte(FASTMEM_PAGE(addr), addr & 0xFFFF, val);
+         return 1;
+      case FASTMEM_T2:
+         T2WriteByte(FASTMEM_PAGE(addr), addr & 0xFFFF, val);
+         SH2BlockCacheWrite(FastmemCode[(addr >> 16) & 0xFFF] + (addr & 0xFFFF));
+         return 1;
+   }
+   return 0;
+}
+
+static INLINE int FastmemWriteWord(u32 addr, u16 val)
+{
+   switch (FastmemWrite[addr >> 16])
+   {
+      case FASTMEM_T1:
+         T1WriteWord(FASTMEM_PAGE(addr), addr & 0xFFFF, val);
+         return 1;
+      case FASTMEM_T2:
+         T2WriteWord(FASTMEM_PAGE(addr), addr & 0xFFFF, val);
+         SH2BlockCacheWrite(FastmemCode[(addr >> 16) & 0xFFF] + (addr & 0xFFFF));
+         return 1;
+   }
+   return 0;
+}
+
+static INLINE int FastmemWriteLong(u32 addr, u32 val)
+{
+   switch (FastmemWrite[addr >> 16])
+   {
+      case FASTMEM_T1:
+         T1WriteLong(FASTMEM_PAGE(addr), addr & 0xFFFF, val);
+         return 1;
+      case FASTMEM_T2:
+         T2WriteLong(FASTMEM_PAGE(addr), addr & 0xFFFF, val);
+         SH2BlockCacheWrite(FastmemCode[(addr >> 16) & 0xFFF] + (addr & 0xFFFF));
+         return 1;
+   }
+   return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
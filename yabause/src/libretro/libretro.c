@@ -65,6 +65,9 @@ static int g_sh2coretype = SH2CORE_INTERPRETER;
 static int g_frame_skip = 1;
 static int g_rbg_resolution_mode = 0;
 static int g_rbg_use_compute_shader = 1;
+static int g_sh2_block_cache = 1;
+static int g_ssh2_thread = 0;
+static int g_fastmem = 1;
 static int addon_cart_type = CART_DRAM32MBIT;
 static int resolution_mode = 1;
 static int initial_resolution_mode = 0;
@@ -106,6 +109,9 @@ void retro_set_environment(retro_environment_t cb)
 #ifdef DYNAREC_DEVMIYAX
       { "yabasanshiro_sh2coretype", "SH2 Core (restart); dynarec|interpreter" },
 #endif
+      { "yabasanshiro_sh2_block_cache", "SH2 interpreter block cache (restart); enabled|disabled" },
+      { "yabasanshiro_ssh2_thread", "Slave SH2 on its own thread (restart, experimental); disabled|enabled" },
+      { "yabasanshiro_fastmem", "Fast memory access (restart); enabled|disabled" },
 #ifdef ALLOW_POLYGON_MODE
       { "yabasanshiro_polygon_mode", "Polygon Mode; perspective_correction|gpu_tesselation|cpu_tesselation" },
 #endif
@@ -738,6 +744,36 @@ void check_variables(void)
    }
 #endif
 
+   var.key = "yabasanshiro_sh2_block_cache";
+   var.value = NULL;
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      if (strcmp(var.value, "enabled") == 0)
+         g_sh2_block_cache = 1;
+      else if (strcmp(var.value, "disabled") == 0)
+         g_sh2_block_cache = 0;
+   }
+
+   var.key = "yabasanshiro_ssh2_thread";
+   var.value = NULL;
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      if (strcmp(var.value, "enabled") == 0)
+         g_ssh2_thread = 1;
+      else if (strcmp(var.value, "disabled") == 0)
+         g_ssh2_thread = 0;
+   }
+
+   var.key = "yabasanshiro_fastmem";
+   var.value = NULL;
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      if (strcmp(var.value, "enabled") == 0)
+         g_fastmem = 1;
+      else if (strcmp(var.value, "disabled") == 0)
+         g_fastmem = 0;
+   }
+
    var.key = "yabasanshiro_addon_cart";
    var.value = NULL;
    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
@@ -842,40 +878,18 @@ void retro_set_controller_port_device(unsigned port, unsigned device)
 
 size_t retro_serialize_size(void)
 {
-   // Disabling savestates until they are safe
-   return 0;
-   void *buffer;
-   size_t size;
-
-   ScspMuteAudio(SCSP_MUTE_SYSTEM);
-   YabSaveStateBuffer (&buffer, &size);
-   ScspUnMuteAudio(SCSP_MUTE_SYSTEM);
-
-   free(buffer);
-
-   return size;
+   // Fixed for the session, run-ahead and netplay reuse one buffer
+   return YabSaveStateMaxSize();
 }
 
 bool retro_serialize(void *data, size_t size)
 {
-   // Disabling savestates until they are safe
-   return true;
-   void *buffer;
-   size_t out_size;
-
-   int error = YabSaveStateBuffer (&buffer, &out_size);
-
-   memcpy(data, buffer, size);
-
-   free(buffer);
-   return !error;
+   return YabSaveStateFixed(data, size) == 0;
 }
 
 bool retro_unserialize(const void *data, size_t size)
 {
-   // Disabling savestates until they are safe
-   return true;
-   int error = YabLoadStateBuffer(data, size);
+   int error = YabLoadStateFixed(data, size);
    retro_set_resolution();
 
    return !error;
@@ -963,6 +977,9 @@ bool retro_load_game_common()
    yinit.vidcoretype               = VIDCORE_OGL;
    yinit.percoretype               = PERCORE_LIBRETRO;
    yinit.sh2coretype               = g_sh2coretype;
+   yinit.use_sh2_block_cache       = g_sh2_block_cache;
+   yinit.use_ssh2_thread           = g_ssh2_thread;
+   yinit.use_fastmem               = g_fastmem;
    yinit.sndcoretype               = SNDCORE_LIBRETRO;
 #ifdef HAVE_MUSASHI
    yinit.m68kcoretype              = M68KCORE_MUSASHI;
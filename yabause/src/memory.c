@@ -57,6 +57,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 #include "debug.h"
 #include "error.h"
 #include "sh2core.h"
+#include "sh2int.h"
+#include "sh2thread.h"
+#include "fastmem.h"
 #include "scsp.h"
 #include "scu.h"
 #include "smpc.h"
@@ -65,6 +68,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 #include "yabause.h"
 #include "yui.h"
 #include "movie.h"
+#include "memstream.h"
+#include "rewind.h"
 
 //#ifdef HAVE_LIBGL
 //#define USE_OPENGL
@@ -110,6 +115,9 @@ extern u32 tweak_backup_file_addr;
  * e.g. for implementing autosave of backup RAM. */
 u8 BupRamWritten;
 
+// Upper bound of the fixed size states, 0 until YabSaveStateMaxSize
+static size_t state_max_size = 0;
+
 #if defined(NX)
 
 void * YabMemMap(char * filename, u32 size ) {
@@ -376,6 +384,7 @@ static u32 FASTCALL HighWramMemoryReadLong(u32 addr)
 static void FASTCALL HighWramMemoryWriteByte(u32 addr, u8 val)
 {
    T2WriteByte(HighWram, addr & 0xFFFFF, val);
+   SH2BlockCacheWrite(SH2_BLOCK_HWRAM + (addr & 0xFFFFF));
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -383,6 +392,7 @@ static void FASTCALL HighWramMemoryWriteByte(u32 addr, u8 val)
 static void FASTCALL HighWramMemoryWriteWord(u32 addr, u16 val)
 {
    T2WriteWord(HighWram, addr & 0xFFFFF, val);
+   SH2BlockCacheWrite(SH2_BLOCK_HWRAM + (addr & 0xFFFFF));
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -390,6 +400,7 @@ static void FASTCALL HighWramMemoryWriteWord(u32 addr, u16 val)
 static void FASTCALL HighWramMemoryWriteLong(u32 addr, u32 val)
 {
    T2WriteLong(HighWram, addr & 0xFFFFF, val);
+   SH2BlockCacheWrite(SH2_BLOCK_HWRAM + (addr & 0xFFFFF));
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -418,6 +429,7 @@ static u32 FASTCALL LowWramMemoryReadLong(u32 addr)
 static void FASTCALL LowWramMemoryWriteByte(u32 addr, u8 val)
 {
    T2WriteByte(LowWram, addr & 0xFFFFF, val);
+   SH2BlockCacheWrite(SH2_BLOCK_LWRAM + (addr & 0xFFFFF));
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -425,6 +437,7 @@ static void FASTCALL LowWramMemoryWriteByte(u32 addr, u8 val)
 static void FASTCALL LowWramMemoryWriteWord(u32 addr, u16 val)
 {
    T2WriteWord(LowWram, addr & 0xFFFFF, val);
+   SH2BlockCacheWrite(SH2_BLOCK_LWRAM + (addr & 0xFFFFF));
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -432,6 +445,7 @@ static void FASTCALL LowWramMemoryWriteWord(u32 addr, u16 val)
 static void FASTCALL LowWramMemoryWriteLong(u32 addr, u32 val)
 {
    T2WriteLong(LowWram, addr & 0xFFFFF, val);
+   SH2BlockCacheWrite(SH2_BLOCK_LWRAM + (addr & 0xFFFFF));
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -611,6 +625,9 @@ static void FillMemoryArea(unsigned short start, unsigned short end,
 
 void MappedMemoryInit()
 {
+   // the cart and the rest of the state may be sized differently now
+   state_max_size = 0;
+
    // Initialize everyting to unhandled to begin with
    FillMemoryArea(0x000, 0xFFF, &UnhandledMemoryReadByte,
                                 &UnhandledMemoryReadWord,
@@ -742,6 +759,32 @@ void MappedMemoryInit()
      &BupRamMemoryWriteLong);
 }
 
+//////////////////////////////////////////////////////////////////////////////
+
+void MappedMemoryMapFastmem(void)
+{
+   // Same pages as MappedMemoryInit gives the plain ram handlers. Sound ram
+   // stays out, its reads keep the scsp in step with the cpus.
+   FastmemMap(BiosRom, 0, 0x80000, 0x000, 0x00F, FASTMEM_T2, FASTMEM_NONE, 0);
+   FastmemMap(LowWram, 0, 0x100000, 0x020, 0x02F, FASTMEM_T2, FASTMEM_T2, SH2_BLOCK_LWRAM);
+   FastmemMap(HighWram, 0, 0x100000, 0x600, 0x610, FASTMEM_T2, FASTMEM_T2, SH2_BLOCK_HWRAM);
+   FastmemMap(Vdp1Ram, 0, 0x80000, 0x5C0, 0x5C7, FASTMEM_T1, FASTMEM_NONE, 0);
+   FastmemMap(Vdp2Ram, 0, 0x80000, 0x5E0, 0x5EF, FASTMEM_T1, FASTMEM_NONE, 0);
+
+   switch (CartridgeArea->carttype)
+   {
+      case CART_DRAM8MBIT:
+         FastmemMap(CartridgeArea->dram, 0, 0x80000, 0x240, 0x24F, FASTMEM_T1, FASTMEM_T1, 0);
+         FastmemMap(CartridgeArea->dram, 0x80000, 0x80000, 0x260, 0x26F, FASTMEM_T1, FASTMEM_T1, 0);
+         break;
+      case CART_DRAM32MBIT:
+         FastmemMap(CartridgeArea->dram, 0, 0x400000, 0x240, 0x27F, FASTMEM_T1, FASTMEM_T1, 0);
+         break;
+      default:
+         break;
+   }
+}
+
 #if 0
 #define GET_MEM_CYCLE_W *cycle = 0;
 #define GET_MEM_CYCLE_R *cycle = 0;
@@ -784,6 +827,8 @@ u32 getMemClock(u32 addr) {
     return 80 >> clock_shift;
   }
   else if (addr >= 0x05e00000 && addr < 0x05E80000) {
+    // the wait depends on where the master left the line
+    SH2_THREAD_PARK();
     if (yabsys.LineCount >= yabsys.VBlankLineCount) {
       return 80 >> clock_shift;
     }
@@ -855,10 +900,14 @@ u8 FASTCALL MappedMemoryReadByteNocache(u32 addr, u32 * cycle)
 u8 FASTCALL MappedMemoryReadByte(u32 addr, u32 * cycle)
 #endif
 {
+   u8 fast;
   if (cycle != NULL) { 
     *cycle = getMemClock(addr);
   }
 
+   if (FastmemReadByte(addr, &fast))
+      return fast;
+
    switch (addr >> 29)
    {
       case 0x0:
@@ -930,10 +979,14 @@ u16 MappedMemoryReadInst(u32 addr, u32 * cycle) {
 u16 FASTCALL MappedMemoryReadWord(u32 addr, u32 * cycle)
 #endif
 {
+   u16 fast;
   if (cycle != NULL) {
     *cycle = getMemClock(addr);
   }
 
+   if (FastmemReadWord(addr, &fast))
+      return fast;
+
    switch (addr >> 29)
    {
       case 0x0:
@@ -997,11 +1050,15 @@ u32 FASTCALL MappedMemoryReadLongNocache(u32 addr, u32 * cycle)
 u32 FASTCALL MappedMemoryReadLong(u32 addr, u32 * cycle)
 #endif
 {
+   u32 fast;
 
   if (cycle != NULL) {
     *cycle = getMemClock(addr);
   }
 
+   if (FastmemReadLong(addr, &fast))
+      return fast;
+
    switch (addr >> 29)
    {
       case 0x0:
@@ -1079,6 +1136,9 @@ void FASTCALL MappedMemoryWriteByte(u32 addr, u8 val, u32 * cycle)
     *cycle = getMemClock(addr);
   }
 
+   if (FastmemWriteByte(addr, val))
+      return;
+
   switch (addr >> 29)
    {
       case 0x0:
@@ -1094,6 +1154,7 @@ void FASTCALL MappedMemoryWriteByte(u32 addr, u8 val, u32 * cycle)
       case 0x5:
       {
          // Purge Area
+         SH2_THREAD_PARK();
          return;
       }
 
@@ -1143,6 +1204,9 @@ void FASTCALL MappedMemoryWriteWord(u32 addr, u16 val, u32 * cycle )
     *cycle = getMemClock(addr);
   }
 
+   if (FastmemWriteWord(addr, val))
+      return;
+
    switch (addr >> 29)
    {
       case 0x0:
@@ -1158,6 +1222,7 @@ void FASTCALL MappedMemoryWriteWord(u32 addr, u16 val, u32 * cycle )
       case 0x5:
       {
         // Purge Area
+        SH2_THREAD_PARK();
         return;
       }
 
@@ -1220,6 +1285,9 @@ void FASTCALL MappedMemoryWriteLong(u32 addr, u32 val, u32 * cycle )
      *cycle = getMemClock(addr);
    }
 
+   if (FastmemWriteLong(addr, val))
+      return;
+
    switch (addr >> 29)
    {
       case 0x0:
@@ -1235,6 +1303,7 @@ void FASTCALL MappedMemoryWriteLong(u32 addr, u32 val, u32 * cycle )
       case 0x5:
       {
         // Purge Area
+        SH2_THREAD_PARK();
         return;
       }
 
@@ -1492,38 +1561,195 @@ void FormatBackupRam(void *mem, u32 size)
 
 //////////////////////////////////////////////////////////////////////////////
 
-int YabSaveStateBuffer(void ** buffer, size_t * size)
+static size_t last_state_size = 0;
+static int save_state_quiet = 0;
+static int save_state_screenshot = 1;
+static int save_state_no_ram = 0;
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Bring the rendering and sound threads to a stop before touching anything
+// they read or write. The rendering thread runs what was queued and then
+// waits for the next event, the sound thread parks until StateResume.
+static void StateQuiesce(int wait_vdp)
+{
+   if (wait_vdp)
+      VdpQuiesce();
+   ScspLockThread();
+}
+
+static void StateResume(void)
+{
+   ScspUnLockThread();
+}
+
+#define STATE_QUIET   0x1   // no OSD message
+#define STATE_NO_SHOT 0x2   // no screenshot, for states nobody looks at
+#define STATE_NO_RAM  0x4   // rewind's, see YabSaveStateNoRam
+
+static int SaveStateToStream(FILE * fp, int flags)
+{
+   int status;
+
+   save_state_quiet = (flags & STATE_QUIET) != 0;
+   save_state_screenshot = (flags & STATE_NO_SHOT) == 0;
+   save_state_no_ram = (flags & STATE_NO_RAM) != 0;
+   StateQuiesce(!save_state_no_ram);
+   status = YabSaveStateStream(fp);
+   StateResume();
+   save_state_quiet = 0;
+   save_state_screenshot = 1;
+   save_state_no_ram = 0;
+
+   return status;
+}
+
+static int LoadStateFromStream(FILE * fp, int flags)
+{
+   int status;
+
+   save_state_quiet = (flags & STATE_QUIET) != 0;
+   save_state_no_ram = (flags & STATE_NO_RAM) != 0;
+   StateQuiesce(1);
+   status = YabLoadStateStream(fp);
+   StateResume();
+   save_state_quiet = 0;
+   save_state_no_ram = 0;
+
+   // rewind's snapshots lead to a machine that isn't there anymore
+   if (status == 0 && !(flags & STATE_NO_RAM))
+      RewindReset();
+
+   return status;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void StateWriteRam(IOCheck_struct * check, void * ram, size_t size, FILE * fp)
+{
+   if (!save_state_no_ram)
+      ywrite(check, ram, size, 1, fp);
+}
+
+void StateReadRam(IOCheck_struct * check, void * ram, size_t size, FILE * fp)
+{
+   if (!save_state_no_ram)
+      yread(check, ram, size, 1, fp);
+}
+
+// Replaces the contents of ms with the state. A fixed ms fails when the
+// state doesn't fit. Goes through a temp file where there are no custom
+// streams.
+static int SaveStateToMem(YabMemStream * ms, int flags)
 {
    FILE * fp;
    int status;
-   size_t num_read = 0;
+   int tmp = 0;
 
-   if (buffer != NULL) *buffer = NULL;
-   *size = 0;
+   ms->size = 0;
+   if ((fp = YabMemStreamOpen(ms, "wb+")) == NULL)
+   {
+      if ((fp = tmpfile()) == NULL)
+         return -1;
+      tmp = 1;
+   }
 
-   fp = tmpfile();
+   status = SaveStateToStream(fp, flags);
+   // a write past the end of a fixed buffer fails, it shows up on the flush
+   if (status == 0 && (fflush(fp) != 0 || ferror(fp)))
+      status = -1;
+   if (status == 0 && tmp)
+      status = YabMemStreamReadFile(ms, fp);
 
-   ScspLockThread();
-   status = YabSaveStateStream(fp);
-   ScspUnLockThread();
+   fclose(fp);
+   return status;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// ms must be initialized, its contents are replaced by the new state. An
+// already allocated buffer is reused so per frame callers don't reallocate.
+int YabSaveStateMem(YabMemStream *ms, int quiet)
+{
+   int status;
+
+   if (ms->capacity == 0 && YabMemStreamInit(ms, last_state_size) != 0)
+      return -1;
 
-   if (status != 0)
+   if ((status = SaveStateToMem(ms, quiet ? STATE_QUIET : 0)) != 0)
    {
-      fclose(fp);
+      YabMemStreamFree(ms);
       return status;
    }
 
-   fseek(fp, 0, SEEK_END);
-   *size = ftell(fp);
-   fseek(fp, 0, SEEK_SET);
+   last_state_size = ms->size;
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
 
+int YabSaveStateBuffer(void ** buffer, size_t * size)
+{
+   YabMemStream ms;
+   int status;
+
+   if (buffer != NULL) *buffer = NULL;
+   *size = 0;
+
+   if (YabMemStreamInit(&ms, last_state_size) != 0)
+      return -1;
+
+   if ((status = SaveStateToMem(&ms, 0)) != 0)
+   {
+      YabMemStreamFree(&ms);
+      return status;
+   }
+
+   last_state_size = ms.size;
    if (buffer != NULL)
+      *buffer = YabMemStreamDetach(&ms, size);
+   else
    {
-      *buffer = malloc(*size);
-      num_read = fread(*buffer, 1, *size, fp);
+      *size = ms.size;
+      YabMemStreamFree(&ms);
    }
+   return 0;
+}
 
-   fclose(fp);
+//////////////////////////////////////////////////////////////////////////////
+
+// Room left for the parts of a state that change size while running, the
+// movie data and the CD block partitions
+#define STATE_SIZE_SLACK 0x10000
+
+size_t YabSaveStateMaxSize(void)
+{
+   YabMemStream ms;
+
+   if (state_max_size != 0)
+      return state_max_size;
+
+   YabMemStreamInit(&ms, 0);
+   if (SaveStateToMem(&ms, STATE_QUIET | STATE_NO_SHOT) == 0 && ms.size > 0)
+      state_max_size = (ms.size + STATE_SIZE_SLACK + 0xFFFF) & ~(size_t)0xFFFF;
+
+   YabMemStreamFree(&ms);
+   return state_max_size;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int YabSaveStateFixed(void * buffer, size_t size)
+{
+   YabMemStream ms;
+   int status;
+
+   YabMemStreamInitFixed(&ms, buffer, size);
+   if ((status = SaveStateToMem(&ms, STATE_QUIET | STATE_NO_SHOT)) != 0)
+      return status;
+
+   // The same machine state always gives the same bytes
+   memset((u8 *)buffer + ms.size, 0, size - ms.size);
    return 0;
 }
 
@@ -1541,9 +1767,7 @@ int YabSaveState(const char *filename)
 
    if ((fp = fopen_utf8(filename, "wb")) == NULL)
       return -1;
-   ScspLockThread();
-   status = YabSaveStateStream(fp);
-   ScspUnLockThread();
+   status = SaveStateToStream(fp, 0);
    fclose(fp);
 
    return status;
@@ -1555,9 +1779,7 @@ int YabSaveState(const char *filename)
 // FIXME: Here's a (possibly incomplete) list of data that should be added
 // to the next version of the save state file:
 //    yabsys.DecilineStop (new format)
-//    yabsys.SH2CycleFrac (new field)
 //    yabsys.DecilineUSed (new field)
-//    yabsys.UsecFrac (new field)
 //    [scsp2.c] It would be nice to redo the format entirely because so
 //              many fields have changed format/size from the old scsp.c
 //    [scsp2.c] scsp_clock, scsp_clock_frac, ScspState.sample_timer (timing)
@@ -1570,7 +1792,7 @@ int YabSaveStateStream(FILE *fp)
    u32 i;
    int offset;
    IOCheck_struct check;
-   u8 *buf;
+   u8 *buf = NULL;
    int totalsize;
    int outputwidth;
    int outputheight;
@@ -1620,8 +1842,8 @@ int YabSaveStateStream(FILE *fp)
 
    // Other data
    ywrite(&check, (void *)BupRam, 0x10000, 1, fp); // do we really want to save this?
-   ywrite(&check, (void *)HighWram, 0x100000, 1, fp);
-   ywrite(&check, (void *)LowWram, 0x100000, 1, fp);
+   StateWriteRam(&check, (void *)HighWram, 0x100000, fp);
+   StateWriteRam(&check, (void *)LowWram, 0x100000, fp);
 
    ywrite(&check, (void *)&yabsys.DecilineCount, sizeof(int), 1, fp);
    ywrite(&check, (void *)&yabsys.LineCount, sizeof(int), 1, fp);
@@ -1637,19 +1859,25 @@ int YabSaveStateStream(FILE *fp)
    ywrite(&check, (void *)&yabsys.IsPal, sizeof(int), 1, fp);
 
    VIDCore->GetGlSize(&outputwidth, &outputheight);
+   if (!save_state_screenshot)
+      outputwidth = outputheight = 0;
 
    totalsize=outputwidth * outputheight * sizeof(u32);
 
-   if ((buf = (u8 *)malloc(totalsize)) == NULL)
+   // Zero filled so the state bytes are deterministic when nothing is captured
+   if (totalsize > 0 && (buf = (u8 *)calloc(1, totalsize)) == NULL)
    {
       return -2;
    }
 
    //YuiSwapBuffers();
    #ifdef USE_OPENGL
-   glPixelZoom(1,1);
-   glReadBuffer(GL_BACK);
-   glReadPixels(0, 0, outputwidth, outputheight, GL_RGBA, GL_UNSIGNED_BYTE, buf);
+   if (totalsize > 0)
+   {
+      glPixelZoom(1,1);
+      glReadBuffer(GL_BACK);
+      glReadPixels(0, 0, outputwidth, outputheight, GL_RGBA, GL_UNSIGNED_BYTE, buf);
+   }
    #else
    //memcpy(buf, dispbuffer, totalsize);
    #endif
@@ -1658,7 +1886,8 @@ int YabSaveStateStream(FILE *fp)
    ywrite(&check, (void *)&outputwidth, sizeof(outputwidth), 1, fp);
    ywrite(&check, (void *)&outputheight, sizeof(outputheight), 1, fp);
 
-   ywrite(&check, (void *)buf, totalsize, 1, fp);
+   if (totalsize > 0)
+      ywrite(&check, (void *)buf, totalsize, 1, fp);
 
    movieposition=ftell(fp);
    //write the movie to the end of the savestate
@@ -1666,6 +1895,13 @@ int YabSaveStateStream(FILE *fp)
 
    i += StateFinishHeader(fp, offset);
 
+   // Exact timing fractions, OTHR only has them rounded. Loaders that predate
+   // this chunk stop after OTHR and never see it.
+   offset = StateWriteHeader(fp, "SYS ", 1);
+   ywrite(&check, (void *)&yabsys.SH2CycleFrac, sizeof(u32), 1, fp);
+   ywrite(&check, (void *)&yabsys.UsecFrac, sizeof(u32), 1, fp);
+   i += StateFinishHeader(fp, offset);
+
    // Go back and update size
    fseek(fp, 8, SEEK_SET);
    ywrite(&check, (void *)&i, sizeof(i), 1, fp);
@@ -1674,31 +1910,71 @@ int YabSaveStateStream(FILE *fp)
 
    free(buf);
 
-   OSDPushMessage(OSDMSG_STATUS, 150, "STATE SAVED");
+   if (!save_state_quiet)
+      OSDPushMessage(OSDMSG_STATUS, 150, "STATE SAVED");
    return 0;
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
-int YabLoadStateBuffer(const void * buffer, size_t size)
+static int LoadStateFromMem(const void * buffer, size_t size, int flags)
 {
    FILE * fp;
    int status;
+   YabMemStream ms;
 
-   fp = tmpfile();
-   fwrite(buffer, 1, size, fp);
-
-   fseek(fp, 0, SEEK_SET);
-
-   ScspLockThread();
-   status = YabLoadStateStream(fp);
-   ScspUnLockThread();
+   YabMemStreamInitConst(&ms, buffer, size);
+   if ((fp = YabMemStreamOpen(&ms, "rb")) == NULL)
+   {
+      fp = tmpfile();
+      fwrite(buffer, 1, size, fp);
+      fseek(fp, 0, SEEK_SET);
+   }
 
+   status = LoadStateFromStream(fp, flags);
    fclose(fp);
 
    return status;
 }
 
+int YabLoadStateBuffer(const void * buffer, size_t size)
+{
+   return LoadStateFromMem(buffer, size, 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int YabSaveStateNoRam(YabMemStream * ms)
+{
+   return SaveStateToMem(ms, STATE_QUIET | STATE_NO_SHOT | STATE_NO_RAM);
+}
+
+int YabLoadStateNoRam(const void * buffer, size_t size)
+{
+   return LoadStateFromMem(buffer, size, STATE_QUIET | STATE_NO_RAM);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int YabLoadStateFixed(const void * buffer, size_t size)
+{
+   const u8 * p = (const u8 *)buffer;
+   int headerversion, statesize;
+   size_t total;
+
+   if (size < 0x14 || memcmp(p, "YSS", 3) != 0)
+      return -2;
+
+   // the state is followed by padding, load only what the header covers
+   memcpy(&headerversion, p + 4, 4);
+   memcpy(&statesize, p + 8, 4);
+   total = (size_t)statesize + (headerversion == 1 ? 0xC : 0x14);
+   if (statesize <= 0 || total > size)
+      return -2;
+
+   return LoadStateFromMem(buffer, total, STATE_QUIET);
+}
+
 //////////////////////////////////////////////////////////////////////////////
 
 int YabLoadState(const char *filename)
@@ -1713,10 +1989,7 @@ int YabLoadState(const char *filename)
    if ((fp = fopen_utf8(filename, "rb")) == NULL)
       return -1;
 
-   ScspLockThread();
-   status = YabLoadStateStream(fp);
-   ScspUnLockThread();
-
+   status = LoadStateFromStream(fp, 0);
    fclose(fp);
 
    return status;
@@ -1740,6 +2013,7 @@ int YabLoadStateStream(FILE *fp)
    int temp;
    u32 temp32;
 	int test_endian;
+   long othrend;
 
   yabsys.frame_count = 0;
 
@@ -1871,11 +2145,14 @@ int YabLoadStateStream(FILE *fp)
       // Revert back to old state here
       return -3;
    }
+   othrend = ftell(fp) + chunksize;
    // Other data
    //yread(&check, (void *)BupRam, 0x10000, 1, fp);
    fseek(fp, 0x10000, SEEK_CUR ); // skip this data
-   yread(&check, (void *)HighWram, 0x100000, 1, fp);
-   yread(&check, (void *)LowWram, 0x100000, 1, fp);
+   StateReadRam(&check, (void *)HighWram, 0x100000, fp);
+   StateReadRam(&check, (void *)LowWram, 0x100000, fp);
+   SH2WriteNotify(0x06000000, 0x100000);
+   SH2WriteNotify(0x00200000, 0x100000);
 
    yread(&check, (void *)&yabsys.DecilineCount, sizeof(int), 1, fp);
    yread(&check, (void *)&yabsys.LineCount, sizeof(int), 1, fp);
@@ -1896,6 +2173,9 @@ int YabLoadStateStream(FILE *fp)
 
    totalsize=outputwidth * outputheight * sizeof(u32);
 
+   // states taken without a screenshot have nothing to draw
+   if (totalsize > 0) {
+
    if ((buf = (u8 *)malloc(totalsize)) == NULL)
    {
       return -2;
@@ -1919,14 +2199,23 @@ int YabLoadStateStream(FILE *fp)
    #endif
    //YuiSwapBuffers();
    free(buf);
+   }
 
    fseek(fp, movieposition, SEEK_SET);
    MovieReadState(fp);
    }
 
+   fseek(fp, othrend, SEEK_SET);
+   if (StateCheckRetrieveHeader(fp, "SYS ", &version, &chunksize) == 0)
+   {
+      yread(&check, (void *)&yabsys.SH2CycleFrac, sizeof(u32), 1, fp);
+      yread(&check, (void *)&yabsys.UsecFrac, sizeof(u32), 1, fp);
+   }
+
    ScspUnMuteAudio(SCSP_MUTE_SYSTEM);
 
-   OSDPushMessage(OSDMSG_STATUS, 150, "STATE LOADED");
+   if (!save_state_quiet)
+      OSDPushMessage(OSDMSG_STATUS, 150, "STATE LOADED");
 
    return 0;
 }
@@ -46,6 +46,7 @@ extern "C" {
 
 #include <stdlib.h>
 #include "core.h"
+#include "memstream.h"
 
 //#define CACHE_ENABLE 0 
 
@@ -362,6 +363,9 @@ extern "C" {
   static INLINE void DummyWriteLong(Dummy UNUSED * d, u32 UNUSED a, u32 UNUSED v) {}
 
   void MappedMemoryInit(void);
+  // MappedMemoryMapFastmem: map the ram areas for the fastmem paths, once
+  // they and the cart are allocated. See fastmem.h.
+  void MappedMemoryMapFastmem(void);
   u8 FASTCALL MappedMemoryReadByte(u32 addr, u32 * cycle);
   u16 FASTCALL MappedMemoryReadWord(u32 addr, u32 * cycle);
   u16 FASTCALL MappedMemoryReadInst(u32 addr, u32 * cycle);
@@ -439,8 +443,35 @@ extern "C" {
   int YabSaveStateBuffer(void **buffer, size_t *size);
   int YabLoadStateBuffer(const void *buffer, size_t size);
 
+  int YabSaveStateMem(YabMemStream *ms, int quiet);
+
+  // Rewind's light states: everything but HighWram, LowWram, Vdp1Ram,
+  // Vdp2Ram and SoundRam, which rewind snapshots itself. Saving doesn't
+  // wait for the rendering thread, loading leaves rewind's history alone.
+  int YabSaveStateNoRam(YabMemStream *ms);
+  int YabLoadStateNoRam(const void *buffer, size_t size);
+  void StateWriteRam(IOCheck_struct *check, void *ram, size_t size, FILE *fp);
+  void StateReadRam(IOCheck_struct *check, void *ram, size_t size, FILE *fp);
+
+  // Fixed size states for libretro serialization and run-ahead. The bound is
+  // taken on the first call and kept until MappedMemoryInit, states are
+  // written straight into the caller's buffer without the screenshot and
+  // the tail is zero filled. Load takes the same buffer back.
+  size_t YabSaveStateMaxSize(void);
+  int YabSaveStateFixed(void *buffer, size_t size);
+  int YabLoadStateFixed(const void *buffer, size_t size);
+
+#define YAB_STATE_COMPRESS_ZLIB 0
+#define YAB_STATE_COMPRESS_ZSTD 1
+#define YAB_STATE_COMPRESS_LZ4  2
+
   int YabLoadCompressedState(const char *filename);
+  // YabSaveCompressedState: snapshot the machine and write filename on a
+  // thread. Returns once the snapshot is taken, YabSaveCompressedStateWait
+  // waits for the file and returns -1 if writing it failed.
   int YabSaveCompressedState(const char *filename);
+  int YabSetStateCompression(int method, int level);
+  int YabSaveCompressedStateWait(void);
 
 // Mapped mewmory
 void * YabMemMap(char * filename, u32 size );
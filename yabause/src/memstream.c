@@ -0,0 +1,305 @@
+/*
+        Copyright 2026 agent(agent@local)
+
+This file is part of YabaSanshiro.
+
+        YabaSanshiro is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+YabaSanshiro is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+along with YabaSanshiro; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*! \file memstream.c
+    \brief Growable in-memory FILE streams for save states.
+
+    The save state writers all take a FILE *, so instead of touching every
+    one of them we hand them a stdio stream whose backend is a plain heap
+    buffer (fopencookie on glibc, funopen on BSD/Darwin/bionic).
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "memstream.h"
+
+#if defined(__GLIBC__)
+#define YAB_MEMSTREAM_COOKIE 1
+#elif defined(__APPLE__) || defined(__ANDROID__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#define YAB_MEMSTREAM_FUNOPEN 1
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+
+int YabMemStreamInit(YabMemStream *ms, size_t reserve)
+{
+   ms->size = 0;
+   ms->pos = 0;
+   ms->capacity = 0;
+   ms->data = NULL;
+   ms->fixed = 0;
+
+   if (reserve == 0)
+      return 0;
+
+   if ((ms->data = (u8 *)malloc(reserve)) == NULL)
+      return -1;
+
+   ms->capacity = reserve;
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void YabMemStreamInitConst(YabMemStream *ms, const void *data, size_t size)
+{
+   ms->data = (u8 *)data;
+   ms->size = size;
+   ms->capacity = 0;
+   ms->pos = 0;
+   ms->fixed = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void YabMemStreamInitFixed(YabMemStream *ms, void *data, size_t capacity)
+{
+   ms->data = (u8 *)data;
+   ms->size = 0;
+   ms->capacity = capacity;
+   ms->pos = 0;
+   ms->fixed = 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void YabMemStreamFree(YabMemStream *ms)
+{
+   if (ms->capacity != 0 && !ms->fixed)
+      free(ms->data);
+
+   ms->data = NULL;
+   ms->size = 0;
+   ms->capacity = 0;
+   ms->pos = 0;
+   ms->fixed = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+u8 *YabMemStreamDetach(YabMemStream *ms, size_t *size)
+{
+   u8 *data = ms->data;
+
+   if (size != NULL)
+      *size = ms->size;
+
+   ms->data = NULL;
+   ms->size = 0;
+   ms->capacity = 0;
+   ms->pos = 0;
+   ms->fixed = 0;
+   return data;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int MemStreamReserve(YabMemStream *ms, size_t needed)
+{
+   size_t newcap;
+   u8 *p;
+
+   if (needed <= ms->capacity)
+      return 0;
+
+   // Read only view or caller buffer
+   if ((ms->capacity == 0 && ms->data != NULL) || ms->fixed)
+      return -1;
+
+   newcap = ms->capacity ? ms->capacity : 0x10000;
+   while (newcap < needed)
+      newcap *= 2;
+
+   if ((p = (u8 *)realloc(ms->data, newcap)) == NULL)
+      return -1;
+
+   ms->data = p;
+   ms->capacity = newcap;
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static size_t MemStreamRead(YabMemStream *ms, char *buf, size_t size)
+{
+   size_t avail;
+
+   if (ms->pos >= ms->size)
+      return 0;
+
+   avail = ms->size - ms->pos;
+   if (size > avail)
+      size = avail;
+
+   memcpy(buf, ms->data + ms->pos, size);
+   ms->pos += size;
+   return size;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static size_t MemStreamWrite(YabMemStream *ms, const char *buf, size_t size)
+{
+   if (MemStreamReserve(ms, ms->pos + size) != 0)
+      return 0;
+
+   // Seeking past the end leaves a hole, fill it the same way a file would
+   if (ms->pos > ms->size)
+      memset(ms->data + ms->size, 0, ms->pos - ms->size);
+
+   memcpy(ms->data + ms->pos, buf, size);
+   ms->pos += size;
+   if (ms->pos > ms->size)
+      ms->size = ms->pos;
+   return size;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int MemStreamSeek(YabMemStream *ms, s64 *offset, int whence)
+{
+   s64 base;
+
+   switch (whence)
+   {
+      case SEEK_SET:
+         base = 0;
+         break;
+      case SEEK_CUR:
+         base = (s64)ms->pos;
+         break;
+      case SEEK_END:
+         base = (s64)ms->size;
+         break;
+      default:
+         return -1;
+   }
+
+   if (base + *offset < 0)
+      return -1;
+
+   ms->pos = (size_t)(base + *offset);
+   *offset = (s64)ms->pos;
+   return 0;
+}
+
+#if defined(YAB_MEMSTREAM_COOKIE)
+
+static ssize_t CookieRead(void *cookie, char *buf, size_t size)
+{
+   return (ssize_t)MemStreamRead((YabMemStream *)cookie, buf, size);
+}
+
+static ssize_t CookieWrite(void *cookie, const char *buf, size_t size)
+{
+   // glibc treats a short write as an error, which is what we want on ENOMEM
+   return (ssize_t)MemStreamWrite((YabMemStream *)cookie, buf, size);
+}
+
+static int CookieSeek(void *cookie, off64_t *offset, int whence)
+{
+   s64 off = *offset;
+   int ret = MemStreamSeek((YabMemStream *)cookie, &off, whence);
+   *offset = off;
+   return ret;
+}
+
+static int CookieClose(void *cookie)
+{
+   return 0;
+}
+
+#elif defined(YAB_MEMSTREAM_FUNOPEN)
+
+static int FunRead(void *cookie, char *buf, int size)
+{
+   return (int)MemStreamRead((YabMemStream *)cookie, buf, (size_t)size);
+}
+
+static int FunWrite(void *cookie, const char *buf, int size)
+{
+   size_t ret = MemStreamWrite((YabMemStream *)cookie, buf, (size_t)size);
+   return ret == 0 && size != 0 ? -1 : (int)ret;
+}
+
+static fpos_t FunSeek(void *cookie, fpos_t offset, int whence)
+{
+   s64 off = (s64)offset;
+   if (MemStreamSeek((YabMemStream *)cookie, &off, whence) != 0)
+      return (fpos_t)-1;
+   return (fpos_t)off;
+}
+
+static int FunClose(void *cookie)
+{
+   return 0;
+}
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+
+FILE *YabMemStreamOpen(YabMemStream *ms, const char *mode)
+{
+   ms->pos = 0;
+
+#if defined(YAB_MEMSTREAM_COOKIE)
+   {
+      cookie_io_functions_t funcs;
+      funcs.read = CookieRead;
+      funcs.write = CookieWrite;
+      funcs.seek = CookieSeek;
+      funcs.close = CookieClose;
+      return fopencookie(ms, mode, funcs);
+   }
+#elif defined(YAB_MEMSTREAM_FUNOPEN)
+   return funopen(ms, FunRead, FunWrite, FunSeek, FunClose);
+#else
+   return NULL;
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int YabMemStreamReadFile(YabMemStream *ms, FILE *fp)
+{
+   char buf[0x4000];
+   size_t num_read;
+
+   ms->size = 0;
+   ms->pos = 0;
+   if (fseek(fp, 0, SEEK_SET) != 0)
+      return -1;
+
+   while ((num_read = fread(buf, 1, sizeof(buf), fp)) > 0)
+   {
+      if (MemStreamWrite(ms, buf, num_read) != num_read)
+         return -1;
+   }
+
+   ms->pos = 0;
+   return ferror(fp) ? -1 : 0;
+}
@@ -0,0 +1,74 @@
+/*
+        Copyright 2026 agent(agent@local)
+
+This file is part of YabaSanshiro.
+
+        YabaSanshiro is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+YabaSanshiro is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+along with YabaSanshiro; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*! \file memstream.h
+    \brief Growable in-memory FILE streams for save states.
+*/
+
+#ifndef MEMSTREAM_H
+#define MEMSTREAM_H
+
+#include <stdio.h>
+#include "core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+   u8 *data;
+   size_t size;      // bytes of valid data
+   size_t capacity;  // bytes allocated, 0 for a read only view
+   size_t pos;
+   int fixed;        // capacity belongs to the caller and never grows
+} YabMemStream;
+
+// YabMemStreamInit: start an empty growable buffer, reserving bytes up front
+int YabMemStreamInit(YabMemStream *ms, size_t reserve);
+
+// YabMemStreamInitConst: wrap an existing buffer for reading, no copy is made
+void YabMemStreamInitConst(YabMemStream *ms, const void *data, size_t size);
+
+// YabMemStreamInitFixed: write into a caller owned buffer of capacity bytes.
+// Writes past the end fail instead of growing it, Free leaves it alone.
+void YabMemStreamInitFixed(YabMemStream *ms, void *data, size_t capacity);
+
+// YabMemStreamFree: release the buffer if it is owned by the stream
+void YabMemStreamFree(YabMemStream *ms);
+
+// YabMemStreamDetach: hand the buffer over to the caller (free() it)
+u8 *YabMemStreamDetach(YabMemStream *ms, size_t *size);
+
+// YabMemStreamOpen: open a stdio stream backed by ms. Writes grow the buffer,
+// fseek/ftell work the same as on a regular file. Returns NULL when the
+// platform has no custom stream support; callers fall back to tmpfile().
+// The FILE must be closed before ms is freed or detached.
+FILE *YabMemStreamOpen(YabMemStream *ms, const char *mode);
+
+// YabMemStreamReadFile: replace the contents of ms with all of fp, for
+// callers that went through tmpfile(). Fails when a fixed buffer is short.
+int YabMemStreamReadFile(YabMemStream *ms, FILE *fp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
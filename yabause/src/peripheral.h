@@ -315,6 +315,8 @@ void PlayRecorder_proc( u32 framecount );
 int PlayRecorder_getStatus();
 //int PlayRecorder_getVirtualTime(time_t * t );
 void PlayRecorder_setPlayMode( const char * dir, yabauseinit_struct *init  );
+// 0 keeps emulating with the last input when a played recording ends
+void PlayRecorder_setExitOnFinish( int enable );
 
 #if defined (__cplusplus)
 }
@@ -194,5 +194,19 @@ void ProfileReset (void) {
   Init () ;
 }
 
+/* Number of tags seen since the last reset */
+int ProfileCount (void) {
+  return g_init ? g_i_hwm : 0 ;
+}
+
+/* Returns the entry with the given index, or 0 if there is none.
+   l_total_ms is in clock ticks, divide by CLOCKS_PER_SEC. */
+const entry_t* ProfileEntry (int i_index) {
+  if (i_index < 0 || i_index >= ProfileCount ()) {
+    return 0 ;
+  }
+  return &g_tag [i_index] ;
+}
+
 #endif /* !SYS_PROFILE_H && !DONT_PROFILE */
 
@@ -54,6 +54,10 @@ void ProfileStop (char* str_tag) ;
 void ProfilePrint (void) ;
 /* Resets the profiler. */
 void ProfileReset (void) ;
+/* Number of tags seen since the last reset */
+int ProfileCount (void) ;
+/* Entry for the given index, 0 if out of range */
+const entry_t* ProfileEntry (int i_index) ;
 
 #ifdef __cplusplus
 }
@@ -25,6 +25,7 @@
 #include "ui/UIYabause.h"
 
 #include "../peripheral.h"
+#include "../rewind.h"
 
 #ifdef HAVE_VULKAN
 #include "vulkan/VIDVulkan.h"
@@ -218,6 +219,9 @@ void YabauseThread::initEmulation()
 #endif	
 	mInit = YabauseInit( &mYabauseConf );
 	SetOSDToggle(showFPS);
+
+	if ( mInit == 0 && vs->value( "General/Rewind", false ).toBool() )
+		RewindInit( 0, 0 );
 }
 
 
@@ -632,6 +636,7 @@ void YabauseThread::reloadSettings()
 
 
   mYabauseConf.use_sh2_cache = vs->value("General/UseSh2Cache", true).toBool()?1:0 ;
+  mYabauseConf.use_sh2_block_cache = vs->value("General/UseSh2BlockCache", false).toBool()?1:0 ;
 
 	reloadClock();
 	reloadControllers();
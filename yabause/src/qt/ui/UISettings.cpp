@@ -650,6 +650,7 @@ void UISettings::loadSettings()
    cbUseComputeShader->setChecked(s->value("Video/UseComputeShader",1).toBool());
 
    cbSh2Cache->setChecked(s->value("General/UseSh2Cache", true).toBool());
+   cbRewind->setChecked(s->value("General/Rewind", false).toBool());
 
 	// sound
 	cbSoundCore->setCurrentIndex( cbSoundCore->findData( s->value( "Sound/SoundCore", QtYabause::defaultSNDCore().id ).toInt() ) );
@@ -762,6 +763,7 @@ void UISettings::saveSettings()
   s->setValue("Video/RotateScreen", cbRotateScreen->isChecked());
 
   s->setValue("General/UseSh2Cache", cbSh2Cache->isChecked());
+  s->setValue("General/Rewind", cbRewind->isChecked());
   
   
 
@@ -41,6 +41,7 @@
 #include "../YabauseGL.h"
 #include "../QtYabause.h"
 #include "../CommonDialogs.h"
+#include "../../rewind.h"
 
 #include "PlayRecorder.h"
 
@@ -1431,6 +1432,13 @@ void UIYabause::on_aEmulationPause_triggered()
 void UIYabause::on_aEmulationReset_triggered()
 { mYabauseThread->resetEmulation(); }
 
+// steps back one second per press, enabled with General/Rewind
+void UIYabause::on_aEmulationRewind_triggered()
+{
+	YabauseLocker locker( mYabauseThread );
+	RewindStepBack( 60 );
+}
+
 void UIYabause::on_aEmulationFrameSkipLimiter_toggled( bool toggled )
 {
 	Settings* vs = QtYabause::settings();
@@ -1698,6 +1706,7 @@ void UIYabause::pause( bool paused )
 	aEmulationRun->setEnabled( paused );
 	aEmulationPause->setEnabled( !paused );
 	aEmulationReset->setEnabled( !paused );
+	aEmulationRewind->setEnabled( !paused && RewindIsEnabled() );
 	if (VIDCore && VIDCore->id == VIDCORE_OGL) {
 		mYabauseGL->updateView();
 		mYabauseGL->update();
@@ -1766,7 +1775,8 @@ void UIYabause::on_actionTo_Cloud_triggered()
 
   const char* gamecode = Cs2GetCurrentGmaecode();
 
-  if (YabSaveCompressedState(sdatapath.c_str()) == -1) {
+  // the file is uploaded right away, it has to be written first
+  if (YabSaveCompressedState(sdatapath.c_str()) == -1 || YabSaveCompressedStateWait() == -1) {
     return;
   }
   
@@ -211,6 +211,7 @@ protected slots:
 	void on_aEmulationRun_triggered();
 	void on_aEmulationPause_triggered();
 	void on_aEmulationReset_triggered();
+	void on_aEmulationRewind_triggered();
 	void on_aEmulationFrameSkipLimiter_toggled( bool toggled );
   void on_actionRecord_triggered();
   void on_actionPlay_triggered();
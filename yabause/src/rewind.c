@@ -0,0 +1,502 @@
+/*
+        Copyright 2026 agent(agent@local)
+
+This file is part of YabaSanshiro.
+
+        YabaSanshiro is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+YabaSanshiro is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+along with YabaSanshiro; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*! \file rewind.c
+    \brief Rewind ring buffer built on delta encoded snapshots.
+
+    A snapshot is the big RAM areas (work RAM, VDP1/VDP2 VRAM, sound RAM)
+    read straight from memory, followed by a light save state that leaves
+    them out (YabSaveStateNoRam). It is cut into REWIND_PAGE_SIZE pages and
+    each page is compared with the previous snapshot; unchanged pages are
+    skipped and the rest are XORed and run length encoded, so a frame only
+    costs what the game actually touched. Every keyframe_interval snapshots
+    a keyframe (delta against zero) is stored so old snapshots can be
+    dropped without breaking the chain.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "rewind.h"
+#include "memory.h"
+#include "debug.h"
+#include "scsp.h"
+#include "vdp1.h"
+#include "vdp2.h"
+
+#define REWIND_MAX_ENTRIES 8192
+
+// RLE tokens: bit 15 set is a run of zero bytes, otherwise that many
+// literal bytes follow
+#define RLE_ZERO_RUN 0x8000
+#define RLE_MAX_RUN  0x7FFF
+
+typedef struct
+{
+   u8 **ram;
+   u32 size;
+} RewindRegion;
+
+// Snapshotted in this order, ahead of the light state. The sizes are
+// multiples of REWIND_PAGE_SIZE.
+static const RewindRegion regions[] = {
+   { &HighWram, 0x100000 },
+   { &LowWram, 0x100000 },
+   { &Vdp1Ram, 0x80000 },
+   { &Vdp2Ram, 0x80000 },
+   { &SoundRam, 0x80000 },
+};
+
+#define REWIND_NUM_REGIONS (int)(sizeof(regions) / sizeof(regions[0]))
+#define REWIND_RAM_SIZE    0x380000
+
+typedef struct
+{
+   int keyframe;
+   u32 state_size;
+   u32 size;
+   u8 *data;    // [u32 page][u32 length][rle bytes] records
+} RewindEntry;
+
+static struct
+{
+   int enabled;
+   u64 budget;
+   int keyframe_interval;
+   RewindEntry *entries;
+   int head;            // oldest entry
+   int count;
+   int since_keyframe;
+   u64 bytes;
+   YabMemStream cur;    // scratch for the light state being captured
+   u8 *prev;            // raw copy of the most recent snapshot
+   u32 prev_size;
+   u32 prev_capacity;
+   u8 *encode_buf;
+   u32 encode_capacity;
+   u32 last_encoded;
+} rw;
+
+//////////////////////////////////////////////////////////////////////////////
+
+static u32 RleEncode(const u8 *src, u32 len, u8 *out)
+{
+   u32 i = 0, o = 0;
+
+   while (i < len)
+   {
+      u32 j = i;
+      u16 token;
+
+      if (src[i] == 0)
+      {
+         while (j < len && src[j] == 0 && j - i < RLE_MAX_RUN)
+            j++;
+         token = RLE_ZERO_RUN | (u16)(j - i);
+         memcpy(out + o, &token, 2);
+         o += 2;
+      }
+      else
+      {
+         // Stop a literal run on a pair of zeros, a single one isn't worth it
+         while (j < len && j - i < RLE_MAX_RUN && !(src[j] == 0 && j + 1 < len && src[j + 1] == 0))
+            j++;
+         token = (u16)(j - i);
+         memcpy(out + o, &token, 2);
+         memcpy(out + o + 2, src + i, j - i);
+         o += 2 + (j - i);
+      }
+      i = j;
+   }
+
+   return o;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int RleXorDecode(const u8 *src, u32 len, u8 *dst, u32 dstlen)
+{
+   u32 i = 0, o = 0;
+
+   while (i < len)
+   {
+      u16 token;
+      u32 n;
+
+      memcpy(&token, src + i, 2);
+      i += 2;
+      n = token & RLE_MAX_RUN;
+
+      if (o + n > dstlen)
+         return -1;
+
+      if (!(token & RLE_ZERO_RUN))
+      {
+         u32 k;
+         if (i + n > len)
+            return -1;
+         for (k = 0; k < n; k++)
+            dst[o + k] ^= src[i + k];
+         i += n;
+      }
+      o += n;
+   }
+
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static u32 EncodeWorstCase(u32 size)
+{
+   u32 pages = (size + REWIND_PAGE_SIZE - 1) / REWIND_PAGE_SIZE;
+   // header plus one token per RLE_MAX_RUN bytes, and literal/zero alternation
+   return pages * (8 + REWIND_PAGE_SIZE + (REWIND_PAGE_SIZE / 2) * 2);
+}
+
+// Encode len bytes of cur, found at offset in the snapshot, against the
+// previous snapshot (or against zero for a keyframe) and bring the copy in
+// prev up to date. Only pages that changed are copied.
+static u32 EncodePages(const u8 *cur, u32 offset, u32 len, int keyframe, u8 *out)
+{
+   u8 xorbuf[REWIND_PAGE_SIZE];
+   u32 start, o = 0;
+
+   for (start = 0; start < len; start += REWIND_PAGE_SIZE)
+   {
+      u32 plen = len - start < REWIND_PAGE_SIZE ? len - start : REWIND_PAGE_SIZE;
+      u32 page = (offset + start) / REWIND_PAGE_SIZE;
+      const u8 *src = cur + start;
+      u8 *prev = rw.prev + offset + start;
+      u32 k, enc;
+
+      if (keyframe)
+      {
+         static const u8 zero[REWIND_PAGE_SIZE];
+
+         if (src != prev)
+            memcpy(prev, src, plen);
+         if (memcmp(src, zero, plen) == 0)
+            continue;
+         enc = RleEncode(src, plen, out + o + 8);
+      }
+      else
+      {
+         if (memcmp(src, prev, plen) == 0)
+            continue;
+         for (k = 0; k < plen; k++)
+            xorbuf[k] = src[k] ^ prev[k];
+         memcpy(prev, src, plen);
+         enc = RleEncode(xorbuf, plen, out + o + 8);
+      }
+
+      memcpy(out + o, &page, 4);
+      memcpy(out + o + 4, &enc, 4);
+      o += 8 + enc;
+   }
+
+   return o;
+}
+
+static u32 EncodeSnapshot(int keyframe)
+{
+   u32 offset = 0, o = 0;
+   int i;
+
+   for (i = 0; i < REWIND_NUM_REGIONS; i++)
+   {
+      o += EncodePages(*regions[i].ram, offset, regions[i].size, keyframe, rw.encode_buf + o);
+      offset += regions[i].size;
+   }
+
+   return o + EncodePages(rw.cur.data, offset, (u32)rw.cur.size, keyframe, rw.encode_buf + o);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int DeltaApply(const RewindEntry *entry, u8 *state)
+{
+   u32 i = 0;
+
+   if (entry->keyframe)
+      memset(state, 0, entry->state_size);
+
+   while (i < entry->size)
+   {
+      u32 page, len, start, plen;
+
+      memcpy(&page, entry->data + i, 4);
+      memcpy(&len, entry->data + i + 4, 4);
+      i += 8;
+
+      start = page * REWIND_PAGE_SIZE;
+      if (start >= entry->state_size || i + len > entry->size)
+         return -1;
+      plen = entry->state_size - start < REWIND_PAGE_SIZE ? entry->state_size - start : REWIND_PAGE_SIZE;
+
+      if (RleXorDecode(entry->data + i, len, state + start, plen) != 0)
+         return -1;
+      i += len;
+   }
+
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static RewindEntry *EntryAt(int index)
+{
+   return &rw.entries[(rw.head + index) % REWIND_MAX_ENTRIES];
+}
+
+static void DropOldest(void)
+{
+   RewindEntry *e = EntryAt(0);
+   rw.bytes -= e->size;
+   free(e->data);
+   e->data = NULL;
+   rw.head = (rw.head + 1) % REWIND_MAX_ENTRIES;
+   rw.count--;
+}
+
+static void DropNewest(void)
+{
+   RewindEntry *e = EntryAt(rw.count - 1);
+   rw.bytes -= e->size;
+   free(e->data);
+   e->data = NULL;
+   rw.count--;
+}
+
+// Deltas are useless without their keyframe, so eviction works a whole
+// keyframe group at a time
+static void EvictForSpace(u32 needed)
+{
+   while (rw.count > 0 && (rw.bytes + needed > rw.budget || rw.count >= REWIND_MAX_ENTRIES))
+   {
+      DropOldest();
+      while (rw.count > 0 && !EntryAt(0)->keyframe)
+         DropOldest();
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int RewindInit(u32 budget, int keyframe_interval)
+{
+   RewindDeInit();
+
+   if ((rw.entries = (RewindEntry *)calloc(REWIND_MAX_ENTRIES, sizeof(RewindEntry))) == NULL)
+      return -1;
+
+   rw.budget = budget ? budget : REWIND_DEFAULT_BUDGET;
+   rw.keyframe_interval = keyframe_interval > 0 ? keyframe_interval : REWIND_DEFAULT_KEYFRAME;
+   YabMemStreamInit(&rw.cur, 0);
+   rw.enabled = 1;
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void RewindDeInit(void)
+{
+   RewindReset();
+   free(rw.entries);
+   YabMemStreamFree(&rw.cur);
+   free(rw.prev);
+   free(rw.encode_buf);
+   memset(&rw, 0, sizeof(rw));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int RewindIsEnabled(void)
+{
+   return rw.enabled;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void RewindReset(void)
+{
+   while (rw.count > 0)
+      DropOldest();
+   rw.head = 0;
+   rw.bytes = 0;
+   rw.prev_size = 0;
+   rw.since_keyframe = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int ReserveBuffers(u32 size)
+{
+   u32 worst = EncodeWorstCase(size);
+
+   if (size > rw.prev_capacity)
+   {
+      u8 *p = (u8 *)realloc(rw.prev, size);
+      if (p == NULL)
+         return -1;
+      rw.prev = p;
+      rw.prev_capacity = size;
+   }
+   if (worst > rw.encode_capacity)
+   {
+      u8 *p = (u8 *)realloc(rw.encode_buf, worst);
+      if (p == NULL)
+         return -1;
+      rw.encode_buf = p;
+      rw.encode_capacity = worst;
+   }
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int RewindCapture(void)
+{
+   RewindEntry *e;
+   u32 size, enc;
+   int keyframe;
+
+   if (!rw.enabled)
+      return -1;
+
+   // The sound thread is parked at the start of a frame, keep it there
+   // while sound RAM is read. The light state takes the lock again.
+   ScspLockThread();
+
+   if (YabSaveStateNoRam(&rw.cur) != 0 || ReserveBuffers(REWIND_RAM_SIZE + (u32)rw.cur.size) != 0)
+   {
+      ScspUnLockThread();
+      return -1;
+   }
+
+   size = REWIND_RAM_SIZE + (u32)rw.cur.size;
+   keyframe = rw.count == 0 || rw.prev_size != size || rw.since_keyframe >= rw.keyframe_interval;
+   enc = EncodeSnapshot(keyframe);
+   rw.prev_size = size;
+
+   ScspUnLockThread();
+
+   EvictForSpace(enc);
+   if (rw.count == 0 && !keyframe)
+   {
+      // The whole chain was evicted, start over from a keyframe
+      keyframe = 1;
+      enc = EncodePages(rw.prev, 0, size, 1, rw.encode_buf);
+   }
+   if (enc > rw.budget)
+   {
+      LOG("rewind: budget too small for a single snapshot\n");
+      RewindReset();
+      return -1;
+   }
+
+   e = EntryAt(rw.count);
+   if ((e->data = (u8 *)malloc(enc ? enc : 1)) == NULL)
+   {
+      // prev already holds this snapshot, the chain can't go on from it
+      RewindReset();
+      return -1;
+   }
+   memcpy(e->data, rw.encode_buf, enc);
+   e->size = enc;
+   e->state_size = size;
+   e->keyframe = keyframe;
+   rw.count++;
+   rw.bytes += enc;
+   rw.last_encoded = enc;
+   rw.since_keyframe = keyframe ? 1 : rw.since_keyframe + 1;
+
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int RewindStepBack(int frames)
+{
+   int target, key, i, status;
+   u32 size, offset;
+
+   if (!rw.enabled || rw.count == 0 || frames < 0)
+      return -1;
+
+   if (frames > rw.count - 1)
+      frames = rw.count - 1;
+   target = rw.count - 1 - frames;
+
+   for (key = target; key > 0 && !EntryAt(key)->keyframe; key--);
+
+   size = EntryAt(target)->state_size;
+   if (ReserveBuffers(size) != 0)
+      return -1;
+
+   for (i = key; i <= target; i++)
+   {
+      if (DeltaApply(EntryAt(i), rw.prev) != 0)
+      {
+         RewindReset();
+         return -1;
+      }
+   }
+   rw.prev_size = size;
+
+   // RAM first, under the locks the state loader takes too, then the light
+   // state whose loaders flush what was cached from that RAM
+   VdpQuiesce();
+   ScspLockThread();
+   for (i = 0, offset = 0; i < REWIND_NUM_REGIONS; i++)
+   {
+      memcpy(*regions[i].ram, rw.prev + offset, regions[i].size);
+      offset += regions[i].size;
+   }
+   status = YabLoadStateNoRam(rw.prev + REWIND_RAM_SIZE, size - REWIND_RAM_SIZE);
+   ScspUnLockThread();
+
+   if (status != 0)
+   {
+      RewindReset();
+      return -1;
+   }
+
+   while (rw.count > target + 1)
+      DropNewest();
+
+   rw.since_keyframe = target - key + 1;
+   return frames;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void RewindGetStats(RewindStats *stats)
+{
+   int i;
+
+   memset(stats, 0, sizeof(*stats));
+   stats->frames = rw.count;
+   stats->bytes = rw.bytes;
+   stats->budget = rw.budget;
+   stats->last_encoded = rw.last_encoded;
+   stats->state_size = rw.prev_size;
+   for (i = 0; i < rw.count; i++)
+      stats->keyframes += EntryAt(i)->keyframe;
+}
@@ -0,0 +1,73 @@
+/*
+        Copyright 2026 agent(agent@local)
+
+This file is part of YabaSanshiro.
+
+        YabaSanshiro is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+YabaSanshiro is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+along with YabaSanshiro; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*! \file rewind.h
+    \brief Rewind ring buffer built on delta encoded snapshots.
+*/
+
+#ifndef REWIND_H
+#define REWIND_H
+
+#include "core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define REWIND_DEFAULT_BUDGET     (64 * 1024 * 1024)
+#define REWIND_DEFAULT_KEYFRAME   60
+#define REWIND_PAGE_SIZE          4096
+
+typedef struct
+{
+   u32 frames;         // snapshots currently held
+   u32 keyframes;
+   u64 bytes;          // encoded bytes held, always <= budget
+   u64 budget;
+   u32 last_encoded;   // size of the most recent snapshot after encoding
+   u32 state_size;     // size of a raw snapshot, RAM areas plus light state
+} RewindStats;
+
+// RewindInit: enable rewind with a memory budget in bytes and a keyframe
+// every keyframe_interval snapshots. YabauseEmulate then captures one
+// snapshot at the start of every frame.
+int RewindInit(u32 budget, int keyframe_interval);
+void RewindDeInit(void);
+int RewindIsEnabled(void);
+
+// RewindCapture: take one snapshot, only needed when driving it by hand
+int RewindCapture(void);
+
+// RewindStepBack: restore the snapshot taken frames captures ago (0 is the
+// most recent one). Newer snapshots are dropped. Returns the number of frames
+// actually stepped back or -1 on error.
+int RewindStepBack(int frames);
+
+// RewindReset: drop every snapshot. YabauseReset and the YabLoadState*
+// functions call it, the history belongs to the machine they replaced.
+void RewindReset(void);
+
+void RewindGetStats(RewindStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
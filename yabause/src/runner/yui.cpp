@@ -29,8 +29,15 @@ extern "C"
 #include "../vidsoft.h"
 #include "../vdp2.h"
 #include "../titan/titan.h"
+#include "../memory.h"
+#include "../profile.h"
+#include "../trace.h"
 #ifdef _MSC_VER
 #include <Windows.h>
+#include <Psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
 #endif
 
 extern u8 *vdp1backframebuffer;
@@ -57,6 +64,14 @@ extern "C"
 {
    SH2Interface_struct *SH2CoreList[] = {
       &SH2Interpreter,
+      &SH2DebugInterpreter,
+   #ifdef SH2_DYNAREC
+      &SH2Dynarec,
+   #endif
+   #if DYNAREC_DEVMIYAX
+      &SH2Dyn,
+      &SH2DynDebug,
+   #endif
       NULL
    };
 
@@ -89,9 +104,22 @@ extern "C"
    #endif
    #ifdef HAVE_Q68
       &M68KQ68,
+   #endif
+   #ifdef HAVE_MUSASHI
+      &M68KMusashi,
    #endif
       NULL
    };
+
+   // used by PlayRecorder when a recording is played
+   static const char *backup_path = NULL;
+
+   int YabauseThread_IsUseBios() { return 0; }
+   const char * YabauseThread_getBackupPath() { return backup_path; }
+   void YabauseThread_setUseBios(int use) { }
+   void YabauseThread_setBackupPath(const char * buf) { backup_path = buf; }
+   void YabauseThread_coldBoot() { }
+   void YabauseThread_resetPlaymode() { backup_path = NULL; }
 }
 
 struct ConsoleColor
@@ -331,7 +359,7 @@ int go_to_next_test(int &current_test, std::string filename, yabauseinit_struct
       return -1;
 
    MappedMemoryLoadExec(filename.c_str(), 0);
-   MappedMemoryWriteByte(VDP2_VRAM + AUTO_TEST_SELECT_ADDRESS, current_test);
+   MappedMemoryWriteByte(VDP2_VRAM + AUTO_TEST_SELECT_ADDRESS, current_test, NULL);
 
    return 1;
 }
@@ -811,7 +839,7 @@ namespace yabauseut
          return -1;
 
       MappedMemoryLoadExec(yabause_ut_filename.c_str(), 0);
-      MappedMemoryWriteByte(VDP2_VRAM + AUTO_TEST_SELECT_ADDRESS, current_test);
+      MappedMemoryWriteByte(VDP2_VRAM + AUTO_TEST_SELECT_ADDRESS, current_test, NULL);
 
       bool write_images = false;
 
@@ -829,7 +857,7 @@ namespace yabauseut
          //emulate a frame
          PERCore->HandleEvents();
 
-         status = MappedMemoryReadByteNoCache(VDP2_VRAM + AUTO_TEST_STATUS_ADDRESS);
+         status = MappedMemoryReadByteNocache(VDP2_VRAM + AUTO_TEST_STATUS_ADDRESS, NULL);
 
          if (status == AUTO_TEST_MESSAGE_SENT)
          {
@@ -898,7 +926,7 @@ namespace yabauseut
                   return -1;
 
                MappedMemoryLoadExec(yabause_ut_filename.c_str() , 0);
-               MappedMemoryWriteByte(VDP2_VRAM + AUTO_TEST_SELECT_ADDRESS, current_test);
+               MappedMemoryWriteByte(VDP2_VRAM + AUTO_TEST_SELECT_ADDRESS, current_test, NULL);
 
                go_to_next_test(current_test, yabause_ut_filename, yinit);
 
@@ -974,19 +1002,336 @@ namespace yabauseut
                printf("Unrecognized message type: %s\n", message);
             }
 
-            MappedMemoryWriteByte(VDP2_VRAM + AUTO_TEST_STATUS_ADDRESS, AUTO_TEST_MESSAGE_RECEIVED);
+            MappedMemoryWriteByte(VDP2_VRAM + AUTO_TEST_STATUS_ADDRESS, AUTO_TEST_MESSAGE_RECEIVED, NULL);
          }
       }
       return stats.regressions || stats.screenshot.diffs;
    }
 }
 
+namespace benchmark
+{
+   struct Options
+   {
+      std::string image;
+      int frames;
+      std::string record;
+      std::string state;
+      std::string output;
+      std::string trace;
+      int sh2;
+      int m68k;
+      int video;
+      bool profile;
+      bool ssh2_thread;
+      u32 ssh2_quantum;
+      bool fastmem;
+   };
+
+   // FNV-1a
+   u64 hash(const u8 * data, u32 size)
+   {
+      u64 h = 14695981039346656037ULL;
+
+      for (u32 i = 0; i < size; i++)
+      {
+         h ^= data[i];
+         h *= 1099511628211ULL;
+      }
+
+      return h;
+   }
+
+   std::string hash_string(u64 h)
+   {
+      char str[17];
+      sprintf(str, "%016llx", (unsigned long long)h);
+      return str;
+   }
+
+   std::string json_string(const std::string input)
+   {
+      std::string result = "\"";
+
+      for (size_t i = 0; i < input.size(); i++)
+      {
+         char c = input[i];
+
+         if (c == '"' || c == '\\')
+            result += '\\';
+
+         if ((unsigned char)c < 0x20)
+            result += ' ';
+         else
+            result += c;
+      }
+
+      return result + "\"";
+   }
+
+   // in kilobytes
+   long peak_rss()
+   {
+#ifdef _MSC_VER
+      PROCESS_MEMORY_COUNTERS counters;
+
+      if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+         return 0;
+
+      return (long)(counters.PeakWorkingSetSize / 1024);
+#else
+      struct rusage usage;
+
+      if (getrusage(RUSAGE_SELF, &usage) != 0)
+         return 0;
+#ifdef __APPLE__
+      return (long)(usage.ru_maxrss / 1024);
+#else
+      return (long)usage.ru_maxrss;
+#endif
+#endif
+   }
+
+   bool parse_options(const std::vector<std::string> & args, Options & options)
+   {
+      options.image = args.at(2);
+      options.frames = string_to_int(args.at(3));
+      options.sh2 = SH2CORE_INTERPRETER;
+      options.m68k = M68KCORE_C68K;
+      options.video = VIDCORE_SOFT;
+      options.profile = false;
+      options.ssh2_thread = false;
+      options.ssh2_quantum = 0;
+      options.fastmem = false;
+
+      if (options.frames <= 0)
+      {
+         std::cout << "The frame count must be above 0." << std::endl;
+         return false;
+      }
+
+      for (size_t i = 4; i < args.size(); i++)
+      {
+         size_t equals = args.at(i).find('=');
+
+         if (equals == std::string::npos)
+         {
+            std::cout << "Benchmark options are key=value, found " << args.at(i) << std::endl;
+            return false;
+         }
+
+         std::string key = args.at(i).substr(0, equals);
+         std::string value = args.at(i).substr(equals + 1);
+
+         if (key == "record")
+            options.record = value;
+         else if (key == "state")
+            options.state = value;
+         else if (key == "output")
+            options.output = value;
+         else if (key == "trace")
+            options.trace = value;
+         else if (key == "bios")
+            bios = strdup(value.c_str());
+         else if (key == "sh2")
+            options.sh2 = string_to_int(value);
+         else if (key == "m68k")
+            options.m68k = string_to_int(value);
+         else if (key == "video")
+            options.video = string_to_int(value);
+         else if (key == "profile")
+            options.profile = string_to_int(value) != 0;
+         else if (key == "ssh2thread")
+            options.ssh2_thread = string_to_int(value) != 0;
+         else if (key == "ssh2quantum")
+            options.ssh2_quantum = string_to_int(value);
+         else if (key == "fastmem")
+            options.fastmem = string_to_int(value) != 0;
+         else
+         {
+            std::cout << "Unknown benchmark option " << key << std::endl;
+            return false;
+         }
+      }
+
+      if (!options.record.empty() && !options.state.empty())
+      {
+         std::cout << "Use either a recording or a save state, not both." << std::endl;
+         return false;
+      }
+
+      return true;
+   }
+
+   int init(const Options & options)
+   {
+      yabauseinit_struct yinit = { 0 };
+
+      yinit.percoretype = PERCORE_DUMMY;
+      yinit.sh2coretype = options.sh2;
+      yinit.vidcoretype = options.video;
+      yinit.m68kcoretype = options.m68k;
+      yinit.sndcoretype = SNDCORE_DUMMY;
+      yinit.cdcoretype = CDCORE_ISO;
+      yinit.carttype = CART_NONE;
+      yinit.regionid = REGION_AUTODETECT;
+      yinit.biospath = emulate_bios ? NULL : bios;
+      yinit.cdpath = options.image.c_str();
+      yinit.buppath = NULL;
+      yinit.mpegpath = NULL;
+      yinit.cartpath = NULL;
+      yinit.frameskip = 0;
+      yinit.framelimit = 1;
+      yinit.videoformattype = VIDEOFORMATTYPE_NTSC;
+      // the same clock every run, a recording sets its own on the first frame
+      yinit.clocksync = 1;
+      yinit.basetime = 946684800;
+      yinit.skip_load = 0;
+      yinit.numthreads = 0;
+      yinit.usethreads = 0;
+      yinit.use_new_scsp = 1;
+      yinit.use_ssh2_thread = options.ssh2_thread;
+      yinit.ssh2_quantum = options.ssh2_quantum;
+      yinit.use_fastmem = options.fastmem;
+      yinit.playRecordPath = options.record.empty() ? NULL : options.record.c_str();
+
+      if (!options.record.empty())
+         PlayRecorder_setExitOnFinish(0);
+
+      if (YabauseInit(&yinit) != 0)
+         return -1;
+
+      if (!options.state.empty() && YabLoadState(options.state.c_str()) != 0)
+      {
+         std::cout << "Couldn't load " << options.state << std::endl;
+         return -1;
+      }
+
+      return 0;
+   }
+
+   void write_results(FILE * fp, const Options & options, double seconds, const std::string framebuffer_hash)
+   {
+      fprintf(fp, "{\n");
+      fprintf(fp, "   \"image\": %s,\n", json_string(options.image).c_str());
+      if (!options.record.empty())
+         fprintf(fp, "   \"record\": %s,\n", json_string(options.record).c_str());
+      if (!options.state.empty())
+         fprintf(fp, "   \"state\": %s,\n", json_string(options.state).c_str());
+      fprintf(fp, "   \"cores\": { \"sh2\": %s, \"m68k\": %s, \"video\": %s },\n",
+         json_string(SH2Core->Name).c_str(), json_string(M68K->Name).c_str(), json_string(VIDCore->Name).c_str());
+      fprintf(fp, "   \"ssh2_thread\": %s,\n", yabsys.use_ssh2_thread ? "true" : "false");
+      fprintf(fp, "   \"fastmem\": %s,\n", yabsys.use_fastmem ? "true" : "false");
+      fprintf(fp, "   \"frames\": %d,\n", options.frames);
+      fprintf(fp, "   \"seconds\": %.3f,\n", seconds);
+      fprintf(fp, "   \"fps\": %.2f,\n", seconds > 0 ? options.frames / seconds : 0.0);
+
+      // process cpu time of every PROFILE_START/PROFILE_STOP tag in YabauseEmulate
+      fprintf(fp, "   \"profile\": {");
+#ifndef DONT_PROFILE
+      for (int i = 0; options.profile && i < ProfileCount(); i++)
+      {
+         const entry_t * entry = ProfileEntry(i);
+
+         fprintf(fp, "%s\n      %s: { \"calls\": %d, \"ms\": %.1f }", i ? "," : "",
+            json_string(entry->str_name).c_str(), entry->i_calls,
+            (double)entry->l_total_ms * 1000.0 / CLOCKS_PER_SEC);
+      }
+      if (options.profile && ProfileCount())
+         fprintf(fp, "\n   ");
+#endif
+      fprintf(fp, "},\n");
+
+      fprintf(fp, "   \"peak_rss_kb\": %ld,\n", peak_rss());
+      fprintf(fp, "   \"hashes\": {\n");
+      fprintf(fp, "      \"framebuffer\": %s,\n", framebuffer_hash.empty() ? "null" : json_string(framebuffer_hash).c_str());
+      fprintf(fp, "      \"low_wram\": \"%s\",\n", hash_string(hash(LowWram, 0x100000)).c_str());
+      fprintf(fp, "      \"high_wram\": \"%s\",\n", hash_string(hash(HighWram, 0x100000)).c_str());
+      fprintf(fp, "      \"vdp1_ram\": \"%s\",\n", hash_string(hash(Vdp1Ram, 0x80000)).c_str());
+      fprintf(fp, "      \"vdp2_ram\": \"%s\",\n", hash_string(hash(Vdp2Ram, 0x80000)).c_str());
+      fprintf(fp, "      \"sound_ram\": \"%s\"\n", hash_string(hash(SoundRam, 0x80000)).c_str());
+      fprintf(fp, "   }\n");
+      fprintf(fp, "}\n");
+   }
+
+   int start(const std::vector<std::string> & args)
+   {
+      Options options;
+
+      if (!parse_options(args, options))
+         return 1;
+
+      if (init(options) != 0)
+      {
+         std::cout << "Couldn't init " << options.image << std::endl;
+         return 1;
+      }
+
+      // the tags cost time of their own, so they are only on when asked for
+      if (options.profile)
+         YabauseSetProfiling(1);
+      if (!options.trace.empty())
+         TraceStart();
+
+      s64 ticks = YabauseGetTicks();
+
+      for (int i = 0; i < options.frames; i++)
+         PERCore->HandleEvents();
+
+      double seconds = (double)(YabauseGetTicks() - ticks) / (double)yabsys.tickfreq;
+
+      YabauseSetProfiling(0);
+      TraceStop();
+
+      if (!options.trace.empty() && TraceWriteChrome(options.trace.c_str()) != 0)
+         std::cout << "Couldn't write " << options.trace << std::endl;
+
+      // the composited screen, only the software renderer draws one here
+      std::string framebuffer_hash;
+
+      if (VIDCore->id == VIDCORE_SOFT)
+      {
+         int width = 0, height = 0;
+         pixel_t * runner_dispbuffer = (pixel_t*)calloc(1, sizeof(pixel_t) * 704 * 512);
+
+         TitanGetResolution(&width, &height);
+         TitanRender(runner_dispbuffer);
+         framebuffer_hash = hash_string(hash((u8*)runner_dispbuffer, sizeof(pixel_t) * width * height));
+
+         free(runner_dispbuffer);
+      }
+
+      FILE * fp = stdout;
+
+      if (!options.output.empty())
+      {
+         fp = fopen(options.output.c_str(), "w");
+
+         if (fp == NULL)
+         {
+            std::cout << "Couldn't write " << options.output << std::endl;
+            return 1;
+         }
+      }
+
+      write_results(fp, options, seconds, framebuffer_hash);
+
+      if (fp != stdout)
+         fclose(fp);
+
+      YabauseDeInit();
+
+      return 0;
+   }
+}
+
 //usage
 //no spaces in paths allowed, include final / on directories
 //yabause game check game_data_file path_file screenshot_path fail_path
 //yabause game dump game_data_file path_file output_path
 //yabause yabauseut check yabause_ut_binary_path screenshot_path framebuffer_path
 //yabause yabauseut dump yabause_ut_binary_path output_path
+//yabause bench disc_image frames [record=dir] [state=file] [bios=file] [sh2=id] [m68k=id] [video=id] [profile=1] [trace=file] [ssh2thread=1] [ssh2quantum=cycles] [fastmem=1] [output=file]
 int main(int argc, char *argv[])
 {
    int i = 0;
@@ -1004,6 +1349,12 @@ int main(int argc, char *argv[])
       return false;
    }
 
+   if (args.at(1) == "bench")
+   {
+      //benchmark mode, prints json results
+      return benchmark::start(args);
+   }
+
    if (args.size() > 7)
    {
       std::cout << "Too many command line arguments." << std::endl;
@@ -119,6 +119,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 #include "scsp.h"
 #include "scspdsp.h"
 #include "threads.h"
+#include "trace.h"
 #include <atomic>
 
 #ifndef max
@@ -1446,6 +1447,93 @@ int get_sdl_shift(int sdl)
 
 
 
+static int new_scsp_slot_skip = 1;
+
+void scsp_set_slot_skip(int enable)
+{
+   new_scsp_slot_skip = enable;
+}
+
+//direct and effect send of one slot, what generate_sample adds after its
+//sound stack write
+static void mix_slot(struct Scsp * s, int slot_num, s16 output, s32 * outl32, s32 * outr32)
+{
+   int disdl = get_sdl_shift(s->slots[slot_num].regs.disdl);
+
+   s16 disdl_applied = (output >> disdl);
+
+   s16 mixs_input = output >>
+      get_sdl_shift(s->slots[slot_num].regs.imxl);
+
+   int pan_val_l = 0, pan_val_r = 0;
+
+   get_panning(s->slots[slot_num].regs.dipan, &pan_val_l, &pan_val_r);
+
+   *outl32 = *outl32 + ((disdl_applied >> pan_val_l) >> 1);
+   *outr32 = *outr32 + ((disdl_applied >> pan_val_r) >> 1);
+   scsp_dsp.mixs[s->slots[slot_num].regs.isel] += mixs_input << 4;
+}
+
+//the 32 steps of generate_sample, leaving out the slots that are silent when
+//it starts. Only a key on brings the attenuation of a slot back under 0x3bf,
+//so for the whole sample their stages return straight away, level 1 clears
+//the output and nothing gets mixed. The sound stack write still runs for
+//every slot. Each output is kept as it was at its sound stack write and
+//mixed once all steps are done, only the slots that put out something.
+static void generate_active_slots(struct Scsp * s, s32 * outl32, s32 * outr32)
+{
+   u32 active = 0;
+   u32 sounding = 0;
+   s16 output[32];
+   int step_num, i;
+
+   for (i = 0; i < 32; i++)
+   {
+      if (s->slots[i].state.attenuation < 0x3bf)
+         active |= 1u << i;
+   }
+
+   for (step_num = 0; step_num < 32; step_num++)
+   {
+      int last_step = (step_num - 6) & 0x1f;
+
+      if (active)
+      {
+         if (active & (1u << step_num))
+            op1(&s->slots[step_num]);
+         if (active & (1u << ((step_num - 1) & 0x1f)))
+            op2(&s->slots[(step_num - 1) & 0x1f], s);
+         if (active & (1u << ((step_num - 2) & 0x1f)))
+            op3(&s->slots[(step_num - 2) & 0x1f]);
+         if (active & (1u << ((step_num - 3) & 0x1f)))
+            op4(&s->slots[(step_num - 3) & 0x1f]);
+         if (active & (1u << ((step_num - 4) & 0x1f)))
+            op5(&s->slots[(step_num - 4) & 0x1f]);
+         else
+            s->slots[(step_num - 4) & 0x1f].state.output = 0;
+      }
+      else
+         s->slots[(step_num - 4) & 0x1f].state.output = 0;
+
+      op7(&s->slots[last_step], s);
+
+      output[last_step] = s->slots[last_step].state.output;
+      if (output[last_step])
+         sounding |= 1u << last_step;
+   }
+
+   for (i = 0; sounding; i++, sounding >>= 1)
+   {
+      if (!(sounding & 1))
+         continue;
+
+      if (s->debug_mode && scsp_debug_instrument_check_is_muted(s->slots[i].regs.sa))
+         continue;
+
+      mix_slot(s, i, output[i], outl32, outr32);
+   }
+}
+
 void generate_sample(struct Scsp * s, int rbp, int rbl, s16 * out_l, s16* out_r, int mvol, s16 cd_in_l, s16 cd_in_r)
 {
    int step_num = 0;
@@ -1456,7 +1544,9 @@ void generate_sample(struct Scsp * s, int rbp, int rbl, s16 * out_l, s16* out_r,
 
    //run 32 steps to generate 1 full sample (512 clock cycles at 22579200hz)
    //7 operations happen simultaneously on different channels due to pipelining
-   for (step_num = 0; step_num < 32; step_num++)
+   if (new_scsp_slot_skip)
+      generate_active_slots(s, &outl32, &outr32);
+   else for (step_num = 0; step_num < 32; step_num++)
    {
       int last_step = (step_num - 6) & 0x1f;
       int debug_muted = 0;
@@ -1476,22 +1566,7 @@ void generate_sample(struct Scsp * s, int rbp, int rbl, s16 * out_l, s16* out_r,
       }
 
       if (!debug_muted)
-      {
-         int disdl = get_sdl_shift(s->slots[last_step].regs.disdl);
-
-         s16 disdl_applied = (s->slots[last_step].state.output >> disdl);
-
-         s16 mixs_input = s->slots[last_step].state.output >> 
-            get_sdl_shift(s->slots[last_step].regs.imxl);
-
-         int pan_val_l = 0, pan_val_r = 0;
-
-         get_panning(s->slots[last_step].regs.dipan, &pan_val_l, &pan_val_r);
-
-         outl32 = outl32 + ((disdl_applied >> pan_val_l) >> 1);
-         outr32 = outr32 + ((disdl_applied >> pan_val_r) >> 1);
-         scsp_dsp.mixs[s->slots[last_step].regs.isel] += mixs_input << 4;
-      }
+         mix_slot(s, last_step, s->slots[last_step].state.output, &outl32, &outr32);
    }
 
    scsp_dsp.rbp = rbp;
@@ -1500,19 +1575,10 @@ void generate_sample(struct Scsp * s, int rbp, int rbl, s16 * out_l, s16* out_r,
    scsp_dsp.exts[0] = cd_in_l;
    scsp_dsp.exts[1] = cd_in_r;
 
-   if (scsp_dsp.updated){
-
-	   for (i = 127; i >= 0; --i)
-	   {
-		   if( scsp_dsp.mpro[i] != 0 )
-			   break;
-	   }
-	   scsp_dsp.last_step = i + 1;
-	   scsp_dsp.updated = 0;
-   }
+   if (scsp_dsp.updated)
+      ScspDspCompile(&scsp_dsp);
 
-   for (i = 0; i < scsp_dsp.last_step; i++)
-      ScspDspExec(&scsp_dsp, i, SoundRam);
+   ScspDspRun(&scsp_dsp, SoundRam);
 
    if (!scsp_dsp.mdec_ct){
      scsp_dsp.mdec_ct = (0x2000 << rbl);
@@ -4270,6 +4336,7 @@ scsp_w_b (u32 a, u8 d)
     default:
       break;
     }
+    scsp_dsp.updated = 1;
     return;
   }
   else if (a > 0xC00 && a <= 0xee2)
@@ -5485,13 +5552,85 @@ void new_scsp_update_samples(s32 *bufL, s32 *bufR, int scspsoundlen)
    new_scsp_outbuf_pos = 0;
 }
 
+// Quiesce handshake with the sound thread. The emulation thread asks for a
+// stop and the sound thread parks at a point where it has caught up with the
+// 68k counter, or is already blocked waiting for the next frame. Nothing the
+// state savers read changes while it is held.
+enum {
+  SCSP_THREAD_ACTIVE,
+  SCSP_THREAD_WAITING,    // in a blocking wait, between ScspThreadIdleBegin/End
+  SCSP_THREAD_REQUESTED,  // stop asked for, not reached yet
+  SCSP_THREAD_HELD
+};
+
+static std::atomic<int> scsp_thread_state(SCSP_THREAD_ACTIVE);
+static int scsp_held_from = -1;   // state it was taken from, -1 when not held
+static int scsp_hold_count = 0;
+
+static void ScspQuiescePoint() {
+  int expected = SCSP_THREAD_REQUESTED;
+  if (!scsp_thread_state.compare_exchange_strong(expected, SCSP_THREAD_HELD))
+    return;
+  while (scsp_thread_state.load() == SCSP_THREAD_HELD)
+    YabThreadYield();
+}
+
+// Brackets a blocking wait of the sound thread, a quiesce asked for in
+// between takes it without waiting for the thread to wake up
+static void ScspThreadIdleBegin() {
+  int expected = SCSP_THREAD_ACTIVE;
+  TRACE_BEGIN(TRACE_SCSP_WAIT);
+  while (!scsp_thread_state.compare_exchange_strong(expected, SCSP_THREAD_WAITING)) {
+    ScspQuiescePoint();
+    expected = SCSP_THREAD_ACTIVE;
+  }
+}
+
+static void ScspThreadIdleEnd() {
+  // A quiesce may have taken the waiting state while we were blocked
+  int expected = SCSP_THREAD_WAITING;
+  while (!scsp_thread_state.compare_exchange_strong(expected, SCSP_THREAD_ACTIVE)) {
+    if (expected == SCSP_THREAD_ACTIVE)
+      break;
+    if (expected == SCSP_THREAD_REQUESTED)
+      ScspQuiescePoint();
+    else
+      YabThreadYield();
+    expected = SCSP_THREAD_WAITING;
+  }
+  TRACE_END(TRACE_SCSP_WAIT);
+}
+
+// ScspLockThread: stop the sound thread at a quiesce point, calls nest
 void ScspLockThread() {
-  g_scsp_lock = 1;
-  YabThreadUSleep(16666*2);
+  int expected;
+
+  if (scsp_hold_count++ != 0 || thread_running == 0)
+    return;
+
+  for (;;) {
+    expected = SCSP_THREAD_WAITING;
+    if (scsp_thread_state.compare_exchange_strong(expected, SCSP_THREAD_HELD)) {
+      scsp_held_from = SCSP_THREAD_WAITING;
+      return;
+    }
+    expected = SCSP_THREAD_ACTIVE;
+    if (scsp_thread_state.compare_exchange_strong(expected, SCSP_THREAD_REQUESTED))
+      break;
+  }
+
+  scsp_held_from = SCSP_THREAD_ACTIVE;
+  while (scsp_thread_state.load() != SCSP_THREAD_HELD && thread_running)
+    YabThreadYield();
 }
 
 void ScspUnLockThread() {
-  g_scsp_lock = 0;
+  if (scsp_hold_count == 0 || --scsp_hold_count != 0 || scsp_held_from < 0)
+    return;
+
+  // back to waiting when it was taken blocked, it still is
+  scsp_thread_state.store(scsp_held_from);
+  scsp_held_from = -1;
 }
 
 
@@ -5535,6 +5674,7 @@ extern "C" void * ScspAsynMainCpuTime( void * p ){
   if( yabsys.use_cpu_affinity ){
     YabThreadSetCurrentThreadAffinityMask( YabThreadGetFastestCpuIndex() );
   }
+  TraceThreadName("scsp");
   before = YabauseGetTicks();
   u32 wait_clock = 0;
   u64 pre_m68k_cycle = 0;
@@ -5545,6 +5685,8 @@ extern "C" void * ScspAsynMainCpuTime( void * p ){
   //YabWaitEventQueue(q_scsp_frame_start);
   now = 0;
   before = 0;
+  // one span per frame of sound, the wait for the next one in between
+  TRACE_BEGIN(TRACE_SCSP_EXEC);
   while (thread_running){
     while (g_scsp_lock) { YabThreadUSleep(1000); }
     u64 m68k_done_counter = 0;
@@ -5554,6 +5696,8 @@ extern "C" void * ScspAsynMainCpuTime( void * p ){
       m68k_integer_part = getM68KCounter() >> SCSP_FRACTIONAL_BITS;
       m68k_cycle = m68k_integer_part - pre_m68k_cycle;
       if (thread_running == 0) break;
+      // caught up with the emulation thread, safe to park here
+      if (m68k_cycle == 0) ScspQuiescePoint();
     } while (m68k_cycle == 0);
 
     m68k_inc += m68k_cycle;
@@ -5583,7 +5727,11 @@ extern "C" void * ScspAsynMainCpuTime( void * p ){
         pre_m68k_cycle = 0;
         m68k_inc = 0;
         //LOG("[SCSP] WAIT SH2");
+        TRACE_END(TRACE_SCSP_EXEC);
+        ScspThreadIdleBegin();
         YabWaitEventQueue(q_scsp_frame_start);
+        ScspThreadIdleEnd();
+        TRACE_BEGIN(TRACE_SCSP_EXEC);
         now = YabauseGetTicks();
         //LOG(" SCSPTIME = %d/16666666 %d/735", (s32)(now - before), hzcheck);
         hzcheck = 0;
@@ -5593,6 +5741,7 @@ extern "C" void * ScspAsynMainCpuTime( void * p ){
     }
     setM68kDoneCounter(pre_m68k_cycle);
   }
+  TRACE_END(TRACE_SCSP_EXEC);
   YabThreadWake(YAB_THREAD_SCSP);
   return NULL;
 }
@@ -5635,14 +5784,18 @@ extern "C" void * ScspAsynMainRealtime(void * p) {
   if( yabsys.use_cpu_affinity ){
     YabThreadSetCurrentThreadAffinityMask(YabThreadGetFastestCpuIndex());
   }
+  TraceThreadName("scsp");
   
   before = YabauseGetTicks();
   u32 wait_clock = 0;
 
   now = 0;
   before = 0;
+  // one span per slice of a frame, up to the sleep
+  TRACE_BEGIN(TRACE_SCSP_EXEC);
   while (thread_running) {
     while (g_scsp_lock) { YabThreadUSleep(1000); }
+    ScspQuiescePoint();
     // Run 1 sample(44100Hz)
     for (i = 0; i < samplecnt; i += step) {
       MM68KExec(step);
@@ -5669,6 +5822,7 @@ extern "C" void * ScspAsynMainRealtime(void * p) {
         ScspExecAsync();
         frame_count = 0;
       }
+      TRACE_END(TRACE_SCSP_EXEC);
       s64 sleeptime = 0;
       s64 initsleeptime = 0;
       s64 initnow = 0;
@@ -5704,8 +5858,10 @@ extern "C" void * ScspAsynMainRealtime(void * p) {
         }
         tm.tv_nsec = ts.tv_nsec;
 
+        ScspThreadIdleBegin();
         pthread_mutex_lock(&sync_mutex);
         int rtn = pthread_cond_timedwait(&sync_cnd, &sync_mutex, &tm);
+        ScspThreadIdleEnd();
         if (rtn == 0) {
           for (i = 0; i < samplecnt; i += step) {
             MM68KExec(step);
@@ -5727,8 +5883,10 @@ extern "C" void * ScspAsynMainRealtime(void * p) {
         if( n > tm.tv_nsec){
           tm.tv_sec += 1;
         }
+        ScspThreadIdleBegin();
         pthread_mutex_lock(&sync_mutex);
         int rtn = pthread_cond_timedwait(&sync_cnd,&sync_mutex,ctime(&tm));
+        ScspThreadIdleEnd();
         if(rtn == 0){
           for (i = 0; i < samplecnt; i += step) {
             MM68KExec(step);
@@ -5744,7 +5902,11 @@ extern "C" void * ScspAsynMainRealtime(void * p) {
         }
         pthread_mutex_unlock(&sync_mutex);
 #else
-        if (sleeptime > 10000) YabThreadUSleep(0);
+        if (sleeptime > 10000) {
+          ScspThreadIdleBegin();
+          YabThreadUSleep(0);
+          ScspThreadIdleEnd();
+        }
         if (sh2_read_req != 0) {
           for (i = 0; i < samplecnt; i += step) {
             MM68KExec(step);
@@ -5766,8 +5928,10 @@ extern "C" void * ScspAsynMainRealtime(void * p) {
       //printf("vsynctime = %d(%d) %d(%d)\n", (s32)(checktime - before),16666666/frame_div,(s32)(checktime - initnow),(s32)initsleeptime);
       //printf("vsynctime = %d(%d) %"PRIu64"-%"PRIu64"=(%"PRId64")\n", (s32)(checktime - before),16666666/frame_div,now,before,initsleeptime);
       before = checktime;
+      TRACE_BEGIN(TRACE_SCSP_EXEC);
     }
   }
+  TRACE_END(TRACE_SCSP_EXEC);
   YabThreadWake(YAB_THREAD_SCSP);
   return NULL;
 }
@@ -6168,7 +6332,7 @@ SoundSaveState (FILE *fp)
   ywrite (&check, (void *)scsp_reg, 0x1000, 1, fp);
 
   // Sound RAM is important
-  ywrite (&check, (void *)SoundRam, 0x80000, 1, fp);
+  StateWriteRam (&check, (void *)SoundRam, 0x80000, fp);
 
   // Write slot internal variables
   for (i = 0; i < 32; i++)
@@ -6462,7 +6626,7 @@ SoundLoadState (FILE *fp, int version, int size)
   yread (&check, (void *)scsp_reg, 0x1000, 1, fp);
 
   // Lastly, sound ram
-  yread (&check, (void *)SoundRam, 0x80000, 1, fp);
+  StateReadRam (&check, (void *)SoundRam, 0x80000, fp);
 
   if (version > 1)
     {
@@ -6688,6 +6852,8 @@ SoundLoadState (FILE *fp, int version, int size)
     yread(&check, (void *)&scsp_dsp.write_data, sizeof(u16), 1, fp);
     yread(&check, (void *)&scsp_dsp.updated, sizeof(int), 1, fp);
     yread(&check, (void *)&scsp_dsp.last_step, sizeof(int), 1, fp);
+    // the compiled steps aren't saved
+    scsp_dsp.updated = 1;
 
     yread(&check, (void *)&ScspInternalVars->scsptiming1, sizeof(u32), 1, fp);
     yread(&check, (void *)&ScspInternalVars->scsptiming2, sizeof(u32), 1, fp);
@@ -182,7 +182,12 @@ void scsp_debug_instrument_clear();
 void scsp_debug_get_envelope(int chan, int * env, int * state);
 void scsp_debug_set_mode(int mode);
 void scsp_set_use_new(int which);
+// scsp_set_slot_skip: let the cycle accurate SCSP leave out the stages of
+// slots whose envelope is off (the default), or run every stage of every
+// slot. Both give the same samples and slot state.
+void scsp_set_slot_skip(int enable);
 void new_scsp_exec(s32 cycles);
+void new_scsp_update_samples(s32 *bufL, s32 *bufR, int scspsoundlen);
 
 void ScspLockThread();
 void ScspUnLockThread();
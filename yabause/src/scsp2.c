@@ -1707,7 +1707,7 @@ int SoundSaveState(FILE *fp)
    ywrite(&check, (void *)scsp_regcache, 0x1000, 1, fp);
 
    // Sound RAM is important
-   ywrite(&check, (void *)SoundRam, 0x80000, 1, fp);
+   StateWriteRam(&check, (void *)SoundRam, 0x80000, fp);
 
    // Write slot internal variables
    for (i = 0; i < 32; i++)
@@ -1836,7 +1836,7 @@ int SoundLoadState(FILE *fp, int version, int size)
    yread(&check, (void *)scsp_regcache, 0x1000, 1, fp);
 
    // And sound RAM
-   yread(&check, (void *)SoundRam, 0x80000, 1, fp);
+   StateReadRam(&check, (void *)SoundRam, 0x80000, fp);
 
    // Break out slot registers into their respective fields
    for (i = 0; i < 32; i++)
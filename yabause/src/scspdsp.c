@@ -162,7 +162,7 @@ void ScspDspExec(ScspDsp* dsp, int addr, u8 * sound_ram)
   u32 address = 0;
   s32 shift_temp = 0;
 
-  inst.all = scsp_dsp.mpro[addr];
+  inst.all = dsp->mpro[addr];
 
   const unsigned TEMPWriteAddr = (inst.part.twa + dsp->mdec_ct) & 0x7F;
   const unsigned TEMPReadAddr = (inst.part.tra + dsp->mdec_ct) & 0x7F;
@@ -289,6 +289,201 @@ void ScspDspExec(ScspDsp* dsp, int addr, u8 * sound_ram)
 }
 
 
+void ScspDspCompile(ScspDsp* dsp)
+{
+  union ScspDspInstruction inst;
+  int i;
+
+  for (i = 127; i >= 0; --i)
+  {
+    if (dsp->mpro[i] != 0)
+      break;
+  }
+  dsp->last_step = i + 1;
+  dsp->updated = 0;
+
+  for (i = 0; i < dsp->last_step; i++)
+  {
+    ScspDspStep* step = &dsp->steps[i];
+
+    inst.all = dsp->mpro[i];
+
+    if (inst.part.ira & 0x20) {
+      if (inst.part.ira & 0x10) {
+        step->input = (inst.part.ira & 0xE) ? SCSP_DSP_INPUT_KEEP : SCSP_DSP_INPUT_EXTS;
+        step->input_index = inst.part.ira & 0x1;
+      }
+      else {
+        step->input = SCSP_DSP_INPUT_MIXS;
+        step->input_index = inst.part.ira & 0xF;
+      }
+    }
+    else {
+      step->input = SCSP_DSP_INPUT_MEMS;
+      step->input_index = inst.part.ira & 0x1F;
+    }
+
+    step->tra = inst.part.tra;
+    step->twa = inst.part.twa;
+    step->xsel = inst.part.xsel;
+    step->ysel = inst.part.ysel;
+    step->coef = inst.part.coef;
+    step->yrl = inst.part.yrl;
+    step->shift = inst.part.shift0 ^ inst.part.shift1;
+    step->saturate = !inst.part.shift1;
+    step->select = inst.part.shift0 & inst.part.shift1;
+    step->ewt = inst.part.ewt;
+    step->ewa = inst.part.ewa;
+    step->twt = inst.part.twt;
+    step->frcl = inst.part.frcl;
+    step->bsel = inst.part.bsel;
+    step->negb = inst.part.negb;
+    step->zero = inst.part.zero;
+    step->iwt = inst.part.iwt;
+    step->iwa = inst.part.iwa;
+    step->masa = inst.part.masa;
+    step->nxadr = inst.part.nxadr;
+    step->adreb = inst.part.adreb;
+    step->table = inst.part.table;
+    step->mrd = inst.part.mrd;
+    step->mwt = inst.part.mwt;
+    step->nofl = inst.part.nofl;
+    step->adrl = inst.part.adrl;
+
+    step->temp = !step->xsel || (!step->bsel && !step->zero);
+    step->shifter = step->ewt || step->twt || step->frcl || step->mwt || step->adrl;
+  }
+}
+
+void ScspDspRun(ScspDsp* dsp, u8 * sound_ram)
+{
+  u16* sound_ram_16 = (u16*)sound_ram;
+  const ScspDspStep* step = dsp->steps;
+  const ScspDspStep* end = step + dsp->last_step;
+  const u16 ring_mask = (0x2000 << dsp->rbl) - 1;
+  const u32 ring_base = dsp->rbp << 12;
+
+  for (; step < end; step++)
+  {
+    s32 INPUTS;
+    s32 TEMP = 0;
+    s32 ShifterOutput = 0;
+    u16 y;
+    u32 SGAOutput;
+    u16 addr;
+
+    switch (step->input)
+    {
+    case SCSP_DSP_INPUT_MEMS:
+      dsp->inputs = dsp->mems[step->input_index];
+      break;
+    case SCSP_DSP_INPUT_MIXS:
+      dsp->inputs = dsp->mixs[step->input_index] << 4;
+      break;
+    case SCSP_DSP_INPUT_EXTS:
+      dsp->inputs = dsp->exts[step->input_index] << 8;
+      break;
+    default:
+      break;
+    }
+
+    INPUTS = sign_x_to_s32(24, dsp->inputs);
+
+    // read before this step's TWT write, like the interpreter
+    if (step->temp)
+      TEMP = sign_x_to_s32(24, dsp->temp[(step->tra + dsp->mdec_ct) & 0x7F]);
+
+    switch (step->ysel)
+    {
+    case 0: y = dsp->frc_reg; break;
+    case 1: y = dsp->coef[step->coef]; break;
+    case 2: y = (u16)((dsp->y_reg >> 11) & 0x1FFF); break;
+    default: y = (u16)((dsp->y_reg >> 4) & 0x0FFF); break;
+    }
+
+    if (step->yrl)
+      dsp->y_reg = INPUTS & 0xFFFFFF;
+
+    if (step->shifter)
+    {
+      ShifterOutput = (u32)sign_x_to_s32(26, dsp->shift_reg) << step->shift;
+
+      if (step->saturate)
+      {
+        if (ShifterOutput > 0x7FFFFF)
+          ShifterOutput = 0x7FFFFF;
+        else if (ShifterOutput < -0x800000)
+          ShifterOutput = 0x800000;
+      }
+      ShifterOutput &= 0xFFFFFF;
+
+      if (step->ewt)
+        dsp->efreg[step->ewa] = (ShifterOutput >> 8);
+
+      if (step->twt)
+        dsp->temp[(step->twa + dsp->mdec_ct) & 0x7F] = ShifterOutput;
+
+      if (step->frcl)
+        dsp->frc_reg = step->select ? (ShifterOutput & 0xFFF) : (ShifterOutput >> 11);
+    }
+
+    dsp->product = ((s64)sign_x_to_s32(13, y) * (step->xsel ? INPUTS : TEMP)) >> 12;
+
+    SGAOutput = step->bsel ? dsp->shift_reg : (u32)TEMP;
+
+    if (step->negb)
+      SGAOutput = -SGAOutput;
+
+    if (step->zero)
+      SGAOutput = 0;
+
+    dsp->shift_reg = (dsp->product + SGAOutput) & 0x3FFFFFF;
+
+    if (step->iwt)
+      dsp->mems[step->iwa] = dsp->read_value;
+
+    if (dsp->read_pending)
+    {
+      u16 tmp = sound_ram_16[dsp->io_addr];
+      dsp->read_value = (dsp->read_pending == 2) ? (tmp << 8) : float_to_int(tmp);
+      dsp->read_pending = 0;
+    }
+    else if (dsp->write_pending)
+    {
+      if (!(dsp->io_addr & 0x40000))
+        sound_ram_16[dsp->io_addr] = dsp->write_value;
+      dsp->write_pending = 0;
+    }
+
+    addr = dsp->madrs[step->masa];
+    addr += step->nxadr;
+
+    if (step->adreb)
+      addr += sign_x_to_s32(12, dsp->adrs_reg);
+
+    if (!step->table)
+    {
+      addr += dsp->mdec_ct;
+      addr &= ring_mask;
+    }
+
+    dsp->io_addr = (addr + ring_base) & 0x3FFFF;
+
+    if (step->mrd)
+      dsp->read_pending = 1 + step->nofl;
+
+    if (step->mwt)
+    {
+      dsp->write_pending = 1;
+      dsp->write_value = step->nofl ? (ShifterOutput >> 8) : int_to_float(ShifterOutput);
+    }
+
+    if (step->adrl)
+      dsp->adrs_reg = step->select ? (u16)(ShifterOutput >> 12) : (u16)((INPUTS >> 16) & 0xFFF);
+  }
+}
+
+
 int ScspDspAssembleGetValue(char* instruction)
 {
    char temp[512] = { 0 };
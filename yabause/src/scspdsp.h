@@ -45,6 +45,47 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 extern "C" {
 #endif
 
+// One step of the DSP program with its fields taken out of the MPRO word
+// and the work it never uses left out, see ScspDspCompile
+typedef struct
+{
+   u8 input;        // SCSP_DSP_INPUT_*
+   u8 input_index;
+   u8 tra;
+   u8 twa;
+   u8 temp;         // X or B read the temp ram
+   u8 xsel;
+   u8 ysel;
+   u8 coef;
+   u8 yrl;
+   u8 shifter;      // something reads the shifter output
+   u8 shift;        // shift0 ^ shift1
+   u8 saturate;     // !shift1
+   u8 select;       // shift0 & shift1, picks the FRCL and ADRL inputs
+   u8 ewt;
+   u8 ewa;
+   u8 twt;
+   u8 frcl;
+   u8 bsel;
+   u8 negb;
+   u8 zero;
+   u8 iwt;
+   u8 iwa;
+   u8 masa;
+   u8 nxadr;
+   u8 adreb;
+   u8 table;
+   u8 mrd;
+   u8 mwt;
+   u8 nofl;
+   u8 adrl;
+} ScspDspStep;
+
+#define SCSP_DSP_INPUT_MEMS 0
+#define SCSP_DSP_INPUT_MIXS 1
+#define SCSP_DSP_INPUT_EXTS 2
+#define SCSP_DSP_INPUT_KEEP 3   // unused exts inputs, the last input stays
+
 typedef struct
 {
    u16 coef[64];
@@ -89,6 +130,7 @@ typedef struct
    int write_pending;
    u32 shift_reg;
 
+   ScspDspStep steps[128];  // mpro up to last_step, rebuilt when updated is set
 }ScspDsp;
 
 //dsp instruction format
@@ -189,6 +231,14 @@ union ScspDspInstruction {
 void ScspDspDisasm(u8 addr, char *outstring);
 void ScspDspExec(ScspDsp* dsp, int addr, u8 * sound_ram);
 
+// ScspDspCompile: decode mpro into steps, up to the last step that isn't
+// zero, and set last_step. Called when updated is set, clears it.
+void ScspDspCompile(ScspDsp* dsp);
+
+// ScspDspRun: one sample of the compiled program, the same as ScspDspExec for
+// every step below last_step
+void ScspDspRun(ScspDsp* dsp, u8 * sound_ram);
+
 extern ScspDsp scsp_dsp;
 
 #if defined (__cplusplus)
@@ -48,12 +48,23 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 #include "sh2core.h"
 #include "yabause.h"
 #include <inttypes.h>
+#include <string.h>
+#include "vdp1.h"
+#include "vdp2.h"
 
 #ifdef OPTIMIZED_DMA
 # include "cs2.h"
 # include "scsp.h"
-# include "vdp1.h"
-# include "vdp2.h"
+#endif
+
+#if !defined(WORDS_BIGENDIAN)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SCU_DMA_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SCU_DMA_NEON
+#include <arm_neon.h>
+#endif
 #endif
 
 Scu * ScuRegs;
@@ -62,6 +73,59 @@ scubp_struct * ScuBP;
 static int incFlg[4] = { 0 };
 static void ScuTestInterruptMask(void);
 
+// Decoded DSP program, one entry per ProgramRam word. An entry is decoded
+// the first time its word runs and kept until the word is written.
+enum
+{
+   SCUDSP_OP_NOP,
+   SCUDSP_OP_OPERATION,
+   SCUDSP_OP_MVI,
+   SCUDSP_OP_DMA,
+   SCUDSP_OP_JMP,
+   SCUDSP_OP_LPS,
+   SCUDSP_OP_BTM,
+   SCUDSP_OP_END,
+   SCUDSP_OP_INVALID
+};
+
+typedef struct
+{
+   u32 instruction;
+   s32 imm;          // MVI value, D1-bus immediate or jump target
+   u8 valid;
+   u8 kind;
+   u8 alu;           // ALU command of operation commands
+   u8 pbus, xbus, ybus, abus, d1bus;
+   u8 xsrc, ysrc;    // also the P-bus and A-bus sources
+   u8 d1dst, d1src;
+   u8 cond_mask;     // Z, S, C and T0 as bits 0-3, 0 for unconditional
+   u8 cond_set;      // condition is true when one of the masked flags is set
+   u8 interrupt;     // END raises the DSP end interrupt
+   u8 counters;      // may step the data ram address counters through incFlg
+} scudspop_struct;
+
+static scudspop_struct ScuDspOps[256];
+static int ScuDspCacheEnabled = 1;
+static scudspstats_struct ScuDspFrameStats;
+static scudspstats_struct ScuDspLastStats;
+
+static INLINE void ScuDspInvalidateWord(u8 addr)
+{
+   if (ScuDspOps[addr].valid)
+   {
+      ScuDspOps[addr].valid = 0;
+      ScuDspFrameStats.invalidations++;
+   }
+}
+
+static void ScuDspInvalidateProgram(void)
+{
+   int i;
+
+   for (i = 0; i < 256; i++)
+      ScuDspInvalidateWord((u8)i);
+}
+
 void ScuRemoveInterruptByCPU(u32 pre, u32 after);
 void step_dsp_dma(scudspregs_struct *sc);
 
@@ -101,6 +165,9 @@ int ScuInit(void) {
    ScuBP->numcodebreakpoints = 0;
    ScuBP->BreakpointCallBack=NULL;
    ScuBP->inbreakpoint=0;
+   memset(ScuDspOps, 0, sizeof(ScuDspOps));
+   memset(&ScuDspFrameStats, 0, sizeof(ScuDspFrameStats));
+   memset(&ScuDspLastStats, 0, sizeof(ScuDspLastStats));
 
    for( int j=0; i<4; j++ ){
       for( int i=0; i<64; i++ ){
@@ -786,6 +853,7 @@ void dsp_dma_write_d0bus(scudspregs_struct *sc, int sel, int add, int count){
     }
   // CPU-BUS
     else{
+      u32 start = sc->WA0M << 2;
 
       if (add == 0) add = 1;
 
@@ -812,6 +880,7 @@ void dsp_dma_write_d0bus(scudspregs_struct *sc, int sel, int add, int count){
           sc->WA0M += (add >> 1);
         }
       }
+      SH2WriteNotify(start, (sc->WA0M << 2) - start);
 
     }
 
@@ -866,6 +935,7 @@ void dsp_dma03(scudspregs_struct *sc, u32 inst)
     {
       if (sel == 0x04){
         sc->ProgramRam[index] = MappedMemoryReadLongNocache((sc->RA0M << 2), NULL);
+        ScuDspInvalidateWord((u8)index);
         //LOG("read from %08X to P[%d] val %08X", (sc->RA0 << 2), index, sc->ProgramRam[index]);
         index++;
       }
@@ -885,6 +955,7 @@ void dsp_dma03(scudspregs_struct *sc, u32 inst)
 
       if (sel == 0x04){
         sc->ProgramRam[index] = MappedMemoryReadLongNocache((sc->RA0M << 2), NULL);
+        ScuDspInvalidateWord((u8)index);
         //LOG("read from %08X to P[%d] val %08X", (sc->RA0 << 2), index, sc->ProgramRam[index]);
         index++;
       }else{
@@ -1110,6 +1181,178 @@ void ScuSetAddValue(scudmainfo_struct * dmainfo) {
 
 }
 
+//////////////////////////////////////////////////////////////////////////////
+
+static int ScuDmaBulkEnabled = 1;
+
+// Host memory behind a DMA address. Work ram keeps each halfword in host
+// order (T2), the vdp rams keep the bytes in bus order (T1).
+typedef struct
+{
+  u8 * ram;
+  u32 offset;
+  u32 left;     // bytes up to the end of the ram or of its mirror
+  int t2;
+  int vdp;      // 1 or 2 for the vdp rams, their writes are tracked
+} scudmaspan_struct;
+
+static int ScuDmaResolve(u32 addr, u32 align, int write, scudmaspan_struct * span)
+{
+  u32 a = addr & 0x0FFFFFFF;
+
+  // Only the areas MappedMemoryWrite* sends to the memory map
+  if (write && (addr >> 29) != 0 && (addr >> 29) != 1 && (addr >> 29) != 4)
+    return 0;
+  if (addr & (align - 1))
+    return 0;
+
+  if (a >= 0x00200000 && a < 0x00300000) {
+    span->ram = LowWram;
+    span->offset = a & 0xFFFFF;
+    span->left = 0x100000 - span->offset;
+    span->t2 = 1;
+    span->vdp = 0;
+  }
+  else if (a >= 0x06000000 && a < 0x06110000) {
+    span->ram = HighWram;
+    span->offset = a & 0xFFFFF;
+    span->left = 0x100000 - span->offset;
+    if (span->left > 0x06110000 - a)
+      span->left = 0x06110000 - a;
+    span->t2 = 1;
+    span->vdp = 0;
+  }
+  else if (a >= 0x05C00000 && a < 0x05C80000) {
+    span->ram = Vdp1Ram;
+    span->offset = a & 0x7FFFF;
+    span->left = 0x80000 - span->offset;
+    span->t2 = 0;
+    span->vdp = 1;
+  }
+  else if (a >= 0x05E00000 && a < 0x05F00000) {
+    span->ram = Vdp2Ram;
+    span->offset = a & 0x7FFFF;
+    span->left = 0x80000 - span->offset;
+    span->t2 = 0;
+    span->vdp = 2;
+  }
+  else
+    return 0;
+
+  return span->ram != NULL;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Copy between T1 and T2 memory, swapping the bytes of every halfword
+static void ScuDmaSwapCopy(u8 * dst, const u8 * src, u32 size)
+{
+  u32 i = 0;
+#if defined(SCU_DMA_SSE2)
+  for (; i + 16 <= size; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    _mm_storeu_si128((__m128i *)(dst + i), v);
+  }
+#elif defined(SCU_DMA_NEON)
+  for (; i + 16 <= size; i += 16)
+    vst1q_u8(dst + i, vrev16q_u8(vld1q_u8(src + i)));
+#endif
+  for (; i + 4 <= size; i += 4) {
+    u32 v;
+    memcpy(&v, src + i, 4);
+    v = BSWAP16(v);
+    memcpy(dst + i, &v, 4);
+  }
+  for (; i < size; i += 2) {
+    dst[i] = src[i + 1];
+    dst[i + 1] = src[i];
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Runs as many elements of a transfer as host memory allows with one memcpy,
+// byte swap or fill, where SucDmaExec would go one element at a time. unit is
+// the bytes each element moves, both addresses advancing by that much (the
+// read address stays put for fills), align the access size of the element.
+// Returns 0 without doing anything when an end isn't plain ram, the caller
+// then goes on element by element.
+static int ScuDmaBulk(scudmainfo_struct * dma, int * time, u32 unit, u32 align, const u32 * fill)
+{
+  scudmaspan_struct dst, src;
+  u32 count, size;
+
+  if (!ScuDmaBulkEnabled)
+    return 0;
+  if (!ScuDmaResolve(dma->WriteAddress, align, 1, &dst))
+    return 0;
+
+  count = (dma->TransferNumber + unit - 1) / unit;
+  if (count > (u32)*time)
+    count = *time;
+  if (count > dst.left / unit)
+    count = dst.left / unit;
+
+  if (fill == NULL) {
+    if (!ScuDmaResolve(dma->ReadAddress, align, 0, &src))
+      return 0;
+    if (count > src.left / unit)
+      count = src.left / unit;
+    // Overlapping copies keep the element order of the slow path
+    if (src.ram == dst.ram && src.offset < dst.offset + count * unit
+      && dst.offset < src.offset + count * unit)
+      return 0;
+  }
+
+  if (count == 0)
+    return 0;
+
+  size = count * unit;
+
+  if (fill == NULL) {
+#ifdef WORDS_BIGENDIAN
+    memcpy(dst.ram + dst.offset, src.ram + src.offset, size);
+#else
+    if (src.t2 == dst.t2)
+      memcpy(dst.ram + dst.offset, src.ram + src.offset, size);
+    else
+      ScuDmaSwapCopy(dst.ram + dst.offset, src.ram + src.offset, size);
+#endif
+    dma->ReadAddress += size;
+  }
+  else {
+    u8 * p = dst.ram + dst.offset;
+    u32 done = 4;
+    int swap = 0;
+    int i;
+#ifndef WORDS_BIGENDIAN
+    swap = dst.t2;
+#endif
+    // The pattern in bus order, turned into the order of the destination.
+    // The offset is even so the halfwords line up.
+    for (i = 0; i < 4; i++)
+      p[i] = (u8)(*fill >> (24 - 8 * ((i ^ swap) & 3)));
+    while (done < size) {
+      u32 n = done < size - done ? done : size - done;
+      memcpy(p + done, p, n);
+      done += n;
+    }
+  }
+
+  if (dst.vdp == 1)
+    Vdp1RamDirty(dst.offset, size);
+  else if (dst.vdp == 2)
+    Vdp2RamDirty(dst.offset, size);
+
+  dma->WriteAddress += size;
+  dma->TransferNumber -= size;
+  *time -= count;
+  return 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 void SucDmaExec(scudmainfo_struct * dma, int * time ) {
   LOG("[SCU] SucDmaExec src=%08X,dst=%08X,size=%d, ra:%d/wa:%d flame=%d:%d",
     dma->ReadAddress, dma->WriteAddress, dma->TransferNumber, dma->ReadAdd, dma->WriteAdd, yabsys.frame_count, yabsys.LineCount);
@@ -1139,6 +1382,14 @@ void SucDmaExec(scudmainfo_struct * dma, int * time ) {
         }
 
         u32 start = dma->WriteAddress;
+        if (dma->WriteAdd == 2) {
+          while (*time > 0 && ScuDmaBulk(dma, time, 4, 2, &val)) {
+            if (dma->TransferNumber <= 0) {
+              SH2WriteNotify(start, dma->WriteAddress - start);
+              return;
+            }
+          }
+        }
         while ( *time > 0 ) {
           *time -= 1;
           MappedMemoryWriteWordNocache(dma->WriteAddress, (u16)(val >> 16), &cycle);
@@ -1177,6 +1428,14 @@ void SucDmaExec(scudmainfo_struct * dma, int * time ) {
       u32 start = dma->WriteAddress;
       if (constant_source) {
         u32 val = MappedMemoryReadLongNocache((dma->ReadAddress & 0x0FFFFFFF), &cycle);
+        if (dma->WriteAdd == 4) {
+          while (*time > 0 && ScuDmaBulk(dma, time, 4, 4, &val)) {
+            if (dma->TransferNumber <= 0) {
+              SH2WriteNotify(start, dma->WriteAddress - start);
+              return;
+            }
+          }
+        }
         while ( *time > 0) {
           *time -= 1;
           MappedMemoryWriteLongNocache(dma->WriteAddress, val, &cycle);
@@ -1216,6 +1475,14 @@ void SucDmaExec(scudmainfo_struct * dma, int * time ) {
       // Copy in 16-bit units, avoiding misaligned accesses.
       u32 counter = 0;
       u32 start = dma->WriteAddress;
+      if (dma->WriteAdd == 2) {
+        while (*time > 0 && ScuDmaBulk(dma, time, 2, 2, NULL)) {
+          if (dma->TransferNumber <= 0) {
+            SH2WriteNotify(start, dma->WriteAddress - start);
+            return;
+          }
+        }
+      }
       while (*time > 0) {
         *time -= 1;
         u16 tmp = MappedMemoryReadWordNocache((dma->ReadAddress & 0x0FFFFFFF), &cycle);
@@ -1232,6 +1499,14 @@ void SucDmaExec(scudmainfo_struct * dma, int * time ) {
     }
     else if (((dma->ReadAddress & 0x1FFFFFFF) >= 0x5A00000 && (dma->ReadAddress & 0x1FFFFFFF) < 0x5FF0000)) {
       u32 start = dma->WriteAddress;
+      if ((dma->WriteAdd >> 1) == 2) {
+        while (*time > 0 && ScuDmaBulk(dma, time, 2, 2, NULL)) {
+          if (dma->TransferNumber <= 0) {
+            SH2WriteNotify(start, dma->WriteAddress - start);
+            return;
+          }
+        }
+      }
       while ( *time > 0) {
         *time -= 1;
         u16 tmp = MappedMemoryReadWordNocache((dma->ReadAddress & 0x0FFFFFFF), &cycle);
@@ -1249,6 +1524,14 @@ void SucDmaExec(scudmainfo_struct * dma, int * time ) {
     else {
       u32 counter = 0;
       u32 start = dma->WriteAddress;
+      if (dma->WriteAdd == 4) {
+        while (*time > 0 && ScuDmaBulk(dma, time, 4, 4, NULL)) {
+          if (dma->TransferNumber <= 0) {
+            SH2WriteNotify(start, dma->WriteAddress - start);
+            return;
+          }
+        }
+      }
       while (*time > 0) {
         *time -= 1;
         u32 val = MappedMemoryReadLongNocache((dma->ReadAddress & 0x0FFFFFFF), &cycle);
@@ -1340,6 +1623,555 @@ void ScuDmaProc(Scu * scu, int time) {
 }
 
 //////////////////////////////////////////////////////////////////////////////
+
+// ALU commands of the operation commands, command is instruction >> 26. The
+// ALU register starts as a copy of AC.
+static INLINE void ScuDspAlu(u32 command)
+{
+   switch (command)
+   {
+      case 0x0: // NOP
+         //AC is moved as-is to the ALU
+        //ScuDsp->ALU.all = ScuDsp->AC.all;
+         break;
+      case 0x1: // AND
+         //the upper 16 bits of AC are not modified for and, or, add, sub, rr and rl8
+        ScuDsp->ALU.part.L = (s64)((u32)ScuDsp->AC.part.L & (u32)ScuDsp->P.part.L);
+
+         if (ScuDsp->ALU.part.L == 0)
+            ScuDsp->ProgControlPort.part.Z = 1;
+         else
+            ScuDsp->ProgControlPort.part.Z = 0;
+
+         if ((s64)ScuDsp->ALU.part.L < 0)
+            ScuDsp->ProgControlPort.part.S = 1;
+         else
+            ScuDsp->ProgControlPort.part.S = 0;
+
+         ScuDsp->ProgControlPort.part.C = 0;
+         break;
+      case 0x2: // OR
+        ScuDsp->ALU.part.L = (u64)((u32)ScuDsp->AC.part.L | (u32)ScuDsp->P.part.L);
+
+         if (ScuDsp->ALU.part.L == 0)
+            ScuDsp->ProgControlPort.part.Z = 1;
+         else
+            ScuDsp->ProgControlPort.part.Z = 0;
+
+         if ((s64)ScuDsp->ALU.part.L < 0)
+            ScuDsp->ProgControlPort.part.S = 1;
+         else
+            ScuDsp->ProgControlPort.part.S = 0;
+
+         ScuDsp->ProgControlPort.part.C = 0;
+         break;
+      case 0x3: // XOR
+        ScuDsp->ALU.part.L = (u64)((u32)ScuDsp->AC.part.L ^ (u32)ScuDsp->P.part.L);
+
+         if (ScuDsp->ALU.part.L == 0)
+            ScuDsp->ProgControlPort.part.Z = 1;
+         else
+            ScuDsp->ProgControlPort.part.Z = 0;
+
+         if ((s64)ScuDsp->ALU.part.L < 0)
+            ScuDsp->ProgControlPort.part.S = 1;
+         else
+            ScuDsp->ProgControlPort.part.S = 0;
+
+         ScuDsp->ProgControlPort.part.C = 0;
+         break;
+      case 0x4: // ADD
+         ScuDsp->ALU.part.L = (s32)ScuDsp->AC.part.L + (s32)ScuDsp->P.part.L;
+           DSPLOG( "%02X: %d + %d = %d\n", ScuDsp->PC, (s32)ScuDsp->AC.part.L, (s32)ScuDsp->P.part.L, (s32)ScuDsp->ALU.part.L);
+         if (ScuDsp->ALU.part.L == 0)
+            ScuDsp->ProgControlPort.part.Z = 1;
+         else
+            ScuDsp->ProgControlPort.part.Z = 0;
+
+         if ((s32)ScuDsp->ALU.part.L < 0)
+            ScuDsp->ProgControlPort.part.S = 1;
+         else
+            ScuDsp->ProgControlPort.part.S = 0;
+
+         //0x00000001 + 0xFFFFFFFF will set the carry bit, needs to be unsigned math
+         if (((u64)(u32)ScuDsp->P.part.L + (u64)(u32)ScuDsp->AC.part.L) & 0x100000000){
+           ScuDsp->ProgControlPort.part.C = 1;
+         }
+         else{
+           ScuDsp->ProgControlPort.part.C = 0;
+         }
+
+
+         //if (ScuDsp->ALU.part.L ??) // set overflow flag
+         //    ScuDsp->ProgControlPort.part.V = 1;
+         //else
+         //   ScuDsp->ProgControlPort.part.V = 0;
+         break;
+      case 0x5: // SUB
+      {
+        ScuDsp->ALU.part.L = (s32)ScuDsp->AC.part.L - (s32)ScuDsp->P.part.L;
+        DSPLOG( "%02X: %d - %d = %d \n", ScuDsp->PC, (s32)ScuDsp->AC.part.L, (s32)ScuDsp->P.part.L, (s32)ScuDsp->ALU.part.L);
+        //ScuDsp->ProgControlPort.part.C = ((ans >> 32) & 0x01);
+
+        //ScuDsp->ALU.part.L = ans;
+
+        if (ScuDsp->ALU.part.L == 0)
+          ScuDsp->ProgControlPort.part.Z = 1;
+        else
+          ScuDsp->ProgControlPort.part.Z = 0;
+
+        if ((s64)ScuDsp->ALU.part.L < 0)
+          ScuDsp->ProgControlPort.part.S = 1;
+        else
+          ScuDsp->ProgControlPort.part.S = 0;
+
+        //0x00000001 - 0xFFFFFFFF will set the carry bit, needs to be unsigned math
+        if ((((u64)(u32)ScuDsp->AC.part.L - (u64)(u32)ScuDsp->P.part.L)) & 0x100000000)
+          ScuDsp->ProgControlPort.part.C = 1;
+        else
+          ScuDsp->ProgControlPort.part.C = 0;
+
+        //0x00000001 - 0xFFFFFFFF will set the carry bit, needs to be unsigned math
+        //if ((((u64)(u32)ScuDsp->AC.part.L - (u64)(u32)ScuDsp->P.part.L)) & 0x100000000)
+        //  ScuDsp->ProgControlPort.part.C = 1;
+        //else
+        //  ScuDsp->ProgControlPort.part.C = 0;
+
+
+        //               if (ScuDsp->ALU.part.L ??) // set overflow flag
+        //                  ScuDsp->ProgControlPort.part.V = 1;
+        //               else
+        //                  ScuDsp->ProgControlPort.part.V = 0;
+      }
+         break;
+      case 0x6: // AD2
+        ScuDsp->ALU.all = (s64)ScuDsp->AC.all +(s64)ScuDsp->P.all;
+         DSPLOG( "%02X: %" PRId64 "+2 %" PRId64 "= %" PRId64 "\n", ScuDsp->PC, ScuDsp->AC.all, ScuDsp->P.all, ScuDsp->ALU.all);
+         if (ScuDsp->ALU.all == 0)
+            ScuDsp->ProgControlPort.part.Z = 1;
+         else
+            ScuDsp->ProgControlPort.part.Z = 0;
+
+         //0x500000000000 + 0xd00000000000 will set the sign bit
+         if (ScuDsp->ALU.all & 0x800000000000)
+            ScuDsp->ProgControlPort.part.S = 1;
+         else
+            ScuDsp->ProgControlPort.part.S = 0;
+
+         //AC.all and P.all are sign-extended so we need to mask it off and check for a carry
+         if (((ScuDsp->AC.all & 0xffffffffffff) + (ScuDsp->P.all & 0xffffffffffff)) & (0x1000000000000))
+            ScuDsp->ProgControlPort.part.C = 1;
+         else
+            ScuDsp->ProgControlPort.part.C = 0;
+
+//               if (ScuDsp->ALU.part.unused != 0)
+//                  ScuDsp->ProgControlPort.part.V = 1;
+//               else
+//                  ScuDsp->ProgControlPort.part.V = 0;
+
+         break;
+      case 0x8: // SR
+        ScuDsp->ProgControlPort.part.C = ScuDsp->AC.part.L & 0x1;
+         ScuDsp->ALU.part.L = (ScuDsp->AC.part.L & 0x80000000) | (ScuDsp->AC.part.L >> 1);
+
+         if (ScuDsp->ALU.part.L == 0)
+            ScuDsp->ProgControlPort.part.Z = 1;
+         else
+            ScuDsp->ProgControlPort.part.Z = 0;
+
+         if (ScuDsp->ALU.part.L & 0x80000000)
+            ScuDsp->ProgControlPort.part.S = 1;
+         else
+            ScuDsp->ProgControlPort.part.S = 0;
+
+         //0x00000001 >> 1 will set the carry bit
+         //ScuDsp->ProgControlPort.part.C = ScuDsp->ALU.part.L >> 31; would not handle this case
+         break;
+      case 0x9: // RR
+        ScuDsp->ProgControlPort.part.C = ScuDsp->AC.part.L & 0x1;
+         ScuDsp->ALU.part.L = ((u32)(ScuDsp->ProgControlPort.part.C) << 31) | ((u32)(ScuDsp->AC.part.L) >> 1) ;
+         
+         if (ScuDsp->ALU.part.L == 0)
+            ScuDsp->ProgControlPort.part.Z = 1;
+         else
+            ScuDsp->ProgControlPort.part.Z = 0;
+
+         //rotating 0x00000001 right will produce 0x80000000 and set 
+         //the sign bit.
+         if (ScuDsp->ALU.part.L & 0x80000000)
+            ScuDsp->ProgControlPort.part.S = 1;
+         else
+            ScuDsp->ProgControlPort.part.S = 0;
+         break;
+      case 0xA: // SL
+        ScuDsp->ProgControlPort.part.C = (ScuDsp->AC.part.L >> 31) & 0x01;
+
+         ScuDsp->ALU.part.L = (u32)(ScuDsp->AC.part.L << 1);
+
+         if (ScuDsp->ALU.part.L == 0)
+            ScuDsp->ProgControlPort.part.Z = 1;
+         else
+            ScuDsp->ProgControlPort.part.Z = 0;
+
+         if (ScuDsp->ALU.part.L & 0x80000000)
+            ScuDsp->ProgControlPort.part.S = 1;
+         else
+            ScuDsp->ProgControlPort.part.S = 0;
+         break;
+      case 0xB: // RL
+
+        ScuDsp->ProgControlPort.part.C = (ScuDsp->AC.part.L >> 31) & 0x01;
+
+         ScuDsp->ALU.part.L = (((u32)ScuDsp->AC.part.L << 1) | ScuDsp->ProgControlPort.part.C);
+         
+         if (ScuDsp->ALU.part.L == 0)
+            ScuDsp->ProgControlPort.part.Z = 1;
+         else
+            ScuDsp->ProgControlPort.part.Z = 0;
+   
+         if (ScuDsp->ALU.part.L & 0x80000000)
+            ScuDsp->ProgControlPort.part.S = 1;
+         else
+            ScuDsp->ProgControlPort.part.S = 0;
+         
+         //ScuDsp->AC.part.L = ScuDsp->ALU.part.L;
+         break;
+      case 0xF: // RL8
+        DSPLOG( "%02X:RL8 %d = %d\n", ScuDsp->PC, ScuDsp->AC.part.L, ((u32)(ScuDsp->AC.part.L << 8) | ((ScuDsp->AC.part.L >> 24) & 0xFF)) );
+        ScuDsp->ProgControlPort.part.C = (ScuDsp->AC.part.L >> 24) & 0x01;
+        ScuDsp->ALU.part.L  = ((u32)(ScuDsp->AC.part.L << 8) | ((ScuDsp->AC.part.L >> 24) & 0xFF)) ;
+
+        if (ScuDsp->ALU.part.L == 0)
+            ScuDsp->ProgControlPort.part.Z = 1;
+         else
+            ScuDsp->ProgControlPort.part.Z = 0;
+
+         //rotating 0x00ffffff left 8 will produce 0xffffff00 and
+         //set the sign bit
+         if ( ScuDsp->ALU.part.L & 0x80000000 )
+            ScuDsp->ProgControlPort.part.S = 1;
+         else
+            ScuDsp->ProgControlPort.part.S = 0;
+
+         //rotating 0xff000000 left 8 will produce 0x000000ff and set the
+         //carry bit
+         //ScuDsp->ProgControlPort.part.C = (ScuDsp->AC.part.L >> 24) & 0x01;
+         break;
+      default: break;
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// DMA commands, the transfer itself is done by step_dsp_dma
+static void ScuDspStartDma(u32 instruction)
+{
+   int Counter = 0;
+   int cycle = 0;
+
+   // Finish Previous DMA operation
+   if (ScuDsp->dsp_dma_wait > 0) {
+     ScuDsp->dsp_dma_wait = 0;
+     step_dsp_dma(ScuDsp);
+   }
+
+   ScuDsp->dsp_dma_instruction = instruction;
+   ScuDsp->ProgControlPort.part.T0 = 1;
+
+   if ( ((instruction >> 10) & 0x1F) == 0x00 || 
+        ((instruction >> 10) & 0x1F) == 0x04  || 
+        ((instruction >> 11) & 0x0F) == 0x08 || 
+        ((instruction >> 10) & 0x1F) == 0x14 )
+   {
+      Counter = instruction & 0xFF;
+   }
+   else if (
+     ((instruction >> 11) & 0x0F) == 0x04 || 
+     ((instruction >> 10) & 0x1F) == 0x0C || 
+     ((instruction >> 11) & 0x0F) == 0x0C || 
+     ((instruction >> 10) & 0x1F) == 0x1C)
+   {
+     switch ((instruction & 0x7))
+     {
+     case 0x00: Counter = ScuDsp->MD[0][ScuDsp->CT[0] & 0x3F]; break;
+     case 0x01: Counter = ScuDsp->MD[1][ScuDsp->CT[1] & 0x3F]; break;
+     case 0x02: Counter = ScuDsp->MD[2][ScuDsp->CT[2] & 0x3F]; break;
+     case 0x03: Counter = ScuDsp->MD[3][ScuDsp->CT[3] & 0x3F]; break;
+     case 0x04: Counter = ScuDsp->MD[0][ScuDsp->CT[0] & 0x3F]; ScuDsp->CT[0]++; ScuDsp->CT[0] &= 0x3F; break;
+     case 0x05: Counter = ScuDsp->MD[1][ScuDsp->CT[1] & 0x3F]; ScuDsp->CT[1]++; ScuDsp->CT[1] &= 0x3F; break;
+     case 0x06: Counter = ScuDsp->MD[2][ScuDsp->CT[2] & 0x3F]; ScuDsp->CT[2]++; ScuDsp->CT[2] &= 0x3F; break;
+     case 0x07: Counter = ScuDsp->MD[3][ScuDsp->CT[3] & 0x3F]; ScuDsp->CT[3]++; ScuDsp->CT[3] &= 0x3F; break;
+     }
+
+   }
+
+   ScuDsp->dsp_dma_size = Counter;
+   ScuDsp->dsp_dma_wait = 2; // DMA operation will be start when this count is zero
+   ScuDsp->WA0M = ScuDsp->WA0;
+   ScuDsp->RA0M = ScuDsp->RA0;
+
+   switch ((ScuDsp->WA0M << 2) & 0xDFF00000) {
+   case 0x00200000: /* Low */
+     cycle = 2;
+     break;
+   case 0x05A00000: /* SOUND */
+     cycle = 1;
+     break;
+   case 0x05C00000: /* VDP1 */
+     cycle = 1;
+     break;
+   case 0x05e00000: /* VDP2 */
+     cycle = 1;
+     break;
+   case 0x06000000: /* High */
+     cycle = 4;
+     break;
+   default:
+     cycle = 4;
+   }
+   ScuDsp->dsp_dma_wait = (Counter >> cycle) + 1;
+   LOG("Start DSP DMA RA=%08X WA=%08X inst=%08X count=%d wait = %d", ScuDsp->RA0M<<2, ScuDsp->WA0M<<2, ScuDsp->dsp_dma_instruction, Counter, ScuDsp->dsp_dma_wait );
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Condition field of MVI and JMP without the "conditional" bit, 0x01 Z,
+// 0x02 S, 0x03 Z or S, 0x04 C, 0x08 T0, 0x20 set for "flag set"
+static int ScuDspDecodeCondition(scudspop_struct *op, u32 code)
+{
+   switch (code & 0x1F)
+   {
+      case 0x01: case 0x02: case 0x03: case 0x04: case 0x08:
+         op->cond_mask = (u8)(code & 0xF);
+         op->cond_set = (u8)((code >> 5) & 1);
+         return 1;
+      default:
+         return 0;
+   }
+}
+
+static INLINE int ScuDspCondition(const scudspop_struct *op)
+{
+   u32 flags;
+
+   if (op->cond_mask == 0)
+      return 1;
+
+   flags = ScuDsp->ProgControlPort.part.Z | (ScuDsp->ProgControlPort.part.S << 1) |
+      (ScuDsp->ProgControlPort.part.C << 2) | (ScuDsp->ProgControlPort.part.T0 << 3);
+   if (op->cond_set)
+      return (flags & op->cond_mask) != 0;
+   return (flags & op->cond_mask) == 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Pulls the fields out of a program word the way ScuExec's interpreter reads
+// them
+static void ScuDspDecode(u8 addr)
+{
+   scudspop_struct *op = &ScuDspOps[addr];
+   u32 instruction = ScuDsp->ProgramRam[addr];
+
+   memset(op, 0, sizeof(scudspop_struct));
+   op->instruction = instruction;
+   op->valid = 1;
+   ScuDspFrameStats.decodes++;
+
+   switch (instruction >> 30) {
+      case 0x00: // Operation Commands
+         op->kind = SCUDSP_OP_OPERATION;
+         op->alu = (u8)(instruction >> 26);
+         op->pbus = (instruction >> 23) & 0x3;
+         op->xbus = (instruction >> 23) & 0x4;
+         op->xsrc = (instruction >> 20) & 0x7;
+         op->ybus = (instruction >> 17) & 0x4;
+         op->abus = (instruction >> 17) & 0x3;
+         op->ysrc = (instruction >> 14) & 0x7;
+         op->d1bus = (instruction >> 12) & 0x3;
+         op->d1dst = (instruction >> 8) & 0xF;
+         op->d1src = instruction & 0xF;
+         op->imm = (s32)(signed char)(instruction & 0xFF);
+         op->counters = ((op->pbus == 3 || op->xbus) && op->xsrc >= 4) ||
+            ((op->abus == 3 || op->ybus) && op->ysrc >= 4) ||
+            (op->d1bus == 3 && op->d1src >= 4 && op->d1src <= 7) ||
+            (op->d1bus != 0 && op->d1dst <= 3);
+         break;
+      case 0x02: // Load Immediate Commands
+         op->kind = SCUDSP_OP_MVI;
+         op->d1dst = (instruction >> 26) & 0xF;
+         op->counters = op->d1dst <= 3;
+         if ((instruction >> 25) & 1)
+         {
+            if (!ScuDspDecodeCondition(op, (instruction >> 19) & 0x3F))
+               op->kind = SCUDSP_OP_NOP;
+            op->imm = (instruction & 0x7FFFF) | ((instruction & 0x40000) ? 0xFFF80000 : 0x00000000);
+         }
+         else
+         {
+            op->imm = (instruction & 0x1FFFFFF);
+            if (op->imm & 0x1000000) op->imm |= 0xfe000000;
+         }
+         break;
+      case 0x03: // Other
+         switch ((instruction >> 28) & 0xF) {
+            case 0x0C:
+               op->kind = SCUDSP_OP_DMA;
+               break;
+            case 0x0D:
+               op->kind = SCUDSP_OP_JMP;
+               op->imm = instruction & 0xFF;
+               if (((instruction >> 19) & 0x7F) != 0x00 &&
+                   (!(instruction & 0x2000000) || !ScuDspDecodeCondition(op, (instruction >> 19) & 0x3F)))
+               {
+                  LOG("scu\t: Unknown JMP instruction not implemented\n");
+                  op->kind = SCUDSP_OP_NOP;
+               }
+               break;
+            case 0x0E:
+               op->kind = (instruction & 0x8000000) ? SCUDSP_OP_LPS : SCUDSP_OP_BTM;
+               break;
+            case 0x0F:
+               op->kind = SCUDSP_OP_END;
+               op->interrupt = (instruction & 0x8000000) != 0;
+               break;
+            default:
+               break;
+         }
+         break;
+      default:
+         op->kind = SCUDSP_OP_INVALID;
+         break;
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Same steps as the interpreter in ScuExec without decoding the word again.
+// incFlg is always clear between instructions, so it's not reset here.
+static void ScuDspExecCached(s32 dsp_counter)
+{
+   u32 ran = 0, held = 0;
+
+   while (dsp_counter > 0) {
+      const scudspop_struct *op;
+
+      if (ScuDsp->ProgControlPort.part.T0 != 0) {
+         step_dsp_dma(ScuDsp);
+      }
+
+      // the DMA above may have loaded the word
+      op = &ScuDspOps[ScuDsp->PC];
+      if (!op->valid)
+         ScuDspDecode(ScuDsp->PC);
+      ran++;
+
+      ScuDsp->ALU.all = ScuDsp->AC.all;
+
+      switch (op->kind) {
+         case SCUDSP_OP_OPERATION:
+            ScuDspAlu(op->alu);
+
+            if (op->pbus == 2)
+               ScuDsp->P.all = (s64)ScuDsp->RX * (s32)ScuDsp->RY;
+            else if (op->pbus == 3)
+               ScuDsp->P.all = (s64)(s32)readgensrc(op->xsrc);
+            if (op->xbus)
+               ScuDsp->RX = readgensrc(op->xsrc);
+            if (op->ybus)
+               ScuDsp->RY = readgensrc(op->ysrc);
+            if (op->abus == 1)
+               ScuDsp->AC.all = 0;
+            else if (op->abus == 2)
+               ScuDsp->AC.all = ScuDsp->ALU.all;
+            else if (op->abus == 3)
+               ScuDsp->AC.all = (s64)(s32)readgensrc(op->ysrc);
+
+            if (op->d1bus == 1) {
+               if (incFlg[0] != 0){ ScuDsp->CT[0]++; ScuDsp->CT[0] &= 0x3f; incFlg[0] = 0; };
+               if (incFlg[1] != 0){ ScuDsp->CT[1]++; ScuDsp->CT[1] &= 0x3f; incFlg[1] = 0; };
+               if (incFlg[2] != 0){ ScuDsp->CT[2]++; ScuDsp->CT[2] &= 0x3f; incFlg[2] = 0; };
+               if (incFlg[3] != 0){ ScuDsp->CT[3]++; ScuDsp->CT[3] &= 0x3f; incFlg[3] = 0; };
+               writed1busdest(op->d1dst, (u32)op->imm);
+            }
+            else if (op->d1bus == 3)
+               writed1busdest(op->d1dst, readgensrc(op->d1src));
+            break;
+         case SCUDSP_OP_MVI:
+            if (ScuDspCondition(op))
+               writeloadimdest(op->d1dst, (u32)op->imm);
+            break;
+         case SCUDSP_OP_DMA:
+            ScuDspStartDma(op->instruction);
+            break;
+         case SCUDSP_OP_JMP:
+            if (ScuDsp->jmpaddr == 0xffffffff && ScuDspCondition(op)) {
+               ScuDsp->jmpaddr = op->imm;
+               ScuDsp->delayed = 0;
+            }
+            break;
+         case SCUDSP_OP_LPS:
+            if (ScuDsp->LOP != 0) {
+               ScuDsp->jmpaddr = ScuDsp->PC;
+               ScuDsp->delayed = 0;
+               ScuDsp->LOP--;
+            }
+            break;
+         case SCUDSP_OP_BTM:
+            if (ScuDsp->LOP != 0) {
+               ScuDsp->jmpaddr = ScuDsp->TOP;
+               ScuDsp->delayed = 0;
+               ScuDsp->LOP--;
+            }
+            break;
+         case SCUDSP_OP_END:
+            ScuDsp->ProgControlPort.part.EX = 0;
+            if (op->interrupt) {
+               ScuDsp->ProgControlPort.part.E = 1;
+               ScuSendDSPEnd();
+            }
+            LOG("dsp has ended\n");
+            ScuDsp->ProgControlPort.part.P = ScuDsp->PC+1;
+            dsp_counter = 1;
+            break;
+         case SCUDSP_OP_INVALID:
+            LOG("scu\t: Invalid DSP opcode %08X at offset %02X\n", op->instruction, ScuDsp->PC);
+            break;
+         default:
+            break;
+      }
+
+      if (op->counters) {
+         if (incFlg[0] != 0){ ScuDsp->CT[0]++; ScuDsp->CT[0] &= 0x3f; incFlg[0] = 0; };
+         if (incFlg[1] != 0){ ScuDsp->CT[1]++; ScuDsp->CT[1] &= 0x3f; incFlg[1] = 0; };
+         if (incFlg[2] != 0){ ScuDsp->CT[2]++; ScuDsp->CT[2] &= 0x3f; incFlg[2] = 0; };
+         if (incFlg[3] != 0){ ScuDsp->CT[3]++; ScuDsp->CT[3] &= 0x3f; incFlg[3] = 0; };
+      }
+
+      ScuDsp->PC++;
+
+      // Handle delayed jumps
+      if (ScuDsp->jmpaddr != 0xFFFFFFFF)
+      {
+         if (ScuDsp->delayed)
+         {
+            ScuDsp->PC = (unsigned char)ScuDsp->jmpaddr;
+            ScuDsp->jmpaddr = 0xFFFFFFFF;
+            dsp_counter += 1; // hold clock
+            held++;
+         }
+         else
+            ScuDsp->delayed = 1;
+      }
+      dsp_counter--;
+   }
+
+   ScuDspFrameStats.cached += ran;
+   ScuDspFrameStats.cycles += ran + held;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 void ScuExec(u32 timing) {
    int i;
 
@@ -1382,8 +2214,11 @@ void ScuExec(u32 timing) {
   ScuDmaProc(ScuRegs, (int)timing<<4);
 #endif
 
-   // is dsp executing?
-   if (ScuDsp->ProgControlPort.part.EX) {
+   // is dsp executing? Breakpoints are only checked by the interpreter
+   if (ScuDsp->ProgControlPort.part.EX && ScuDspCacheEnabled && ScuBP->numcodebreakpoints == 0) {
+      ScuDspExecCached((s32)timing);
+   }
+   else if (ScuDsp->ProgControlPort.part.EX) {
 
      DSPLOG( "*********************************************\n");
 
@@ -1410,6 +2245,8 @@ void ScuExec(u32 timing) {
 
          instruction = ScuDsp->ProgramRam[ScuDsp->PC];
          //LOG("scu: dsp %08X @ %08X", instruction, ScuDsp->PC);
+         ScuDspFrameStats.interpreted++;
+         ScuDspFrameStats.cycles++;
          incFlg[0] = 0;
          incFlg[1] = 0;
          incFlg[2] = 0;
@@ -1424,238 +2261,7 @@ void ScuExec(u32 timing) {
          }
 #endif
          // ALU commands
-         switch (instruction >> 26)
-         {
-            case 0x0: // NOP
-               //AC is moved as-is to the ALU
-              //ScuDsp->ALU.all = ScuDsp->AC.all;
-               break;
-            case 0x1: // AND
-               //the upper 16 bits of AC are not modified for and, or, add, sub, rr and rl8
-              ScuDsp->ALU.part.L = (s64)((u32)ScuDsp->AC.part.L & (u32)ScuDsp->P.part.L);
-
-               if (ScuDsp->ALU.part.L == 0)
-                  ScuDsp->ProgControlPort.part.Z = 1;
-               else
-                  ScuDsp->ProgControlPort.part.Z = 0;
-
-               if ((s64)ScuDsp->ALU.part.L < 0)
-                  ScuDsp->ProgControlPort.part.S = 1;
-               else
-                  ScuDsp->ProgControlPort.part.S = 0;
-
-               ScuDsp->ProgControlPort.part.C = 0;
-               break;
-            case 0x2: // OR
-              ScuDsp->ALU.part.L = (u64)((u32)ScuDsp->AC.part.L | (u32)ScuDsp->P.part.L);
-
-               if (ScuDsp->ALU.part.L == 0)
-                  ScuDsp->ProgControlPort.part.Z = 1;
-               else
-                  ScuDsp->ProgControlPort.part.Z = 0;
-
-               if ((s64)ScuDsp->ALU.part.L < 0)
-                  ScuDsp->ProgControlPort.part.S = 1;
-               else
-                  ScuDsp->ProgControlPort.part.S = 0;
-
-               ScuDsp->ProgControlPort.part.C = 0;
-               break;
-            case 0x3: // XOR
-              ScuDsp->ALU.part.L = (u64)((u32)ScuDsp->AC.part.L ^ (u32)ScuDsp->P.part.L);
-
-               if (ScuDsp->ALU.part.L == 0)
-                  ScuDsp->ProgControlPort.part.Z = 1;
-               else
-                  ScuDsp->ProgControlPort.part.Z = 0;
-
-               if ((s64)ScuDsp->ALU.part.L < 0)
-                  ScuDsp->ProgControlPort.part.S = 1;
-               else
-                  ScuDsp->ProgControlPort.part.S = 0;
-
-               ScuDsp->ProgControlPort.part.C = 0;
-               break;
-            case 0x4: // ADD
-               ScuDsp->ALU.part.L = (s32)ScuDsp->AC.part.L + (s32)ScuDsp->P.part.L;
-                 DSPLOG( "%02X: %d + %d = %d\n", ScuDsp->PC, (s32)ScuDsp->AC.part.L, (s32)ScuDsp->P.part.L, (s32)ScuDsp->ALU.part.L);
-               if (ScuDsp->ALU.part.L == 0)
-                  ScuDsp->ProgControlPort.part.Z = 1;
-               else
-                  ScuDsp->ProgControlPort.part.Z = 0;
-
-               if ((s32)ScuDsp->ALU.part.L < 0)
-                  ScuDsp->ProgControlPort.part.S = 1;
-               else
-                  ScuDsp->ProgControlPort.part.S = 0;
-
-               //0x00000001 + 0xFFFFFFFF will set the carry bit, needs to be unsigned math
-               if (((u64)(u32)ScuDsp->P.part.L + (u64)(u32)ScuDsp->AC.part.L) & 0x100000000){
-                 ScuDsp->ProgControlPort.part.C = 1;
-               }
-               else{
-                 ScuDsp->ProgControlPort.part.C = 0;
-               }
-
- 
-               //if (ScuDsp->ALU.part.L ??) // set overflow flag
-               //    ScuDsp->ProgControlPort.part.V = 1;
-               //else
-               //   ScuDsp->ProgControlPort.part.V = 0;
-               break;
-            case 0x5: // SUB
-            {
-              u64 ans = (u64)ScuDsp->AC.part.L - (u32)ScuDsp->P.part.L;
-              ScuDsp->ALU.part.L = (s32)ScuDsp->AC.part.L - (s32)ScuDsp->P.part.L;
-              DSPLOG( "%02X: %" PRId64 " - %d = %" PRId64 " \n", ScuDsp->PC, (u64)ScuDsp->AC.part.L, (u32)ScuDsp->P.part.L, ans);
-              //ScuDsp->ProgControlPort.part.C = ((ans >> 32) & 0x01);
-
-              //ScuDsp->ALU.part.L = ans;
-
-              if (ScuDsp->ALU.part.L == 0)
-                ScuDsp->ProgControlPort.part.Z = 1;
-              else
-                ScuDsp->ProgControlPort.part.Z = 0;
-
-              if ((s64)ScuDsp->ALU.part.L < 0)
-                ScuDsp->ProgControlPort.part.S = 1;
-              else
-                ScuDsp->ProgControlPort.part.S = 0;
-
-              //0x00000001 - 0xFFFFFFFF will set the carry bit, needs to be unsigned math
-              if ((((u64)(u32)ScuDsp->AC.part.L - (u64)(u32)ScuDsp->P.part.L)) & 0x100000000)
-                ScuDsp->ProgControlPort.part.C = 1;
-              else
-                ScuDsp->ProgControlPort.part.C = 0;
-
-              //0x00000001 - 0xFFFFFFFF will set the carry bit, needs to be unsigned math
-              //if ((((u64)(u32)ScuDsp->AC.part.L - (u64)(u32)ScuDsp->P.part.L)) & 0x100000000)
-              //  ScuDsp->ProgControlPort.part.C = 1;
-              //else
-              //  ScuDsp->ProgControlPort.part.C = 0;
-
-
-              //               if (ScuDsp->ALU.part.L ??) // set overflow flag
-              //                  ScuDsp->ProgControlPort.part.V = 1;
-              //               else
-              //                  ScuDsp->ProgControlPort.part.V = 0;
-            }
-               break;
-            case 0x6: // AD2
-              ScuDsp->ALU.all = (s64)ScuDsp->AC.all +(s64)ScuDsp->P.all;
-               DSPLOG( "%02X: %" PRId64 "+2 %" PRId64 "= %" PRId64 "\n", ScuDsp->PC, ScuDsp->AC.all, ScuDsp->P.all, ScuDsp->ALU.all);
-               if (ScuDsp->ALU.all == 0)
-                  ScuDsp->ProgControlPort.part.Z = 1;
-               else
-                  ScuDsp->ProgControlPort.part.Z = 0;
-
-               //0x500000000000 + 0xd00000000000 will set the sign bit
-               if (ScuDsp->ALU.all & 0x800000000000)
-                  ScuDsp->ProgControlPort.part.S = 1;
-               else
-                  ScuDsp->ProgControlPort.part.S = 0;
-
-               //AC.all and P.all are sign-extended so we need to mask it off and check for a carry
-               if (((ScuDsp->AC.all & 0xffffffffffff) + (ScuDsp->P.all & 0xffffffffffff)) & (0x1000000000000))
-                  ScuDsp->ProgControlPort.part.C = 1;
-               else
-                  ScuDsp->ProgControlPort.part.C = 0;
-
-//               if (ScuDsp->ALU.part.unused != 0)
-//                  ScuDsp->ProgControlPort.part.V = 1;
-//               else
-//                  ScuDsp->ProgControlPort.part.V = 0;
-
-               break;
-            case 0x8: // SR
-              ScuDsp->ProgControlPort.part.C = ScuDsp->AC.part.L & 0x1;
-               ScuDsp->ALU.part.L = (ScuDsp->AC.part.L & 0x80000000) | (ScuDsp->AC.part.L >> 1);
-
-               if (ScuDsp->ALU.part.L == 0)
-                  ScuDsp->ProgControlPort.part.Z = 1;
-               else
-                  ScuDsp->ProgControlPort.part.Z = 0;
-
-               if (ScuDsp->ALU.part.L & 0x80000000)
-                  ScuDsp->ProgControlPort.part.S = 1;
-               else
-                  ScuDsp->ProgControlPort.part.S = 0;
-
-               //0x00000001 >> 1 will set the carry bit
-               //ScuDsp->ProgControlPort.part.C = ScuDsp->ALU.part.L >> 31; would not handle this case
-               break;
-            case 0x9: // RR
-              ScuDsp->ProgControlPort.part.C = ScuDsp->AC.part.L & 0x1;
-               ScuDsp->ALU.part.L = ((u32)(ScuDsp->ProgControlPort.part.C) << 31) | ((u32)(ScuDsp->AC.part.L) >> 1) ;
-               
-               if (ScuDsp->ALU.part.L == 0)
-                  ScuDsp->ProgControlPort.part.Z = 1;
-               else
-                  ScuDsp->ProgControlPort.part.Z = 0;
-
-               //rotating 0x00000001 right will produce 0x80000000 and set 
-               //the sign bit.
-               if (ScuDsp->ALU.part.L & 0x80000000)
-                  ScuDsp->ProgControlPort.part.S = 1;
-               else
-                  ScuDsp->ProgControlPort.part.S = 0;
-               break;
-            case 0xA: // SL
-              ScuDsp->ProgControlPort.part.C = (ScuDsp->AC.part.L >> 31) & 0x01;
-
-               ScuDsp->ALU.part.L = (u32)(ScuDsp->AC.part.L << 1);
-
-               if (ScuDsp->ALU.part.L == 0)
-                  ScuDsp->ProgControlPort.part.Z = 1;
-               else
-                  ScuDsp->ProgControlPort.part.Z = 0;
-
-               if (ScuDsp->ALU.part.L & 0x80000000)
-                  ScuDsp->ProgControlPort.part.S = 1;
-               else
-                  ScuDsp->ProgControlPort.part.S = 0;
-               break;
-            case 0xB: // RL
-
-              ScuDsp->ProgControlPort.part.C = (ScuDsp->AC.part.L >> 31) & 0x01;
-
-               ScuDsp->ALU.part.L = (((u32)ScuDsp->AC.part.L << 1) | ScuDsp->ProgControlPort.part.C);
-               
-               if (ScuDsp->ALU.part.L == 0)
-                  ScuDsp->ProgControlPort.part.Z = 1;
-               else
-                  ScuDsp->ProgControlPort.part.Z = 0;
-         
-               if (ScuDsp->ALU.part.L & 0x80000000)
-                  ScuDsp->ProgControlPort.part.S = 1;
-               else
-                  ScuDsp->ProgControlPort.part.S = 0;
-               
-               //ScuDsp->AC.part.L = ScuDsp->ALU.part.L;
-               break;
-            case 0xF: // RL8
-              DSPLOG( "%02X:RL8 %d = %d\n", ScuDsp->PC, ScuDsp->AC.part.L, ((u32)(ScuDsp->AC.part.L << 8) | ((ScuDsp->AC.part.L >> 24) & 0xFF)) );
-              ScuDsp->ProgControlPort.part.C = (ScuDsp->AC.part.L >> 24) & 0x01;
-              ScuDsp->ALU.part.L  = ((u32)(ScuDsp->AC.part.L << 8) | ((ScuDsp->AC.part.L >> 24) & 0xFF)) ;
-
-              if (ScuDsp->ALU.part.L == 0)
-                  ScuDsp->ProgControlPort.part.Z = 1;
-               else
-                  ScuDsp->ProgControlPort.part.Z = 0;
-
-               //rotating 0x00ffffff left 8 will produce 0xffffff00 and
-               //set the sign bit
-               if ( ScuDsp->ALU.part.L & 0x80000000 )
-                  ScuDsp->ProgControlPort.part.S = 1;
-               else
-                  ScuDsp->ProgControlPort.part.S = 0;
-
-               //rotating 0xff000000 left 8 will produce 0x000000ff and set the
-               //carry bit
-               //ScuDsp->ProgControlPort.part.C = (ScuDsp->AC.part.L >> 24) & 0x01;
-               break;
-            default: break;
-         }
+         ScuDspAlu(instruction >> 26);
 
          
          switch (instruction >> 30) {
@@ -1777,70 +2383,7 @@ void ScuExec(u32 timing) {
                switch((instruction >> 28) & 0xF) {
                  case 0x0C: // DMA Commands
                  {
-                   // Finish Previous DMA operation
-                   if (ScuDsp->dsp_dma_wait > 0) {
-                     ScuDsp->dsp_dma_wait = 0;
-                     step_dsp_dma(ScuDsp);
-                   }
-
-                   ScuDsp->dsp_dma_instruction = instruction;
-                   ScuDsp->ProgControlPort.part.T0 = 1;
-
-                   int Counter = 0;
-                   if ( ((instruction >> 10) & 0x1F) == 0x00 || 
-                        ((instruction >> 10) & 0x1F) == 0x04  || 
-                        ((instruction >> 11) & 0x0F) == 0x08 || 
-                        ((instruction >> 10) & 0x1F) == 0x14 )
-                   {
-                      Counter = instruction & 0xFF;
-                   }
-                   else if (
-                     ((instruction >> 11) & 0x0F) == 0x04 || 
-                     ((instruction >> 10) & 0x1F) == 0x0C || 
-                     ((instruction >> 11) & 0x0F) == 0x0C || 
-                     ((instruction >> 10) & 0x1F) == 0x1C)
-                   {
-                     switch ((instruction & 0x7))
-                     {
-                     case 0x00: Counter = ScuDsp->MD[0][ScuDsp->CT[0] & 0x3F]; break;
-                     case 0x01: Counter = ScuDsp->MD[1][ScuDsp->CT[1] & 0x3F]; break;
-                     case 0x02: Counter = ScuDsp->MD[2][ScuDsp->CT[2] & 0x3F]; break;
-                     case 0x03: Counter = ScuDsp->MD[3][ScuDsp->CT[3] & 0x3F]; break;
-                     case 0x04: Counter = ScuDsp->MD[0][ScuDsp->CT[0] & 0x3F]; ScuDsp->CT[0]++; ScuDsp->CT[0] &= 0x3F; break;
-                     case 0x05: Counter = ScuDsp->MD[1][ScuDsp->CT[1] & 0x3F]; ScuDsp->CT[1]++; ScuDsp->CT[1] &= 0x3F; break;
-                     case 0x06: Counter = ScuDsp->MD[2][ScuDsp->CT[2] & 0x3F]; ScuDsp->CT[2]++; ScuDsp->CT[2] &= 0x3F; break;
-                     case 0x07: Counter = ScuDsp->MD[3][ScuDsp->CT[3] & 0x3F]; ScuDsp->CT[3]++; ScuDsp->CT[3] &= 0x3F; break;
-                     }
-
-                   }
-
-                   ScuDsp->dsp_dma_size = Counter;
-                   ScuDsp->dsp_dma_wait = 2; // DMA operation will be start when this count is zero
-                   ScuDsp->WA0M = ScuDsp->WA0;
-                   ScuDsp->RA0M = ScuDsp->RA0;
-
-                   int cycle = 0;
-                   switch ((ScuDsp->WA0M << 2) & 0xDFF00000) {
-                   case 0x00200000: /* Low */
-                     cycle = 2;
-                     break;
-                   case 0x05A00000: /* SOUND */
-                     cycle = 1;
-                     break;
-                   case 0x05C00000: /* VDP1 */
-                     cycle = 1;
-                     break;
-                   case 0x05e00000: /* VDP2 */
-                     cycle = 1;
-                     break;
-                   case 0x06000000: /* High */
-                     cycle = 4;
-                     break;
-                   default:
-                     cycle = 4;
-                   }
-                   ScuDsp->dsp_dma_wait = (Counter >> cycle) + 1;
-                   LOG("Start DSP DMA RA=%08X WA=%08X inst=%08X count=%d wait = %d", ScuDsp->RA0M<<2, ScuDsp->WA0M<<2, ScuDsp->dsp_dma_instruction, Counter, ScuDsp->dsp_dma_wait );
+                   ScuDspStartDma(instruction);
                    break;
                   }
                   case 0x0D: // Jump Commands
@@ -1999,6 +2542,7 @@ void ScuExec(u32 timing) {
                ScuDsp->PC = (unsigned char)ScuDsp->jmpaddr;
                ScuDsp->jmpaddr = 0xFFFFFFFF;
                dsp_counter += 1; // hold clock
+               ScuDspFrameStats.cycles++;
             }
             else
                ScuDsp->delayed = 1;
@@ -2499,6 +3043,25 @@ void ScuDspStep(void) {
 
 //////////////////////////////////////////////////////////////////////////////
 
+void ScuDspSetCache(int enable) {
+   ScuDspCacheEnabled = enable;
+   memset(ScuDspOps, 0, sizeof(ScuDspOps));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void ScuDmaSetBulk(int enable) {
+   ScuDmaBulkEnabled = enable;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void ScuDspGetStats(scudspstats_struct *stats) {
+   *stats = ScuDspLastStats;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 int ScuDspSaveProgram(const char *filename) {
    FILE *fp;
    u32 i;
@@ -2598,6 +3161,7 @@ void ScuDspGetRegisters(scudspregs_struct *regs) {
 void ScuDspSetRegisters(scudspregs_struct *regs) {
    if (regs != NULL) {
       memcpy(ScuDsp->ProgramRam, regs->ProgramRam, sizeof(u32) * 256);
+      ScuDspInvalidateProgram();
       memcpy(ScuDsp->MD, regs->MD, sizeof(u32) * 64 * 4);
 
       ScuDsp->ProgControlPort.all = regs->ProgControlPort.all;
@@ -2963,6 +3527,7 @@ void FASTCALL ScuWriteLong(u32 addr, u32 val) {
       case 0x84: // DSP Program Ram Data Port
          //LOG("scu: wrote %08X to DSP Program ram offset %02X", val, ScuDsp->PC);
          ScuDsp->ProgramRam[ScuDsp->PC] = val;
+         ScuDspInvalidateWord(ScuDsp->PC);
          ScuDsp->PC++;
          ScuDsp->ProgControlPort.part.P = ScuDsp->PC;
          break;
@@ -3330,6 +3895,10 @@ void ScuSendVBlankIN(void) {
    ScuRemoveTimer0();
    SendInterrupt(0x40, 0xF, 0x0001, 0x0001);
    ScuChekIntrruptDMA(0);
+
+   ScuDspFrameStats.cycles_per_second = ScuDspFrameStats.cycles * (yabsys.IsPal ? 50 : 60);
+   ScuDspLastStats = ScuDspFrameStats;
+   memset(&ScuDspFrameStats, 0, sizeof(ScuDspFrameStats));
    
 }
 
@@ -3677,6 +4246,8 @@ int ScuLoadState(FILE *fp, UNUSED int version, int size)
      yread(&check, incFlg, sizeof(int), 4, fp);
    }
 
+   ScuDspInvalidateProgram();
+
    return size;
 }
 
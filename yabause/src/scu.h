@@ -296,6 +296,16 @@ extern "C" {
     u32 dmy;
   } scudspregs_struct;
 
+  // DSP counters of the last frame, updated at VBlank IN
+  typedef struct {
+    u32 cycles;             // DSP cycles run, hold clocks of jumps included
+    u32 cycles_per_second;  // cycles at the frame rate
+    u32 cached;             // instructions run from decoded program words
+    u32 interpreted;        // instructions decoded as they ran
+    u32 decodes;            // program words decoded for the cache
+    u32 invalidations;      // decoded words dropped by program writes
+  } scudspstats_struct;
+
 
   int ScuInit(void);
   void ScuDeInit(void);
@@ -343,6 +353,14 @@ extern "C" {
 
   void ScuDspDisasm(u8 addr, char *outstring);
   void ScuDspStep(void);
+  // ScuDspSetCache: run the DSP from decoded program words (the default) or
+  // through the interpreter. The interpreter is always used while code
+  // breakpoints are set.
+  void ScuDspSetCache(int enable);
+  void ScuDspGetStats(scudspstats_struct *stats);
+  // ScuDmaSetBulk: move transfers between work ram and the vdp rams with
+  // one copy per span (the default) or one bus access per element
+  void ScuDmaSetBulk(int enable);
   int ScuDspSaveProgram(const char *filename);
   int ScuDspSaveMD(const char *filename, int num);
   void ScuDspGetRegisters(scudspregs_struct *regs);
@@ -343,11 +343,11 @@ void DumpInstX( int i, u32 pc, u16 op  )
 
 #define opNULL			x86op_desc(0,0,0,0,0,0,0,0,0,0)
 
-#if defined(_WINDOWS)
+#if defined(_WINDOWS) || defined(__x86_64__)
 
 
 
-#if defined(_WIN64)
+#if defined(_WIN64) || defined(__x86_64__)
   #define PROLOGSIZE		     (0x31)    
   #define SEPERATORSIZE_NORMAL (0x3c-0x31)
   #define SEPERATORSIZE_DELAY_SLOT  (0x6a-0x3c)
@@ -362,6 +362,16 @@ void DumpInstX( int i, u32 pc, u16 op  )
   #define SEPERATORSIZE_DEBUG  (0xe3-0xb5)
   #define SEPERATORSIZE_DELAYD_DEBUG (0x11d-0xe3)
 
+  // Where the templates return to the dispatcher, blocks jump to their exit
+  // stub from there instead, see EmmitExitStub
+  #define LINK_JUMPS
+  #define PAGEFLIP_EXIT_OFFSET (0xa5-0x95)
+  #define DELAY_SLOT_EXIT_OFFSET (0x50-0x3c)
+  #define DELAY_AFTER_EXIT_OFFSET (0x75-0x6a)
+  #define PUSHAQSIZE (0x0f)
+  #define LINKJUMPSIZE 37
+  #define EXITSTUBSIZE 192
+
 #else // 32bit
   #define PROLOGSIZE		     27    
   #define EPILOGSIZE		      3
@@ -410,13 +420,15 @@ void DumpInstX( int i, u32 pc, u16 op  )
 #endif
 
 
+#if !defined(EXITSTUBSIZE)
+#define EXITSTUBSIZE 0
+#endif
+
 #define MININSTRSIZE    3
 #define MAXINSTRSIZE	416
 #define MAXJUMPSIZE		46
 
 #define SAFEPAGESIZE	MAXBLOCKSIZE - MAXINSTRSIZE - SEPERATORSIZE_DELAY_SLOT - SEPERATORSIZE_DELAY_AFTER - SEPERATORSIZE_NORMAL - EPILOGSIZE
-#define MAXINSTRCNT		MAXBLOCKSIZE/(MININSTRSIZE+SEPERATORSIZE_NORMAL)
-int instrSize[NUMOFBLOCKS][MAXINSTRCNT];
 
 #define opinit(x)	extern const unsigned short x##_size; \
                     extern const unsigned char x##_src, x##_dest, x##_off1, x##_imm, x##_off3; \
@@ -745,20 +757,264 @@ x86op_desc asm_list[] =
 void CompileBlocks::Init()
 {
   memset((void*)dCode, 0, sizeof(Block)*NUMOFBLOCKS);
+  for (int i = 0; i < NUMOFBLOCKS; i++ ) {
+    dCode[i].id = i;
+  }
+  Flush();
+  return;
+}
+
+void CompileBlocks::Flush()
+{
   memset(LookupTable, 0, sizeof(LookupTable));
   memset(LookupTableRom, 0, sizeof(LookupTableRom));
   memset(LookupTableLow, 0, sizeof(LookupTableLow));
   memset(LookupTableC, 0, sizeof(LookupTableC));
+  for (int i = 0; i < NUMOFCODEPAGES; i++) {
+    code_pages_[i].clear();
+  }
+  memset(code_page_bits_, 0, sizeof(code_page_bits_));
+  for (int i = 0; i < blockCount; i++) {
+    dCode[i].link[0] = NULL;
+    dCode[i].link[1] = NULL;
+    linked_from_[i].clear();
+  }
   blockCount = 0;
-  LastMakeBlock = 0;
-  g_CompleBlock = dCode;
-  for (int i = 0; i < NUMOFBLOCKS; i++ ) {
-    g_CompleBlock[i].id = i;
+  // the first MAXBLOCKSIZE bytes are kept for code that is run once and
+  // thrown away, see CompileTransientBlock
+  code_used_ = MAXBLOCKSIZE;
+  flush_count_++;
+}
+
+Block **CompileBlocks::lookupEntry(u32 addr)
+{
+  switch (codeArea(addr)) {
+  case 0: return &LookupTableRom[(addr & 0x000FFFFF) >> 1];
+  case 1: return &LookupTableLow[(addr & 0x000FFFFF) >> 1];
+  case 2: return &LookupTable[(addr & 0x000FFFFF) >> 1];
   }
-  for (int i = 0; i < (0x100000>>1) ; i++) {
-    LookupParentTable[i].clear();
+  return NULL;
+}
+
+// Pages covered by a block, a block running past the end of its area stops
+// at the area's last page
+bool CompileBlocks::blockPages(Block *page, int *first, int *last)
+{
+  int area = codeArea(page->b_addr);
+  if (area < 0) return false;
+  *first = area * CODE_AREA_PAGES + ((page->b_addr & 0x000FFFFF) >> CODE_PAGE_SHIFT);
+  *last = area * CODE_AREA_PAGES + ((page->e_addr & 0x000FFFFF) >> CODE_PAGE_SHIFT);
+  if (codeArea(page->e_addr) != area || *last < *first) {
+    *last = (area + 1) * CODE_AREA_PAGES - 1;
+  }
+  return true;
+}
+
+void CompileBlocks::trackBlock(Block *page)
+{
+  int first, last;
+  if (!blockPages(page, &first, &last)) return;
+  page->flags |= BLOCK_TRACKED;
+  for (int i = first; i <= last; i++) {
+    code_pages_[i].push_back(page);
+    code_page_bits_[i >> 5] |= (1 << (i & 31));
+  }
+}
+
+void CompileBlocks::removeBlock(Block *page)
+{
+  int first, last;
+  if (!blockPages(page, &first, &last)) return;
+  for (int i = first; i <= last; i++) {
+    vector<Block *> & blocks = code_pages_[i];
+    for (size_t j = 0; j < blocks.size(); j++) {
+      if (blocks[j] == page) {
+        blocks[j] = blocks.back();
+        blocks.pop_back();
+        break;
+      }
+    }
+    if (blocks.empty()) {
+      code_page_bits_[i >> 5] &= ~(1 << (i & 31));
+    }
+  }
+  Block **entry = lookupEntry(page->b_addr);
+  if (*entry == page) {
+    *entry = NULL;
+  }
+
+  // nothing may jump into the old code any more
+  vector<Block *> & callers = linked_from_[page->id];
+  for (size_t j = 0; j < callers.size(); j++) {
+    for (int k = 0; k < 2; k++) {
+      if (callers[j]->link[k] == page) {
+        callers[j]->link[k] = NULL;
+        unpatchLink(callers[j], k);
+        unlink_count_++;
+      }
+    }
+  }
+  callers.clear();
+  remove_count_++;
+}
+
+void CompileBlocks::linkBlock(Block *from, Block *to)
+{
+#if defined(SET_DIRTY)
+  // Only blocks removed through removeBlock can be linked, the others are
+  // dropped by clearing their lookup table entry and would stay reachable
+  if ((from->flags & BLOCK_TRACKED) == 0 || (to->flags & BLOCK_TRACKED) == 0) {
+    return;
+  }
+  for (int k = 0; k < 2; k++) {
+    if (from->exit_pc[k] == to->b_addr && from->link[k] == NULL) {
+      from->link[k] = to;
+      linked_from_[to->id].push_back(from);
+      link_count_++;
+      // the dispatcher has to see the idle loops and step in debug mode
+      if (!debug_mode_ && (to->flags & BLOCK_LOOP) == 0) {
+        patchLink(from, k, to);
+      }
+    }
+  }
+#endif
+}
+
+#if defined(LINK_JUMPS)
+static inline u8 *emitByte(u8 *ptr, u8 v) { *ptr = v; return ptr + 1; }
+static inline u8 *emitLong(u8 *ptr, u32 v) { memcpy(ptr, &v, 4); return ptr + 4; }
+static inline u8 *emitQuad(u8 *ptr, u64 v) { memcpy(ptr, &v, 8); return ptr + 8; }
+static inline void setRel32(u8 *pos, u8 *to) { s32 rel = (s32)(to - (pos + 4)); memcpy(pos, &rel, 4); }
+
+// Blocks with statically known successors leave through this stub instead of
+// returning. It does what the dispatcher does between two blocks: adds the
+// memory access cycles to the clock, returns when the time slice is over or
+// an interrupt can be taken, and takes the jump of the exit matching the pc.
+// The jumps return too until linkBlock patches them.
+//
+//   mov eax,[rdi+memcycle]; add [r12+4],eax; mov dword [rdi+memcycle],0
+//   mov eax,[r12+4]; cmp eax,[rdi+exitcount]; jae ret
+//   mov eax,[rbx]; and eax,0xF0; cmp eax,[r12+8]; jb ret
+//   mov eax,[r12]; cmp eax,exit_pc[k]; je ret (patched to link k)
+// ret:
+//   popaq; ret
+u8 *CompileBlocks::EmmitExitStub(Block *page, u8 *ptr, u8 **sites, int count)
+{
+  u8 *stub = ptr;
+  u8 *to_ret[4];
+  int jumps = 0;
+
+  for (int i = 0; i < count; i++) {
+    sites[i][0] = 0xE9; // jmp rel32
+    setRel32(sites[i] + 1, stub);
+  }
+
+  ptr = emitByte(ptr, 0x8B); ptr = emitByte(ptr, 0x87);
+  ptr = emitLong(ptr, offsetof(tagSH2, memcycle));
+  ptr = emitByte(ptr, 0x41); ptr = emitByte(ptr, 0x01); ptr = emitByte(ptr, 0x44);
+  ptr = emitByte(ptr, 0x24); ptr = emitByte(ptr, 0x04);
+  ptr = emitByte(ptr, 0xC7); ptr = emitByte(ptr, 0x87);
+  ptr = emitLong(ptr, offsetof(tagSH2, memcycle)); ptr = emitLong(ptr, 0);
+
+  ptr = emitByte(ptr, 0x41); ptr = emitByte(ptr, 0x8B); ptr = emitByte(ptr, 0x44);
+  ptr = emitByte(ptr, 0x24); ptr = emitByte(ptr, 0x04);
+  ptr = emitByte(ptr, 0x3B); ptr = emitByte(ptr, 0x87);
+  ptr = emitLong(ptr, offsetof(tagSH2, exitcount));
+  ptr = emitByte(ptr, 0x0F); ptr = emitByte(ptr, 0x83);
+  to_ret[jumps++] = ptr; ptr += 4;
+
+  ptr = emitByte(ptr, 0x8B); ptr = emitByte(ptr, 0x03);
+  ptr = emitByte(ptr, 0x25); ptr = emitLong(ptr, 0xF0);
+  ptr = emitByte(ptr, 0x41); ptr = emitByte(ptr, 0x3B); ptr = emitByte(ptr, 0x44);
+  ptr = emitByte(ptr, 0x24); ptr = emitByte(ptr, 0x08);
+  ptr = emitByte(ptr, 0x0F); ptr = emitByte(ptr, 0x82);
+  to_ret[jumps++] = ptr; ptr += 4;
+
+  ptr = emitByte(ptr, 0x41); ptr = emitByte(ptr, 0x8B); ptr = emitByte(ptr, 0x04);
+  ptr = emitByte(ptr, 0x24);
+  for (int k = 0; k < 2; k++) {
+    if (page->exit_pc[k] == NO_EXIT_PC) continue;
+    ptr = emitByte(ptr, 0x3D); ptr = emitLong(ptr, page->exit_pc[k]);
+    ptr = emitByte(ptr, 0x0F); ptr = emitByte(ptr, 0x84);
+    page->exit_jump[k] = ptr;
+    to_ret[jumps++] = ptr; ptr += 4;
+  }
+
+  page->exit_ret = ptr;
+  memcpy((void*)ptr, (void*)epilogue, EPILOGSIZE);
+  ptr += EPILOGSIZE;
+  for (int i = 0; i < jumps; i++) {
+    setRel32(to_ret[i], page->exit_ret);
+  }
+
+  // room for the code patchLink writes
+  for (int k = 0; k < 2; k++) {
+    if (page->exit_jump[k] == NULL) continue;
+    page->exit_link[k] = ptr;
+    ptr += LINKJUMPSIZE;
+  }
+  return ptr;
+}
+
+//   mov rax,&jump_count_; inc dword [rax]      (EXECUTE_STAT only)
+//   mov rax,to; mov [rdi+last_block],rax
+//   mov rcx,rdi; jmp to->code + PUSHAQSIZE
+void CompileBlocks::patchLink(Block *from, int k, Block *to)
+{
+  u8 *ptr = from->exit_link[k];
+  if (from->exit_jump[k] == NULL) return;
+
+#if defined(EXECUTE_STAT)
+  ptr = emitByte(ptr, 0x48); ptr = emitByte(ptr, 0xB8); ptr = emitQuad(ptr, (uintptr_t)&jump_count_);
+  ptr = emitByte(ptr, 0xFF); ptr = emitByte(ptr, 0x00);
+#endif
+  ptr = emitByte(ptr, 0x48); ptr = emitByte(ptr, 0xB8); ptr = emitQuad(ptr, (uintptr_t)to);
+  ptr = emitByte(ptr, 0x48); ptr = emitByte(ptr, 0x89); ptr = emitByte(ptr, 0x87);
+  ptr = emitLong(ptr, offsetof(tagSH2, last_block));
+  ptr = emitByte(ptr, 0x48); ptr = emitByte(ptr, 0x89); ptr = emitByte(ptr, 0xF9);
+  ptr = emitByte(ptr, 0xE9); setRel32(ptr, to->code + PUSHAQSIZE);
+  setRel32(from->exit_jump[k], from->exit_link[k]);
+}
+
+void CompileBlocks::unpatchLink(Block *from, int k)
+{
+  if (from->exit_jump[k] == NULL) return;
+  setRel32(from->exit_jump[k], from->exit_ret);
+}
+#else
+// Only x86-64 has exit stubs. On the other targets linkBlock still records
+// the links, but every block returns to the dispatcher.
+u8 *CompileBlocks::EmmitExitStub(Block *page, u8 *ptr, u8 **sites, int count) { return ptr; }
+void CompileBlocks::patchLink(Block *from, int k, Block *to) {}
+void CompileBlocks::unpatchLink(Block *from, int k) {}
+#endif
+
+void CompileBlocks::invalidateRange(u32 start, u32 length)
+{
+  int area = codeArea(start);
+  if (length == 0 || area < 0) return;
+  u32 first = start & 0x000FFFFE;
+  u32 last = first + length - 1;
+  if (last > 0x000FFFFF) last = 0x000FFFFF;
+
+  // every block on these pages comes from the same area, the offsets are
+  // enough to compare them
+  int base = area * CODE_AREA_PAGES;
+  for (int i = base + (first >> CODE_PAGE_SHIFT); i <= base + (int)(last >> CODE_PAGE_SHIFT); i++) {
+    if ((code_page_bits_[i >> 5] & (1 << (i & 31))) == 0) continue;
+    vector<Block *> & blocks = code_pages_[i];
+    for (size_t j = 0; j < blocks.size(); ) {
+      Block * page = blocks[j];
+      u32 end = page->e_addr & 0x000FFFFF;
+      if (codeArea(page->e_addr) != area || end < (page->b_addr & 0x000FFFFF)) end = 0x000FFFFF;
+      if ((page->b_addr & 0x000FFFFF) <= last && end >= first) {
+        removeBlock(page); // moves another block into slot j
+      }
+      else {
+        j++;
+      }
+    }
   }
-  return;
 }
 
 int CompileBlocks::opcodeIndex(u16 op)
@@ -783,66 +1039,66 @@ void CompileBlocks::BuildInstructionList()
   }
 }
 
-Block * CompileBlocks::CompileBlock(u32 pc, addrs * ParentT = NULL)
+Block * CompileBlocks::CompileBlock(u32 pc, bool track_writes)
 {
   compile_count_++;
 
-  auto block_index = self_modify_block.find(pc);
-  if( block_index != self_modify_block.end()  ){
-      blockCount = block_index->second ;
-      self_modify_block.erase(pc);
-      LOG( "hit! last_modified_block = %d, last_modified_pc = %08X",blockCount, pc );
-  }else{
-    blockCount = LastMakeBlock;
-    LastMakeBlock++;
-    LastMakeBlock &= (NUMOFBLOCKS-1);
+  if (blockCount >= NUMOFBLOCKS || code_used_ + MAXBLOCKSIZE > CODE_ARENA_SIZE) {
+    //LOG("code arena is full, %d blocks %d bytes", blockCount, code_used_);
+    Flush();
   }
-  
-  if (g_CompleBlock[blockCount].b_addr != 0x00) {
-    
-    if ((g_CompleBlock[blockCount].b_addr & 0xFF000000) == 0xC0000000) {
-      LookupTableC[(g_CompleBlock[blockCount].b_addr & 0x000FFFFF) >> 1] = NULL;
-    }
-    else {
-      switch (g_CompleBlock[blockCount].b_addr & 0x0FF00000) {
-      case 0x00000000:
-        if (yabsys.emulatebios) {
-          //return NULL; do nothing
-        }
-        else {
-          LookupTableRom[(g_CompleBlock[blockCount].b_addr & 0x000FFFFF) >> 1] = NULL;
-        }
-        break;
-      case 0x00200000:
-        LookupTableLow[(g_CompleBlock[blockCount].b_addr & 0x000FFFFF) >> 1] = NULL;
-        break;
-      case 0x06000000:
-        /*case 0x06100000:*/
-        LookupTable[(g_CompleBlock[blockCount].b_addr & 0x000FFFFF) >> 1] = NULL;
-        //LOG("%d, %08X is removed due to overflow", blockCount, g_CompleBlock[blockCount].b_addr);
-        break;
-      default:
-        break;
-      }
-    }
-  }
-
-  g_CompleBlock[blockCount].b_addr = pc;
 
+  Block * page = &dCode[blockCount];
+  page->code = code_arena_ + code_used_;
+  page->b_addr = pc;
 
   //LOG("%d,%08X is compiled",blockCount,pc );
-  if (EmmitCode(&g_CompleBlock[blockCount], ParentT) != 0) {
+  if (EmmitCode(page) != 0) {
     return NULL;
   }
 
-  return &g_CompleBlock[blockCount];
+  // keep the next block aligned like a function entry
+  code_used_ += (page->size + 15) & ~15;
+  blockCount++;
+
+  if (track_writes) {
+    trackBlock(page);
+  }
+
+  return page;
+}
+
+Block * CompileBlocks::CompileTransientBlock(u32 pc)
+{
+  static Block transient;
+
+  compile_count_++;
+
+  // Code from areas without a lookup table is compiled every time it runs,
+  // reuse the same space for it instead of filling the arena
+  transient.code = code_arena_;
+  transient.b_addr = pc;
+  transient.id = NUMOFBLOCKS;
+  if (EmmitCode(&transient) != 0) {
+    return NULL;
+  }
+  return &transient;
 }
 
 void CompileBlocks::ShowStatics() {
   //LOG("Compile\t%d\t%d\t%d\n", compile_count_, exec_count_, remove_count_);
+#if defined(EXECUTE_STAT)
+  LOG("Dispatch exec %d lookup %d chained %d jump %d link %d unlink %d flush %d\n",
+    exec_count_, dispatch_count_, chain_count_, jump_count_, link_count_, unlink_count_, flush_count_);
+#endif
   compile_count_ = 0;
   exec_count_ = 0;
   remove_count_ = 0;
+  dispatch_count_ = 0;
+  chain_count_ = 0;
+  link_count_ = 0;
+  unlink_count_ = 0;
+  jump_count_ = 0;
 }
 
 // memo DirectMemoryAccess
@@ -890,7 +1146,7 @@ void CompileBlocks::opcodePass(x86op_desc *op, u16 opcode, u8 *ptr)
   if (*(op->imm) != 0xFF)
     *(ptr + *(op->imm)) = (u8)(opcode & 0xff);
 
-#if _WINDOWS
+#if defined(_WINDOWS) || defined(__x86_64__)
   if (*(op->off3) != 0xFF)
     *(u16*)(ptr + *(op->off3)) = (u16)(opcode & 0xfff);
 #else  
@@ -999,7 +1255,7 @@ int CompileBlocks::overrideMemFunc( void* ptr, int i ) {
 }
 
 
-int CompileBlocks::EmmitCode(Block *page, addrs * ParentT )
+int CompileBlocks::EmmitCode(Block *page)
 {
   int i, j, jmp = 0, count = 0;
   u16 op, temp;
@@ -1009,7 +1265,11 @@ int CompileBlocks::EmmitCode(Block *page, addrs * ParentT )
   u32 instruction_counter = 0;
   u32 write_memory_counter = 0;
   u32 calsize;
+  u32 branch_op = NO_EXIT_PC;
+  u32 branch_addr = 0;
   std::unordered_map<u32, uintptr_t> addr_map;
+  u8 *exit_sites[4];
+  int exit_site_count = 0;
 
   startptr = ptr = page->code;
 
@@ -1056,13 +1316,6 @@ int CompileBlocks::EmmitCode(Block *page, addrs * ParentT )
   while (1) {
     // translate the opcode and insert code
     op = MappedMemoryReadInst(addr, NULL);
-#ifdef SET_DIRTY
-    if (ParentT) {
-      u32 keepaddr = adress_mask(addr);
-      ParentT[keepaddr].push_back(adress_mask(start_addr));
-      ParentT[keepaddr].unique();
-    }
-#endif
 
     addr_map[addr] = (uintptr_t)ptr;
 
@@ -1096,7 +1349,7 @@ int CompileBlocks::EmmitCode(Block *page, addrs * ParentT )
       calsize = (ptr - startptr) + *asm_list[i].size + *asm_list[delayop].size + delay_seperator_size + SEPERATORSIZE_DELAY_AFTER + EPILOGSIZE;
     }
 #endif
-    if (calsize >= MAXBLOCKSIZE) {
+    if (calsize + EXITSTUBSIZE >= MAXBLOCKSIZE) {
       break; // no space is available
     }
 
@@ -1132,6 +1385,7 @@ int CompileBlocks::EmmitCode(Block *page, addrs * ParentT )
     u32 jumppc = 0xFFFFFFFF;
     uintptr_t jumpptr = 0xFFFFFFFF;
     if (asm_list[i].delay != 0xFF && asm_list[i].delay != 0x00) {
+      branch_addr = addr - 2;
       if (asm_list[i].delay == 1) {
         jumppc = addr + ((signed char)(op & 0xff) << 1) + 2;
       }
@@ -1164,7 +1418,7 @@ int CompileBlocks::EmmitCode(Block *page, addrs * ParentT )
       }
 
       memcpy((void*)(ptr + *(asm_list[i].size)), (void*)nomal_seperator, nomal_seperator_size);
-      instrSize[blockCount][count++] = *(asm_list[i].size) + nomal_seperator_size;
+      count++;
       opcodePass(&asm_list[i], op, ptr);
 #if defined(AARCH64)
       u32 * counterpos = (u32*)(ptr + *(asm_list[i].size) + nomal_seperator_counter_offset);
@@ -1188,7 +1442,7 @@ int CompileBlocks::EmmitCode(Block *page, addrs * ParentT )
       }
 
       memcpy((void*)(ptr + *(asm_list[i].size)), (void*)nomal_seperator, nomal_seperator_size);
-      instrSize[blockCount][count++] = *(asm_list[i].size) + nomal_seperator_size;
+      count++;
       opcodePass(&asm_list[i], op, ptr);
       ptr += *(asm_list[i].size) + nomal_seperator_size;
     }
@@ -1207,7 +1461,7 @@ int CompileBlocks::EmmitCode(Block *page, addrs * ParentT )
       if (jumpptr != 0xFFFFFFFF ) {
         intptr_t offset = *(asm_list[i].size) + nomal_seperator_size;
         memcpy((void*)(ptr + offset), (void*)internal_jmp, internal_jmp_size);
-        instrSize[blockCount][count++] = offset + internal_jmp_size;
+        count++;
         opcodePass(&asm_list[i], op, ptr);
         intptr_t jump_offset = jumpptr - (intptr_t)(ptr + offset + internal_jmp_to_offset);
 
@@ -1230,7 +1484,10 @@ int CompileBlocks::EmmitCode(Block *page, addrs * ParentT )
       }
       else {
         memcpy((void*)(ptr + *(asm_list[i].size) + nomal_seperator_size), (void*)PageFlip, DELAYJUMPSIZE);
-        instrSize[blockCount][count++] = *(asm_list[i].size) + nomal_seperator_size + DELAYJUMPSIZE;
+#if defined(LINK_JUMPS)
+        exit_sites[exit_site_count++] = ptr + *(asm_list[i].size) + nomal_seperator_size + PAGEFLIP_EXIT_OFFSET;
+#endif
+        count++;
         opcodePass(&asm_list[i], op, ptr);
 #if defined(AARCH64)
         u32 * counterpos = (u32*)(ptr + *(asm_list[i].size) + nomal_seperator_counter_offset);
@@ -1257,19 +1514,15 @@ int CompileBlocks::EmmitCode(Block *page, addrs * ParentT )
       }
 
       memcpy((void*)(ptr + *(asm_list[i].size)), (void*)delay_seperator, delay_seperator_size);
-      instrSize[blockCount][count++] = *(asm_list[i].size) + delay_seperator_size;
+#if defined(LINK_JUMPS)
+      exit_sites[exit_site_count++] = ptr + *(asm_list[i].size) + DELAY_SLOT_EXIT_OFFSET;
+#endif
+      count++;
       opcodePass(&asm_list[i], op, ptr);
       ptr += *(asm_list[i].size) + delay_seperator_size;
 
       // Get NExt instruction
       temp = MappedMemoryReadInst(addr,NULL);
-#ifdef SET_DIRTY
-      if (ParentT) {
-        u32 keepaddr = adress_mask(addr);
-        ParentT[keepaddr].push_back(adress_mask(start_addr));
-        ParentT[keepaddr].unique();
-      }
-#endif
       addr += 2;
       j = opcodeIndex(temp);
       write_memory_counter += asm_list[j].write_count;
@@ -1306,7 +1559,7 @@ int CompileBlocks::EmmitCode(Block *page, addrs * ParentT )
 
         u32 cpsize = internal_delay_jmp_size;
         memcpy((void*)(ptr + offset), (void*)internal_delay_jmp, internal_delay_jmp_size);
-        instrSize[blockCount][count++] = offset + internal_delay_jmp_size;
+        count++;
         opcodePass(&asm_list[j], temp, ptr);
 
         intptr_t jump_offset = jumpptr - (intptr_t)(ptr + offset + internal_delay_jmp_to_offset);
@@ -1330,7 +1583,10 @@ int CompileBlocks::EmmitCode(Block *page, addrs * ParentT )
       }
       else {
         memcpy((void*)(ptr + offset), (void*)seperator_delay_after, SEPERATORSIZE_DELAY_AFTER);
-        instrSize[blockCount][count++] = offset + SEPERATORSIZE_DELAY_AFTER;
+#if defined(LINK_JUMPS)
+        exit_sites[exit_site_count++] = ptr + offset + DELAY_AFTER_EXIT_OFFSET;
+#endif
+        count++;
         opcodePass(&asm_list[j], temp, ptr);
 #if defined(AARCH64)
         u32 * counterpos = (u32*)(ptr + *(asm_list[j].size) + delayslot_seperator_counter_offset);
@@ -1373,6 +1629,7 @@ int CompileBlocks::EmmitCode(Block *page, addrs * ParentT )
       write_memory_counter = 0;
       //if( (op&0xFF00) == 0x8900) continue;  // BT
       //if( (op&0xFF00) == 0x8B00) continue;  // BF
+      branch_op = op;
       break;
     }
 
@@ -1383,9 +1640,37 @@ int CompileBlocks::EmmitCode(Block *page, addrs * ParentT )
 
   }
   page->e_addr = addr-2;
+#if defined(LINK_JUMPS)
+  exit_sites[exit_site_count++] = ptr;
+#endif
   memcpy((void*)ptr, (void*)epilogue, EPILOGSIZE);
   ptr += EPILOGSIZE;
 
+  // Successors the dispatcher may link to. jmp, jsr, rts, rte, braf, bsrf
+  // and trapa go through a register or memory and get none.
+  page->exit_pc[0] = NO_EXIT_PC;
+  page->exit_pc[1] = NO_EXIT_PC;
+  if (branch_op == NO_EXIT_PC) { // out of space or ldc to sr
+    page->exit_pc[0] = addr;
+  }
+  else if ((branch_op & 0xF900) == 0x8900) { // bt, bf, bt/s, bf/s
+    page->exit_pc[0] = branch_addr + 4 + ((s32)(s8)(branch_op & 0xFF) << 1);
+    page->exit_pc[1] = branch_addr + 2; // not taken, a delay slot starts the next block
+  }
+  else if ((branch_op & 0xE000) == 0xA000) { // bra, bsr
+    s32 disp = branch_op & 0xFFF;
+    if (disp & 0x800) disp |= 0xFFFFF000;
+    page->exit_pc[0] = branch_addr + 4 + (disp << 1);
+  }
+  page->link[0] = NULL;
+  page->link[1] = NULL;
+  page->exit_jump[0] = NULL;
+  page->exit_jump[1] = NULL;
+  if (!debug_mode_ && (page->flags & BLOCK_LOOP) == 0 && page->exit_pc[0] != NO_EXIT_PC) {
+    ptr = EmmitExitStub(page, ptr, exit_sites, exit_site_count);
+  }
+  page->size = ptr - startptr;
+
   if (write_memory_counter > 0) {
     page->flags |= BLOCK_WRITE;
   }
@@ -1419,8 +1704,7 @@ int CompileBlocks::EmmitCode(Block *page, addrs * ParentT )
   return 0;
 }
 
-DynarecSh2::DynarecSh2() {
-  m_pDynaSh2     = new tagSH2;
+DynarecSh2::DynarecSh2() : m_pDynaSh2(new tagSH2), memcycle_(m_pDynaSh2->memcycle) {
 
 #if CACHE_ENABLE
   if (yabsys.use_sh2_cache) {
@@ -1453,6 +1737,8 @@ DynarecSh2::DynarecSh2() {
   interruput_chk_cnt_ = 0;
   interruput_cnt_ = 0;
   pre_PC_ = 0;
+  last_block_ = NULL;
+  last_flush_ = 0;
   ctx_ = NULL;
   mtx_ = YabThreadCreateMutex();
   logenable_ = false;
@@ -1479,6 +1765,7 @@ void DynarecSh2::ResetCPU(){
   m_pDynaSh2->SysReg[5] = 0;
   pre_cnt_ = 0;
   pre_exe_count_ = 0;
+  last_block_ = NULL;
   interruput_chk_cnt_ = 0;
   interruput_cnt_ = 0;
   memcycle_ = 0;
@@ -1578,23 +1865,12 @@ void DynarecSh2::Undecoded(){
 }
 
 
-inline int DynarecSh2::Execute(){
+// Finds or compiles the block at the current PC. Returns NULL with the
+// value Execute has to return in rtn when there is nothing to run.
+Block * DynarecSh2::LookupBlock(int & rtn){
 
   Block * pBlock = NULL;
 
-#if defined(BUILD_INFO)
-  m_pCompiler->setShowCode(true);
-#endif
-
-  m_pCompiler->exec_count_++;
-#if defined(EXECUTE_STAT)
-  //m_pCompiler->setShowCode( is_slave_ );
-  m_pCompiler->setShowCode(true);
-#endif
-//#endif
-
-  //if( !this->is_slave_ ) LOG("Execute %08X", GET_PC());
-
   if ((GET_PC() & 0xFF000000) == 0xC0000000)
   {
     pBlock = m_pCompiler->LookupTableC[(GET_PC() & 0x000FFFFF) >> 1];
@@ -1604,7 +1880,8 @@ inline int DynarecSh2::Execute(){
       m_pCompiler->LookupTableC[(GET_PC() & 0x000FFFFF) >> 1] = pBlock;
       if (pBlock == NULL) {
         Undecoded();
-        return IN_INFINITY_LOOP;
+        rtn = IN_INFINITY_LOOP;
+        return NULL;
       }
     }
   }
@@ -1621,34 +1898,36 @@ inline int DynarecSh2::Execute(){
           LOG("BUP_Init");
           BiosBUPInit(ctx_);
           yabsys.extend_backup = 2;
-          return IN_INFINITY_LOOP;
+          rtn = IN_INFINITY_LOOP;
+          return NULL;
         }
         else if (yabsys.extend_backup == 2 &&
           GET_PC() >= 0x0380 &&
           GET_PC() <= 0x03A8) {
           BiosHandleFunc(ctx_);
-          return IN_INFINITY_LOOP;
+          rtn = IN_INFINITY_LOOP;
+          return NULL;
         }
       }
       if (yabsys.emulatebios) {
 
         const int cmd = (((GET_PC() - 0x200) >> 2) & 0xFF) ;
-        int rtn = 0;
         if ( cmd == 0x40 || cmd == 0x44 || cmd == 0x50 || cmd == 0x51 ) {
           rtn = IN_INFINITY_LOOP;
         }
         ctx_->cycles = 0;
         BiosHandleFunc(ctx_);
         memcycle_ += ctx_->cycles;
-        return rtn;
+        return NULL;
       }
       pBlock = m_pCompiler->LookupTableRom[(GET_PC() & 0x000FFFFF) >> 1];
       if (pBlock == NULL)
       {
-        pBlock = m_pCompiler->CompileBlock(GET_PC());
+        pBlock = m_pCompiler->CompileBlock(GET_PC(), true);
         if (pBlock == NULL) {
           Undecoded();
-          return IN_INFINITY_LOOP;
+          rtn = IN_INFINITY_LOOP;
+          return NULL;
         }
         m_pCompiler->LookupTableRom[(GET_PC() & 0x000FFFFF) >> 1] = pBlock;
       }
@@ -1659,10 +1938,11 @@ inline int DynarecSh2::Execute(){
       pBlock = m_pCompiler->LookupTableLow[(GET_PC() & 0x000FFFFF) >> 1];
       if (pBlock == NULL)
       {
-        pBlock = m_pCompiler->CompileBlock(GET_PC());
+        pBlock = m_pCompiler->CompileBlock(GET_PC(), true);
         if (pBlock == NULL) {
           Undecoded();
-          return IN_INFINITY_LOOP;
+          rtn = IN_INFINITY_LOOP;
+          return NULL;
         }
         m_pCompiler->LookupTableLow[(GET_PC() & 0x000FFFFF) >> 1] = pBlock;
       }
@@ -1675,10 +1955,11 @@ inline int DynarecSh2::Execute(){
       pBlock = m_pCompiler->LookupTable[(GET_PC() & 0x000FFFFF) >> 1];
       if (pBlock == NULL)
       {
-        pBlock = m_pCompiler->CompileBlock(GET_PC(), m_pCompiler->LookupParentTable);
+        pBlock = m_pCompiler->CompileBlock(GET_PC(), true);
         if (pBlock == NULL) {
           Undecoded();
-          return IN_INFINITY_LOOP;
+          rtn = IN_INFINITY_LOOP;
+          return NULL;
         }
         m_pCompiler->LookupTable[(GET_PC() & 0x000FFFFF) >> 1] = pBlock;
       }
@@ -1686,14 +1967,57 @@ inline int DynarecSh2::Execute(){
 
       // Cache
     default:
-      pBlock = m_pCompiler->CompileBlock(GET_PC());
+      pBlock = m_pCompiler->CompileTransientBlock(GET_PC());
       if (pBlock == NULL) {
         Undecoded();
-        return IN_INFINITY_LOOP;
+        rtn = IN_INFINITY_LOOP;
+        return NULL;
       }
       break;
     }
   }
+
+  return pBlock;
+}
+
+inline int DynarecSh2::Execute(){
+
+  Block * pBlock = NULL;
+
+#if defined(BUILD_INFO)
+  m_pCompiler->setShowCode(true);
+#endif
+
+  m_pCompiler->exec_count_++;
+#if defined(EXECUTE_STAT)
+  //m_pCompiler->setShowCode( is_slave_ );
+  m_pCompiler->setShowCode(true);
+#endif
+//#endif
+
+  //if( !this->is_slave_ ) LOG("Execute %08X", GET_PC());
+
+  if (last_block_ != NULL && last_flush_ == m_pCompiler->flush_count_) {
+    pBlock = m_pCompiler->followLink(last_block_, GET_PC());
+  }
+
+  if (pBlock != NULL) {
+    m_pCompiler->chain_count_++;
+  }
+  else {
+    int rtn = 0;
+    pBlock = LookupBlock(rtn);
+    if (pBlock == NULL) {
+      last_block_ = NULL;
+      return rtn;
+    }
+    m_pCompiler->dispatch_count_++;
+    // compiling may have flushed the arena and last_block_ with it
+    if (last_block_ != NULL && last_flush_ == m_pCompiler->flush_count_) {
+      m_pCompiler->linkBlock(last_block_, pBlock);
+    }
+  }
+  m_pDynaSh2->last_block = pBlock;
     
 #if 0
     static FILE * fp = NULL;
@@ -1728,6 +2052,11 @@ inline int DynarecSh2::Execute(){
 #else
   ((dynaFunc)((void*)(pBlock->code)))(m_pDynaSh2);
 #endif
+
+  // blocks linked by a jump ran without coming back here
+  pBlock = m_pDynaSh2->last_block;
+  last_block_ = pBlock;
+  last_flush_ = m_pCompiler->flush_count_;
   
   if ((GET_SR() & 0xF0) < GET_ICOUNT()) {
     this->CheckInterupt();
@@ -25,6 +25,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 #include <map>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <sys/types.h>
 #include <stdint.h>
@@ -80,13 +81,22 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 //#define FREEMEM(x,a)	if(x){ free(x); x = NULL;}
 #endif
 
+// The x86-64 back end is the object assembled for Win64, on other x86-64
+// hosts the generated code and the callbacks it makes keep that convention.
+// Some handlers push a register before calling, so the callbacks realign
+// the stack themselves.
+#if defined(__x86_64__) && !defined(_WINDOWS)
+#define DYNACALL __attribute__((ms_abi, force_align_arg_pointer))
+#else
+#define DYNACALL
+#endif
+
 const int MAX_INSTSIZE = 0xFFFF + 1;
 
 using std::list;
 using std::map;
 using std::string;
-
-typedef list<u32> addrs;
+using std::vector;
 
 struct CompileStaticsNode
 {
@@ -101,23 +111,43 @@ typedef map<u32, CompileStaticsNode> MapCompileStatics;
 // Structs
 //****************************************************
 
-const int NUMOFBLOCKS = 1024 * 4;
+// Compiled code is bump allocated from one executable arena, every block
+// only takes what it needs. When the arena or the block table runs out
+// everything is thrown away and compiled again.
+const int CODE_ARENA_SIZE = 1024 * 1024 * 8;
+const int NUMOFBLOCKS = 1024 * 16;
 // const int MAXBLOCKSIZE = 3072-(4*4);
-const int MAXBLOCKSIZE = 4096;
+const int MAXBLOCKSIZE = 4096; // largest block EmmitCode will produce
 #define MAINMEMORY_SIZE (0x100000);
 #define ROM_SIZE (0x80000);
 
+// Pages that hold compiled code. Rom, low and high work ram each get their
+// own range of page numbers, so the same offset in two areas never shares a page
+const int CODE_PAGE_SHIFT = 9;
+const int CODE_AREA_PAGES = 0x100000 >> CODE_PAGE_SHIFT;
+const int NUMOFCODEAREAS = 3;
+const int NUMOFCODEPAGES = NUMOFCODEAREAS * CODE_AREA_PAGES;
+
 struct Block
 {
-  u8 code[MAXBLOCKSIZE];
+  u8 *code;
+  u32 size;
   u32 b_addr; // beginning PC
   u32 e_addr; // ending PC
   u32 id;
   u32 flags;
+  u32 exit_pc[2]; // statically known successors, 0xFFFFFFFF if none
+  Block *link[2]; // compiled successors, filled in by the dispatcher
+  u8 *exit_jump[2]; // jump of the exit stub taken for each exit, NULL if none
+  u8 *exit_link[2]; // where that jump goes once the exit is linked
+  u8 *exit_ret;     // where it goes otherwise, back to the dispatcher
 };
 
 #define BLOCK_LOOP (0x01)
 #define BLOCK_WRITE (0x02)
+#define BLOCK_TRACKED (0x04) // invalidated through setDirty, can be linked
+
+#define NO_EXIT_PC (0xFFFFFFFF)
 
 #define IN_INFINITY_LOOP (-1)
 
@@ -136,6 +166,8 @@ struct tagSH2
     setmemlong = 0;
     eachclock = 0;
     exitcount = 0;
+    memcycle = 0;
+    last_block = NULL;
   }
 
   u32 GenReg[16];
@@ -149,6 +181,8 @@ struct tagSH2
   uintptr_t setmemlong;
   uintptr_t eachclock;
   u32 exitcount;
+  u32 memcycle;      // memory access cycles not added to the clock yet
+  Block *last_block; // block run last, blocks linked by a jump update it
 };
 
 // Instruction
@@ -222,20 +256,23 @@ private:
   {
     debug_mode_ = false;
     BuildInstructionList();
-    dCode = (Block*)ALLOCATE(sizeof(Block)*NUMOFBLOCKS);
-#ifdef SET_DIRTY
-    LookupParentTable = new addrs[0x100000 >> 1];
-#else
-    LookupParentTable = NULL;
-#endif
+    code_arena_ = (u8*)ALLOCATE(CODE_ARENA_SIZE);
+    dCode = new Block[NUMOFBLOCKS];
     Init();
     compile_count_ = 0;
     exec_count_ = 0;
     remove_count_ = 0;
+    flush_count_ = 0;
+    dispatch_count_ = 0;
+    chain_count_ = 0;
+    link_count_ = 0;
+    unlink_count_ = 0;
+    jump_count_ = 0;
   }
   ~CompileBlocks()
   {
-    FREEMEM(dCode, sizeof(Block) * NUMOFBLOCKS);
+    FREEMEM(code_arena_, CODE_ARENA_SIZE);
+    delete[] dCode;
   }
   static CompileBlocks *instance_;
   bool show_code_ = false;
@@ -252,57 +289,77 @@ public:
   }
 
   int blockCount;
-  int LastMakeBlock;
   bool debug_mode_;
-  Block *g_CompleBlock;
 
   u8 dsh2_instructions[MAX_INSTSIZE];
   Block *LookupTable[0x100000 >> 1];
-  // addrs LookupParentTable[0x100000>>1];
-  addrs *LookupParentTable;
   Block *LookupTableRom[0x80000 >> 1];
   Block *LookupTableLow[0x100000 >> 1];
   Block *LookupTableC[0x8000 >> 1];
   Block *dCode;
 
-  std::unordered_map<u32, int> self_modify_block;
+  u8 *code_arena_;
+  u32 code_used_;
 
-  inline void setDirty(u32 addr)
+  // Blocks compiled from each page, the bitmap lets writes to pages without
+  // code return right away
+  vector<Block *> code_pages_[NUMOFCODEPAGES];
+  u32 code_page_bits_[NUMOFCODEPAGES / 32];
+
+  // Area of addr in the page numbers, -1 if code there isn't tracked
+  static inline int codeArea(u32 addr)
   {
-    addr = adress_mask(addr);
-    if (LookupParentTable[addr].size() == 0)
-      return;
-    for (auto it = LookupParentTable[addr].begin(); it != LookupParentTable[addr].end(); it++)
-    {
-      if (LookupTable[*it] != NULL)
-      {
-        for (u32 i = adress_mask(LookupTable[*it]->b_addr); i <= adress_mask(LookupTable[*it]->e_addr); i++)
-        {
-          if (i != addr)
-          {
-            LookupParentTable[i].remove(*it);
-          }
-        }
-        LOG("%d %08X is removed", LookupTable[*it]->id, (*it) << 1);
-        remove_count_++;
-        self_modify_block[(((*it) << 1) | 0x06000000)] = LookupTable[*it]->id;
-        LookupTable[*it] = NULL;
-      }
+    switch (addr & 0x0FF00000) {
+    case 0x00000000: return 0; // ROM
+    case 0x00200000: return 1; // Low Memory
+    case 0x06000000: return 2; // High Memory
     }
-    LookupParentTable[addr].clear();
+    return -1;
+  }
+
+  inline void setDirty(u32 addr)
+  {
+    int area = codeArea(addr);
+    if (area < 0) return;
+    u32 page = area * CODE_AREA_PAGES + ((addr & 0x000FFFFF) >> CODE_PAGE_SHIFT);
+    if (code_page_bits_[page >> 5] & (1 << (page & 31)))
+      invalidateRange(addr, 2);
+  }
+
+  Block **lookupEntry(u32 addr);
+  bool blockPages(Block *page, int *first, int *last);
+
+  void invalidateRange(u32 start, u32 length);
+  void trackBlock(Block *page);
+  void removeBlock(Block *page);
+
+  // Blocks whose link points at each block, indexed by id, so the links can
+  // be cleared when the block is removed
+  vector<Block *> linked_from_[NUMOFBLOCKS];
+
+  inline Block *followLink(Block *from, u32 pc)
+  {
+    if (from->exit_pc[0] == pc) return from->link[0];
+    if (from->exit_pc[1] == pc) return from->link[1];
+    return NULL;
   }
+  void linkBlock(Block *from, Block *to);
+  u8 *EmmitExitStub(Block *page, u8 *ptr, u8 **sites, int count);
+  void patchLink(Block *from, int k, Block *to);
+  void unpatchLink(Block *from, int k);
 
   void Init();
+  void Flush();
 
-  Block *CompileBlock(u32 pc, addrs *ParentT);
+  Block *CompileBlock(u32 pc, bool track_writes = false);
+  Block *CompileTransientBlock(u32 pc);
 
   void opcodePass(x86op_desc *op, u16 opcode, u8 *ptr);
   int opcodeIndex(u16 code);
   void FindOpCode(u16 opcode, u8 *instindex);
   void BuildInstructionList();
 
-  int findFreeBlock(u32 pc);
-  int EmmitCode(Block *page, addrs *ParentT = NULL);
+  int EmmitCode(Block *page);
 
   int overrideMemFunc(void *ptr, int func);
 
@@ -310,12 +367,18 @@ public:
   u32 compile_count_;
   u32 exec_count_;
   u32 remove_count_;
+  u32 flush_count_;
+  u32 dispatch_count_; // blocks found through the lookup tables
+  u32 chain_count_;    // blocks reached through a link
+  u32 link_count_;
+  u32 unlink_count_;
+  u32 jump_count_;     // blocks reached through a patched jump
 
   void ShowStatics();
   void SetDebugMode(bool debug) { debug_mode_ = debug; }
 };
 
-typedef void (*dynaFunc)(tagSH2 *);
+typedef void (DYNACALL *dynaFunc)(tagSH2 *);
 
 class DynarecSh2
 {
@@ -329,6 +392,8 @@ protected:
   int pre_exe_count_;
   bool is_slave_ = false;
   u32 pre_PC_;
+  Block *last_block_;  // block run by the previous Execute, for linking
+  u32 last_flush_;     // flush_count_ when last_block_ was run
   SH2_struct *ctx_;
   YabMutex *mtx_;
   bool logenable_;
@@ -369,6 +434,7 @@ public:
   void ResetCPU();
   void ExecuteCount(u32 Count);
   int Execute();
+  Block *LookupBlock(int &rtn);
   void Undecoded();
 
   void AddCycle(u32 cycle)
@@ -377,14 +443,13 @@ public:
   }
 
   u32 addcycle_ = 0;
-  u32 memcycle_ = 0;
+  u32 &memcycle_; // kept in tagSH2 so the exit stubs can add it up
   void ShowStatics();
   void ShowCompileInfo();
   void ResetCompileInfo();
 
   void onFrame()
   {
-    m_pCompiler->self_modify_block.clear();
   }
 
   tagSH2 *getDynaSh() { return m_pDynaSh2; };
@@ -416,26 +481,26 @@ public:
 // callback from cpu emulation
 extern "C"
 {
-  int EachClock();
-  int DelayEachClock();
-  int DebugEachClock();
-  int DebugDelayClock();
-
-  void memSetByte(u32, u8);
-  void memSetWord(u32, u16);
-  void memSetLong(u32, u32);
-
-  u8 memGetByte(u32);
-  u16 memGetWord(u32);
-  u32 memGetLong(u32);
-
-  void memSetByteNoCache(u32, u8);
-  void memSetWordNoCache(u32, u16);
-  void memSetLongNoCache(u32, u32);
-
-  u8 memGetByteNoCache(u32);
-  u16 memGetWordNoCache(u32);
-  u32 memGetLongNoCache(u32);
+  int DYNACALL EachClock();
+  int DYNACALL DelayEachClock();
+  int DYNACALL DebugEachClock();
+  int DYNACALL DebugDelayClock();
+
+  void DYNACALL memSetByte(u32, u8);
+  void DYNACALL memSetWord(u32, u16);
+  void DYNACALL memSetLong(u32, u32);
+
+  u8 DYNACALL memGetByte(u32);
+  u16 DYNACALL memGetWord(u32);
+  u32 DYNACALL memGetLong(u32);
+
+  void DYNACALL memSetByteNoCache(u32, u8);
+  void DYNACALL memSetWordNoCache(u32, u16);
+  void DYNACALL memSetLongNoCache(u32, u32);
+
+  u8 DYNACALL memGetByteNoCache(u32);
+  u16 DYNACALL memGetWordNoCache(u32);
+  u32 DYNACALL memGetLongNoCache(u32);
 
 }
 
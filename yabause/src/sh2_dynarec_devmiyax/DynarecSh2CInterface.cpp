@@ -350,21 +350,29 @@ void SH2DynWriteNotify(u32 start, u32 length){
   switch (start & 0x0FF00000){
     // ROM
   case 0x00000000:
+#if defined(SET_DIRTY)
+    block->invalidateRange(start, length);
+#else
       block->LookupTableRom[ (start&0x000FFFFF)>>1 ] = NULL;
+#endif
     break;
 
   // Low Memory
   case 0x00200000:
+#if defined(SET_DIRTY)
+    block->invalidateRange(start, length);
+#else
     for (u32 addr = start; addr< start + length; addr += 2)
       block->LookupTableLow[ (addr&0x000FFFFF)>>1 ] = NULL;
+#endif
     break;
     // High Memory
   case 0x06000000:
-    for( u32 addr = start; addr< start+length; addr+=2 )
 #if defined(SET_DIRTY)
-    block->setDirty(addr);
+    block->invalidateRange(start, length);
 #else
-    block->LookupTable[ (addr&0x000FFFFF)>>1 ] = NULL;
+    for( u32 addr = start; addr< start+length; addr+=2 )
+      block->LookupTable[ (addr&0x000FFFFF)>>1 ] = NULL;
 #endif
     break;
 
@@ -399,7 +407,7 @@ void SH2DynShowSttaics(SH2_struct * master, SH2_struct * slave ){
 #pragma GCC optimize ("O1")
 #endif
 
-void memSetByteNoCache(u32 addr, u8 data)
+void DYNACALL memSetByteNoCache(u32 addr, u8 data)
 {
   dynaLock();
   u32 cycle = 0;
@@ -409,7 +417,11 @@ void memSetByteNoCache(u32 addr, u8 data)
   {
     // Low Memory
   case 0x00200000:
+#if defined(SET_DIRTY)
+    block->setDirty(addr);
+#else
     block->LookupTableLow[(addr & 0x000FFFFF) >> 1] = NULL;
+#endif
     T2WriteByte(LowWram, addr & 0xFFFFF, data);
     if (addr & 0x20000000) DynarecSh2::CurrentContext->memcycle_ += 7;
     dynaFree();
@@ -441,7 +453,7 @@ void memSetByteNoCache(u32 addr, u8 data)
 
 }
 
-void memSetWordNoCache(u32 addr, u16 data)
+void DYNACALL memSetWordNoCache(u32 addr, u16 data)
 {
   dynaLock();
   u32 cycle = 0;
@@ -452,7 +464,11 @@ void memSetWordNoCache(u32 addr, u16 data)
   {
     // Low Memory
   case 0x00200000:
+#if defined(SET_DIRTY)
+    block->setDirty(addr);
+#else
     block->LookupTableLow[(addr & 0x000FFFFF) >> 1] = NULL;
+#endif
     T2WriteWord(LowWram, addr & 0xFFFFF, data);
     if (addr & 0x20000000) DynarecSh2::CurrentContext->memcycle_ += 7;
     dynaFree();
@@ -485,7 +501,7 @@ void memSetWordNoCache(u32 addr, u16 data)
 }
 
 
-void memSetLongNoCache(u32 addr, u32 data)
+void DYNACALL memSetLongNoCache(u32 addr, u32 data)
 {
   dynaLock();
   //LOG("memSetLong %08X, %08X\n", addr, data);
@@ -496,8 +512,13 @@ void memSetLongNoCache(u32 addr, u32 data)
   {
     // Low Memory
   case 0x00200000:
+#if defined(SET_DIRTY)
+    block->setDirty(addr);
+    block->setDirty(addr + 2);
+#else
     block->LookupTableLow[(addr & 0x000FFFFF) >> 1] = NULL;
     block->LookupTableLow[((addr & 0x000FFFFF) >> 1) + 1] = NULL;
+#endif
     T2WriteLong(LowWram, addr & 0xFFFFF, data);
     if (addr & 0x20000000) DynarecSh2::CurrentContext->memcycle_ += 7;
     dynaFree();
@@ -531,7 +552,7 @@ void memSetLongNoCache(u32 addr, u32 data)
 
 }
 
-u8 memGetByteNoCache(u32 addr)
+u8 DYNACALL memGetByteNoCache(u32 addr)
 {
   dynaLock();
   u8 val;
@@ -560,7 +581,7 @@ u8 memGetByteNoCache(u32 addr)
   return val;
 }
 
-u16 memGetWordNoCache(u32 addr)
+u16 DYNACALL memGetWordNoCache(u32 addr)
 {
   dynaLock();
   u16 val;
@@ -589,7 +610,7 @@ u16 memGetWordNoCache(u32 addr)
   return val;
 }
 
-u32 memGetLongNoCache(u32 addr)
+u32 DYNACALL memGetLongNoCache(u32 addr)
 {
   dynaLock();
 
@@ -620,7 +641,7 @@ u32 memGetLongNoCache(u32 addr)
 
 
 
-void memSetByte(u32 addr , u8 data )
+void DYNACALL memSetByte(u32 addr , u8 data )
 {
   dynaLock();
   u32 cycle = 0;
@@ -629,7 +650,11 @@ void memSetByte(u32 addr , u8 data )
   {
   // Low Memory
   case 0x00200000:
+#if defined(SET_DIRTY)
+    block->setDirty(addr);
+#else
     block->LookupTableLow[  (addr&0x000FFFFF)>>1 ] = NULL;
+#endif
     break;
   // High Memory
   case 0x06000000:
@@ -652,7 +677,7 @@ void memSetByte(u32 addr , u8 data )
   dynaFree();
 }
 
-void memSetWord(u32 addr, u16 data )
+void DYNACALL memSetWord(u32 addr, u16 data )
 {
   dynaLock();
   u32 cycle = 0;
@@ -661,7 +686,11 @@ void memSetWord(u32 addr, u16 data )
   {
   // Low Memory
    case 0x00200000:
+#if defined(SET_DIRTY)
+    block->setDirty(addr);
+#else
     block->LookupTableLow[ (addr&0x000FFFFF)>>1 ] = NULL;
+#endif
     break;
   // High Memory
    case 0x06000000:  {
@@ -685,7 +714,7 @@ void memSetWord(u32 addr, u16 data )
   dynaFree();
 }
 
-void memSetLong(u32 addr , u32 data )
+void DYNACALL memSetLong(u32 addr , u32 data )
 {
   dynaLock();
 
@@ -696,8 +725,13 @@ void memSetLong(u32 addr , u32 data )
   {  
     // Low Memory
   case 0x00200000:
+#if defined(SET_DIRTY)
+    block->setDirty(addr);
+    block->setDirty(addr + 2);
+#else
     block->LookupTableLow[ (addr & 0x000FFFFF)>>1  ] = NULL;
     block->LookupTableLow[ ((addr & 0x000FFFFF)>>1) + 1 ] = NULL;
+#endif
     break;
   // High Memory
   case 0x06000000:
@@ -722,7 +756,7 @@ void memSetLong(u32 addr , u32 data )
   dynaFree();
 }
 
-u8 memGetByte(u32 addr)
+u8 DYNACALL memGetByte(u32 addr)
 {
   dynaLock();
   u32 cycle = 0;
@@ -732,7 +766,7 @@ u8 memGetByte(u32 addr)
   return val;
 }
  
-u16 memGetWord(u32 addr)
+u16 DYNACALL memGetWord(u32 addr)
 {
   dynaLock();
   u32 cycle = 0;
@@ -742,7 +776,7 @@ u16 memGetWord(u32 addr)
   return val;
 }
 
-u32 memGetLong(u32 addr)
+u32 DYNACALL memGetLong(u32 addr)
 {
   dynaLock();
   u32 cycle = 0;
@@ -777,12 +811,12 @@ void DynaCheckBreakPoint(u32 pc) {
 }
 
 
-int DelayEachClock() {
+int DYNACALL DelayEachClock() {
 
   return 0;
 }
 
-int DebugDelayClock() {
+int DYNACALL DebugDelayClock() {
   dynaLock();
 
 #ifdef DMPHISTORY
@@ -800,7 +834,7 @@ int DebugDelayClock() {
   return 0;
 }
 
-int DebugEachClock() {
+int DYNACALL DebugEachClock() {
   dynaLock();
   #define INSTRUCTION_B(x) ((x & 0x0F00) >> 8)
   #define INSTRUCTION_C(x) ((x & 0x00F0) >> 4)
@@ -969,7 +1003,7 @@ if( pc == 0x060133C8 ) {
   return 0;
 }
   
-int EachClock() {
+int DYNACALL EachClock() {
   dynaLock();
   if (DynarecSh2::CurrentContext->CheckInterupt()) {
       dynaFree();
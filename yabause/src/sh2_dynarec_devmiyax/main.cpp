@@ -40,7 +40,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 
 SH2_struct *MSH2 = NULL;
 SH2_struct *SSH2 = NULL;
-extern SH2_struct *CurrentSH2;
+extern SH2_CURRENT_LOCAL SH2_struct *CurrentSH2;
 extern yabsys_struct yabsys;
 SH2Interface_struct *SH2Core = NULL;
 SH2Interface_struct *SH2CoreList[] = {
@@ -30,7 +30,7 @@ u8 *LowWram;
 u8 *BiosRom;
 bool romlock = false;
 
-SH2_struct *CurrentSH2;
+SH2_CURRENT_LOCAL SH2_struct *CurrentSH2;
 yabsys_struct yabsys;
 
 
@@ -22,5 +22,5 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
  int freeMemory();
  void setromlock( bool lock );
 
-extern SH2_struct *CurrentSH2;
+extern SH2_CURRENT_LOCAL SH2_struct *CurrentSH2;
 extern yabsys_struct yabsys;
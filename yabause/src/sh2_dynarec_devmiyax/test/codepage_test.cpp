@@ -0,0 +1,73 @@
+#include "gtest/gtest.h"
+#include <core.h>
+#include "sh2core.h"
+#include "debug.h"
+#include "yabause.h"
+#include "memory_for_test.h"
+#include "DynarecSh2.h"
+
+namespace {
+
+class CodePageTest : public ::testing::Test {
+ protected:
+   DynarecSh2 * pctx_;
+
+  CodePageTest() {
+    initMemory();
+    pctx_ = new DynarecSh2();
+    pctx_->SetCurrentContext();
+  }
+
+  virtual ~CodePageTest() {
+    freeMemory();
+    delete pctx_;
+  }
+
+virtual void SetUp() {
+
+}
+
+virtual void TearDown() {
+}
+
+};
+
+// Code at the same offset in low and high work ram, writing one of them
+// must leave the other one compiled
+TEST_F(CodePageTest, areas) {
+
+  CompileBlocks * block = CompileBlocks::getInstance();
+
+  memSetWord( 0x06000100, 0xE001 );  // mov #1, r0
+  memSetWord( 0x06000102, 0x000B );  // rts
+  memSetWord( 0x06000104, 0x0009 );  // nop
+
+  memSetWord( 0x00200100, 0xE002 );  // mov #2, r0
+  memSetWord( 0x00200102, 0x000B );  // rts
+  memSetWord( 0x00200104, 0x0009 );  // nop
+
+  pctx_->SET_PC( 0x06000100 );
+  pctx_->Execute();
+  EXPECT_EQ( 0x01, pctx_->GetGenRegPtr()[0] );
+
+  pctx_->SET_PC( 0x00200100 );
+  pctx_->Execute();
+  EXPECT_EQ( 0x02, pctx_->GetGenRegPtr()[0] );
+
+  Block * high = block->LookupTable[0x100 >> 1];
+  ASSERT_TRUE( high != NULL );
+
+  memSetWord( 0x00200100, 0xE003 );  // mov #3, r0
+  EXPECT_EQ( high, block->LookupTable[0x100 >> 1] );
+  EXPECT_TRUE( block->LookupTableLow[0x100 >> 1] == NULL );
+
+  pctx_->SET_PC( 0x00200100 );
+  pctx_->Execute();
+  EXPECT_EQ( 0x03, pctx_->GetGenRegPtr()[0] );
+
+  pctx_->SET_PC( 0x06000100 );
+  pctx_->Execute();
+  EXPECT_EQ( 0x01, pctx_->GetGenRegPtr()[0] );
+}
+
+}  // namespace
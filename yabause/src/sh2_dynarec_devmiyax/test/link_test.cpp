@@ -0,0 +1,78 @@
+#include "gtest/gtest.h"
+#include <core.h>
+#include "sh2core.h"
+#include "debug.h"
+#include "yabause.h"
+#include "memory_for_test.h"
+#include "DynarecSh2.h"
+
+namespace {
+
+class LinkTest : public ::testing::Test {
+ protected:
+   DynarecSh2 * pctx_;
+
+  LinkTest() {
+    initMemory();
+    pctx_ = new DynarecSh2();
+    pctx_->SetCurrentContext();
+  }
+
+  virtual ~LinkTest() {
+    freeMemory();
+    delete pctx_;
+  }
+
+virtual void SetUp() {
+
+}
+
+virtual void TearDown() {
+}
+
+};
+
+// Two blocks branching to each other, the writes keep them from being
+// taken as idle loops
+TEST_F(LinkTest, chain) {
+
+  CompileBlocks * block = CompileBlocks::getInstance();
+
+  for (int i = 0; i < 15; i++)
+    pctx_->GetGenRegPtr()[i] = 0;
+  pctx_->GetGenRegPtr()[1] = 0x06001000;
+  pctx_->GetGenRegPtr()[2] = 0x06001004;
+  pctx_->SET_SR(0);
+
+  memSetWord( 0x06000100, 0x2102 );  // mov.l r0, @r1
+  memSetWord( 0x06000102, 0x7001 );  // add #1, r0
+  memSetWord( 0x06000104, 0xA07C );  // bra 0x06000200
+  memSetWord( 0x06000106, 0x0009 );  // nop
+
+  memSetWord( 0x06000200, 0x2202 );  // mov.l r0, @r2
+  memSetWord( 0x06000202, 0xAF7D );  // bra 0x06000100
+  memSetWord( 0x06000204, 0x0009 );  // nop
+
+  u32 execs = block->exec_count_;
+  pctx_->SET_PC( 0x06000100 );
+  pctx_->ExecuteCount( 2000 );
+
+  u32 first = pctx_->GetGenRegPtr()[0];
+  EXPECT_GT( first, 100 );
+  EXPECT_GE( CurrentSH2->cycles, 2000 );
+  EXPECT_LT( CurrentSH2->cycles, 2000 + 16 );
+#if defined(_WIN64) || defined(__x86_64__)
+  // the blocks jump to each other without coming back through Execute
+  EXPECT_LT( block->exec_count_ - execs, 10 );
+#endif
+
+  // the linked jump into the old code has to go
+  u32 unlinks = block->unlink_count_;
+  memSetWord( 0x06000204, 0x7010 );  // add #16, r0
+  EXPECT_GT( block->unlink_count_ - unlinks, 0 );
+
+  pctx_->ExecuteCount( 2000 );
+  EXPECT_GT( pctx_->GetGenRegPtr()[0] - first, 16 * 100 );
+}
+
+}  // namespace
@@ -34,6 +34,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 #include "yabause.h"
 #include "sh2cache.h"
 #include "sh2core.h"
+#include "sh2thread.h"
 
 #include "debug.h"
 
@@ -287,6 +288,7 @@ void cache_memory_write_l(cache_enty *ca, u32 addr, u32 val, u32 *cycle)
     const u32 entry = (addr & ENTRY_MASK) >> ENTRY_SHIFT;
 
     CACHE_LOG("Cache purge %08X %d\n", addr, entry);
+    SH2_THREAD_PARK();
 
     for (i = 0; i < 4; i++)
     {
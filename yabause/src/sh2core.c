@@ -44,6 +44,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 #include <stdlib.h>
 #include "sh2core.h"
 #include "debug.h"
+#include "fastmem.h"
 #include "memory.h"
 #include "yabause.h"
 
@@ -54,10 +55,11 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 #endif
 
 #include "sh2cache.h"
+#include "sh2thread.h"
 
 SH2_struct *MSH2=NULL;
 SH2_struct *SSH2=NULL;
-SH2_struct *CurrentSH2;
+SH2_CURRENT_LOCAL SH2_struct *CurrentSH2;
 SH2Interface_struct *SH2Core=NULL;
 extern SH2Interface_struct *SH2CoreList[];
 
@@ -260,11 +262,15 @@ void FASTCALL SH2OnFrame(SH2_struct *context) {
 
 void SH2SendInterrupt(SH2_struct *context, u8 vector, u8 level)
 {
+   if (context == SSH2 && SH2ThreadDefer(vector, level, 0))
+      return;
    SH2Core->SendInterrupt(context, vector, level);
 }
 
 void SH2RemoveInterrupt(SH2_struct *context, u8 vector, u8 level)
 {
+  if (context == SSH2 && SH2ThreadDefer(vector, level, 1))
+    return;
   SH2Core->RemoveInterrupt(context, vector, level);
 }
 
@@ -861,6 +867,7 @@ int SH2AddMemoryBreakpoint(SH2_struct *context, u32 addr, u32 flags) {
       }
 
       context->bp.nummemorybreakpoints++;
+      FastmemHoldPage((addr >> 16) & 0xFFF, 1);
 
       return 0;
    }
@@ -931,6 +938,7 @@ int SH2DelMemoryBreakpoint(SH2_struct *context, u32 addr) {
                WriteLongList[(addr >> 16) & 0xFFF] = context->bp.memorybreakpoint[i].oldwritelong;
 
             context->bp.memorybreakpoint[i].addr = 0xFFFFFFFF;
+            FastmemHoldPage((addr >> 16) & 0xFFF, 0);
             SH2SortMemoryBreakpoints(context);
             context->bp.nummemorybreakpoints--;
             return 0;
@@ -2613,7 +2621,8 @@ void FASTCALL MSH2InputCaptureWriteWord(UNUSED u32 addr, UNUSED u16 data)
       SH2Core->SetPC(MSH2, pc);
    }
 
-   if (CurrentSH2->depth < 4) {
+   // with the slave on its own thread the two only meet between quanta
+   if (CurrentSH2->depth < 4 && !SH2ThreadActive()) {
      CurrentSH2->depth++;
      int syncCycle = CurrentSH2->cycles - MSH2->cycles;
      if (syncCycle > 0) {
@@ -2652,7 +2661,7 @@ void FASTCALL SSH2InputCaptureWriteWord(UNUSED u32 addr, UNUSED u16 data)
    }
 
 #if 1
-   if (CurrentSH2->depth < 4) {
+   if (CurrentSH2->depth < 4 && !SH2ThreadActive()) {
      CurrentSH2->depth++;
      int syncCycle = CurrentSH2->cycles - SSH2->cycles;
      if (syncCycle > 0) {
@@ -693,7 +693,15 @@ typedef struct
 
 extern SH2_struct *MSH2;
 extern SH2_struct *SSH2;
-extern SH2_struct *CurrentSH2;
+// The cpu running on this host thread. The slave gets its own thread with
+// yabsys.use_ssh2_thread (sh2thread.h), the dynarec's linkage code stores
+// to CurrentSH2 directly so there it stays one global.
+#if defined(SH2_DYNAREC) && SH2_DYNAREC
+#define SH2_CURRENT_LOCAL
+#else
+#define SH2_CURRENT_LOCAL THREAD_LOCAL
+#endif
+extern SH2_CURRENT_LOCAL SH2_struct *CurrentSH2;
 extern SH2Interface_struct *SH2Core;
 
 int SH2Init(int coreid);
@@ -36,9 +36,10 @@ done, ending with a conditional jump, at the point of which all registers are
 executed loops */
 
 /* bDet : Bitwise register markers. 1: register is deterministic
-   bChg : Bitwise register markers. 1: register has been changed, not in a deterministic way */
+   bChg : Bitwise register markers. 1: register has been changed, not in a deterministic way
+   Per host thread, the slave sh2 may be checking its own loop at the same time */
 
-u32 bDet, bChg;
+static THREAD_LOCAL u32 bDet, bChg;
 
 /* Macro <implies(dest,src)> : makes changes resulting from the
    execution of an instruction in which the content of <dest> register
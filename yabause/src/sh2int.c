@@ -126,7 +126,7 @@ SH2Interface_struct SH2Interpreter = {
    SH2InterpreterGetInterrupts,
    SH2InterpreterSetInterrupts,
 
-   NULL,  // SH2WriteNotify not used
+   SH2InterpreterWriteNotify,
 
    SH2InterpreterAddCycle
 };
@@ -173,6 +173,30 @@ SH2Interface_struct SH2DebugInterpreter = {
 
 fetchfunc fetchlist[0x100];
 
+#define SH2_BLOCK_NONE                0xFFFFFFFF
+#define SH2_BLOCK_PAGE_SIZE           (1 << SH2_BLOCK_PAGE_SHIFT)
+#define SH2_BLOCK_PAGES               (SH2_BLOCK_SPACE >> SH2_BLOCK_PAGE_SHIFT)
+#define SH2_BLOCK_MAX_INSTRUCTIONS    32
+#define SH2_BLOCK_ENTRIES             4096
+
+typedef struct
+{
+   u32 offset;       // block space offset of the first instruction
+   u32 generation;   // page generation the block was decoded at
+   u32 count;
+   opcodefunc handler[SH2_BLOCK_MAX_INSTRUCTIONS];
+   u16 instruction[SH2_BLOCK_MAX_INSTRUCTIONS];
+} sh2block_struct;
+
+u8 SH2BlockCodePage[SH2_BLOCK_PAGES];
+static u32 blockgeneration[SH2_BLOCK_PAGES];
+static sh2block_struct blocks[SH2_BLOCK_ENTRIES];
+
+// Where each fetchlist area lands in block space, SH2_BLOCK_NONE when the
+// area isn't cached
+static u32 blockbase[0x100];
+static u32 blockmask[0x100];
+
 //////////////////////////////////////////////////////////////////////////////
 
 void SH2HandleInterrupts(SH2_struct *context)
@@ -2946,15 +2970,26 @@ int SH2InterpreterInit()
    for(i = 0;i < 0x10000;i++)
       opcodes[i] = decode(i);
 
+   for (i = 0; i < SH2_BLOCK_ENTRIES; i++)
+      blocks[i].offset = SH2_BLOCK_NONE;
+   SH2BlockCacheFlush();
+
    for (i = 0; i < 0x100; i++)
    {
+      blockbase[i] = SH2_BLOCK_NONE;
+      blockmask[i] = 0;
+
       switch (i)
       {
          case 0x000: // Bios              
             fetchlist[i] = FetchBios;
+            blockbase[i] = SH2_BLOCK_BIOS;
+            blockmask[i] = 0x7FFFF;
             break;
          case 0x002: // Low Work Ram
             fetchlist[i] = FetchLWram;
+            blockbase[i] = SH2_BLOCK_LWRAM;
+            blockmask[i] = 0xFFFFF;
             break;
          case 0x020: // CS0
             fetchlist[i] = FetchCs0;
@@ -2979,6 +3014,8 @@ int SH2InterpreterInit()
          case 0x06E: 
          case 0x06F:
             fetchlist[i] = FetchHWram;
+            blockbase[i] = SH2_BLOCK_HWRAM;
+            blockmask[i] = 0xFFFFF;
             break;
          default:
             fetchlist[i] = FetchInvalid;
@@ -3022,6 +3059,7 @@ void SH2InterpreterDeInit()
 void SH2InterpreterReset(UNUSED SH2_struct *context)
 {
    // Reset any internal variables here
+   SH2BlockCacheFlush();
    context->stepOverOut.enabled = 0;
    context->stepOverOut.enabled = 0;
 }
@@ -3172,6 +3210,157 @@ FASTCALL void SH2DebugInterpreterExec(SH2_struct *context, u32 cycles)
 }
 
 
+//////////////////////////////////////////////////////////////////////////////
+
+void SH2BlockCacheInvalidatePage(u32 page)
+{
+   SH2BlockCodePage[page] = 0;
+   blockgeneration[page]++;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void SH2BlockCacheFlush(void)
+{
+   u32 i;
+
+   for (i = 0; i < SH2_BLOCK_PAGES; i++)
+      SH2BlockCacheInvalidatePage(i);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void SH2InterpreterWriteNotify(u32 start, u32 length)
+{
+   u32 base = blockbase[(start >> 20) & 0xFF];
+   u32 offset, pages;
+
+   // Dma and the file loaders end up here, the cpu's own writes
+   // are caught by the work ram write handlers
+   if (base == SH2_BLOCK_NONE || length == 0)
+      return;
+
+   offset = start & blockmask[(start >> 20) & 0xFF];
+   pages = ((offset & (SH2_BLOCK_PAGE_SIZE - 1)) + length + SH2_BLOCK_PAGE_SIZE - 1) >> SH2_BLOCK_PAGE_SHIFT;
+
+   while (pages--)
+   {
+      SH2BlockCacheWrite(base + offset);
+      offset = (offset + SH2_BLOCK_PAGE_SIZE) & blockmask[(start >> 20) & 0xFF];
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static INLINE int SH2BlockEnds(u16 instruction)
+{
+   switch (instruction & 0xF000)
+   {
+      case 0x0000:
+         // braf, bsrf, rts, rte
+         return (instruction & 0xFF) == 0x23 || (instruction & 0xFF) == 0x03 ||
+                instruction == 0x000B || instruction == 0x002B;
+      case 0x4000:
+         // jmp, jsr
+         return (instruction & 0xFF) == 0x2B || (instruction & 0xFF) == 0x0B;
+      case 0xA000: // bra
+      case 0xB000: // bsr
+         return 1;
+      case 0xC000:
+         // trapa
+         return (instruction & 0xFF00) == 0xC300;
+      default:
+         return 0;
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void SH2BlockDecode(sh2block_struct *block, u32 pc, u32 offset)
+{
+   fetchfunc fetch = fetchlist[(pc >> 20) & 0xFF];
+   u32 page = offset >> SH2_BLOCK_PAGE_SHIFT;
+   u32 left = (SH2_BLOCK_PAGE_SIZE - (offset & (SH2_BLOCK_PAGE_SIZE - 1))) >> 1;
+   u32 count = 0;
+
+   // Blocks never cross a page so one generation check covers them
+   if (left > SH2_BLOCK_MAX_INSTRUCTIONS)
+      left = SH2_BLOCK_MAX_INSTRUCTIONS;
+
+   // Flag the page and take its generation before fetching, so a write
+   // landing while the block is decoded still invalidates it
+   SH2BlockCodePage[page] = 1;
+   block->generation = blockgeneration[page];
+
+   while (count < left)
+   {
+      u16 instruction = fetch(pc + count * 2);
+
+      block->instruction[count] = instruction;
+      block->handler[count] = opcodes[instruction];
+      count++;
+
+      if (SH2BlockEnds(instruction))
+         break;
+   }
+
+   block->offset = offset;
+   block->count = count;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void SH2BlockExec(SH2_struct *context, int target_cycle)
+{
+   while (context->cycles < target_cycle)
+   {
+      u32 pc = context->regs.PC;
+      u32 base = blockbase[(pc >> 20) & 0xFF];
+      sh2block_struct *block;
+      u32 *generation;
+      u32 offset, i;
+
+#ifdef EXEC_FROM_CACHE
+      if ((pc & 0xC0000000) == 0xC0000000) base = SH2_BLOCK_NONE;
+#endif
+      if (base == SH2_BLOCK_NONE || (pc & 1))
+      {
+#ifdef EXEC_FROM_CACHE
+         if ((pc & 0xC0000000) == 0xC0000000) context->instruction = DataArrayReadWord(pc);
+         else
+#endif
+           context->instruction = fetchlist[(pc >> 20) & 0x0FF](pc);
+         opcodes[context->instruction](context);
+         continue;
+      }
+
+      offset = base + (pc & blockmask[(pc >> 20) & 0xFF]);
+      generation = &blockgeneration[offset >> SH2_BLOCK_PAGE_SHIFT];
+      block = &blocks[(offset >> 1) & (SH2_BLOCK_ENTRIES - 1)];
+
+      if (block->offset != offset || block->generation != *generation)
+         SH2BlockDecode(block, pc, offset);
+
+      // Handlers still update PC themselves, leave the block as soon as one
+      // didn't fall through to the next entry or the page got written to
+      {
+         const u32 count = block->count;
+         const u32 decoded = block->generation;
+
+         for (i = 0; ; )
+         {
+            context->instruction = block->instruction[i];
+            block->handler[i](context);
+            pc += 2;
+
+            if (++i == count || context->regs.PC != pc ||
+                context->cycles >= target_cycle || *generation != decoded)
+               break;
+         }
+      }
+   }
+}
+
 //////////////////////////////////////////////////////////////////////////////
 
 FASTCALL void SH2InterpreterExec(SH2_struct *context, u32 cycles)
@@ -3198,6 +3387,13 @@ FASTCALL void SH2InterpreterExec(SH2_struct *context, u32 cycles)
      SH2idleCheck(context, target_cycle);
 #endif
 
+   if (yabsys.use_sh2_block_cache)
+   {
+      SH2BlockExec(context, target_cycle);
+      context->pre_cycle = context->cycles - target_cycle;
+      return;
+   }
+
    while (context->cycles < target_cycle)
    {
 
@@ -40,6 +40,10 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 #ifndef SH2INT_H
 #define SH2INT_H
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #define SH2CORE_INTERPRETER             0
 #define SH2CORE_DEBUGINTERPRETER        1
 
@@ -80,6 +84,7 @@ int SH2InterpreterGetInterrupts(SH2_struct *context,
                                 interrupt_struct interrupts[MAX_INTERRUPTS]);
 void SH2InterpreterSetInterrupts(SH2_struct *context, int num_interrupts,
                                  const interrupt_struct interrupts[MAX_INTERRUPTS]);
+void SH2InterpreterWriteNotify(u32 start, u32 length);
 
 extern SH2Interface_struct SH2Interpreter;
 extern SH2Interface_struct SH2DebugInterpreter;
@@ -90,4 +95,28 @@ extern fetchfunc fetchlist[0x100];
 typedef void (FASTCALL *opcodefunc)(SH2_struct *);
 extern opcodefunc opcodes[0x10000];
 
+// Decoded block cache. The bios rom and both work rams are mapped into one
+// flat space, split in pages that remember whether a block was decoded from
+// them so the write handlers only have to test one byte.
+#define SH2_BLOCK_BIOS          0x000000
+#define SH2_BLOCK_LWRAM         0x080000
+#define SH2_BLOCK_HWRAM         0x180000
+#define SH2_BLOCK_SPACE         0x280000
+#define SH2_BLOCK_PAGE_SHIFT    8
+
+extern u8 SH2BlockCodePage[SH2_BLOCK_SPACE >> SH2_BLOCK_PAGE_SHIFT];
+
+void SH2BlockCacheInvalidatePage(u32 page);
+void SH2BlockCacheFlush(void);
+
+static INLINE void SH2BlockCacheWrite(u32 offset)
+{
+   if (SH2BlockCodePage[offset >> SH2_BLOCK_PAGE_SHIFT])
+      SH2BlockCacheInvalidatePage(offset >> SH2_BLOCK_PAGE_SHIFT);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
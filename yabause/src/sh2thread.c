@@ -0,0 +1,431 @@
+/*
+        Copyright 2026 agent(agent@local)
+
+This file is part of YabaSanshiro.
+
+        YabaSanshiro is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+YabaSanshiro is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+along with YabaSanshiro; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*! \file sh2thread.c
+    \brief Slave SH2 on its own host thread.
+
+    YabauseEmulate hands the slave a quantum of steps and runs the master
+    through the same steps meanwhile, then waits for the slave before the
+    next quantum. While both run the slave only has the work rams and the
+    bios to itself: every other page of the memory map gets a handler in
+    front that parks the slave until the master has finished the quantum,
+    as does looking up a VDP2 ram wait state. From there the
+    slave runs alone to the end of the quantum, so it sees the hardware the
+    way the serial loop would show it once the master's steps were done.
+
+    Going the other way, the master waits for the slave and lets it finish
+    the quantum before it writes the slave's input capture or starts or
+    stops it, and interrupts for the slave raised while it runs are kept
+    until the quantum is over. Each of these happens at the same point of
+    the emulation whatever the host threads did, so a game that talks to the
+    slave through these gets the same result on every run. Work ram shared
+    without any of them is seen up to a quantum early or late, which breaks
+    the common pattern of polling high work ram through cache-through
+    addresses. Together with the speedup on slave-heavy games not having
+    been measured on a multi-core host yet, that keeps the option
+    experimental and off by default.
+
+    The interpreter's block cache is shared by both cpus, so it is turned
+    off while the slave has its own thread.
+
+    A quantum is a poor way to pass messages though: each input capture
+    answered through one costs a quantum or two. So once either cpu takes an
+    input capture, and when the slave is started, the cpus talk: the
+    following steps run on the master's thread one after the other the way
+    the serial loop runs them, and only after SH2_THREAD_TALK_STEPS steps
+    without a capture does the slave get its quantum again. A handshake
+    then runs step for step as it does serially, only the first capture
+    after a quiet spell is seen at the end of the quantum it fell in.
+
+    Writes to the cache purge area touch nothing the master could see, but
+    a slave purging its cache is about to read what someone else wrote, so
+    they park the slave too.
+*/
+
+#include <stdlib.h>
+#include "sh2thread.h"
+#include "fastmem.h"
+#include "memory.h"
+#include "sh2int.h"
+#include "threads.h"
+#include "trace.h"
+#include "yabause.h"
+
+#define SH2_THREAD_RUN 0
+#define SH2_THREAD_QUIT -1
+#define SH2_THREAD_PARKED 1
+#define SH2_THREAD_DONE 2
+
+#define SH2_THREAD_MAX_STEPS 4096
+#define SH2_THREAD_MAX_DEFERRED 256
+
+// 16 lines
+#define SH2_THREAD_TALK_STEPS (16 * 10)
+
+THREAD_LOCAL int sh2_thread_parallel = 0;
+
+static THREAD_LOCAL int sh2_thread_worker = 0;
+
+static YabEventQueue * q_run = NULL;
+static YabEventQueue * q_done = NULL;
+static int running = 0;
+
+// Master thread only, the slave reads steps after q_run hands them over
+static u32 steps[SH2_THREAD_MAX_STEPS];
+static int num_steps = 0;
+static int active = 0;
+static int finished = 0;
+
+// Input captures seen so far and steps left to run serially
+static u32 talk_captures = 0;
+static int talk_steps = 0;
+
+typedef struct
+{
+   u8 vector;
+   u8 level;
+   u8 remove;
+} sh2deferred_struct;
+
+static sh2deferred_struct deferred[SH2_THREAD_MAX_DEFERRED];
+static int num_deferred = 0;
+
+// The handlers the sync handlers stand in front of
+static readbytefunc read_byte[0x1000];
+static readwordfunc read_word[0x1000];
+static readlongfunc read_long[0x1000];
+static writebytefunc write_byte[0x1000];
+static writewordfunc write_word[0x1000];
+static writelongfunc write_long[0x1000];
+
+//////////////////////////////////////////////////////////////////////////////
+
+static u8 FASTCALL SH2ThreadReadByte(u32 addr)
+{
+   SH2_THREAD_PARK();
+   return read_byte[(addr >> 16) & 0xFFF](addr);
+}
+
+static u16 FASTCALL SH2ThreadReadWord(u32 addr)
+{
+   SH2_THREAD_PARK();
+   return read_word[(addr >> 16) & 0xFFF](addr);
+}
+
+static u32 FASTCALL SH2ThreadReadLong(u32 addr)
+{
+   SH2_THREAD_PARK();
+   return read_long[(addr >> 16) & 0xFFF](addr);
+}
+
+static void FASTCALL SH2ThreadWriteByte(u32 addr, u8 val)
+{
+   SH2_THREAD_PARK();
+   write_byte[(addr >> 16) & 0xFFF](addr, val);
+}
+
+static void FASTCALL SH2ThreadWriteWord(u32 addr, u16 val)
+{
+   SH2_THREAD_PARK();
+   write_word[(addr >> 16) & 0xFFF](addr, val);
+}
+
+static void FASTCALL SH2ThreadWriteLong(u32 addr, u32 val)
+{
+   SH2_THREAD_PARK();
+   write_long[(addr >> 16) & 0xFFF](addr, val);
+}
+
+// The slave's input capture, the master stops the slave before setting it
+static void FASTCALL SH2ThreadCaptureWriteWord(u32 addr, u16 val)
+{
+   SH2_THREAD_PARK();
+   SH2ThreadSync();
+   write_word[(addr >> 16) & 0xFFF](addr, val);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int SH2ThreadIsPrivate(int page)
+{
+   return page <= 0x00F ||                     // bios
+          (page >= 0x020 && page <= 0x02F) ||  // low work ram
+          (page >= 0x600 && page <= 0x610);    // high work ram
+}
+
+static void SH2ThreadHookMemory(void)
+{
+   int i;
+
+   for (i = 0; i < 0x1000; i++)
+   {
+      if (SH2ThreadIsPrivate(i))
+         continue;
+
+      read_byte[i] = ReadByteList[i];
+      read_word[i] = ReadWordList[i];
+      read_long[i] = ReadLongList[i];
+      write_byte[i] = WriteByteList[i];
+      write_word[i] = WriteWordList[i];
+      write_long[i] = WriteLongList[i];
+
+      ReadByteList[i] = &SH2ThreadReadByte;
+      ReadWordList[i] = &SH2ThreadReadWord;
+      ReadLongList[i] = &SH2ThreadReadLong;
+      WriteByteList[i] = &SH2ThreadWriteByte;
+      WriteWordList[i] = i >= 0x100 && i <= 0x17F ? &SH2ThreadCaptureWriteWord : &SH2ThreadWriteWord;
+      WriteLongList[i] = &SH2ThreadWriteLong;
+      FastmemHoldPage(i, 1);
+   }
+}
+
+static void SH2ThreadUnhookMemory(void)
+{
+   int i;
+
+   for (i = 0; i < 0x1000; i++)
+   {
+      if (SH2ThreadIsPrivate(i))
+         continue;
+
+      if (ReadByteList[i] == &SH2ThreadReadByte)
+         ReadByteList[i] = read_byte[i];
+      if (ReadWordList[i] == &SH2ThreadReadWord)
+         ReadWordList[i] = read_word[i];
+      if (ReadLongList[i] == &SH2ThreadReadLong)
+         ReadLongList[i] = read_long[i];
+      if (WriteByteList[i] == &SH2ThreadWriteByte)
+         WriteByteList[i] = write_byte[i];
+      if (WriteWordList[i] == &SH2ThreadWriteWord || WriteWordList[i] == &SH2ThreadCaptureWriteWord)
+         WriteWordList[i] = write_word[i];
+      if (WriteLongList[i] == &SH2ThreadWriteLong)
+         WriteLongList[i] = write_long[i];
+      FastmemHoldPage(i, 0);
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void SH2ThreadExec(SH2_struct *context, u32 cycles)
+{
+   const u32 shift = yabsys.sync_shift;
+
+   if (shift != 0)
+   {
+      const u32 step = cycles >> shift;
+      const u32 amari = cycles - (step << shift);
+      u32 i;
+
+      if (amari != 0)
+         SH2Exec(context, amari);
+      for (i = amari; i < cycles; i += step)
+         SH2Exec(context, step);
+   }
+   else
+      SH2Exec(context, cycles);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void * SH2ThreadWorker(UNUSED void *arg)
+{
+   sh2_thread_worker = 1;
+   TraceThreadName("ssh2");
+
+   while (YabWaitEventQueue(q_run) != SH2_THREAD_QUIT)
+   {
+      int i;
+
+      TRACE_BEGIN(TRACE_SSH2_EXEC);
+      sh2_thread_parallel = 1;
+      for (i = 0; i < num_steps; i++)
+         SH2ThreadExec(SSH2, steps[i]);
+      sh2_thread_parallel = 0;
+      TRACE_END(TRACE_SSH2_EXEC);
+
+      YabAddEventQueue(q_done, SH2_THREAD_DONE);
+   }
+
+   return NULL;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void SH2ThreadPark(void)
+{
+   TRACE_END(TRACE_SSH2_EXEC);
+   sh2_thread_parallel = 0;
+   YabAddEventQueue(q_done, SH2_THREAD_PARKED);
+   YabWaitEventQueue(q_run);
+   TRACE_BEGIN(TRACE_SSH2_EXEC);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int SH2ThreadInit(void)
+{
+#if defined(SH2_DYNAREC) && SH2_DYNAREC
+   // CurrentSH2 is shared by both cpus there
+   return -1;
+#else
+   if (SH2Core == NULL || SH2Core->id != SH2CORE_INTERPRETER)
+      return -1;
+
+   if (running)
+      return 0;
+
+   q_run = YabThreadCreateQueue(2);
+   q_done = YabThreadCreateQueue(2);
+   if (YabThreadStart(YAB_THREAD_SSH2, "ssh2", SH2ThreadWorker, NULL) != 0)
+   {
+      YabThreadDestoryQueue(q_run);
+      YabThreadDestoryQueue(q_done);
+      q_run = q_done = NULL;
+      return -1;
+   }
+
+   SH2ThreadHookMemory();
+   talk_steps = 0;
+   running = 1;
+   return 0;
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void SH2ThreadDeInit(void)
+{
+   if (!running)
+      return;
+
+   SH2ThreadJoin();
+   YabAddEventQueue(q_run, SH2_THREAD_QUIT);
+   YabThreadWait(YAB_THREAD_SSH2);
+   YabThreadDestoryQueue(q_run);
+   YabThreadDestoryQueue(q_done);
+   q_run = q_done = NULL;
+
+   SH2ThreadUnhookMemory();
+   running = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void SH2ThreadRun(const u32 *cycles, int count)
+{
+   if (count > SH2_THREAD_MAX_STEPS)
+      count = SH2_THREAD_MAX_STEPS;
+
+   memcpy(steps, cycles, count * sizeof(u32));
+   num_steps = count;
+   active = 1;
+   finished = 0;
+   YabAddEventQueue(q_run, SH2_THREAD_RUN);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void SH2ThreadSync(void)
+{
+   int i;
+
+   if (sh2_thread_worker || !active || finished)
+      return;
+
+   TRACE_BEGIN(TRACE_SSH2_WAIT);
+   if (YabWaitEventQueue(q_done) == SH2_THREAD_PARKED)
+   {
+      YabAddEventQueue(q_run, SH2_THREAD_RUN);
+      YabWaitEventQueue(q_done);
+   }
+   TRACE_END(TRACE_SSH2_WAIT);
+   finished = 1;
+
+   // Nothing else touches the slave until the next quantum
+   for (i = 0; i < num_deferred; i++)
+   {
+      if (deferred[i].remove)
+         SH2Core->RemoveInterrupt(SSH2, deferred[i].vector, deferred[i].level);
+      else
+         SH2Core->SendInterrupt(SSH2, deferred[i].vector, deferred[i].level);
+   }
+   num_deferred = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void SH2ThreadJoin(void)
+{
+   SH2ThreadSync();
+   active = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int SH2ThreadActive(void)
+{
+   return active;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int SH2ThreadTalking(void)
+{
+   u32 captures = MSH2->inputCaptureCount + SSH2->inputCaptureCount;
+
+   if (captures != talk_captures)
+   {
+      talk_captures = captures;
+      talk_steps = SH2_THREAD_TALK_STEPS;
+   }
+
+   if (talk_steps == 0)
+      return 0;
+   talk_steps--;
+   return 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void SH2ThreadTalk(void)
+{
+   talk_captures = MSH2->inputCaptureCount + SSH2->inputCaptureCount;
+   talk_steps = SH2_THREAD_TALK_STEPS;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int SH2ThreadDefer(u8 vector, u8 level, int remove)
+{
+   if (sh2_thread_worker || !active || finished)
+      return 0;
+
+   if (num_deferred == SH2_THREAD_MAX_DEFERRED)
+   {
+      SH2ThreadSync();
+      return 0;
+   }
+
+   deferred[num_deferred].vector = vector;
+   deferred[num_deferred].level = level;
+   deferred[num_deferred].remove = (u8)remove;
+   num_deferred++;
+   return 1;
+}
@@ -0,0 +1,88 @@
+/*
+        Copyright 2026 agent(agent@local)
+
+This file is part of YabaSanshiro.
+
+        YabaSanshiro is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+YabaSanshiro is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+along with YabaSanshiro; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*! \file sh2thread.h
+    \brief Slave SH2 on its own host thread (yabsys.use_ssh2_thread).
+*/
+
+#ifndef SH2THREAD_H
+#define SH2THREAD_H
+
+#include "core.h"
+#include "sh2core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Set on the slave's thread while it runs next to the master. Cleared once
+// it has waited for the master, from then on it has the machine to itself
+// until the end of the quantum.
+extern THREAD_LOCAL int sh2_thread_parallel;
+
+// SH2_THREAD_PARK: the slave is about to touch something the master or the
+// rest of the machine could be touching, wait until the master is through
+// with the quantum
+#define SH2_THREAD_PARK() do { if (sh2_thread_parallel) SH2ThreadPark(); } while (0)
+
+// SH2ThreadInit: start the slave's thread and put the sync handlers in
+// front of everything but the work rams and the bios. Call after SH2Init
+// and MappedMemoryInit. Returns -1 when the sh2 core can't run that way,
+// YabauseEmulate then runs both cpus on its own thread as before.
+int SH2ThreadInit(void);
+void SH2ThreadDeInit(void);
+
+// SH2ThreadExec: one YabauseEmulate step of context, split by sync_shift
+// the same way the serial loop splits it
+void SH2ThreadExec(SH2_struct *context, u32 cycles);
+
+// SH2ThreadRun: hand the slave the cycles of the next count steps, it runs
+// them on its thread while the master runs the same steps on the caller's
+void SH2ThreadRun(const u32 *cycles, int count);
+
+// SH2ThreadJoin: wait for the slave to finish the quantum and hand it the
+// interrupts sent to it meanwhile
+void SH2ThreadJoin(void);
+
+// SH2ThreadSync: from the master's side, something is about to change the
+// slave. Waits for the slave to stop and lets it finish the quantum first.
+void SH2ThreadSync(void);
+
+// SH2ThreadActive: a quantum is out between SH2ThreadRun and SH2ThreadJoin
+int SH2ThreadActive(void);
+
+void SH2ThreadPark(void);
+
+// SH2ThreadTalking: between quanta, whether the next step has to run
+// serially because a cpu took an input capture not long ago
+int SH2ThreadTalking(void);
+
+// SH2ThreadTalk: run the next steps serially, the slave was just started
+void SH2ThreadTalk(void);
+
+// SH2ThreadDefer: an interrupt for the slave from another thread while the
+// slave runs. Returns 1 when it was queued for SH2ThreadJoin.
+int SH2ThreadDefer(u8 vector, u8 level, int remove);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -7,8 +7,18 @@ using std::string;
 #include <iostream>
 #include <fstream>
 #include <cstdio>
+#include <cstring>
+#include <vector>
+#include <thread>
+#include <atomic>
 
 #include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_LZ4
+#include <lz4frame.h>
+#endif
 #define CHUNK 16384
 
 extern "C"{
@@ -18,136 +28,269 @@ void ScspLockThread();
 void ScspUnLockThread();
 }
 
-extern "C" int YabSaveCompressedState(const char *filename)
+static int compress_method = YAB_STATE_COMPRESS_ZLIB;
+static int compress_level = Z_BEST_COMPRESSION;
+
+// Compression and file output run here so the emulation thread only pays for
+// the in-memory snapshot. Only one job is in flight at a time. YabauseDeInit
+// waits for it, the destructor covers frontends that exit without one.
+struct CompressThread
 {
-  FILE *fp;
-  int status = 0;
-  int ret, flush;
-  unsigned have;
-  z_stream strm;
-  unsigned char in[CHUNK];
-  unsigned char out[CHUNK];
+  std::thread thread;
+  ~CompressThread() { if (thread.joinable()) thread.join(); }
+};
+static CompressThread compress_thread;
+static std::atomic<int> compress_status(0);
+
+static int CompressZlib(const u8 * src, size_t size, std::vector<u8> & out)
+{
+  uLongf destlen = compressBound((uLong)size);
+  out.resize(destlen);
+  if (compress2(&out[0], &destlen, src, (uLong)size, compress_level) != Z_OK)
+    return -1;
+  out.resize(destlen);
+  return 0;
+}
 
-  string tmptilename;
-  tmptilename = string(filename) + ".tmp";
+#ifdef HAVE_ZSTD
+static int CompressZstd(const u8 * src, size_t size, std::vector<u8> & out)
+{
+  out.resize(ZSTD_compressBound(size));
+  size_t ret = ZSTD_compress(&out[0], out.size(), src, size, compress_level);
+  if (ZSTD_isError(ret))
+    return -1;
+  out.resize(ret);
+  return 0;
+}
+#endif
 
-  if( YabSaveState(tmptilename.c_str()) != 0 ){
+#ifdef HAVE_LZ4
+static int CompressLz4(const u8 * src, size_t size, std::vector<u8> & out)
+{
+  LZ4F_preferences_t prefs;
+  memset(&prefs, 0, sizeof(prefs));
+  prefs.frameInfo.contentSize = size;
+  prefs.compressionLevel = compress_level;
+  out.resize(LZ4F_compressFrameBound(size, &prefs));
+  size_t ret = LZ4F_compressFrame(&out[0], out.size(), src, size, &prefs);
+  if (LZ4F_isError(ret))
     return -1;
+  out.resize(ret);
+  return 0;
+}
+#endif
+
+static int CompressAndWrite(const string & filename, u8 * state, size_t size, int method)
+{
+  std::vector<u8> out;
+  int ret;
+
+  switch (method) {
+#ifdef HAVE_ZSTD
+  case YAB_STATE_COMPRESS_ZSTD:
+    ret = CompressZstd(state, size, out);
+    break;
+#endif
+#ifdef HAVE_LZ4
+  case YAB_STATE_COMPRESS_LZ4:
+    ret = CompressLz4(state, size, out);
+    break;
+#endif
+  default:
+    ret = CompressZlib(state, size, out);
+    break;
   }
-  
-  FILE * source = fopen_utf8(tmptilename.c_str(), "rb");
-  if (source == NULL) return -1;
+  free(state);
 
-  FILE * dest = fopen_utf8(filename, "wb");
-  if (dest == NULL) return -1;
-  
-  /* allocate deflate state */
-  strm.zalloc = Z_NULL;
-  strm.zfree = Z_NULL;
-  strm.opaque = Z_NULL;
-  ret = deflateInit(&strm, Z_BEST_COMPRESSION);
-  if (ret != Z_OK)
+  if (ret != 0)
     return -1;
-  /* compress until end of file */
-  do {
-    strm.avail_in = fread(in, 1, CHUNK, source);
-    if (ferror(source)) {
-      (void)deflateEnd(&strm);
-      return -1;
-    }
-    flush = feof(source) ? Z_FINISH : Z_NO_FLUSH;
-    strm.next_in = in;
-    /* run deflate() on input until output buffer not full, finish
-    compression if all of source has been read in */
-    do {
-      strm.avail_out = CHUNK;
-      strm.next_out = out;
-      ret = deflate(&strm, flush);    /* no bad return value */
-      assert(ret != Z_STREAM_ERROR);  /* state not clobbered */
-      have = CHUNK - strm.avail_out;
-      if (fwrite(out, 1, have, dest) != have || ferror(dest)) {
-        (void)deflateEnd(&strm);
-        return -1;
-      }
-    } while (strm.avail_out == 0);
-    assert(strm.avail_in == 0);     /* all input will be used */
-                                    /* done when last data in file processed */
-  } while (flush != Z_FINISH);
-  assert(ret == Z_STREAM_END);        /* stream will be complete */
-                                      /* clean up and return */
-  (void)deflateEnd(&strm);
 
-  fclose(source);
+  FILE * dest = fopen_utf8(filename.c_str(), "wb");
+  if (dest == NULL) return -1;
+
+  if (fwrite(&out[0], 1, out.size(), dest) != out.size() || ferror(dest)) {
+    fclose(dest);
+    return -1;
+  }
   fclose(dest);
-  std::remove(tmptilename.c_str());
-  return status;
+  return 0;
 }
 
+extern "C" int YabSetStateCompression(int method, int level)
+{
+#ifndef HAVE_ZSTD
+  if (method == YAB_STATE_COMPRESS_ZSTD) return -1;
+#endif
+#ifndef HAVE_LZ4
+  if (method == YAB_STATE_COMPRESS_LZ4) return -1;
+#endif
+  YabSaveCompressedStateWait();
+  compress_method = method;
+  compress_level = level;
+  return 0;
+}
 
-extern "C" int YabLoadCompressedState(const char *filename)
+extern "C" int YabSaveCompressedStateWait(void)
 {
-  int ret;
-  unsigned have;
-  z_stream strm;
-  unsigned char in[CHUNK];
-  unsigned char out[CHUNK];
-  string tmptilename;
-  tmptilename = string(filename) + ".tmp";
+  if (compress_thread.thread.joinable())
+    compress_thread.thread.join();
+  return compress_status;
+}
 
-  FILE * source = fopen_utf8(filename, "rb");
-  if (source == NULL) return -1;
+extern "C" int YabSaveCompressedState(const char *filename)
+{
+  YabMemStream ms;
 
-  FILE * dest = fopen_utf8(tmptilename.c_str(), "wb");
-  if (dest == NULL) return -1;
+  // Wait for the previous job first, it may target the same file
+  YabSaveCompressedStateWait();
+
+  YabMemStreamInit(&ms, 0);
+  if (YabSaveStateMem(&ms, 0) != 0) {
+    return -1;
+  }
+
+  size_t size;
+  u8 * state = YabMemStreamDetach(&ms, &size);
+
+  compress_status = 0;
+  compress_thread.thread = std::thread([](string path, u8 * data, size_t len, int method) {
+    compress_status = CompressAndWrite(path, data, len, method);
+  }, string(filename), state, size, compress_method);
+
+  return 0;
+}
+
+static int DecompressZlib(const std::vector<u8> & in, std::vector<u8> & out)
+{
+  int ret;
+  z_stream strm;
 
   /* allocate inflate state */
   strm.zalloc = Z_NULL;
   strm.zfree = Z_NULL;
   strm.opaque = Z_NULL;
-  strm.avail_in = 0;
-  strm.next_in = Z_NULL;
+  strm.avail_in = (uInt)in.size();
+  strm.next_in = (Bytef *)&in[0];
   ret = inflateInit(&strm);
   if (ret != Z_OK)
     return -1;
-  /* decompress until deflate stream ends or end of file */
+
+  out.resize(in.size() * 4);
+  /* run inflate() growing the output until the deflate stream ends */
   do {
-    strm.avail_in = fread(in, 1, CHUNK, source);
-    if (ferror(source)) {
+    if (strm.total_out == out.size())
+      out.resize(out.size() * 2);
+    strm.next_out = &out[strm.total_out];
+    strm.avail_out = (uInt)(out.size() - strm.total_out);
+    ret = inflate(&strm, Z_NO_FLUSH);
+    assert(ret != Z_STREAM_ERROR);  /* state not clobbered */
+    switch (ret) {
+    case Z_NEED_DICT:
+    case Z_DATA_ERROR:
+    case Z_MEM_ERROR:
       (void)inflateEnd(&strm);
       return -1;
-    }
-    if (strm.avail_in == 0)
-      break;
-    strm.next_in = in;
-
-    /* run inflate() on input until output buffer not full */
-    do {
-      strm.avail_out = CHUNK;
-      strm.next_out = out;
-      ret = inflate(&strm, Z_NO_FLUSH);
-      assert(ret != Z_STREAM_ERROR);  /* state not clobbered */
-      switch (ret) {
-      case Z_NEED_DICT:
-        ret = Z_DATA_ERROR;     /* and fall through */
-      case Z_DATA_ERROR:
-      case Z_MEM_ERROR:
-        (void)inflateEnd(&strm);
-        return -1;
-      }
-      have = CHUNK - strm.avail_out;
-      if (fwrite(out, 1, have, dest) != have || ferror(dest)) {
+    case Z_BUF_ERROR:
+      if (strm.avail_in == 0) {
         (void)inflateEnd(&strm);
         return -1;
       }
-    } while (strm.avail_out == 0);
-    /* done when inflate() says it's done */
+      break;
+    }
   } while (ret != Z_STREAM_END);
 
+  out.resize(strm.total_out);
+  (void)inflateEnd(&strm);
+  return 0;
+}
+
+#ifdef HAVE_ZSTD
+static int DecompressZstd(const std::vector<u8> & in, std::vector<u8> & out)
+{
+  unsigned long long len = ZSTD_getFrameContentSize(&in[0], in.size());
+  if (len == ZSTD_CONTENTSIZE_UNKNOWN || len == ZSTD_CONTENTSIZE_ERROR)
+    return -1;
+  out.resize((size_t)len);
+  size_t ret = ZSTD_decompress(&out[0], out.size(), &in[0], in.size());
+  if (ZSTD_isError(ret) || ret != len)
+    return -1;
+  return 0;
+}
+#endif
+
+#ifdef HAVE_LZ4
+static int DecompressLz4(const std::vector<u8> & in, std::vector<u8> & out)
+{
+  LZ4F_dctx * dctx;
+  LZ4F_frameInfo_t info;
+  size_t consumed = in.size();
+  size_t inpos, outpos = 0;
+  size_t ret;
+
+  if (LZ4F_isError(LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION)))
+    return -1;
+
+  ret = LZ4F_getFrameInfo(dctx, &info, &in[0], &consumed);
+  if (LZ4F_isError(ret) || info.contentSize == 0) {
+    LZ4F_freeDecompressionContext(dctx);
+    return -1;
+  }
+  out.resize((size_t)info.contentSize);
+  inpos = consumed;
+
+  while (ret != 0 && inpos < in.size()) {
+    size_t srcsize = in.size() - inpos;
+    size_t dstsize = out.size() - outpos;
+    ret = LZ4F_decompress(dctx, &out[outpos], &dstsize, &in[inpos], &srcsize, NULL);
+    if (LZ4F_isError(ret)) {
+      LZ4F_freeDecompressionContext(dctx);
+      return -1;
+    }
+    inpos += srcsize;
+    outpos += dstsize;
+  }
+  LZ4F_freeDecompressionContext(dctx);
+  return outpos == out.size() ? 0 : -1;
+}
+#endif
+
+extern "C" int YabLoadCompressedState(const char *filename)
+{
+  std::vector<u8> in;
+  std::vector<u8> out;
+  unsigned char buf[CHUNK];
+  size_t num_read;
+  int ret;
+
+  YabSaveCompressedStateWait();
+
+  FILE * source = fopen_utf8(filename, "rb");
+  if (source == NULL) return -1;
+
+  while ((num_read = fread(buf, 1, CHUNK, source)) != 0)
+    in.insert(in.end(), buf, buf + num_read);
+
+  if (ferror(source) || in.size() < 4) {
+    fclose(source);
+    return -1;
+  }
   fclose(source);
-  fclose(dest);
 
-  int rtn = YabLoadState(tmptilename.c_str());  
-  std::remove(tmptilename.c_str());
-  return rtn;
+  // The codec is identified by the frame magic, plain zlib files stay loadable
+#ifdef HAVE_ZSTD
+  if (in[0] == 0x28 && in[1] == 0xB5 && in[2] == 0x2F && in[3] == 0xFD)
+    ret = DecompressZstd(in, out);
+  else
+#endif
+#ifdef HAVE_LZ4
+  if (in[0] == 0x04 && in[1] == 0x22 && in[2] == 0x4D && in[3] == 0x18)
+    ret = DecompressLz4(in, out);
+  else
+#endif
+    ret = DecompressZlib(in, out);
+
+  if (ret != 0)
+    return -1;
 
+  return YabLoadStateBuffer(&out[0], out.size());
 }
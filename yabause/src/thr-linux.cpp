@@ -108,6 +108,7 @@ int YabThreadStart(unsigned int id, const char * name, void* (*func)(void *), vo
    // Set up a dummy signal handler for SIGUSR1 so we can return from pause()
    // in YabThreadSleep()
    static struct sigaction sa; // = {.sa_handler = dummy_sighandler};
+   sa.sa_handler = dummy_sighandler;
    if (sigaction(SIGUSR1, &sa, NULL) != 0)
    {
       perror("sigaction(SIGUSR1)");
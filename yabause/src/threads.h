@@ -38,18 +38,14 @@ enum {
    YAB_THREAD_NETLINKCONNECT,
    YAB_THREAD_NETLINKCLIENT,
    YAB_THREAD_OPENAL,
-   YAB_THREAD_VIDSOFT_LAYER_NBG3,
-   YAB_THREAD_VIDSOFT_LAYER_NBG2,
-   YAB_THREAD_VIDSOFT_LAYER_NBG1,
-   YAB_THREAD_VIDSOFT_LAYER_NBG0,
    YAB_THREAD_VIDSOFT_LAYER_RBG0,
    YAB_THREAD_VIDSOFT_VDP1,
-   YAB_THREAD_VIDSOFT_PRIORITY_0,
-   YAB_THREAD_VIDSOFT_PRIORITY_1,
-   YAB_THREAD_VIDSOFT_PRIORITY_2,
-   YAB_THREAD_VIDSOFT_PRIORITY_3,
-   YAB_THREAD_VIDSOFT_PRIORITY_4,
-   YAB_THREAD_VIDSOFT_LAYER_SPRITE,
+   YAB_THREAD_CD_PREFETCH,
+   YAB_THREAD_VIDSOFT_WORKER_0,
+   YAB_THREAD_VIDSOFT_WORKER_LAST = YAB_THREAD_VIDSOFT_WORKER_0 + 15,
+   YAB_THREAD_VIDSOFT_VDP1_WORKER_0,
+   YAB_THREAD_VIDSOFT_VDP1_WORKER_LAST = YAB_THREAD_VIDSOFT_VDP1_WORKER_0 + 15,
+   YAB_THREAD_SSH2,
    YAB_NUM_THREADS      // Total number of subthreads
 };
 
@@ -20,9 +20,20 @@
 #include "titan.h"
 #include "../vidshared.h"
 #include "../vidsoft.h"
-#include "../threads.h"
 
 #include <stdlib.h>
+#include <string.h>
+
+#if !defined(WORDS_BIGENDIAN)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TITAN_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define TITAN_SIMD_NEON
+#include <arm_neon.h>
+#endif
+#define TITAN_HAVE_BATCH
+#endif
 
 /* private */
 typedef u32 (*TitanBlendFunc)(u32 top, u32 bottom);
@@ -41,35 +52,48 @@ struct PixelData
    u8 shadow_enabled;
 };
 
+// Layers are stored as struct-of-arrays so the batch compositor can load the
+// priorities of 16 pixels at once. The back screen only ever has a color.
+struct TitanLayer
+{
+   u32 * pixel;
+   u8 * priority;
+   u8 * linescreen;
+   u8 * shadow_type;
+   u8 * shadow_enabled;
+};
+
 static struct TitanContext {
    int inited;
-   struct PixelData * vdp2framebuffer[6];
+   struct TitanLayer vdp2framebuffer[6];
    u32 * linescreen[4];
    int vdp2width;
    int vdp2height;
    TitanBlendFunc blend;
    TitanTransFunc trans;
-   struct PixelData * backscreen;
+   u32 * backscreen;
    int layer_priority[6];
+   int blend_mode;
+   int compositor;
 } tt_context = {
    0,
-   { NULL, NULL, NULL, NULL, NULL, NULL },
+   { { NULL } },
    { NULL, NULL, NULL, NULL },
    320,
    224,
-   NULL,NULL,NULL
+   NULL,NULL,NULL,
+   { 0 },
+   TITAN_BLEND_TOP,
+   // the portable lanes are only there for testing, they are not faster
+#if defined(TITAN_SIMD_SSE2) || defined(TITAN_SIMD_NEON)
+   TITAN_COMPOSITOR_BATCH
+#else
+   TITAN_COMPOSITOR_REFERENCE
+#endif
 };
 
 struct
 {
-   volatile int need_draw[5];
-   volatile int draw_finished[5];
-   struct
-   {
-      volatile int start;
-      volatile int end;
-   }lines[5];
-
    pixel_t * dispbuffer;
    int use_simplified;
 }priority_thread_context;
@@ -147,48 +171,48 @@ void TitanRenderLinesSimplified(pixel_t * dispbuffer, int start_line, int end_li
       for (x = 0; x < tt_context.vdp2width; x++)
       {
          int layer_pos = (layer_y * tt_context.vdp2width) + x;
+         u32 sprite_pixel = tt_context.vdp2framebuffer[TITAN_SPRITE].pixel[layer_pos];
+         u8 sprite_priority = tt_context.vdp2framebuffer[TITAN_SPRITE].priority[layer_pos];
          i = (y * tt_context.vdp2width) + x;
 
          dispbuffer[i] = 0;
 
          for (j = 0; j < num_layers; j++)
          {
-            struct PixelData sprite = tt_context.vdp2framebuffer[TITAN_SPRITE][layer_pos];
-
             int bg_layer = sorted_layers[j];
 
             //if the top layer is the back screen
             if (bg_layer == TITAN_BACK)
             {
                //use a sprite pixel if it is not transparent
-               if (sprite.pixel)
+               if (sprite_pixel)
                {
-                  dispbuffer[i] = TitanFixAlpha(sprite.pixel);
+                  dispbuffer[i] = TitanFixAlpha(sprite_pixel);
                   break;
                }
                else
                {
                   //otherwise use the back screen pixel
-                  dispbuffer[i] = TitanFixAlpha(tt_context.backscreen[y].pixel);
+                  dispbuffer[i] = TitanFixAlpha(tt_context.backscreen[y]);
                   break;
                }
             }
             //if the top layer is a sprite pixel
-            else if (sprite.priority >= tt_context.layer_priority[bg_layer])
+            else if (sprite_priority >= tt_context.layer_priority[bg_layer])
             {
                //use the sprite pixel if it is not transparent
-               if (sprite.pixel)
+               if (sprite_pixel)
                {
-                  dispbuffer[i] = TitanFixAlpha(sprite.pixel);
+                  dispbuffer[i] = TitanFixAlpha(sprite_pixel);
                   break;
                }
             }
             else
             {
                //use the bg layer if it is not covered with a sprite pixel and not transparent
-               if (tt_context.vdp2framebuffer[bg_layer][layer_pos].pixel)
+               if (tt_context.vdp2framebuffer[bg_layer].pixel[layer_pos])
                {
-                  dispbuffer[i] = TitanFixAlpha(tt_context.vdp2framebuffer[bg_layer][layer_pos].pixel);
+                  dispbuffer[i] = TitanFixAlpha(tt_context.vdp2framebuffer[bg_layer].pixel[layer_pos]);
                   break;
                }
             }
@@ -206,27 +230,11 @@ void TitanRenderSimplifiedCheck(pixel_t * buf, int start, int end, int can_use_s
       TitanRenderLines(buf, start, end);
 }
 
-#define DECLARE_PRIORITY_THREAD(FUNC_NAME, THREAD_NUMBER) \
-void * FUNC_NAME(void* data) \
-{ \
-   for (;;) \
-   { \
-      if (priority_thread_context.need_draw[THREAD_NUMBER]) \
-      { \
-         priority_thread_context.need_draw[THREAD_NUMBER] = 0; \
-         TitanRenderSimplifiedCheck(priority_thread_context.dispbuffer, priority_thread_context.lines[THREAD_NUMBER].start, priority_thread_context.lines[THREAD_NUMBER].end, priority_thread_context.use_simplified); \
-         priority_thread_context.draw_finished[THREAD_NUMBER] = 1; \
-      } \
-      YabThreadSleep(); \
-   } return NULL; \
+static void TitanRenderJob(void * arg, int start, int end)
+{
+   TitanRenderSimplifiedCheck(priority_thread_context.dispbuffer, start, end, priority_thread_context.use_simplified);
 }
 
-DECLARE_PRIORITY_THREAD(VidsoftPriorityThread0, 0);
-DECLARE_PRIORITY_THREAD(VidsoftPriorityThread1, 1);
-DECLARE_PRIORITY_THREAD(VidsoftPriorityThread2, 2);
-DECLARE_PRIORITY_THREAD(VidsoftPriorityThread3, 3);
-DECLARE_PRIORITY_THREAD(VidsoftPriorityThread4, 4);
-
 static u32 TitanBlendPixelsTop(u32 top, u32 bottom)
 {
    u8 alpha, ralpha, tr, tg, tb, br, bg, bb;
@@ -291,6 +299,18 @@ static INLINE int FASTCALL TitanTransBit(u32 pixel)
    return pixel & 0x80000000;
 }
 
+static INLINE struct PixelData TitanGetPixelData(int layer, int pos)
+{
+   struct PixelData data;
+   data.pixel = tt_context.vdp2framebuffer[layer].pixel[pos];
+   data.priority = tt_context.vdp2framebuffer[layer].priority[pos];
+   data.linescreen = tt_context.vdp2framebuffer[layer].linescreen[pos];
+   data.shadow_type = tt_context.vdp2framebuffer[layer].shadow_type[pos];
+   data.shadow_enabled = tt_context.vdp2framebuffer[layer].shadow_enabled[pos];
+   return data;
+}
+
+// Reference compositor, TitanRenderLinesBatch must give identical results
 static u32 TitanDigPixel(int pos, int y)
 {
    struct PixelData pixel_stack[2] = { 0 };
@@ -306,9 +326,9 @@ static u32 TitanDigPixel(int pos, int y)
 
       for (which_layer = TITAN_SPRITE; which_layer >= 0; which_layer--)
       {
-         if (tt_context.vdp2framebuffer[which_layer][pos].priority == priority)
+         if (tt_context.vdp2framebuffer[which_layer].priority[pos] == priority)
          {
-            pixel_stack[pixel_stack_pos] = tt_context.vdp2framebuffer[which_layer][pos];
+            pixel_stack[pixel_stack_pos] = TitanGetPixelData(which_layer, pos);
             pixel_stack_pos++;
 
             if (pixel_stack_pos == 2)
@@ -317,7 +337,7 @@ static u32 TitanDigPixel(int pos, int y)
       }
    }
 
-   pixel_stack[pixel_stack_pos] = tt_context.backscreen[pos];
+   pixel_stack[pixel_stack_pos].pixel = tt_context.backscreen[pos];
 
 finished:
 
@@ -373,6 +393,350 @@ finished:
    return pixel_stack[0].pixel;
 }
 
+#ifdef TITAN_HAVE_BATCH
+
+// Batch compositor. Priority selection runs on 16 pixels at a time with u8
+// lanes, the two winning pixels are gathered and then shadow handling and
+// blending run on 4 u32 lanes, all branches computed and merged with masks.
+// Only little endian layouts are handled, the channel offsets are fixed.
+
+#define TITAN_BATCH 16
+
+#if defined(TITAN_SIMD_SSE2)
+typedef __m128i TitanVec;
+#define TV_LOAD(p)         _mm_loadu_si128((const __m128i *)(p))
+#define TV_STORE(p, a)     _mm_storeu_si128((__m128i *)(p), a)
+#define TV_SET1(x)         _mm_set1_epi32((int)(x))
+#define TV_AND(a, b)       _mm_and_si128(a, b)
+#define TV_OR(a, b)        _mm_or_si128(a, b)
+#define TV_ANDNOT(a, b)    _mm_andnot_si128(a, b)
+#define TV_ADD(a, b)       _mm_add_epi32(a, b)
+#define TV_SUB(a, b)       _mm_sub_epi32(a, b)
+#define TV_SHR(a, n)       _mm_srli_epi32(a, n)
+#define TV_SHL(a, n)       _mm_slli_epi32(a, n)
+// both operands are below 0x100, so the 16 bit multiply is exact
+#define TV_MUL8(a, b)      _mm_mullo_epi16(a, b)
+#define TV_CMPEQ(a, b)     _mm_cmpeq_epi32(a, b)
+#define TV_CMPGT(a, b)     _mm_cmpgt_epi32(a, b)
+#elif defined(TITAN_SIMD_NEON)
+typedef uint32x4_t TitanVec;
+#define TV_LOAD(p)         vld1q_u32((const uint32_t *)(p))
+#define TV_STORE(p, a)     vst1q_u32((uint32_t *)(p), a)
+#define TV_SET1(x)         vdupq_n_u32(x)
+#define TV_AND(a, b)       vandq_u32(a, b)
+#define TV_OR(a, b)        vorrq_u32(a, b)
+#define TV_ANDNOT(a, b)    vbicq_u32(b, a)
+#define TV_ADD(a, b)       vaddq_u32(a, b)
+#define TV_SUB(a, b)       vsubq_u32(a, b)
+// register shifts, the immediate forms reject a right shift by 0
+#define TV_SHR(a, n)       vshlq_u32(a, vdupq_n_s32(-(n)))
+#define TV_SHL(a, n)       vshlq_u32(a, vdupq_n_s32(n))
+#define TV_MUL8(a, b)      vmulq_u32(a, b)
+#define TV_CMPEQ(a, b)     vceqq_u32(a, b)
+#define TV_CMPGT(a, b)     vcgtq_u32(a, b)
+#else
+typedef struct { u32 v[4]; } TitanVec;
+#define TV_LANES(expr) { TitanVec r_; int l_; for (l_ = 0; l_ < 4; l_++) r_.v[l_] = (expr); return r_; }
+static INLINE TitanVec TV_LOAD(const u32 * p) TV_LANES(p[l_])
+static INLINE void TV_STORE(u32 * p, TitanVec a) { memcpy(p, a.v, sizeof(a.v)); }
+static INLINE TitanVec TV_SET1(u32 x) TV_LANES(x)
+static INLINE TitanVec TV_AND(TitanVec a, TitanVec b) TV_LANES(a.v[l_] & b.v[l_])
+static INLINE TitanVec TV_OR(TitanVec a, TitanVec b) TV_LANES(a.v[l_] | b.v[l_])
+static INLINE TitanVec TV_ANDNOT(TitanVec a, TitanVec b) TV_LANES(~a.v[l_] & b.v[l_])
+static INLINE TitanVec TV_ADD(TitanVec a, TitanVec b) TV_LANES(a.v[l_] + b.v[l_])
+static INLINE TitanVec TV_SUB(TitanVec a, TitanVec b) TV_LANES(a.v[l_] - b.v[l_])
+static INLINE TitanVec TV_SHR(TitanVec a, int n) TV_LANES(a.v[l_] >> n)
+static INLINE TitanVec TV_SHL(TitanVec a, int n) TV_LANES(a.v[l_] << n)
+static INLINE TitanVec TV_MUL8(TitanVec a, TitanVec b) TV_LANES(a.v[l_] * b.v[l_])
+static INLINE TitanVec TV_CMPEQ(TitanVec a, TitanVec b) TV_LANES(a.v[l_] == b.v[l_] ? 0xFFFFFFFF : 0)
+static INLINE TitanVec TV_CMPGT(TitanVec a, TitanVec b) TV_LANES(a.v[l_] > b.v[l_] ? 0xFFFFFFFF : 0)
+#undef TV_LANES
+#endif
+
+#define TV_SELECT(mask, a, b) TV_OR(TV_AND(mask, a), TV_ANDNOT(mask, b))
+
+// exact floor(v / 255) for v <= 255 * 255
+static INLINE TitanVec TitanVecDiv255(TitanVec v)
+{
+   return TV_SHR(TV_ADD(TV_ADD(v, TV_SET1(1)), TV_SHR(v, 8)), 8);
+}
+
+#define TITAN_VEC_MIX_CHANNEL(shift) \
+   c = TV_ADD(TitanVecDiv255(TV_MUL8(TV_AND(TV_SHR(top, shift), mask), alpha)), \
+              TitanVecDiv255(TV_MUL8(TV_AND(TV_SHR(bottom, shift), mask), ralpha))); \
+   res = TV_OR(res, TV_SHL(c, shift));
+
+// top * alpha / 0xFF + bottom * ralpha / 0xFF on every color channel
+static INLINE TitanVec TitanVecMix(TitanVec top, TitanVec bottom, TitanVec alpha)
+{
+   TitanVec mask = TV_SET1(0xFF);
+   TitanVec ralpha = TV_SUB(mask, alpha);
+   TitanVec res = TV_SET1(0);
+   TitanVec c;
+
+   TITAN_VEC_MIX_CHANNEL(0);
+   TITAN_VEC_MIX_CHANNEL(8);
+   TITAN_VEC_MIX_CHANNEL(16);
+   return res;
+}
+
+static INLINE TitanVec TitanVecGetAlpha(TitanVec pixel)
+{
+   return TV_AND(TV_SHR(pixel, 24), TV_SET1(0x3F));
+}
+
+static INLINE TitanVec TitanVecBlendTop(TitanVec top, TitanVec bottom)
+{
+   TitanVec alpha = TV_ADD(TV_SHL(TitanVecGetAlpha(top), 2), TV_SET1(3));
+   return TV_OR(TitanVecMix(top, bottom, alpha), TV_SET1(0x3F000000));
+}
+
+static INLINE TitanVec TitanVecBlendBottom(TitanVec top, TitanVec bottom)
+{
+   TitanVec alpha = TV_ADD(TV_SHL(TitanVecGetAlpha(bottom), 2), TV_SET1(3));
+   TitanVec res = TV_OR(TitanVecMix(top, bottom, alpha), TV_SHL(TitanVecGetAlpha(top), 24));
+   TitanVec opaque = TV_CMPEQ(TV_AND(top, TV_SET1(0x80000000)), TV_SET1(0));
+   return TV_SELECT(opaque, top, res);
+}
+
+// sums are at most 0x1FE so a signed compare is fine
+#define TITAN_VEC_ADD_CHANNEL(shift) \
+   c = TV_ADD(TV_AND(TV_SHR(top, shift), mask), TV_AND(TV_SHR(bottom, shift), mask)); \
+   c = TV_SELECT(TV_CMPGT(c, mask), mask, c); \
+   res = TV_OR(res, TV_SHL(c, shift));
+
+static INLINE TitanVec TitanVecBlendAdd(TitanVec top, TitanVec bottom)
+{
+   TitanVec mask = TV_SET1(0xFF);
+   TitanVec res = TV_SET1(0x3F000000);
+   TitanVec c;
+
+   TITAN_VEC_ADD_CHANNEL(0);
+   TITAN_VEC_ADD_CHANNEL(8);
+   TITAN_VEC_ADD_CHANNEL(16);
+   return res;
+}
+
+static INLINE TitanVec TitanVecBlend(TitanVec top, TitanVec bottom, int mode)
+{
+   if (mode == TITAN_BLEND_BOTTOM)
+      return TitanVecBlendBottom(top, bottom);
+   else if (mode == TITAN_BLEND_ADD)
+      return TitanVecBlendAdd(top, bottom);
+   return TitanVecBlendTop(top, bottom);
+}
+
+static INLINE TitanVec TitanVecTrans(TitanVec pixel, int mode)
+{
+   if (mode == TITAN_BLEND_TOP)
+      return TV_CMPGT(TV_SET1(0x3F), TitanVecGetAlpha(pixel));
+   return TV_ANDNOT(TV_CMPEQ(TV_AND(pixel, TV_SET1(0x80000000)), TV_SET1(0)), TV_SET1(0xFFFFFFFF));
+}
+
+// Same as TitanBlendPixelsTop(0x20000000, pixel)
+static INLINE TitanVec TitanVecShadow(TitanVec pixel)
+{
+   return TitanVecBlendTop(TV_SET1(0x20000000), pixel);
+}
+
+struct TitanBatch
+{
+   u8 top[TITAN_BATCH];
+   u8 second[TITAN_BATCH];
+   u32 top_pixel[TITAN_BATCH];
+   u32 top_shadow_type[TITAN_BATCH];
+   u32 line_mask[TITAN_BATCH];
+   u32 line_color[TITAN_BATCH];
+   u32 bottom_pixel[TITAN_BATCH];
+   u32 bottom_shadow[TITAN_BATCH];
+   u32 dot[TITAN_BATCH];
+};
+
+// Selection key of a layer pixel: priority in bits 3-5 and layer + 1 in bits
+// 0-2, zero when the priority is outside 1-7. Keys are unique per pixel so
+// the two highest keys are exactly what TitanDigPixel would stack.
+static void TitanBatchSelect(struct TitanBatch * batch, int pos)
+{
+#if defined(TITAN_SIMD_SSE2)
+   __m128i top = _mm_setzero_si128();
+   __m128i second = _mm_setzero_si128();
+   __m128i keys[6];
+   int layer;
+
+   for (layer = 0; layer < 6; layer++)
+   {
+      __m128i prio = _mm_loadu_si128((const __m128i *)(tt_context.vdp2framebuffer[layer].priority + pos));
+      __m128i valid = _mm_andnot_si128(_mm_cmpeq_epi8(prio, _mm_setzero_si128()),
+         _mm_cmpeq_epi8(_mm_min_epu8(prio, _mm_set1_epi8(7)), prio));
+      // prio is at most 7 once masked so nothing shifts across byte lanes
+      keys[layer] = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(prio, valid), 3),
+         _mm_and_si128(valid, _mm_set1_epi8((char)(layer + 1))));
+      top = _mm_max_epu8(top, keys[layer]);
+   }
+   for (layer = 0; layer < 6; layer++)
+      second = _mm_max_epu8(second, _mm_andnot_si128(_mm_cmpeq_epi8(keys[layer], top), keys[layer]));
+
+   _mm_storeu_si128((__m128i *)batch->top, top);
+   _mm_storeu_si128((__m128i *)batch->second, second);
+#elif defined(TITAN_SIMD_NEON)
+   uint8x16_t top = vdupq_n_u8(0);
+   uint8x16_t second = vdupq_n_u8(0);
+   uint8x16_t keys[6];
+   int layer;
+
+   for (layer = 0; layer < 6; layer++)
+   {
+      uint8x16_t prio = vld1q_u8(tt_context.vdp2framebuffer[layer].priority + pos);
+      uint8x16_t valid = vandq_u8(vtstq_u8(prio, prio), vcleq_u8(prio, vdupq_n_u8(7)));
+      keys[layer] = vandq_u8(vorrq_u8(vshlq_n_u8(prio, 3), vdupq_n_u8(layer + 1)), valid);
+      top = vmaxq_u8(top, keys[layer]);
+   }
+   for (layer = 0; layer < 6; layer++)
+      second = vmaxq_u8(second, vbicq_u8(keys[layer], vceqq_u8(keys[layer], top)));
+
+   vst1q_u8(batch->top, top);
+   vst1q_u8(batch->second, second);
+#else
+   int i, layer;
+
+   for (i = 0; i < TITAN_BATCH; i++)
+   {
+      u8 top = 0, second = 0;
+
+      for (layer = 0; layer < 6; layer++)
+      {
+         u8 prio = tt_context.vdp2framebuffer[layer].priority[pos + i];
+         u8 key = (prio > 0 && prio <= 7) ? (u8)((prio << 3) | (layer + 1)) : 0;
+
+         if (key > top)
+         {
+            second = top;
+            top = key;
+         }
+         else if (key > second)
+            second = key;
+      }
+      batch->top[i] = top;
+      batch->second[i] = second;
+   }
+#endif
+}
+
+static void TitanBatchGather(struct TitanBatch * batch, int pos, int y)
+{
+   int i;
+
+   for (i = 0; i < TITAN_BATCH; i++)
+   {
+      int top = batch->top[i];
+      int second = batch->second[i];
+      int p = pos + i;
+
+      if (top)
+      {
+         struct TitanLayer * layer = &tt_context.vdp2framebuffer[(top & 7) - 1];
+         int linescreen = layer->linescreen[p];
+
+         batch->top_pixel[i] = layer->pixel[p];
+         batch->top_shadow_type[i] = layer->shadow_type[p];
+         batch->line_mask[i] = linescreen ? 0xFFFFFFFF : 0;
+         batch->line_color[i] = linescreen ? tt_context.linescreen[linescreen][y] : 0;
+
+         if (second)
+         {
+            layer = &tt_context.vdp2framebuffer[(second & 7) - 1];
+            batch->bottom_pixel[i] = layer->pixel[p];
+            batch->bottom_shadow[i] = layer->shadow_enabled[p] ? 0xFFFFFFFF : 0;
+         }
+         else
+         {
+            batch->bottom_pixel[i] = tt_context.backscreen[p];
+            batch->bottom_shadow[i] = 0;
+         }
+      }
+      else
+      {
+         batch->top_pixel[i] = tt_context.backscreen[p];
+         batch->top_shadow_type[i] = 0;
+         batch->line_mask[i] = 0;
+         batch->line_color[i] = 0;
+         batch->bottom_pixel[i] = 0;
+         batch->bottom_shadow[i] = 0;
+      }
+   }
+}
+
+static void TitanBatchResolve(struct TitanBatch * batch, int mode, int self_shadow)
+{
+   int i;
+
+   for (i = 0; i < TITAN_BATCH; i += 4)
+   {
+      TitanVec top = TV_LOAD(batch->top_pixel + i);
+      TitanVec bottom = TV_LOAD(batch->bottom_pixel + i);
+      TitanVec shadow_type = TV_LOAD(batch->top_shadow_type + i);
+      TitanVec zero = TV_SET1(0);
+      TitanVec blended, shadowed_bottom, msb, use_bottom, res;
+
+      top = TV_SELECT(TV_LOAD(batch->line_mask + i), TitanVecBlend(top, TV_LOAD(batch->line_color + i), mode), top);
+
+      blended = TV_SELECT(TitanVecTrans(top, mode), TitanVecBlend(top, bottom, mode), top);
+      shadowed_bottom = TV_SELECT(TV_LOAD(batch->bottom_shadow + i), TitanVecShadow(bottom), bottom);
+
+      msb = TV_CMPEQ(shadow_type, TV_SET1(TITAN_MSB_SHADOW));
+      //transparent sprite shadow or normal shadow show the pixel below
+      use_bottom = TV_OR(TV_AND(msb, TV_CMPEQ(TV_AND(top, TV_SET1(0xFFFFFF)), zero)),
+         TV_CMPEQ(shadow_type, TV_SET1(TITAN_NORMAL_SHADOW)));
+
+      res = blended;
+      if (self_shadow)
+         res = TV_SELECT(msb, TitanVecShadow(blended), res);
+      res = TV_SELECT(use_bottom, shadowed_bottom, res);
+
+      TV_STORE(batch->dot + i, res);
+   }
+}
+
+static void TitanRenderLinesBatch(pixel_t * dispbuffer, int start_line, int end_line)
+{
+   int x, y, layer_y, i;
+   int line_increment, interlace_line;
+   int mode = tt_context.blend_mode;
+   //sprite self-shadowing, only if sprite window is not enabled
+   int self_shadow = !(Vdp2Regs->SPCTL & 0x10);
+   struct TitanBatch batch;
+
+   Vdp2GetInterlaceInfo(&interlace_line, &line_increment);
+
+   set_layer_y(start_line, &layer_y);
+
+   for (y = start_line + interlace_line; y < end_line; y += line_increment)
+   {
+      pixel_t * line = dispbuffer + (y * tt_context.vdp2width);
+      int layer_pos = layer_y * tt_context.vdp2width;
+
+      for (x = 0; x + TITAN_BATCH <= tt_context.vdp2width; x += TITAN_BATCH)
+      {
+         TitanBatchSelect(&batch, layer_pos + x);
+         TitanBatchGather(&batch, layer_pos + x, y);
+         TitanBatchResolve(&batch, mode, self_shadow);
+
+         for (i = 0; i < TITAN_BATCH; i++)
+            line[x + i] = batch.dot[i] ? TitanFixAlpha(batch.dot[i]) : 0;
+      }
+
+      for (; x < tt_context.vdp2width; x++)
+      {
+         u32 dot = TitanDigPixel(layer_pos + x, y);
+         line[x] = dot ? TitanFixAlpha(dot) : 0;
+      }
+
+      layer_y++;
+   }
+}
+
+#endif
+
 /* public */
 int TitanInit()
 {
@@ -382,8 +746,16 @@ int TitanInit()
    {
       for(i = 0;i < 6;i++)
       {
-         if ((tt_context.vdp2framebuffer[i] = (struct PixelData *)calloc(sizeof(struct PixelData), 704 * 256)) == NULL)
+         struct TitanLayer * layer = &tt_context.vdp2framebuffer[i];
+
+         if ((layer->pixel = (u32 *)calloc(sizeof(u32), 704 * 256)) == NULL)
             return -1;
+         // the byte planes share one block, padded so 16 byte loads never overrun
+         if ((layer->priority = (u8 *)calloc(4, 704 * 256 + 16)) == NULL)
+            return -1;
+         layer->linescreen = layer->priority + (704 * 256 + 16);
+         layer->shadow_type = layer->linescreen + (704 * 256 + 16);
+         layer->shadow_enabled = layer->shadow_type + (704 * 256 + 16);
       }
 
       /* linescreen 0 is not initialized as it's not used... */
@@ -393,26 +765,17 @@ int TitanInit()
             return -1;
       }
 
-      if ((tt_context.backscreen = (struct PixelData  *)calloc(sizeof(struct PixelData), 704 * 512)) == NULL)
+      if ((tt_context.backscreen = (u32 *)calloc(sizeof(u32), 704 * 512)) == NULL)
          return -1;
 
-      for (i = 0; i < 5; i++)
-      {
-         priority_thread_context.draw_finished[i] = 1;
-         priority_thread_context.need_draw[i] = 0;
-      }
-
-      YabThreadStart(YAB_THREAD_VIDSOFT_PRIORITY_0, "YAB_THREAD_VIDSOFT_PRIORITY_0", VidsoftPriorityThread0, NULL);
-      YabThreadStart(YAB_THREAD_VIDSOFT_PRIORITY_1, "YAB_THREAD_VIDSOFT_PRIORITY_1", VidsoftPriorityThread1, NULL);
-      YabThreadStart(YAB_THREAD_VIDSOFT_PRIORITY_2, "YAB_THREAD_VIDSOFT_PRIORITY_2", VidsoftPriorityThread2, NULL);
-      YabThreadStart(YAB_THREAD_VIDSOFT_PRIORITY_3, "YAB_THREAD_VIDSOFT_PRIORITY_3", VidsoftPriorityThread3, NULL);
-      YabThreadStart(YAB_THREAD_VIDSOFT_PRIORITY_4, "YAB_THREAD_VIDSOFT_PRIORITY_4", VidsoftPriorityThread4, NULL);
-
       tt_context.inited = 1;
    }
 
    for(i = 0;i < 6;i++)
-      memset(tt_context.vdp2framebuffer[i], 0, sizeof(u32) * 704 * 256);
+   {
+      memset(tt_context.vdp2framebuffer[i].pixel, 0, sizeof(u32) * 704 * 256);
+      memset(tt_context.vdp2framebuffer[i].priority, 0, 4 * (704 * 256 + 16));
+   }
 
    for(i = 1;i < 4;i++)
       memset(tt_context.linescreen[i], 0, sizeof(u32) * 512);
@@ -430,7 +793,16 @@ void TitanErase()
       height /= 2;
 
    for (i = 0; i < 6; i++)
-      memset(tt_context.vdp2framebuffer[i], 0, sizeof(struct PixelData) * tt_context.vdp2width * height);
+   {
+      struct TitanLayer * layer = &tt_context.vdp2framebuffer[i];
+      int count = tt_context.vdp2width * height;
+
+      memset(layer->pixel, 0, sizeof(u32) * count);
+      memset(layer->priority, 0, count);
+      memset(layer->linescreen, 0, count);
+      memset(layer->shadow_type, 0, count);
+      memset(layer->shadow_enabled, 0, count);
+   }
 }
 
 int TitanDeInit()
@@ -438,7 +810,10 @@ int TitanDeInit()
    int i;
 
    for(i = 0;i < 6;i++)
-      free(tt_context.vdp2framebuffer[i]);
+   {
+      free(tt_context.vdp2framebuffer[i].pixel);
+      free(tt_context.vdp2framebuffer[i].priority);
+   }
 
    for(i = 1;i < 4;i++)
       free(tt_context.linescreen[i]);
@@ -460,6 +835,8 @@ void TitanGetResolution(int * width, int * height)
 
 void TitanSetBlendingMode(int blend_mode)
 {
+   tt_context.blend_mode = blend_mode;
+
    if (blend_mode == TITAN_BLEND_BOTTOM)
    {
       tt_context.blend = TitanBlendPixelsBottom;
@@ -479,11 +856,11 @@ void TitanSetBlendingMode(int blend_mode)
 
 void TitanPutBackHLine(s32 y, u32 color)
 {
-   struct PixelData* buffer = &tt_context.backscreen[(y * tt_context.vdp2width)];
+   u32 * buffer = &tt_context.backscreen[(y * tt_context.vdp2width)];
    int i;
 
    for (i = 0; i < tt_context.vdp2width; i++)
-      buffer[i].pixel = color;
+      buffer[i] = color;
 }
 
 void TitanPutLineHLine(int linescreen, s32 y, u32 color)
@@ -502,11 +879,12 @@ void TitanPutPixel(int priority, s32 x, s32 y, u32 color, int linescreen, vdp2dr
 
    {
       int pos = (y * tt_context.vdp2width) + x;
-      tt_context.vdp2framebuffer[info->titan_which_layer][pos].pixel = color;
-      tt_context.vdp2framebuffer[info->titan_which_layer][pos].priority = priority;
-      tt_context.vdp2framebuffer[info->titan_which_layer][pos].linescreen = linescreen;
-      tt_context.vdp2framebuffer[info->titan_which_layer][pos].shadow_enabled = info->titan_shadow_enabled;
-      tt_context.vdp2framebuffer[info->titan_which_layer][pos].shadow_type = info->titan_shadow_type;
+      struct TitanLayer * layer = &tt_context.vdp2framebuffer[info->titan_which_layer];
+      layer->pixel[pos] = color;
+      layer->priority[pos] = priority;
+      layer->linescreen[pos] = linescreen;
+      layer->shadow_enabled[pos] = info->titan_shadow_enabled;
+      layer->shadow_type[pos] = info->titan_shadow_type;
    }
 }
 
@@ -515,11 +893,11 @@ void TitanPutHLine(int priority, s32 x, s32 y, s32 width, u32 color)
    if (priority == 0) return;
 
    {
-      struct PixelData * buffer = &tt_context.vdp2framebuffer[priority][ (y * tt_context.vdp2width) + x];
+      u32 * buffer = &tt_context.vdp2framebuffer[priority].pixel[(y * tt_context.vdp2width) + x];
       int i;
 
       for (i = 0; i < width; i++)
-         buffer[i].pixel = color;
+         buffer[i] = color;
    }
 }
 
@@ -534,6 +912,14 @@ void TitanRenderLines(pixel_t * dispbuffer, int start_line, int end_line)
       return;
    }
 
+#ifdef TITAN_HAVE_BATCH
+   if (tt_context.compositor == TITAN_COMPOSITOR_BATCH)
+   {
+      TitanRenderLinesBatch(dispbuffer, start_line, end_line);
+      return;
+   }
+#endif
+
    Vdp2GetInterlaceInfo(&interlace_line, &line_increment);
 
    set_layer_y(start_line, &layer_y);
@@ -559,68 +945,50 @@ void TitanRenderLines(pixel_t * dispbuffer, int start_line, int end_line)
    }
 }
 
-//num + 1 needs to be an even number to avoid issues with interlace modes
-void VIDSoftSetNumPriorityThreads(int num)
+int TitanSetCompositor(int compositor)
 {
-   vidsoft_num_priority_threads = num > 5 ? 5 : num;
-
-   if (num == 2)
-      vidsoft_num_priority_threads = 1;
-
-   if (num == 4)
-      vidsoft_num_priority_threads = 3;
+#ifndef TITAN_HAVE_BATCH
+   if (compositor == TITAN_COMPOSITOR_BATCH)
+      return -1;
+#endif
+   tt_context.compositor = compositor;
+   return 0;
 }
 
-void TitanStartPriorityThread(int which)
+int TitanGetCompositor(void)
 {
-   priority_thread_context.need_draw[which] = 1;
-   priority_thread_context.draw_finished[which] = 0;
-   YabThreadWake(YAB_THREAD_VIDSOFT_PRIORITY_0 + which);
+   return tt_context.compositor;
 }
 
-void TitanWaitForPriorityThread(int which)
+// The lines are composited by the vidsoft worker pool, this only turns the
+// splitting on or off
+void VIDSoftSetNumPriorityThreads(int num)
 {
-   while (!priority_thread_context.draw_finished[which]){}
+   vidsoft_num_priority_threads = num;
 }
 
+// bands start on even lines to avoid issues with interlace modes
+#define TITAN_BAND_LINES 16
+
 void TitanRenderThreads(pixel_t * dispbuffer, int can_use_simplified)
 {
-   int i;
-   int total_jobs = vidsoft_num_priority_threads + 1;//main thread runs a job
-   int num_lines_per_job = tt_context.vdp2height / total_jobs;
-   int remainder = tt_context.vdp2height % total_jobs;
-   int starts[6] = { 0 }; 
-   int ends[6] = { 0 };
+   VidsoftJob jobs[512 / TITAN_BAND_LINES];
+   int num_jobs = 0;
+   int line;
 
    priority_thread_context.dispbuffer = dispbuffer;
    priority_thread_context.use_simplified = can_use_simplified;
 
-   for (i = 0; i < total_jobs; i++)
+   for (line = 0; line < tt_context.vdp2height; line += TITAN_BAND_LINES)
    {
-      starts[i] = num_lines_per_job * i;
-      ends[i] = ((i + 1) * num_lines_per_job);
+      jobs[num_jobs].func = TitanRenderJob;
+      jobs[num_jobs].arg = NULL;
+      jobs[num_jobs].start = line;
+      jobs[num_jobs].end = line + TITAN_BAND_LINES < tt_context.vdp2height ? line + TITAN_BAND_LINES : tt_context.vdp2height;
+      num_jobs++;
    }
 
-   for (i = 0; i < vidsoft_num_priority_threads; i++)
-   {
-      priority_thread_context.lines[i].start = starts[i+1];
-      priority_thread_context.lines[i].end = ends[i+1];
-   }
-
-   //put any remaining lines on the last thread
-   priority_thread_context.lines[vidsoft_num_priority_threads - 1].end += remainder;
-
-   for (i = 0; i < vidsoft_num_priority_threads; i++)
-   {
-      TitanStartPriorityThread(i);
-   }
-
-   TitanRenderSimplifiedCheck(dispbuffer, starts[0], ends[0], can_use_simplified);
-
-   for (i = 0; i < vidsoft_num_priority_threads; i++)
-   {
-      TitanWaitForPriorityThread(i);
-   }
+   VidsoftRunJobs(jobs, num_jobs);
 }
 
 void TitanRender(pixel_t * dispbuffer)
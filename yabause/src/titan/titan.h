@@ -38,6 +38,9 @@
 #define TITAN_NORMAL_SHADOW 1
 #define TITAN_MSB_SHADOW 2
 
+#define TITAN_COMPOSITOR_REFERENCE 0
+#define TITAN_COMPOSITOR_BATCH     1
+
 int TitanInit();
 int TitanDeInit();
 void TitanErase();
@@ -56,6 +59,12 @@ void TitanPutHLine(int priority, s32 x, s32 y, s32 width, u32 color);
 
 void TitanRender(pixel_t * dispbuffer);
 
+// TitanSetCompositor: pick the per pixel reference compositor or the batched
+// SIMD one (the default where available). Returns -1 if the batched one is
+// not built for this target.
+int TitanSetCompositor(int compositor);
+int TitanGetCompositor(void);
+
 void TitanWriteColor(pixel_t * dispbuffer, s32 bufwidth, s32 x, s32 y, u32 color);
 
 #endif
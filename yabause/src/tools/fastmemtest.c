@@ -0,0 +1,433 @@
+/*******************************************************************************
+  FASTMEMTEST - Yabause fastmem tester
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+*******************************************************************************/
+
+// Runs the same programs with fastmem off and on and hashes the rams and
+// both cpus, which must come out the same: a pair filling work and VDP2
+// ram, a master that rewrites its own loop under the block cache, and the
+// pair again with the slave on its own thread.
+//
+// Then checks the mirrors and cache through addresses read what was
+// written, that VDP1 ram writes still mark their page, and that memory
+// breakpoints and the slave thread keep the pages they hook off the fast
+// path. Also reports the time a MappedMemoryReadLong and WriteLong take on
+// high work ram both ways.
+
+// example: fastmemtest [frames]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../core.h"
+#include "../yabause.h"
+#include "../yui.h"
+#include "../memory.h"
+#include "../cdbase.h"
+#include "../cs0.h"
+#include "../fastmem.h"
+#include "../m68kcore.h"
+#include "../peripheral.h"
+#include "../sh2core.h"
+#include "../sh2int.h"
+#include "../scsp.h"
+#include "../vdp1.h"
+#include "../vdp2.h"
+#include "toolutil.h"
+
+#define PROG_NAME "FASTMEMTEST"
+#define VER_NAME "1.0"
+
+#define MASTER_ADDR 0x06004000
+#define SLAVE_ADDR 0x06005000
+#define BENCH_ACCESSES 1000000
+#define BENCH_PASSES 8
+
+SH2Interface_struct *SH2CoreList[] = {
+   &SH2Interpreter,
+   NULL
+};
+
+PerInterface_struct *PERCoreList[] = {
+   &PERDummy,
+   NULL
+};
+
+CDInterface *CDCoreList[] = {
+   &DummyCD,
+   NULL
+};
+
+SoundInterface_struct *SNDCoreList[] = {
+   &SNDDummy,
+   NULL
+};
+
+VideoInterface_struct *VIDCoreList[] = {
+   &VIDDummy,
+   NULL
+};
+
+M68K_struct * M68KCoreList[] = {
+   &M68KDummy,
+   NULL
+};
+
+void YuiErrorMsg(const char *string) { printf("Error: %s\n", string); }
+
+void YuiSwapBuffers() { }
+
+//////////////////////////////////////////////////////////////////////////////
+
+// The ssh2threadtest loop: r1 and r4 get the counter in r2 at the offset in
+// r3, masked by r5
+static const u16 fill_program[] = {
+   0x7201,     // loop: add #1,r2
+   0x6033,     // mov r3,r0
+   0x0126,     // mov.l r2,@(r0,r1)
+   0x0426,     // mov.l r2,@(r0,r4)
+   0x7304,     // add #4,r3
+   0x2359,     // and r5,r3
+   0xAFF8,     // bra loop
+   0x0009,     // nop
+};
+
+// Stores r4 over its first instruction through @r1 and flips r4 between
+// add #1,r2 and add #2,r2 with r5, r6 counts the rounds
+static const u16 patch_program[] = {
+   0x7201,     // loop: add #1,r2 (patched)
+   0x7601,     // add #1,r6
+   0x2141,     // mov.w r4,@r1
+   0x245A,     // xor r5,r4
+   0xAFFA,     // bra loop
+   0x0009,     // nop
+};
+
+typedef struct
+{
+   const char *name;
+   const u16 *master;
+   int master_len;
+   u32 master_regs[8];
+   const u16 *slave;
+   int slave_len;
+   u32 slave_regs[8];
+} Setup;
+
+// cached and cache through high work ram, the VDP2 ram mirror and the cart
+static const Setup fill = {
+   "fill",
+   fill_program, sizeof(fill_program) / 2,
+   { 0, 0x06010000, 0, 0, 0x25E80000, 0x0000FFFC, 0, 0 },
+   fill_program, sizeof(fill_program) / 2,
+   { 0, 0x26020000, 0x1000, 0, 0x20240000, 0x0000FFFC, 0, 0 },
+};
+
+static const Setup patch = {
+   "patch",
+   patch_program, sizeof(patch_program) / 2,
+   { 0, MASTER_ADDR | 0x20000000, 0, 0, 0x7202, 0x0003, 0, 0 },
+   fill_program, sizeof(fill_program) / 2,
+   { 0, 0x06020000, 0x1000, 0, 0x06106000, 0x00007FFC, 0, 0 },
+};
+
+typedef struct
+{
+   u64 hash;
+   u32 master_regs[16];
+} Result;
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int Init(int fastmem, int threaded)
+{
+   yabauseinit_struct yinit;
+
+   memset(&yinit, 0, sizeof(yinit));
+   yinit.percoretype = PERCORE_DUMMY;
+   yinit.sh2coretype = SH2CORE_INTERPRETER;
+   yinit.vidcoretype = VIDCORE_DUMMY;
+   yinit.m68kcoretype = M68KCORE_DUMMY;
+   yinit.sndcoretype = SNDCORE_DUMMY;
+   yinit.cdcoretype = CDCORE_DUMMY;
+   yinit.carttype = CART_DRAM32MBIT;
+   yinit.regionid = REGION_AUTODETECT;
+   yinit.videoformattype = VIDEOFORMATTYPE_NTSC;
+   yinit.framelimit = 1;
+   yinit.scsp_main_mode = 1; // the sound thread runs on its own, as in libretro
+   yinit.skip_load = 1;
+   yinit.use_sh2_block_cache = 1;
+   yinit.use_ssh2_thread = threaded;
+   yinit.use_fastmem = fastmem;
+
+   if (YabauseInit(&yinit) != 0)
+   {
+      printf("YabauseInit failed\n");
+      return -1;
+   }
+   return 0;
+}
+
+static int Run(const Setup *setup, int fastmem, int threaded, int frames, Result *result)
+{
+   sh2regs_struct regs;
+   int frame;
+
+   if (Init(fastmem, threaded) != 0)
+      return -1;
+
+   // the emulated bios sets the slave up from ram, the program goes over it
+   YabauseStartSlave();
+   LoadProgram(MSH2, MASTER_ADDR, setup->master, setup->master_len, setup->master_regs);
+   LoadProgram(SSH2, SLAVE_ADDR, setup->slave, setup->slave_len, setup->slave_regs);
+
+   for (frame = 0; frame < frames; frame++)
+      YabauseEmulate();
+
+   result->hash = HashMachine();
+   SH2GetRegisters(MSH2, &regs);
+   memcpy(result->master_regs, regs.R, sizeof(result->master_regs));
+
+   YabauseDeInit();
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int TestSame(const Setup *setup, int threaded, int frames, Result *fast)
+{
+   Result slow;
+
+   if (Run(setup, 0, threaded, frames, &slow) != 0 || Run(setup, 1, threaded, frames, fast) != 0)
+      return 1;
+
+   if (slow.hash != fast->hash)
+   {
+      printf("%s%s: fastmem run differs from the plain one\n", setup->name,
+         threaded ? ", threaded" : "");
+      return 1;
+   }
+   return 0;
+}
+
+static int TestPatch(int frames)
+{
+   Result result;
+
+   if (TestSame(&patch, 0, frames, &result) != 0)
+      return 1;
+
+   // every other round adds 2 once the patches are seen
+   if (result.master_regs[6] == 0 || result.master_regs[2] <= result.master_regs[6])
+   {
+      printf("patch: %u rounds added up to %u\n", (unsigned)result.master_regs[6],
+         (unsigned)result.master_regs[2]);
+      return 1;
+   }
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int Expect(const char *what, u32 addr, u32 expected)
+{
+   u32 val = MappedMemoryReadLong(addr, NULL);
+
+   if (val != expected)
+   {
+      printf("%s: %08X read %08X, expected %08X\n", what, (unsigned)addr, (unsigned)val,
+         (unsigned)expected);
+      return 1;
+   }
+   return 0;
+}
+
+static int TestMap(void)
+{
+   int failed = 0;
+   u32 writes;
+
+   if (Init(1, 0) != 0)
+      return 1;
+
+   if (FastmemRead[0x0600] != FASTMEM_T2 || FastmemWrite[0x2600] != FASTMEM_T2 ||
+       FastmemRead[0x25E8] != FASTMEM_T1 || FastmemWrite[0x25E0] != FASTMEM_NONE ||
+       FastmemWrite[0x2240] != FASTMEM_T1)
+   {
+      printf("map: the ram areas didn't get mapped\n");
+      failed++;
+   }
+
+   MappedMemoryWriteLong(0x06000100, 0x12345678, NULL);
+   failed += Expect("high work ram", 0x26000100, 0x12345678);
+   failed += Expect("high work ram", 0x06100100, 0x12345678);
+   MappedMemoryWriteWord(0x26100102, 0xABCD, NULL);
+   failed += Expect("high work ram", 0x06000100, 0x1234ABCD);
+   if (T2ReadLong(HighWram, 0x100) != 0x1234ABCD)
+   {
+      printf("high work ram: HighWram doesn't hold what was written\n");
+      failed++;
+   }
+
+   MappedMemoryWriteByte(0x20200203, 0x5A, NULL);
+   failed += Expect("low work ram", 0x00200200, 0x0000005A);
+
+   MappedMemoryWriteLong(0x25E00010, 0xCAFEF00D, NULL);
+   failed += Expect("vdp2 ram", 0x25E80010, 0xCAFEF00D);
+   failed += Expect("vdp2 ram", 0x05E00010, 0xCAFEF00D);
+
+   writes = Vdp1RamPageWrites[0];
+   MappedMemoryWriteLong(0x25C00020, 0x11223344, NULL);
+   failed += Expect("vdp1 ram", 0x25C00020, 0x11223344);
+   if (Vdp1RamPageWrites[0] == writes)
+   {
+      printf("vdp1 ram: the write didn't mark its page\n");
+      failed++;
+   }
+
+   MappedMemoryWriteLong(0x22600040, 0x55AA55AA, NULL);
+   failed += Expect("cart dram", 0x02600040, 0x55AA55AA);
+   if (T1ReadLong(CartridgeArea->dram, 0x200040) != 0x55AA55AA)
+   {
+      printf("cart dram: the write went somewhere else\n");
+      failed++;
+   }
+
+   YabauseDeInit();
+   return failed;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int TestHold(void)
+{
+   int failed = 0;
+
+   if (Init(1, 0) != 0)
+      return 1;
+
+   MappedMemoryWriteLong(0x06000200, 0x10, NULL);
+   if (SH2AddMemoryBreakpoint(MSH2, 0x06000200, BREAK_LONGREAD) != 0)
+   {
+      printf("hold: couldn't add a breakpoint\n");
+      failed++;
+   }
+   else if (FastmemRead[0x0600] != FASTMEM_NONE || FastmemRead[0x2600] != FASTMEM_NONE)
+   {
+      printf("hold: a breakpoint's page is still fast\n");
+      failed++;
+   }
+   failed += Expect("hold", 0x06000200, 0x10);
+
+   SH2DelMemoryBreakpoint(MSH2, 0x06000200);
+   if (FastmemRead[0x0600] != FASTMEM_T2)
+   {
+      printf("hold: the page didn't come back after the breakpoint\n");
+      failed++;
+   }
+   YabauseDeInit();
+
+   if (Init(1, 1) != 0)
+      return failed + 1;
+   if (yabsys.use_ssh2_thread &&
+       (FastmemRead[0x25E0] != FASTMEM_NONE || FastmemRead[0x2240] != FASTMEM_NONE ||
+        FastmemRead[0x0600] != FASTMEM_T2))
+   {
+      printf("hold: the slave thread's pages aren't held\n");
+      failed++;
+   }
+   YabauseDeInit();
+
+   return failed;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static double TicksToNsec(s64 ticks, int count)
+{
+   return (double)ticks * 1000000000.0 / (double)yabsys.tickfreq / count;
+}
+
+// The best of a few passes over the first megabyte, in ns an access
+static void Bench(int fastmem, double *read, double *write)
+{
+   volatile u32 sum = 0;
+   int pass, i;
+
+   *read = *write = 0;
+   if (Init(fastmem, 0) != 0)
+      return;
+
+   for (pass = 0; pass < BENCH_PASSES; pass++)
+   {
+      double nsec;
+      s64 t;
+
+      t = YabauseGetTicks();
+      for (i = 0; i < BENCH_ACCESSES; i++)
+         sum += MappedMemoryReadLong(0x06000000 + ((i * 4) & 0xFFFFC), NULL);
+      nsec = TicksToNsec(YabauseGetTicks() - t, BENCH_ACCESSES);
+      if (pass == 0 || nsec < *read)
+         *read = nsec;
+
+      t = YabauseGetTicks();
+      for (i = 0; i < BENCH_ACCESSES; i++)
+         MappedMemoryWriteLong(0x06000000 + ((i * 4) & 0xFFFFC), i, NULL);
+      nsec = TicksToNsec(YabauseGetTicks() - t, BENCH_ACCESSES);
+      if (pass == 0 || nsec < *write)
+         *write = nsec;
+   }
+
+   YabauseDeInit();
+}
+
+static void ReportSpeed(void)
+{
+   double slow_read, slow_write, fast_read, fast_write;
+
+   Bench(0, &slow_read, &slow_write);
+   Bench(1, &fast_read, &fast_write);
+
+   printf("high work ram read %.2f ns plain, %.2f ns fastmem; write %.2f ns plain, %.2f ns fastmem\n",
+      slow_read, fast_read, slow_write, fast_write);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+   Result result;
+   int frames = 4;
+   int failed = 0;
+
+   printf("%s v%s\n", PROG_NAME, VER_NAME);
+
+   if (argc > 1)
+      frames = atoi(argv[1]);
+   if (frames <= 0)
+      frames = 4;
+
+   failed += TestSame(&fill, 0, frames, &result);
+   failed += TestPatch(frames);
+   failed += TestSame(&fill, 1, frames, &result);
+   failed += TestMap();
+   failed += TestHold();
+   ReportSpeed();
+
+   printf("%s\n", failed ? "FAIL" : "OK");
+   return failed ? 1 : 0;
+}
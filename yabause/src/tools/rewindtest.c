@@ -0,0 +1,288 @@
+/*******************************************************************************
+  REWINDTEST - Yabause rewind buffer tester
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+*******************************************************************************/
+
+// Runs the core with rewind enabled, keeps a raw copy of the RAM areas and
+// CPU registers at every frame, then steps back by various amounts (inside a
+// keyframe group and across several) and checks that the restored machine
+// is byte-for-byte identical to the copy. Then times the capture of a
+// frame's worth of changes, which has to fit easily in a 60 Hz frame.
+
+// example: rewindtest [bios path] [cd image path]
+// Without a cd image a small program runs instead of the bios.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../core.h"
+#include "../yabause.h"
+#include "../yui.h"
+#include "../memory.h"
+#include "../rewind.h"
+#include "../cdbase.h"
+#include "../cs0.h"
+#include "../m68kcore.h"
+#include "../peripheral.h"
+#include "../sh2core.h"
+#include "../sh2int.h"
+#include "../scsp.h"
+#include "../smpc.h"
+#include "../vdp1.h"
+#include "../vdp2.h"
+#include "toolutil.h"
+
+#define PROG_NAME "REWINDTEST"
+#define VER_NAME "1.0"
+
+#define NUM_FRAMES 48
+#define KEYFRAME_INTERVAL 8
+#define PROGRAM_ADDR 0x06004000
+#define TIMED_FRAMES 120
+// a quarter of a 60 Hz frame, the rest of the frame is the emulation's.
+// The median is checked, a keyframe or the scheduler can make one slow.
+#define CAPTURE_BUDGET_USEC (1000000.0 / 60 / 4)
+
+SH2Interface_struct *SH2CoreList[] = {
+   &SH2Interpreter,
+   NULL
+};
+
+PerInterface_struct *PERCoreList[] = {
+   &PERDummy,
+   NULL
+};
+
+CDInterface *CDCoreList[] = {
+   &DummyCD,
+   &ISOCD,
+   NULL
+};
+
+SoundInterface_struct *SNDCoreList[] = {
+   &SNDDummy,
+   NULL
+};
+
+VideoInterface_struct *VIDCoreList[] = {
+   &VIDDummy,
+   NULL
+};
+
+M68K_struct * M68KCoreList[] = {
+   &M68KDummy,
+   NULL
+};
+
+void YuiErrorMsg(const char *string) { printf("Error: %s\n", string); }
+
+void YuiSwapBuffers() { }
+
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct
+{
+   const char *name;
+   u8 **ptr;
+   u32 size;
+} Region;
+
+static Region regions[] = {
+   { "HighWram", &HighWram, 0x100000 },
+   { "LowWram", &LowWram, 0x100000 },
+   { "Vdp1Ram", &Vdp1Ram, 0x80000 },
+   { "Vdp2Ram", &Vdp2Ram, 0x80000 },
+   { "Vdp2ColorRam", &Vdp2ColorRam, 0x1000 },
+   { "SoundRam", &SoundRam, 0x80000 },
+};
+
+#define NUM_REGIONS (sizeof(regions) / sizeof(regions[0]))
+
+typedef struct
+{
+   u8 *ram[NUM_REGIONS];
+   sh2regs_struct msh2;
+   sh2regs_struct ssh2;
+} Snapshot;
+
+static Snapshot snapshots[NUM_FRAMES];
+static s64 capture_ticks[TIMED_FRAMES];
+
+static int CompareTicks(const void *a, const void *b)
+{
+   s64 x = *(const s64 *)a, y = *(const s64 *)b;
+   return x < y ? -1 : x > y;
+}
+
+static void TakeSnapshot(Snapshot *s)
+{
+   int i;
+
+   for (i = 0; i < NUM_REGIONS; i++)
+   {
+      s->ram[i] = (u8 *)malloc(regions[i].size);
+      memcpy(s->ram[i], *regions[i].ptr, regions[i].size);
+   }
+   SH2GetRegisters(MSH2, &s->msh2);
+   SH2GetRegisters(SSH2, &s->ssh2);
+}
+
+static int CompareSnapshot(const Snapshot *s)
+{
+   sh2regs_struct regs;
+   int i, ret = 0;
+
+   for (i = 0; i < NUM_REGIONS; i++)
+   {
+      if (memcmp(s->ram[i], *regions[i].ptr, regions[i].size) != 0)
+      {
+         printf("  %s differs\n", regions[i].name);
+         ret = -1;
+      }
+   }
+
+   SH2GetRegisters(MSH2, &regs);
+   if (memcmp(&regs, &s->msh2, sizeof(regs)) != 0)
+   {
+      printf("  MSH2 registers differ\n");
+      ret = -1;
+   }
+   SH2GetRegisters(SSH2, &regs);
+   if (memcmp(&regs, &s->ssh2, sizeof(regs)) != 0)
+   {
+      printf("  SSH2 registers differ\n");
+      ret = -1;
+   }
+
+   return ret;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+   static const int steps[] = { 0, 3, KEYFRAME_INTERVAL, KEYFRAME_INTERVAL * 2 + 5 };
+   yabauseinit_struct yinit;
+   RewindStats stats;
+   int frame, i, failed = 0;
+   double median;
+
+   printf("%s v%s\n", PROG_NAME, VER_NAME);
+
+   memset(&yinit, 0, sizeof(yinit));
+   yinit.percoretype = PERCORE_DUMMY;
+   yinit.sh2coretype = SH2CORE_INTERPRETER;
+   yinit.vidcoretype = VIDCORE_DUMMY;
+   yinit.m68kcoretype = M68KCORE_DUMMY;
+   yinit.sndcoretype = SNDCORE_DUMMY;
+   yinit.cdcoretype = CDCORE_DUMMY;
+   yinit.carttype = CART_NONE;
+   yinit.regionid = REGION_AUTODETECT;
+   yinit.videoformattype = VIDEOFORMATTYPE_NTSC;
+   yinit.framelimit = 1;
+   yinit.scsp_main_mode = 1; // the sound thread runs on its own, as in libretro
+
+   if (argc > 1 && argv[1][0] != '\0')
+      yinit.biospath = argv[1];
+   if (argc > 2 && argv[2][0] != '\0')
+   {
+      yinit.cdcoretype = CDCORE_ISO;
+      yinit.cdpath = argv[2];
+   }
+   else
+      yinit.skip_load = 1; // the emulated bios refuses to start without a game
+
+   if (YabauseInit(&yinit) != 0)
+   {
+      printf("YabauseInit failed\n");
+      return 1;
+   }
+
+   if (yinit.skip_load)
+      LoadCounterProgram(PROGRAM_ADDR);
+
+   for (frame = 0; frame < 60; frame++)
+      YabauseEmulate();
+
+   if (RewindInit(REWIND_DEFAULT_BUDGET, KEYFRAME_INTERVAL) != 0)
+   {
+      printf("RewindInit failed\n");
+      return 1;
+   }
+
+   // YabauseEmulate captures at the start of the frame, so the copy taken
+   // just before it matches snapshot number frame
+   for (frame = 0; frame < NUM_FRAMES; frame++)
+   {
+      TakeSnapshot(&snapshots[frame]);
+      YabauseEmulate();
+   }
+
+   RewindGetStats(&stats);
+   printf("%u snapshots, %u keyframes, %u bytes held, raw state %u bytes\n",
+      stats.frames, stats.keyframes, (unsigned)stats.bytes, stats.state_size);
+
+   frame = NUM_FRAMES - 1;
+   for (i = 0; i < sizeof(steps) / sizeof(steps[0]); i++)
+   {
+      int stepped = RewindStepBack(steps[i]);
+
+      frame -= steps[i];
+      printf("step back %d -> frame %d: ", steps[i], frame);
+      if (stepped != steps[i] || CompareSnapshot(&snapshots[frame]) != 0)
+      {
+         printf("FAIL\n");
+         failed++;
+      }
+      else
+         printf("OK\n");
+   }
+
+   // YabauseEmulate captured at the start of the frame, the capture after
+   // it holds what the frame changed
+   for (frame = 0; frame < TIMED_FRAMES; frame++)
+   {
+      YabauseEmulate();
+      capture_ticks[frame] = YabauseGetTicks();
+      if (RewindCapture() != 0)
+      {
+         printf("RewindCapture failed\n");
+         failed++;
+         break;
+      }
+      capture_ticks[frame] = YabauseGetTicks() - capture_ticks[frame];
+   }
+
+   qsort(capture_ticks, TIMED_FRAMES, sizeof(capture_ticks[0]), CompareTicks);
+   median = TicksToUsec(capture_ticks[TIMED_FRAMES / 2]);
+   printf("capture: %.1f us median, %.1f us worst over %d frames (budget %.1f us)\n",
+      median, TicksToUsec(capture_ticks[TIMED_FRAMES - 1]), TIMED_FRAMES, CAPTURE_BUDGET_USEC);
+   if (median > CAPTURE_BUDGET_USEC)
+   {
+      printf("capture too slow for 60 Hz: FAIL\n");
+      failed++;
+   }
+
+   RewindDeInit();
+   YabauseDeInit();
+
+   for (frame = 0; frame < NUM_FRAMES; frame++)
+      for (i = 0; i < NUM_REGIONS; i++)
+         free(snapshots[frame].ram[i]);
+
+   return failed ? 1 : 0;
+}
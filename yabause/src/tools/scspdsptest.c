@@ -0,0 +1,308 @@
+/*******************************************************************************
+  SCSPDSPTEST - Yabause SCSP DSP compiled program tester
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+*******************************************************************************/
+
+// Runs random effect DSP programs with ScspDspExec step by step and with the
+// compiled steps of ScspDspRun, and checks both leave the same registers,
+// work rams and sound ram after every sample. Each program is changed once
+// while it runs, the way a sound driver loads a new effect. A full length
+// program measures both paths.
+
+// example: scspdsptest
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include "../core.h"
+#include "../yabause.h"
+#include "../yui.h"
+#include "../memory.h"
+#include "../cdbase.h"
+#include "../cs0.h"
+#include "../m68kcore.h"
+#include "../peripheral.h"
+#include "../sh2core.h"
+#include "../sh2int.h"
+#include "../scsp.h"
+#include "../scspdsp.h"
+#include "../scu.h"
+#include "../vdp1.h"
+#include "../vdp2.h"
+
+#define PROG_NAME "SCSPDSPTEST"
+#define VER_NAME "1.0"
+
+#define RANDOM_PROGRAMS 300
+#define RANDOM_SAMPLES 48
+#define SOUND_RAM_SIZE 0x80000
+#define BENCH_SAMPLES 44100
+#define BENCH_ROUNDS 5
+
+SH2Interface_struct *SH2CoreList[] = {
+   &SH2Interpreter,
+   NULL
+};
+
+PerInterface_struct *PERCoreList[] = {
+   &PERDummy,
+   NULL
+};
+
+CDInterface *CDCoreList[] = {
+   &DummyCD,
+   NULL
+};
+
+SoundInterface_struct *SNDCoreList[] = {
+   &SNDDummy,
+   NULL
+};
+
+VideoInterface_struct *VIDCoreList[] = {
+   &VIDDummy,
+   NULL
+};
+
+M68K_struct * M68KCoreList[] = {
+   &M68KDummy,
+   NULL
+};
+
+void YuiErrorMsg(const char *string) { printf("Error: %s\n", string); }
+
+void YuiSwapBuffers() { }
+
+//////////////////////////////////////////////////////////////////////////////
+
+static u32 seed;
+
+static u32 Random(void)
+{
+   seed = seed * 1103515245 + 12345;
+   return (seed >> 8) ^ (seed << 16);
+}
+
+static u64 RandomStep(void)
+{
+   return ((u64)Random() << 32) | Random();
+}
+
+static ScspDsp reference, compiled;
+static u8 *reference_ram, *compiled_ram;
+
+static void RandomState(ScspDsp *dsp, u8 *ram, int steps)
+{
+   int i;
+
+   memset(dsp, 0, sizeof(*dsp));
+   for (i = 0; i < 64; i++)
+      dsp->coef[i] = Random() & 0x1FFF;
+   for (i = 0; i < 32; i++)
+      dsp->madrs[i] = Random();
+   for (i = 0; i < steps; i++)
+      dsp->mpro[i] = (Random() & 7) ? RandomStep() : 0;
+   for (i = 0; i < 128; i++)
+      dsp->temp[i] = Random() & 0xFFFFFF;
+   for (i = 0; i < 32; i++)
+      dsp->mems[i] = Random() & 0xFFFFFF;
+   for (i = 0; i < 16; i++)
+      dsp->mixs[i] = Random() & 0xFFFFF;
+   dsp->exts[0] = Random();
+   dsp->exts[1] = Random();
+   dsp->mdec_ct = Random() & 0xFFFF;
+   dsp->rbl = Random() & 3;
+   dsp->rbp = Random() & 0x3F;
+   dsp->y_reg = Random() & 0xFFFFFF;
+   dsp->frc_reg = Random() & 0x1FFF;
+   dsp->adrs_reg = Random() & 0xFFF;
+   dsp->shift_reg = Random() & 0x3FFFFFF;
+   dsp->read_value = Random() & 0xFFFFFF;
+   dsp->updated = 1;
+
+   for (i = 0; i < SOUND_RAM_SIZE; i++)
+      ram[i] = Random();
+}
+
+// what generate_sample does around the program
+static void Sample(ScspDsp *dsp, u8 *ram, int compile)
+{
+   int i;
+
+   if (dsp->updated)
+      ScspDspCompile(dsp);
+
+   if (compile)
+      ScspDspRun(dsp, ram);
+   else
+   {
+      for (i = 0; i < dsp->last_step; i++)
+         ScspDspExec(dsp, i, ram);
+   }
+
+   if (!dsp->mdec_ct)
+      dsp->mdec_ct = (0x2000 << dsp->rbl);
+   dsp->mdec_ct--;
+}
+
+static int Compare(int program, int sample)
+{
+   const char *what = NULL;
+
+   if (memcmp(&reference, &compiled, offsetof(ScspDsp, steps)))
+      what = "registers";
+   else if (memcmp(reference_ram, compiled_ram, SOUND_RAM_SIZE))
+      what = "sound ram";
+   else
+      return 0;
+
+   printf("program %d sample %d: %s differ\n", program, sample, what);
+   return 1;
+}
+
+static int TestRandom(void)
+{
+   int i, j, failed = 0;
+
+   for (i = 0; i < RANDOM_PROGRAMS && failed < 10; i++)
+   {
+      seed = i + 1;
+      RandomState(&reference, reference_ram, 1 + Random() % 128);
+      memcpy(&compiled, &reference, sizeof(compiled));
+      memcpy(compiled_ram, reference_ram, SOUND_RAM_SIZE);
+
+      for (j = 0; j < RANDOM_SAMPLES; j++)
+      {
+         if (j == RANDOM_SAMPLES / 2)
+         {
+            // a new effect, longer or shorter than the last one
+            int step = Random() & 127;
+            u64 word = (Random() & 1) ? RandomStep() : 0;
+            reference.mpro[step] = compiled.mpro[step] = word;
+            reference.updated = compiled.updated = 1;
+         }
+
+         // the slots feed new inputs every sample
+         reference.mixs[j & 15] = compiled.mixs[j & 15] = Random() & 0xFFFFF;
+         reference.exts[j & 1] = compiled.exts[j & 1] = Random();
+
+         Sample(&reference, reference_ram, 0);
+         Sample(&compiled, compiled_ram, 1);
+
+         if (Compare(i, j))
+         {
+            failed++;
+            break;
+         }
+      }
+   }
+
+   return failed;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static double Bench(int compile)
+{
+   ScspDsp *dsp = compile ? &compiled : &reference;
+   u8 *ram = compile ? compiled_ram : reference_ram;
+   s64 t;
+   int i;
+
+   seed = 12345;
+   RandomState(dsp, ram, 128);
+
+   t = YabauseGetTicks();
+   for (i = 0; i < BENCH_SAMPLES; i++)
+      Sample(dsp, ram, compile);
+   return (double)(YabauseGetTicks() - t) * 1000000.0 / (double)yabsys.tickfreq;
+}
+
+static int TestBench(void)
+{
+   double usec[2] = { 0, 0 };
+   int i;
+
+   // best of a few rounds, the two paths take turns
+   for (i = 0; i < BENCH_ROUNDS; i++)
+   {
+      double interpreted = Bench(0);
+      double fast = Bench(1);
+      if (i == 0 || interpreted < usec[0])
+         usec[0] = interpreted;
+      if (i == 0 || fast < usec[1])
+         usec[1] = fast;
+   }
+
+   printf("%d samples of a 128 step program: interpreter %.1f ms, compiled %.1f ms\n", BENCH_SAMPLES,
+      usec[0] / 1000.0, usec[1] / 1000.0);
+
+   if (memcmp(&reference, &compiled, offsetof(ScspDsp, steps)) ||
+      memcmp(reference_ram, compiled_ram, SOUND_RAM_SIZE))
+   {
+      printf("benchmark program: interpreter and compiled steps differ\n");
+      return 1;
+   }
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+   yabauseinit_struct yinit;
+   int failed = 0;
+
+   printf("%s v%s\n", PROG_NAME, VER_NAME);
+
+   memset(&yinit, 0, sizeof(yinit));
+   yinit.percoretype = PERCORE_DUMMY;
+   yinit.sh2coretype = SH2CORE_INTERPRETER;
+   yinit.vidcoretype = VIDCORE_DUMMY;
+   yinit.m68kcoretype = M68KCORE_DUMMY;
+   yinit.sndcoretype = SNDCORE_DUMMY;
+   yinit.cdcoretype = CDCORE_DUMMY;
+   yinit.carttype = CART_NONE;
+   yinit.regionid = REGION_AUTODETECT;
+   yinit.videoformattype = VIDEOFORMATTYPE_NTSC;
+   yinit.skip_load = 1;
+
+   if (YabauseInit(&yinit) != 0)
+   {
+      printf("YabauseInit failed\n");
+      return 1;
+   }
+
+   reference_ram = (u8 *)malloc(SOUND_RAM_SIZE);
+   compiled_ram = (u8 *)malloc(SOUND_RAM_SIZE);
+   if (reference_ram == NULL || compiled_ram == NULL)
+   {
+      printf("out of memory\n");
+      return 1;
+   }
+
+   failed += TestRandom();
+   failed += TestBench();
+
+   printf("%s\n", failed ? "FAIL" : "OK");
+
+   free(reference_ram);
+   free(compiled_ram);
+   YabauseDeInit();
+   return failed ? 1 : 0;
+}
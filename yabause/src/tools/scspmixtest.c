@@ -0,0 +1,319 @@
+/*******************************************************************************
+  SCSPMIXTEST - Yabause cycle accurate SCSP slot skipping tester
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+*******************************************************************************/
+
+// Plays random slot settings, key ons and key offs on the cycle accurate
+// SCSP with every stage of every slot run and with the silent slots left
+// out, and checks both give the same samples, envelopes and sound stack
+// sample for sample. The settings cover every loop mode, 8 and 16 bit
+// samples and modulation from the sound stack. A second run with a few slots playing
+// measures both paths.
+
+// example: scspmixtest
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../core.h"
+#include "../yabause.h"
+#include "../yui.h"
+#include "../memory.h"
+#include "../cdbase.h"
+#include "../cs0.h"
+#include "../m68kcore.h"
+#include "../peripheral.h"
+#include "../sh2core.h"
+#include "../sh2int.h"
+#include "../scsp.h"
+#include "../scu.h"
+#include "../vdp1.h"
+#include "../vdp2.h"
+
+#define PROG_NAME "SCSPMIXTEST"
+#define VER_NAME "1.0"
+
+#define SAMPLES 20000
+#define BLOCK 800               // samples fetched at once, under the 900 kept
+#define BENCH_SAMPLES 44100
+#define BENCH_SLOTS 6
+#define BENCH_ROUNDS 3
+
+SH2Interface_struct *SH2CoreList[] = {
+   &SH2Interpreter,
+   NULL
+};
+
+PerInterface_struct *PERCoreList[] = {
+   &PERDummy,
+   NULL
+};
+
+CDInterface *CDCoreList[] = {
+   &DummyCD,
+   NULL
+};
+
+SoundInterface_struct *SNDCoreList[] = {
+   &SNDDummy,
+   NULL
+};
+
+VideoInterface_struct *VIDCoreList[] = {
+   &VIDDummy,
+   NULL
+};
+
+M68K_struct * M68KCoreList[] = {
+   &M68KDummy,
+   NULL
+};
+
+void YuiErrorMsg(const char *string) { printf("Error: %s\n", string); }
+
+void YuiSwapBuffers() { }
+
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct
+{
+   s32 left[SAMPLES];
+   s32 right[SAMPLES];
+   u32 envelopes;          // hash of the envelopes and sound stack after every sample
+   double usec;
+} RunResult;
+
+static RunResult reference, skipped;
+
+static u32 seed;
+
+static u32 Random(void)
+{
+   seed = seed * 1103515245 + 12345;
+   return (seed >> 8) ^ (seed << 16);
+}
+
+static void Reset(int skip)
+{
+   u32 i;
+
+   // the noise lfo tables come from rand()
+   srand(1);
+   scsp_set_use_new(0);
+   scsp_set_use_new(1);
+   scsp_set_slot_skip(skip);
+
+   seed = 1;
+   for (i = 0; i < 0x80000; i++)
+      SoundRam[i] = (u8)Random();
+
+   scsp_w_w(0x400, 0xF);   // master volume
+}
+
+static void SetSlot(int slot)
+{
+   u32 a = slot << 5;
+   u32 lsa = Random() & 0x3FFF;
+
+   // SA, loop mode and sample size, the key on bit left clear
+   scsp_w_w(a + 0x00, Random() & 0x7F);
+   scsp_w_w(a + 0x02, Random() & 0xFFFF);
+   scsp_w_w(a + 0x04, lsa);
+   scsp_w_w(a + 0x06, lsa + 1 + (Random() & 0x3FFF));
+   scsp_w_w(a + 0x08, Random() & 0xFFFF);
+   scsp_w_w(a + 0x0A, Random() & 0xFFFF);
+   scsp_w_w(a + 0x0C, Random() & 0x3F);
+   scsp_w_w(a + 0x0E, (Random() & 3) ? Random() & 0x0FFF : Random() & 0xFFFF);
+   scsp_w_w(a + 0x10, Random() & 0x7FFF);
+   scsp_w_w(a + 0x12, Random() & 0xFFFF);
+   scsp_w_w(a + 0x14, Random() & 0x7F);
+   scsp_w_w(a + 0x16, ((1 + Random() % 7) << 13) | (Random() & 0x1FFF));
+}
+
+// KB of every slot in mask set, the others cleared, then KYONEX
+static void KeyOnEx(u32 mask)
+{
+   int i;
+
+   for (i = 0; i < 32; i++)
+   {
+      u16 word = scsp_r_w(i << 5) & ~0x1800;
+      scsp_w_w(i << 5, word | ((mask >> i) & 1 ? 0x800 : 0));
+   }
+   scsp_w_w(0, scsp_r_w(0) | 0x1000);
+}
+
+static void Play(int skip, RunResult *result)
+{
+   u32 keys = 0;
+   int i, done = 0;
+
+   Reset(skip);
+   result->envelopes = 2166136261u;
+
+   for (i = 0; i < SAMPLES; i++)
+   {
+      int j;
+
+      if (i % 37 == 0)
+         SetSlot(Random() & 31);
+      if (i % 151 == 0)
+      {
+         // a few slots on, some of them keyed off again later
+         keys = (keys | (Random() & Random())) & ~(Random() & Random() & Random());
+         KeyOnEx(keys);
+      }
+
+      new_scsp_exec(512);
+
+      for (j = 0; j < 32; j++)
+      {
+         int env, state;
+         scsp_debug_get_envelope(j, &env, &state);
+         result->envelopes = (result->envelopes ^ (u32)(env | (state << 16))) * 16777619u;
+      }
+      // the sound stack the 68k can read back
+      for (j = 0; j < 64; j++)
+         result->envelopes = (result->envelopes ^ scsp_r_w(0x600 + j * 2)) * 16777619u;
+
+      if (i + 1 - done == BLOCK || i + 1 == SAMPLES)
+      {
+         new_scsp_update_samples(result->left + done, result->right + done, i + 1 - done);
+         done = i + 1;
+      }
+   }
+}
+
+static int TestPlay(void)
+{
+   int i;
+
+   Play(0, &reference);
+   Play(1, &skipped);
+
+   if (reference.envelopes != skipped.envelopes)
+   {
+      printf("envelopes or sound stack differ\n");
+      return 1;
+   }
+
+   for (i = 0; i < SAMPLES; i++)
+   {
+      if (reference.left[i] != skipped.left[i] || reference.right[i] != skipped.right[i])
+      {
+         printf("sample %d differs, %d/%d %d/%d\n", i, reference.left[i], skipped.left[i],
+            reference.right[i], skipped.right[i]);
+         return 1;
+      }
+   }
+
+   for (i = 0; i < SAMPLES; i++)
+   {
+      if (reference.left[i] || reference.right[i])
+         return 0;
+   }
+
+   printf("all samples silent\n");
+   return 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void Bench(int skip, RunResult *result)
+{
+   static s32 left[BLOCK], right[BLOCK];
+   s64 t;
+   int i;
+
+   Reset(skip);
+   for (i = 0; i < BENCH_SLOTS; i++)
+   {
+      // normal loops that keep playing
+      SetSlot(i * 5);
+      scsp_w_w((i * 5) << 5, 0x20);
+      scsp_w_w(((i * 5) << 5) + 0x08, 0x001F);
+   }
+   KeyOnEx(0x02108421);
+
+   t = YabauseGetTicks();
+   for (i = 0; i < BENCH_SAMPLES; i++)
+   {
+      new_scsp_exec(512);
+      if ((i + 1) % BLOCK == 0)
+         new_scsp_update_samples(left, right, BLOCK);
+   }
+   result->usec = (double)(YabauseGetTicks() - t) * 1000000.0 / (double)yabsys.tickfreq;
+   new_scsp_update_samples(left, right, BLOCK);
+}
+
+static int TestBench(void)
+{
+   double usec[2] = { 0, 0 };
+   int i;
+
+   // best of a few rounds, the two paths take turns
+   for (i = 0; i < BENCH_ROUNDS; i++)
+   {
+      Bench(0, &reference);
+      Bench(1, &skipped);
+      if (i == 0 || reference.usec < usec[0])
+         usec[0] = reference.usec;
+      if (i == 0 || skipped.usec < usec[1])
+         usec[1] = skipped.usec;
+   }
+
+   printf("%d samples, %d slots playing: every slot %.1f ms, active slots %.1f ms\n", BENCH_SAMPLES,
+      BENCH_SLOTS, usec[0] / 1000.0, usec[1] / 1000.0);
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+   yabauseinit_struct yinit;
+   int failed = 0;
+
+   printf("%s v%s\n", PROG_NAME, VER_NAME);
+
+   memset(&yinit, 0, sizeof(yinit));
+   yinit.percoretype = PERCORE_DUMMY;
+   yinit.sh2coretype = SH2CORE_INTERPRETER;
+   yinit.vidcoretype = VIDCORE_DUMMY;
+   yinit.m68kcoretype = M68KCORE_DUMMY;
+   yinit.sndcoretype = SNDCORE_DUMMY;
+   yinit.cdcoretype = CDCORE_DUMMY;
+   yinit.carttype = CART_NONE;
+   yinit.regionid = REGION_AUTODETECT;
+   yinit.videoformattype = VIDEOFORMATTYPE_NTSC;
+   yinit.use_new_scsp = 1;
+   yinit.skip_load = 1;
+
+   if (YabauseInit(&yinit) != 0)
+   {
+      printf("YabauseInit failed\n");
+      return 1;
+   }
+
+   failed += TestPlay();
+   failed += TestBench();
+
+   printf("%s\n", failed ? "FAIL" : "OK");
+
+   YabauseDeInit();
+   return failed ? 1 : 0;
+}
@@ -0,0 +1,325 @@
+/*******************************************************************************
+  SCUDMATEST - Yabause SCU DMA bulk transfer tester
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+*******************************************************************************/
+
+// Runs level 0 DMA transfers element by element and with the bulk copies and
+// checks both leave the same work ram, vdp rams, transfer registers and
+// written pages. The transfers cover copies between every pair of rams,
+// fills, strides the bulk path leaves alone, overlapping copies and the ends
+// of the rams and their mirrors. A large work ram to VDP1 copy measures both
+// paths.
+
+// example: scudmatest
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../core.h"
+#include "../yabause.h"
+#include "../yui.h"
+#include "../memory.h"
+#include "../cdbase.h"
+#include "../cs0.h"
+#include "../m68kcore.h"
+#include "../peripheral.h"
+#include "../sh2core.h"
+#include "../sh2int.h"
+#include "../scsp.h"
+#include "../scu.h"
+#include "../vdp1.h"
+#include "../vdp2.h"
+
+#define PROG_NAME "SCUDMATEST"
+#define VER_NAME "1.0"
+
+#define BENCH_SIZE 0x80000
+#define BENCH_ROUNDS 5
+
+SH2Interface_struct *SH2CoreList[] = {
+   &SH2Interpreter,
+   NULL
+};
+
+PerInterface_struct *PERCoreList[] = {
+   &PERDummy,
+   NULL
+};
+
+CDInterface *CDCoreList[] = {
+   &DummyCD,
+   NULL
+};
+
+SoundInterface_struct *SNDCoreList[] = {
+   &SNDDummy,
+   NULL
+};
+
+VideoInterface_struct *VIDCoreList[] = {
+   &VIDDummy,
+   NULL
+};
+
+M68K_struct * M68KCoreList[] = {
+   &M68KDummy,
+   NULL
+};
+
+void YuiErrorMsg(const char *string) { printf("Error: %s\n", string); }
+
+void YuiSwapBuffers() { }
+
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct
+{
+   const char *name;
+   u32 read;
+   u32 write;
+   u32 count;
+   u32 add;          // D0AD: 0x100 reads every long, the low bits the write step
+} Transfer;
+
+static const Transfer transfers[] = {
+   { "high wram to vdp1",           0x06010000, 0x25C00100, 0x8000, 0x101 },
+   { "low wram to vdp2, odd word",  0x00200402, 0x25E10002, 0x1236, 0x101 },
+   { "vdp1 to vdp2",                0x25C20000, 0x25E40000, 0x4000, 0x101 },
+   { "vdp2 to high wram",           0x25E04000, 0x06080000, 0x3000, 0x102 },
+   { "vdp1 to low wram",            0x05C10002, 0x00240000, 0x0FFE, 0x102 },
+   { "high wram to low wram",       0x06020000, 0x002C0000, 0x1002, 0x102 },
+   { "low wram to high wram",       0x00210000, 0x260F0000, 0x10000, 0x102 },
+   { "high wram overlapping",       0x06030000, 0x06030008, 0x800, 0x102 },
+   { "high wram to vdp1 stride",    0x06040000, 0x25C30000, 0x800, 0x103 },
+   { "high wram to vdp2 stride",    0x06040000, 0x25E50000, 0x800, 0x104 },
+   { "vdp2 mirror",                 0x06050000, 0x25E7FF00, 0x400, 0x101 },
+   { "vdp1 end",                    0x06050000, 0x25C7FF00, 0x400, 0x101 },
+   { "high wram mirror end",        0x00220000, 0x0610FF00, 0x400, 0x102 },
+   { "low wram end",                0x06060000, 0x002FFC00, 0x800, 0x102 },
+   { "fill vdp1",                   0x06070000, 0x25C40002, 0x2000, 0x001 },
+   { "fill vdp2 from vdp1",         0x25C50000, 0x25E60000, 0x2000, 0x001 },
+   { "fill high wram",              0x00230000, 0x06090000, 0x2000, 0x002 },
+   { "fill low wram from vdp2",     0x25E70000, 0x00280000, 0x2000, 0x002 },
+   { "fill vdp1 stride",            0x06070000, 0x25C60000, 0x1000, 0x003 },
+   { "copy from sound ram",         0x25A00000, 0x060A0000, 0x400, 0x102 },
+   { "copy to sound ram",           0x060A0000, 0x25A01000, 0x400, 0x101 },
+};
+
+typedef struct
+{
+   u8 lwram[0x100000];
+   u8 hwram[0x100000];
+   u8 vdp1ram[0x80000];
+   u8 vdp2ram[0x80000];
+   u32 vdp1pages[VDP1_RAM_PAGES];
+   u32 vdp2pages[VDP2_RAM_PAGES];
+   scudmainfo_struct dma;
+} Snapshot;
+
+static Snapshot start, reference, bulk;
+
+static u32 seed;
+
+static u32 Random(void)
+{
+   seed = seed * 1103515245 + 12345;
+   return (seed >> 8) ^ (seed << 16);
+}
+
+static void Save(Snapshot *snap)
+{
+   memcpy(snap->lwram, LowWram, sizeof(snap->lwram));
+   memcpy(snap->hwram, HighWram, sizeof(snap->hwram));
+   memcpy(snap->vdp1ram, Vdp1Ram, sizeof(snap->vdp1ram));
+   memcpy(snap->vdp2ram, Vdp2Ram, sizeof(snap->vdp2ram));
+   memcpy(snap->vdp1pages, Vdp1RamPageWrites, sizeof(snap->vdp1pages));
+   memcpy(snap->vdp2pages, Vdp2RamPageWrites, sizeof(snap->vdp2pages));
+   memcpy(&snap->dma, &ScuRegs->dma0, sizeof(snap->dma));
+}
+
+static void Restore(const Snapshot *snap)
+{
+   memcpy(LowWram, snap->lwram, sizeof(snap->lwram));
+   memcpy(HighWram, snap->hwram, sizeof(snap->hwram));
+   memcpy(Vdp1Ram, snap->vdp1ram, sizeof(snap->vdp1ram));
+   memcpy(Vdp2Ram, snap->vdp2ram, sizeof(snap->vdp2ram));
+}
+
+static void Start(const Transfer *t)
+{
+   ScuWriteLong(0x00, t->read);
+   ScuWriteLong(0x04, t->write);
+   ScuWriteLong(0x08, t->count);
+   ScuWriteLong(0x0C, t->add);
+   ScuWriteLong(0x14, 0x7);      // started by writing D0EN
+   ScuWriteLong(0x10, 0x101);
+}
+
+static void Run(int enable, const Transfer *t, Snapshot *snap)
+{
+   int i;
+
+   Restore(&start);
+   ScuDmaSetBulk(enable);
+   Start(t);
+   // uneven slices, so transfers stop in the middle of spans
+   for (i = 0; i < 100000 && ScuRegs->dma0.TransferNumber > 0; i++)
+      ScuExec(1 + (i * 13) % 97);
+   Save(snap);
+}
+
+// pages the transfer wrote, the slow path counts every write and the bulk
+// path every span
+static int SamePages(const u32 *before, const u32 *a, const u32 *b, int count)
+{
+   int i;
+
+   for (i = 0; i < count; i++)
+      if ((a[i] != before[i]) != (b[i] != before[i]))
+         return 0;
+   return 1;
+}
+
+static int TestTransfers(void)
+{
+   int i, failed = 0;
+
+   for (i = 0; i < (int)(sizeof(transfers) / sizeof(transfers[0])); i++)
+   {
+      const Transfer *t = &transfers[i];
+      const char *what = NULL;
+
+      Run(0, t, &reference);
+      Run(1, t, &bulk);
+
+      if (memcmp(reference.lwram, bulk.lwram, sizeof(bulk.lwram)))
+         what = "low work ram";
+      else if (memcmp(reference.hwram, bulk.hwram, sizeof(bulk.hwram)))
+         what = "high work ram";
+      else if (memcmp(reference.vdp1ram, bulk.vdp1ram, sizeof(bulk.vdp1ram)))
+         what = "vdp1 ram";
+      else if (memcmp(reference.vdp2ram, bulk.vdp2ram, sizeof(bulk.vdp2ram)))
+         what = "vdp2 ram";
+      else if (reference.dma.ReadAddress != bulk.dma.ReadAddress
+         || reference.dma.WriteAddress != bulk.dma.WriteAddress
+         || reference.dma.TransferNumber != bulk.dma.TransferNumber)
+         what = "transfer registers";
+      else if (!SamePages(start.vdp1pages, reference.vdp1pages, bulk.vdp1pages, VDP1_RAM_PAGES))
+         what = "vdp1 written pages";
+      else if (!SamePages(start.vdp2pages, reference.vdp2pages, bulk.vdp2pages, VDP2_RAM_PAGES))
+         what = "vdp2 written pages";
+
+      if (what != NULL)
+      {
+         printf("%s: %s differ\n", t->name, what);
+         failed++;
+      }
+
+      // the rams return to the start state for the next transfer, so do
+      // the page counters it compares against
+      Save(&start);
+   }
+
+   return failed;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static double Bench(int enable)
+{
+   static const Transfer t = { "bench", 0x06000000, 0x25C00000, BENCH_SIZE, 0x101 };
+   s64 ticks;
+
+   Restore(&start);
+   ScuDmaSetBulk(enable);
+   ticks = YabauseGetTicks();
+   Start(&t);
+   while (ScuRegs->dma0.TransferNumber > 0)
+      ScuExec(1000);
+   return (double)(YabauseGetTicks() - ticks) * 1000000.0 / (double)yabsys.tickfreq;
+}
+
+static int TestBench(void)
+{
+   double usec[2] = { 0, 0 };
+   int i;
+
+   // best of a few rounds, the two paths take turns
+   for (i = 0; i < BENCH_ROUNDS; i++)
+   {
+      double slow = Bench(0);
+      double fast = Bench(1);
+      if (i == 0 || slow < usec[0])
+         usec[0] = slow;
+      if (i == 0 || fast < usec[1])
+         usec[1] = fast;
+   }
+
+   printf("%d bytes work ram to vdp1: per element %.1f ms (%.1f MB/s), bulk %.1f ms (%.1f MB/s)\n", BENCH_SIZE,
+      usec[0] / 1000.0, BENCH_SIZE / usec[0], usec[1] / 1000.0, BENCH_SIZE / usec[1]);
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+   yabauseinit_struct yinit;
+   int failed = 0;
+   u32 i;
+
+   printf("%s v%s\n", PROG_NAME, VER_NAME);
+
+   memset(&yinit, 0, sizeof(yinit));
+   yinit.percoretype = PERCORE_DUMMY;
+   yinit.sh2coretype = SH2CORE_INTERPRETER;
+   yinit.vidcoretype = VIDCORE_DUMMY;
+   yinit.m68kcoretype = M68KCORE_DUMMY;
+   yinit.sndcoretype = SNDCORE_DUMMY;
+   yinit.cdcoretype = CDCORE_DUMMY;
+   yinit.carttype = CART_NONE;
+   yinit.regionid = REGION_AUTODETECT;
+   yinit.videoformattype = VIDEOFORMATTYPE_NTSC;
+   yinit.skip_load = 1;
+
+   if (YabauseInit(&yinit) != 0)
+   {
+      printf("YabauseInit failed\n");
+      return 1;
+   }
+
+   seed = 1;
+   for (i = 0; i < 0x100000; i++)
+   {
+      LowWram[i] = (u8)Random();
+      HighWram[i] = (u8)Random();
+   }
+   for (i = 0; i < 0x80000; i++)
+   {
+      Vdp1Ram[i] = (u8)Random();
+      Vdp2Ram[i] = (u8)Random();
+   }
+   Save(&start);
+
+   failed += TestTransfers();
+   failed += TestBench();
+
+   printf("%s\n", failed ? "FAIL" : "OK");
+
+   YabauseDeInit();
+   return failed ? 1 : 0;
+}
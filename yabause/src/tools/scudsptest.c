@@ -0,0 +1,431 @@
+/*******************************************************************************
+  SCUDSPTEST - Yabause SCU DSP program cache tester
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+*******************************************************************************/
+
+// Runs DSP programs with and without the decoded program cache and checks
+// both end up with the same registers and data ram. Random programs cover
+// the operation, load immediate, jump, loop and end commands. One program
+// loads part of itself with DMA while it runs, another one is replaced
+// through the program ram port between two runs. A multiply and add loop
+// measures both paths.
+
+// example: scudsptest
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../core.h"
+#include "../yabause.h"
+#include "../yui.h"
+#include "../memory.h"
+#include "../cdbase.h"
+#include "../cs0.h"
+#include "../m68kcore.h"
+#include "../peripheral.h"
+#include "../sh2core.h"
+#include "../sh2int.h"
+#include "../scsp.h"
+#include "../scu.h"
+#include "../vdp1.h"
+#include "../vdp2.h"
+
+#define PROG_NAME "SCUDSPTEST"
+#define VER_NAME "1.0"
+
+#define RANDOM_PROGRAMS 500
+#define RANDOM_SLICES 64
+#define LOAD_ADDR 0x00200000   // low work ram, where the DMA test reads from
+#define BENCH_CYCLES 20000000
+#define BENCH_ROUNDS 5
+
+SH2Interface_struct *SH2CoreList[] = {
+   &SH2Interpreter,
+   NULL
+};
+
+PerInterface_struct *PERCoreList[] = {
+   &PERDummy,
+   NULL
+};
+
+CDInterface *CDCoreList[] = {
+   &DummyCD,
+   NULL
+};
+
+SoundInterface_struct *SNDCoreList[] = {
+   &SNDDummy,
+   NULL
+};
+
+VideoInterface_struct *VIDCoreList[] = {
+   &VIDDummy,
+   NULL
+};
+
+M68K_struct * M68KCoreList[] = {
+   &M68KDummy,
+   NULL
+};
+
+void YuiErrorMsg(const char *string) { printf("Error: %s\n", string); }
+
+void YuiSwapBuffers() { }
+
+//////////////////////////////////////////////////////////////////////////////
+
+static u32 seed;
+
+static u32 Random(void)
+{
+   seed = seed * 1103515245 + 12345;
+   return (seed >> 8) ^ (seed << 16);
+}
+
+// D1-bus sources the DSP defines, the others read nothing
+static u32 D1Source(u32 r)
+{
+   static const u8 sources[] = { 0, 1, 2, 3, 4, 5, 6, 7, 9, 10 };
+   return sources[r % sizeof(sources)];
+}
+
+static u32 RandomInstruction(void)
+{
+   u32 r = Random();
+
+   switch (Random() % 20)
+   {
+      case 0: case 1: case 2:
+         // load immediate
+         return 0x80000000 | (r & 0x3FFFFFFF);
+      case 3:
+         return 0xD0000000 | (r & 0x0FFFFFFF);  // jumps, some unknown
+      case 4:
+         return 0xE0000000 | (r & 0x0800FFFF);  // LPS and BTM
+      case 5:
+         if ((r & 0xF) == 0)
+            return 0xF0000000 | (r & 0x08000000);  // END and ENDI
+         // fall through
+      default:
+         // operation commands, with a defined D1-bus source
+         return (r & 0x3FFFFFF0) | D1Source(Random());
+   }
+}
+
+typedef struct
+{
+   scudspregs_struct regs;
+   double usec;
+} RunResult;
+
+static void StartProgram(const u32 *program, int words, const scudspregs_struct *start)
+{
+   scudspregs_struct regs;
+   int i;
+
+   memcpy(&regs, start, sizeof(regs));
+   for (i = 0; i < words; i++)
+      regs.ProgramRam[i] = program[i];
+   regs.ProgControlPort.part.EX = 1;
+   regs.jmpaddr = 0xFFFFFFFF;
+   regs.delayed = 0;
+   ScuDspSetRegisters(&regs);
+}
+
+static void GetResult(RunResult *result)
+{
+   memset(&result->regs, 0, sizeof(result->regs));
+   ScuDspGetRegisters(&result->regs);
+}
+
+static int Compare(const char *name, const RunResult *reference, const RunResult *cached)
+{
+   if (memcmp(&reference->regs, &cached->regs, sizeof(scudspregs_struct)) == 0)
+      return 0;
+
+   printf("%s: interpreter and cache differ, PC %02X/%02X AC %08X/%08X P %08X/%08X\n", name,
+      reference->regs.PC, cached->regs.PC,
+      (u32)reference->regs.AC.all, (u32)cached->regs.AC.all,
+      (u32)reference->regs.P.all, (u32)cached->regs.P.all);
+   return 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void RunRandom(int cache, const u32 *program, const scudspregs_struct *start, RunResult *result)
+{
+   int i;
+
+   ScuDspSetCache(cache);
+   StartProgram(program, 256, start);
+   for (i = 0; i < RANDOM_SLICES; i++)
+      ScuExec(1 + (i * 7) % 40);
+   GetResult(result);
+}
+
+static int TestRandom(void)
+{
+   static u32 program[256];
+   static RunResult reference, cached;
+   scudspregs_struct start;
+   int i, j, failed = 0;
+
+   for (i = 0; i < RANDOM_PROGRAMS && failed < 10; i++)
+   {
+      seed = i + 1;
+      for (j = 0; j < 256; j++)
+         program[j] = RandomInstruction();
+
+      memset(&start, 0, sizeof(start));
+      for (j = 0; j < 4 * 64; j++)
+         start.MD[j / 64][j % 64] = Random();
+      for (j = 0; j < 4; j++)
+         start.CT[j] = Random() & 0x3F;
+      start.LOP = Random() & 0xF;
+      start.TOP = Random() & 0xFF;
+      start.ProgControlPort.part.P = Random() & 0xFF;
+
+      RunRandom(0, program, &start, &reference);
+      RunRandom(1, program, &start, &cached);
+      if (Compare("random program", &reference, &cached))
+      {
+         printf("seed %d\n", i + 1);
+         failed++;
+      }
+   }
+
+   printf("%d random programs\n", i);
+   return failed;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void RunDmaLoad(int cache, RunResult *result)
+{
+   static const u32 program[] = {
+      0x98000000 | (LOAD_ADDR >> 2),   // MVI LOAD_ADDR,RA0
+      0xC0012400,                      // DMA D0,PRG,M0
+      0x00000000,                      // NOP, replaced by the DMA
+      0x00000000,
+      0x00000000,
+      0x00000000,
+   };
+   scudspregs_struct start;
+   int i;
+
+   // words the DMA puts over the program. The first two stay the same, the
+   // third already ran as a NOP and runs again after the loop bottom.
+   MappedMemoryWriteLong(LOAD_ADDR, program[0], NULL);
+   MappedMemoryWriteLong(LOAD_ADDR + 4, program[1], NULL);
+   MappedMemoryWriteLong(LOAD_ADDR + 8, 0x88000222, NULL);                   // MVI 0x222,MC2
+   for (i = 3; i < 13; i++)
+      MappedMemoryWriteLong(LOAD_ADDR + i * 4, 0x84000000 | (i * 0x111), NULL); // MVI imm,MC1
+   MappedMemoryWriteLong(LOAD_ADDR + 13 * 4, 0xE0000000, NULL);              // BTM
+   MappedMemoryWriteLong(LOAD_ADDR + 14 * 4, 0x00000000, NULL);              // NOP
+   MappedMemoryWriteLong(LOAD_ADDR + 15 * 4, 0xF8000000, NULL);              // ENDI
+
+   memset(&start, 0, sizeof(start));
+   start.MD[0][0] = 16;                // DMA count
+   start.LOP = 1;
+   start.TOP = 2;
+
+   ScuDspSetCache(cache);
+   StartProgram(program, sizeof(program) / sizeof(program[0]), &start);
+   for (i = 0; i < 16; i++)
+      ScuExec(4);
+   GetResult(result);
+}
+
+static int TestDmaLoad(void)
+{
+   static RunResult reference, cached;
+   int failed = 0;
+
+   RunDmaLoad(0, &reference);
+   RunDmaLoad(1, &cached);
+   failed += Compare("dma load", &reference, &cached);
+
+   if (cached.regs.ProgControlPort.part.EX || cached.regs.MD[1][9] != 12 * 0x111 ||
+       cached.regs.MD[2][0] != 0x222)
+   {
+      printf("dma load: loaded program didn't run, PC %02X\n", cached.regs.PC);
+      failed++;
+   }
+
+   return failed;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void WriteProgram(const u32 *program, int words)
+{
+   int i;
+
+   ScuWriteLong(0x80, 0x8000); // load PC 0
+   for (i = 0; i < words; i++)
+      ScuWriteLong(0x84, program[i]);
+   ScuWriteLong(0x80, 0x8000);
+}
+
+static void RunReload(int cache, RunResult *result)
+{
+   static const u32 first[] = {
+      0x90000010,    // MVI 16,RX
+      0x94000003,    // MVI 3,PL
+      0x10040000,    // ADD MOV ALU,A
+      0xF0000000,    // END
+   };
+   static const u32 second[] = {
+      0x90000007,    // MVI 7,RX
+      0x84000055,    // MVI 0x55,MC1
+      0x28040000,    // SL MOV ALU,A
+      0xF0000000,    // END
+   };
+   scudspregs_struct start;
+
+   memset(&start, 0, sizeof(start));
+   ScuDspSetCache(cache);
+   StartProgram(first, 4, &start);
+   ScuExec(20);
+
+   WriteProgram(second, 4);
+   ScuWriteLong(0x80, 0x10000);    // run
+   ScuExec(20);
+   GetResult(result);
+}
+
+static int TestReload(void)
+{
+   static RunResult reference, cached;
+   scudspstats_struct stats;
+   int failed = 0;
+
+   RunReload(0, &reference);
+   ScuSendVBlankIN();
+   RunReload(1, &cached);
+   ScuSendVBlankIN();
+   ScuDspGetStats(&stats);
+
+   failed += Compare("program reload", &reference, &cached);
+   if (stats.invalidations == 0)
+   {
+      printf("program reload: no decoded word was dropped\n");
+      failed++;
+   }
+
+   return failed;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void RunBench(int cache, RunResult *result)
+{
+   // multiply and add over the data ram, the inner loop of a transform
+   static const u32 program[] = {
+      0x00020000,                // CLR A
+      0xA800003F,                // MVI 63,LOP
+      0x00000000,                // NOP, loop top
+      0x034D4000,                // MOV MC0,X MOV MUL,P MOV MC1,Y MOV ALU,A
+      0x19000000,                // AD2 MOV MUL,P
+      0xE0000000,                // BTM
+      0x18040000,                // AD2 MOV ALU,A
+      0xD0000000,                // JMP 0
+      0x00000000,                // NOP
+   };
+   scudspregs_struct start;
+   s64 t;
+   int i;
+
+   memset(&start, 0, sizeof(start));
+   for (i = 0; i < 4 * 64; i++)
+      start.MD[i / 64][i % 64] = i * 3 + 1;
+   start.TOP = 2;
+
+   ScuDspSetCache(cache);
+   StartProgram(program, sizeof(program) / sizeof(program[0]), &start);
+
+   t = YabauseGetTicks();
+   for (i = 0; i < BENCH_CYCLES / 1000; i++)
+      ScuExec(1000);
+   result->usec = (double)(YabauseGetTicks() - t) * 1000000.0 / (double)yabsys.tickfreq;
+   GetResult(result);
+}
+
+static int TestBench(void)
+{
+   static RunResult reference, cached;
+   double usec[2] = { 0, 0 };
+   int i, failed = 0;
+
+   // best of a few rounds, the two paths take turns
+   for (i = 0; i < BENCH_ROUNDS; i++)
+   {
+      RunBench(0, &reference);
+      RunBench(1, &cached);
+      failed += Compare("multiply loop", &reference, &cached);
+      if (i == 0 || reference.usec < usec[0])
+         usec[0] = reference.usec;
+      if (i == 0 || cached.usec < usec[1])
+         usec[1] = cached.usec;
+   }
+   reference.usec = usec[0];
+   cached.usec = usec[1];
+
+   printf("%d cycles: interpreter %.1f ms (%.1f Mcycles/s), cache %.1f ms (%.1f Mcycles/s)\n", BENCH_CYCLES,
+      reference.usec / 1000.0, BENCH_CYCLES / reference.usec,
+      cached.usec / 1000.0, BENCH_CYCLES / cached.usec);
+   return failed;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+   yabauseinit_struct yinit;
+   int failed = 0;
+
+   printf("%s v%s\n", PROG_NAME, VER_NAME);
+
+   memset(&yinit, 0, sizeof(yinit));
+   yinit.percoretype = PERCORE_DUMMY;
+   yinit.sh2coretype = SH2CORE_INTERPRETER;
+   yinit.vidcoretype = VIDCORE_DUMMY;
+   yinit.m68kcoretype = M68KCORE_DUMMY;
+   yinit.sndcoretype = SNDCORE_DUMMY;
+   yinit.cdcoretype = CDCORE_DUMMY;
+   yinit.carttype = CART_NONE;
+   yinit.regionid = REGION_AUTODETECT;
+   yinit.videoformattype = VIDEOFORMATTYPE_NTSC;
+   yinit.skip_load = 1;
+
+   if (YabauseInit(&yinit) != 0)
+   {
+      printf("YabauseInit failed\n");
+      return 1;
+   }
+
+   failed += TestRandom();
+   failed += TestDmaLoad();
+   failed += TestReload();
+   failed += TestBench();
+
+   printf("%s\n", failed ? "FAIL" : "OK");
+
+   YabauseDeInit();
+   return failed ? 1 : 0;
+}
@@ -0,0 +1,424 @@
+/*******************************************************************************
+  SH2BLOCKTEST - Yabause SH2 interpreter block cache tester
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+*******************************************************************************/
+
+// Runs a small SH2 program with and without the interpreter's decoded block
+// cache and checks both end up with the same registers and memory. The
+// program loops, calls subroutines, rewrites instructions inside the block
+// it is running and in another page, and gets patched behind its back with
+// only SH2WriteNotify telling the cache. When a bios or a cd image is given
+// the game first runs for a number of frames in both modes from the same
+// save state and the machines are compared.
+
+// example: sh2blocktest [bios path] [cd image path] [frames]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../core.h"
+#include "../yabause.h"
+#include "../yui.h"
+#include "../memory.h"
+#include "../cdbase.h"
+#include "../cs0.h"
+#include "../m68kcore.h"
+#include "../peripheral.h"
+#include "../sh2core.h"
+#include "../sh2int.h"
+#include "../scsp.h"
+#include "../vdp1.h"
+#include "../vdp2.h"
+
+#define PROG_NAME "SH2BLOCKTEST"
+#define VER_NAME "1.0"
+
+#define PROGRAM_ADDR 0x06004000
+#define PROGRAM_WORDS 512
+#define LOOP_COUNT 1000000
+#define SLICE_CYCLES 10000
+#define MAX_SLICES 10000
+
+SH2Interface_struct *SH2CoreList[] = {
+   &SH2Interpreter,
+   NULL
+};
+
+PerInterface_struct *PERCoreList[] = {
+   &PERDummy,
+   NULL
+};
+
+CDInterface *CDCoreList[] = {
+   &DummyCD,
+   &ISOCD,
+   NULL
+};
+
+SoundInterface_struct *SNDCoreList[] = {
+   &SNDDummy,
+   NULL
+};
+
+VideoInterface_struct *VIDCoreList[] = {
+   &VIDDummy,
+   NULL
+};
+
+M68K_struct * M68KCoreList[] = {
+   &M68KDummy,
+   NULL
+};
+
+void YuiErrorMsg(const char *string) { printf("Error: %s\n", string); }
+
+void YuiSwapBuffers() { }
+
+//////////////////////////////////////////////////////////////////////////////
+
+static u16 program[PROGRAM_WORDS];
+static int here;
+static int end_label, patch_label;
+
+static int Emit(u16 op)
+{
+   program[here] = op;
+   return here++;
+}
+
+// Branch and literal displacements, positions are in words from the start
+static u16 Disp8(u16 op, int from, int to) { return op | ((to - from - 2) & 0xFF); }
+static u16 Disp12(u16 op, int from, int to) { return op | ((to - from - 2) & 0xFFF); }
+static u16 LiteralLong(int n, int from, int at) { return 0xD000 | (n << 8) | ((at * 2 - ((from * 2) & ~3) - 4) / 4); }
+static u16 LiteralWord(int n, int from, int at) { return 0x9000 | (n << 8) | ((at * 2 - from * 2 - 4) / 2); }
+
+static void PutLong(int at, u32 val)
+{
+   program[at] = val >> 16;
+   program[at + 1] = val & 0xFFFF;
+}
+
+static void BuildProgram(void)
+{
+   enum { LIT_COUNT = 160, LIT_SLOT1 = 162, LIT_SLOT2 = 164, LIT_SUB2 = 166, LIT_ADD4 = 168, LIT_ADD11 = 169 };
+   enum { SUB2 = 320, PATCH = 400 };
+   int loop, call, slot1, sub1;
+
+   memset(program, 0, sizeof(program));
+   here = 0;
+
+   // arithmetic loop
+   Emit(LiteralLong(1, here, LIT_COUNT));
+   Emit(0xE000);                          // mov #0,r0
+   Emit(0xE903);                          // mov #3,r9
+   loop = Emit(0x301C);                   // add r1,r0
+   Emit(0x209A);                          // xor r9,r0
+   Emit(0x7901);                          // add #1,r9
+   Emit(0x4110);                          // dt r1
+   Emit(Disp8(0x8B00, here, loop));       // bf loop
+
+   // subroutine calls with work in the delay slot
+   Emit(0xE80A);                          // mov #10,r8
+   loop = call = Emit(0);                 // bsr sub1
+   Emit(0x7201);                          // add #1,r2
+   Emit(0x4810);                          // dt r8
+   Emit(Disp8(0x8B00, here, loop));       // bf loop
+
+   // rewrite an instruction a little further in the same block
+   Emit(LiteralLong(6, here, LIT_SLOT1));
+   Emit(0xE700);                          // mov #0,r7
+   Emit(0xE814);                          // mov #20,r8
+   loop = Emit(LiteralWord(5, here, LIT_ADD4));
+   Emit(0x357C);                          // add r7,r5
+   Emit(0x2651);                          // mov.w r5,@r6
+   Emit(0x0009);                          // nop
+   slot1 = Emit(0x0009);                  // nop, becomes add #r7,r4
+   Emit(0x7701);                          // add #1,r7
+   Emit(0x4810);                          // dt r8
+   Emit(Disp8(0x8B00, here, loop));       // bf loop
+
+   // rewrite a subroutine in another page, then call it
+   Emit(LiteralLong(6, here, LIT_SLOT2));
+   Emit(LiteralLong(10, here, LIT_SUB2));
+   Emit(0xE700);                          // mov #0,r7
+   Emit(0xE814);                          // mov #20,r8
+   loop = Emit(LiteralWord(5, here, LIT_ADD11));
+   Emit(0x357C);                          // add r7,r5
+   Emit(0x2651);                          // mov.w r5,@r6
+   Emit(0x4A0B);                          // jsr @r10
+   Emit(0x0009);                          // nop
+   Emit(0x7701);                          // add #1,r7
+   Emit(0x4810);                          // dt r8
+   Emit(Disp8(0x8B00, here, loop));       // bf loop
+
+   end_label = Emit(Disp12(0xA000, here, here)); // bra end
+   Emit(0x0009);                          // nop
+
+   sub1 = Emit(0x332C);                   // add r2,r3
+   Emit(0x000B);                          // rts
+   Emit(0x4300);                          // shll r3
+   program[call] = Disp12(0xB000, call, sub1);
+
+   PutLong(LIT_COUNT, LOOP_COUNT);
+   PutLong(LIT_SLOT1, PROGRAM_ADDR + slot1 * 2);
+   PutLong(LIT_SLOT2, PROGRAM_ADDR + SUB2 * 2);
+   PutLong(LIT_SUB2, PROGRAM_ADDR + SUB2 * 2);
+   program[LIT_ADD4] = 0x7400;            // add #0,r4
+   program[LIT_ADD11] = 0x7B00;           // add #0,r11
+
+   program[SUB2] = 0x0009;                // nop, becomes add #r7,r11
+   program[SUB2 + 1] = 0x000B;            // rts
+   program[SUB2 + 2] = 0x7C01;            // add #1,r12
+
+   // loop the harness patches without going through the cpu
+   patch_label = PATCH;
+   program[PATCH] = 0x7D01;               // add #1,r13
+   program[PATCH + 1] = Disp12(0xA000, PATCH + 1, PATCH); // bra patch
+   program[PATCH + 2] = 0x0009;           // nop
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct
+{
+   sh2regs_struct regs;
+   u16 ram[PROGRAM_WORDS];
+   double usec;
+} RunResult;
+
+static void LoadProgram(void)
+{
+   int i;
+
+   for (i = 0; i < PROGRAM_WORDS; i++)
+      MappedMemoryWriteWord(PROGRAM_ADDR + i * 2, program[i], NULL);
+}
+
+static void StartAt(u32 pc)
+{
+   sh2regs_struct regs;
+
+   SH2GetRegisters(MSH2, &regs);
+   regs.PC = pc;
+   regs.R[15] = 0x06002000;
+   regs.SR.all = 0xF0;
+   SH2SetRegisters(MSH2, &regs);
+}
+
+static void RunProgram(int block_cache, RunResult *result)
+{
+   u32 patch_addr = PROGRAM_ADDR + patch_label * 2;
+   s64 t;
+   int i;
+
+   yabsys.use_sh2_block_cache = block_cache;
+
+   SH2Reset(MSH2);
+   MSH2->pre_cycle = 0;
+   LoadProgram();
+   StartAt(PROGRAM_ADDR);
+
+   t = YabauseGetTicks();
+   for (i = 0; i < MAX_SLICES && MSH2->regs.PC != PROGRAM_ADDR + end_label * 2; i++)
+      SH2Exec(MSH2, SLICE_CYCLES);
+   result->usec = (double)(YabauseGetTicks() - t) * 1000000.0 / (double)yabsys.tickfreq;
+
+   // patch a running loop the way dma or a file loader would
+   StartAt(patch_addr);
+   SH2Exec(MSH2, 1000);
+   T2WriteWord(HighWram, patch_addr & 0xFFFFF, 0x7D02);
+   SH2WriteNotify(patch_addr, 2);
+   SH2Exec(MSH2, 1000);
+
+   SH2GetRegisters(MSH2, &result->regs);
+   for (i = 0; i < PROGRAM_WORDS; i++)
+      result->ram[i] = T2ReadWord(HighWram, (PROGRAM_ADDR + i * 2) & 0xFFFFF);
+}
+
+static int TestProgram(void)
+{
+   static RunResult reference, cached;
+   int i, failed = 0;
+
+   BuildProgram();
+   RunProgram(0, &reference);
+   RunProgram(1, &cached);
+
+   if (reference.regs.PC != PROGRAM_ADDR + patch_label * 2 &&
+       reference.regs.PC != PROGRAM_ADDR + patch_label * 2 + 2)
+   {
+      printf("program didn't reach the patch loop, PC=%08X\n", reference.regs.PC);
+      failed++;
+   }
+
+   for (i = 0; i < 16; i++)
+   {
+      if (reference.regs.R[i] != cached.regs.R[i])
+      {
+         printf("R%d: interpreter %08X, block cache %08X\n", i, reference.regs.R[i], cached.regs.R[i]);
+         failed++;
+      }
+   }
+
+   if (memcmp(&reference.regs, &cached.regs, sizeof(reference.regs)) != 0)
+   {
+      printf("registers differ, PC interpreter %08X block cache %08X\n", reference.regs.PC, cached.regs.PC);
+      failed++;
+   }
+
+   if (memcmp(reference.ram, cached.ram, sizeof(reference.ram)) != 0)
+   {
+      printf("program memory differs\n");
+      failed++;
+   }
+
+   printf("program: interpreter %.1f ms, block cache %.1f ms\n", reference.usec / 1000.0, cached.usec / 1000.0);
+   return failed;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static u8 *SaveRam(void)
+{
+   u8 *ram = (u8 *)malloc(0x200000);
+
+   memcpy(ram, HighWram, 0x100000);
+   memcpy(ram + 0x100000, LowWram, 0x100000);
+   return ram;
+}
+
+static int TestFrames(int frames)
+{
+   void *state;
+   size_t size;
+   sh2regs_struct msh2, ssh2, regs;
+   u8 *ram;
+   s64 t;
+   double usec[2];
+   int i, failed = 0;
+
+   if (YabSaveStateBuffer(&state, &size) != 0)
+   {
+      printf("YabSaveStateBuffer failed\n");
+      return 1;
+   }
+
+   yabsys.use_sh2_block_cache = 0;
+   t = YabauseGetTicks();
+   for (i = 0; i < frames; i++)
+      YabauseEmulate();
+   usec[0] = (double)(YabauseGetTicks() - t) * 1000000.0 / (double)yabsys.tickfreq;
+   SH2GetRegisters(MSH2, &msh2);
+   SH2GetRegisters(SSH2, &ssh2);
+   ram = SaveRam();
+
+   YabLoadStateBuffer(state, size);
+   yabsys.use_sh2_block_cache = 1;
+   t = YabauseGetTicks();
+   for (i = 0; i < frames; i++)
+      YabauseEmulate();
+   usec[1] = (double)(YabauseGetTicks() - t) * 1000000.0 / (double)yabsys.tickfreq;
+
+   SH2GetRegisters(MSH2, &regs);
+   if (memcmp(&regs, &msh2, sizeof(regs)) != 0)
+   {
+      printf("MSH2 registers differ after %d frames\n", frames);
+      failed++;
+   }
+   SH2GetRegisters(SSH2, &regs);
+   if (memcmp(&regs, &ssh2, sizeof(regs)) != 0)
+   {
+      printf("SSH2 registers differ after %d frames\n", frames);
+      failed++;
+   }
+   if (memcmp(ram, HighWram, 0x100000) != 0 || memcmp(ram + 0x100000, LowWram, 0x100000) != 0)
+   {
+      printf("work ram differs after %d frames\n", frames);
+      failed++;
+   }
+
+   printf("%d frames: interpreter %.1f ms, block cache %.1f ms\n", frames, usec[0] / 1000.0, usec[1] / 1000.0);
+
+   free(ram);
+   free(state);
+   return failed;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+   yabauseinit_struct yinit;
+   int frames = 600;
+   int game = 0;
+   int failed = 0;
+   int i;
+
+   printf("%s v%s\n", PROG_NAME, VER_NAME);
+
+   memset(&yinit, 0, sizeof(yinit));
+   yinit.percoretype = PERCORE_DUMMY;
+   yinit.sh2coretype = SH2CORE_INTERPRETER;
+   yinit.vidcoretype = VIDCORE_DUMMY;
+   yinit.m68kcoretype = M68KCORE_DUMMY;
+   yinit.sndcoretype = SNDCORE_DUMMY;
+   yinit.cdcoretype = CDCORE_DUMMY;
+   yinit.carttype = CART_NONE;
+   yinit.regionid = REGION_AUTODETECT;
+   yinit.videoformattype = VIDEOFORMATTYPE_NTSC;
+   yinit.framelimit = 1;
+   yinit.clocksync = 1;
+   yinit.basetime = 0x30000000;
+
+   if (argc > 1 && argv[1][0] != '\0')
+   {
+      yinit.biospath = argv[1];
+      game = 1;
+   }
+   if (argc > 2 && argv[2][0] != '\0')
+   {
+      yinit.cdcoretype = CDCORE_ISO;
+      yinit.cdpath = argv[2];
+      game = 1;
+   }
+   if (argc > 3)
+      frames = atoi(argv[3]);
+
+   if (!game)
+      yinit.skip_load = 1; // the emulated bios refuses to start without a game
+
+   if (YabauseInit(&yinit) != 0)
+   {
+      printf("YabauseInit failed\n");
+      return 1;
+   }
+
+   if (game)
+   {
+      // get past the bios startup before taking the state both runs share
+      for (i = 0; i < 60; i++)
+         YabauseEmulate();
+      failed += TestFrames(frames);
+   }
+
+   failed += TestProgram();
+
+   printf("%s\n", failed ? "FAIL" : "OK");
+
+   YabauseDeInit();
+   return failed ? 1 : 0;
+}
@@ -0,0 +1,431 @@
+/*******************************************************************************
+  SSH2THREADTEST - Yabause slave SH2 thread tester
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+*******************************************************************************/
+
+// Runs both SH2s for some frames with the slave on the emulation thread and
+// then on its own, and hashes the work rams, VDP2 ram and both cpus.
+//
+// A slave that keeps to its own work ram must come out the same either way
+// at any quantum, as must one that writes VDP2 ram when the two cpus meet
+// every step. With a quantum of a line the latter only has to come out the
+// same on every threaded run. Then the two cpus hand jobs to each other
+// through the input capture, every result has to be right, the threaded run
+// has to do as many jobs as the serial one and two threaded runs have to
+// agree. Also reports the frame time both ways for cpus working on their
+// own and for a slave taking long jobs from a master that works meanwhile,
+// which only says something on a host with a core for each thread.
+
+// example: ssh2threadtest [frames]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../core.h"
+#include "../yabause.h"
+#include "../yui.h"
+#include "../memory.h"
+#include "../cdbase.h"
+#include "../cs0.h"
+#include "../m68kcore.h"
+#include "../peripheral.h"
+#include "../sh2core.h"
+#include "../sh2int.h"
+#include "../scsp.h"
+#include "../vdp1.h"
+#include "../vdp2.h"
+#include "toolutil.h"
+
+#define PROG_NAME "SSH2THREADTEST"
+#define VER_NAME "1.0"
+
+#define MASTER_ADDR 0x06004000
+#define SLAVE_ADDR 0x06005000
+#define JOB_ADDR 0x06030000     // job, result, jobs done, wrong results
+#define FTCSR_ADDR 0xFFFFFE11
+
+SH2Interface_struct *SH2CoreList[] = {
+   &SH2Interpreter,
+   NULL
+};
+
+PerInterface_struct *PERCoreList[] = {
+   &PERDummy,
+   NULL
+};
+
+CDInterface *CDCoreList[] = {
+   &DummyCD,
+   NULL
+};
+
+SoundInterface_struct *SNDCoreList[] = {
+   &SNDDummy,
+   NULL
+};
+
+VideoInterface_struct *VIDCoreList[] = {
+   &VIDDummy,
+   NULL
+};
+
+M68K_struct * M68KCoreList[] = {
+   &M68KDummy,
+   NULL
+};
+
+void YuiErrorMsg(const char *string) { printf("Error: %s\n", string); }
+
+void YuiSwapBuffers() { }
+
+//////////////////////////////////////////////////////////////////////////////
+
+// The statedettest loop with its addresses in registers: r1 and r4 get the
+// counter in r2 at the offset in r3, masked by r5
+static const u16 fill_program[] = {
+   0x7201,     // loop: add #1,r2
+   0x6033,     // mov r3,r0
+   0x0126,     // mov.l r2,@(r0,r1)
+   0x0426,     // mov.l r2,@(r0,r4)
+   0x7304,     // add #4,r3
+   0x2359,     // and r5,r3
+   0xAFF8,     // bra loop
+   0x0009,     // nop
+};
+
+// Writes a job to @r2, kicks the slave's input capture at @r3 and waits
+// for its own FTCSR at @r1. Counts the jobs done at @(8,r2) and the wrong
+// results at @(12,r2).
+static const u16 master_program[] = {
+   0x2272,     // next: mov.l r7,@r2
+   0x2301,     // mov.w r0,@r3
+   0x6010,     // wait: mov.b @r1,r0
+   0xC880,     // tst #0x80,r0
+   0x89FC,     // bt wait
+   0xE000,     // mov #0,r0
+   0x2100,     // mov.b r0,@r1
+   0x5421,     // mov.l @(4,r2),r4
+   0x6573,     // mov r7,r5
+   0x357C,     // add r7,r5
+   0x357C,     // add r7,r5
+   0x7501,     // add #1,r5
+   0x3540,     // cmp/eq r4,r5
+   0x8902,     // bt ok
+   0x5023,     // mov.l @(12,r2),r0
+   0x7001,     // add #1,r0
+   0x1203,     // mov.l r0,@(12,r2)
+   0x1272,     // ok: mov.l r7,@(8,r2)
+   0x7701,     // add #1,r7
+   0xAFEB,     // bra next
+   0x0009,     // nop
+};
+
+// Waits for its FTCSR at @r1, answers the job at @r2 with job * 3 + 1 and
+// kicks the master's input capture at @r3
+static const u16 slave_program[] = {
+   0x6010,     // loop: mov.b @r1,r0
+   0xC880,     // tst #0x80,r0
+   0x89FC,     // bt loop
+   0xE000,     // mov #0,r0
+   0x2100,     // mov.b r0,@r1
+   0x6422,     // mov.l @r2,r4
+   0x6543,     // mov r4,r5
+   0x354C,     // add r4,r5
+   0x354C,     // add r4,r5
+   0x7501,     // add #1,r5
+   0x1251,     // mov.l r5,@(4,r2)
+   0x2301,     // mov.w r0,@r3
+   0xAFF2,     // bra loop
+   0x0009,     // nop
+};
+
+// master_program working r6 times round a loop of its own between kicking
+// the slave and waiting for it
+static const u16 busy_master_program[] = {
+   0x2272,     // next: mov.l r7,@r2
+   0x2301,     // mov.w r0,@r3
+   0x6563,     // mov r6,r5
+   0x4510,     // work: dt r5
+   0x8BFD,     // bf work
+   0x6010,     // wait: mov.b @r1,r0
+   0xC880,     // tst #0x80,r0
+   0x89FC,     // bt wait
+   0xE000,     // mov #0,r0
+   0x2100,     // mov.b r0,@r1
+   0x5421,     // mov.l @(4,r2),r4
+   0x6573,     // mov r7,r5
+   0x357C,     // add r7,r5
+   0x357C,     // add r7,r5
+   0x7501,     // add #1,r5
+   0x3540,     // cmp/eq r4,r5
+   0x8902,     // bt ok
+   0x5023,     // mov.l @(12,r2),r0
+   0x7001,     // add #1,r0
+   0x1203,     // mov.l r0,@(12,r2)
+   0x1272,     // ok: mov.l r7,@(8,r2)
+   0x7701,     // add #1,r7
+   0xAFE8,     // bra next
+   0x0009,     // nop
+};
+
+// slave_program working r6 times round a loop on each job
+static const u16 busy_slave_program[] = {
+   0x6010,     // loop: mov.b @r1,r0
+   0xC880,     // tst #0x80,r0
+   0x89FC,     // bt loop
+   0xE000,     // mov #0,r0
+   0x2100,     // mov.b r0,@r1
+   0x6422,     // mov.l @r2,r4
+   0x6563,     // mov r6,r5
+   0x4510,     // work: dt r5
+   0x8BFD,     // bf work
+   0x6543,     // mov r4,r5
+   0x354C,     // add r4,r5
+   0x354C,     // add r4,r5
+   0x7501,     // add #1,r5
+   0x1251,     // mov.l r5,@(4,r2)
+   0x2301,     // mov.w r0,@r3
+   0xAFEF,     // bra loop
+   0x0009,     // nop
+};
+
+typedef struct
+{
+   const char *name;
+   const u16 *master;
+   int master_len;
+   u32 master_regs[8];
+   const u16 *slave;
+   int slave_len;
+   u32 slave_regs[8];
+} Setup;
+
+static const Setup independent = {
+   "independent",
+   fill_program, sizeof(fill_program) / 2,
+   { 0, 0x06010000, 0, 0, 0x25E00000, 0x0000FFFC, 0, 0 },
+   fill_program, sizeof(fill_program) / 2,
+   { 0, 0x06020000, 0x1000, 0, 0x06040000, 0x0000FFFC, 0, 0 },
+};
+
+static const Setup vdp2 = {
+   "vdp2",
+   fill_program, sizeof(fill_program) / 2,
+   { 0, 0x06010000, 0, 0, 0x25E00000, 0x0000FFFC, 0, 0 },
+   fill_program, sizeof(fill_program) / 2,
+   { 0, 0x06020000, 0x1000, 0, 0x25E40000, 0x0000FFFC, 0, 0 },
+};
+
+static const Setup handshake = {
+   "handshake",
+   master_program, sizeof(master_program) / 2,
+   { 0, FTCSR_ADDR, JOB_ADDR, 0x21000000, 0, 0, 0, 1 },
+   slave_program, sizeof(slave_program) / 2,
+   { 0, FTCSR_ADDR, JOB_ADDR, 0x21800000, 0, 0, 0, 0 },
+};
+
+// Most of a frame on the slave for each job, half of that on the master
+static const Setup slave_heavy = {
+   "slave heavy",
+   busy_master_program, sizeof(busy_master_program) / 2,
+   { 0, FTCSR_ADDR, JOB_ADDR, 0x21000000, 0, 0, 50000, 1 },
+   busy_slave_program, sizeof(busy_slave_program) / 2,
+   { 0, FTCSR_ADDR, JOB_ADDR, 0x21800000, 0, 0, 100000, 0 },
+};
+
+typedef struct
+{
+   u64 hash;
+   u32 jobs;
+   u32 wrong;
+   double usec;        // a frame, the best of the run
+} Result;
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int Run(const Setup *setup, int threaded, u32 quantum, int frames, Result *result)
+{
+   yabauseinit_struct yinit;
+   int frame;
+
+   memset(&yinit, 0, sizeof(yinit));
+   yinit.percoretype = PERCORE_DUMMY;
+   yinit.sh2coretype = SH2CORE_INTERPRETER;
+   yinit.vidcoretype = VIDCORE_DUMMY;
+   yinit.m68kcoretype = M68KCORE_DUMMY;
+   yinit.sndcoretype = SNDCORE_DUMMY;
+   yinit.cdcoretype = CDCORE_DUMMY;
+   yinit.carttype = CART_NONE;
+   yinit.regionid = REGION_AUTODETECT;
+   yinit.videoformattype = VIDEOFORMATTYPE_NTSC;
+   yinit.framelimit = 1;
+   yinit.scsp_main_mode = 1; // the sound thread runs on its own, as in libretro
+   yinit.skip_load = 1;
+   yinit.use_ssh2_thread = threaded;
+   yinit.ssh2_quantum = quantum;
+
+   if (YabauseInit(&yinit) != 0)
+   {
+      printf("YabauseInit failed\n");
+      return -1;
+   }
+   if (yabsys.use_ssh2_thread != threaded)
+   {
+      printf("%s: the slave didn't get its thread\n", setup->name);
+      YabauseDeInit();
+      return -1;
+   }
+
+   // the emulated bios sets the slave up from ram, the program goes over it
+   YabauseStartSlave();
+   LoadProgram(MSH2, MASTER_ADDR, setup->master, setup->master_len, setup->master_regs);
+   LoadProgram(SSH2, SLAVE_ADDR, setup->slave, setup->slave_len, setup->slave_regs);
+
+   result->usec = 0;
+   for (frame = 0; frame < frames; frame++)
+   {
+      s64 t = YabauseGetTicks();
+      double usec;
+
+      YabauseEmulate();
+      usec = TicksToUsec(YabauseGetTicks() - t);
+      if (frame == 0 || usec < result->usec)
+         result->usec = usec;
+   }
+
+   result->hash = HashMachine();
+   result->jobs = MappedMemoryReadLong(JOB_ADDR + 8, NULL);
+   result->wrong = MappedMemoryReadLong(JOB_ADDR + 12, NULL);
+
+   YabauseDeInit();
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int TestSame(const Setup *setup, u32 quantum, int frames)
+{
+   Result serial, threaded;
+
+   if (Run(setup, 0, quantum, frames, &serial) != 0 || Run(setup, 1, quantum, frames, &threaded) != 0)
+      return 1;
+
+   if (serial.hash != threaded.hash)
+   {
+      printf("%s, quantum %u: threaded run differs from the serial one\n", setup->name,
+         (unsigned)quantum);
+      return 1;
+   }
+   return 0;
+}
+
+static int TestDeterministic(const Setup *setup, u32 quantum, int frames, Result *first)
+{
+   Result second;
+
+   if (Run(setup, 1, quantum, frames, first) != 0 || Run(setup, 1, quantum, frames, &second) != 0)
+      return 1;
+
+   if (first->hash != second.hash)
+   {
+      printf("%s, quantum %u: two threaded runs differ\n", setup->name, (unsigned)quantum);
+      return 1;
+   }
+   return 0;
+}
+
+static int TestHandshake(int frames)
+{
+   Result serial, threaded;
+   int failed = 0;
+
+   if (Run(&handshake, 0, 0, frames, &serial) != 0)
+      return 1;
+   failed += TestDeterministic(&handshake, 0, frames, &threaded);
+
+   printf("handshake: %u jobs serial, %u threaded\n", (unsigned)serial.jobs, (unsigned)threaded.jobs);
+   if (serial.jobs == 0 || threaded.jobs == 0)
+   {
+      printf("handshake: no jobs done\n");
+      failed++;
+   }
+   else if (serial.jobs != threaded.jobs)
+   {
+      printf("handshake: threaded run did a different number of jobs\n");
+      failed++;
+   }
+   if (serial.wrong != 0 || threaded.wrong != 0)
+   {
+      printf("handshake: %u wrong results serial, %u threaded\n", (unsigned)serial.wrong,
+         (unsigned)threaded.wrong);
+      failed++;
+   }
+
+   return failed;
+}
+
+static int ReportSpeed(const Setup *setup, int frames)
+{
+   Result serial, threaded;
+
+   if (Run(setup, 0, 0, frames, &serial) != 0 || Run(setup, 1, 0, frames, &threaded) != 0)
+      return 1;
+
+   printf("%s: frame %.1f us serial, %.1f us threaded (%.2fx)", setup->name, serial.usec,
+      threaded.usec, threaded.usec > 0 ? serial.usec / threaded.usec : 0.0);
+   if (setup->master == fill_program)
+   {
+      printf("\n");
+      return 0;
+   }
+
+   printf(", %u jobs serial, %u threaded\n", (unsigned)serial.jobs, (unsigned)threaded.jobs);
+   if (serial.jobs == 0 || threaded.jobs == 0 || serial.wrong != 0 || threaded.wrong != 0)
+   {
+      printf("%s: no jobs done or wrong results\n", setup->name);
+      return 1;
+   }
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+   Result result;
+   int frames = 4;
+   int failed = 0;
+
+   printf("%s v%s\n", PROG_NAME, VER_NAME);
+
+   if (argc > 1)
+      frames = atoi(argv[1]);
+   if (frames <= 0)
+      frames = 4;
+
+   failed += TestSame(&independent, 0, frames);
+   failed += TestSame(&independent, 1, frames);
+   failed += TestSame(&independent, 100000, frames);
+   failed += TestSame(&vdp2, 1, frames);
+   failed += TestDeterministic(&vdp2, 0, frames, &result);
+   failed += TestHandshake(frames);
+   failed += ReportSpeed(&independent, frames);
+   failed += ReportSpeed(&slave_heavy, frames);
+
+   printf("%s\n", failed ? "FAIL" : "OK");
+   return failed ? 1 : 0;
+}
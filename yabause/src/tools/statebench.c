@@ -0,0 +1,291 @@
+/*******************************************************************************
+  STATEBENCH - Yabause save state latency benchmark
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+*******************************************************************************/
+
+// Boots the core headless, runs a few frames and then measures how long each
+// subsystem takes to save and load its state through an in-memory stream, as
+// well as the full YabSaveStateBuffer/YabLoadStateBuffer round trip.
+
+// example: statebench [bios path] [cd image path] [iterations]
+// Without a cd image a small program runs instead of the bios.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../core.h"
+#include "../yabause.h"
+#include "../yui.h"
+#include "../memory.h"
+#include "../cdbase.h"
+#include "../cs0.h"
+#include "../cs2.h"
+#include "../m68kcore.h"
+#include "../peripheral.h"
+#include "../sh2core.h"
+#include "../sh2int.h"
+#include "../scsp.h"
+#include "../scu.h"
+#include "../smpc.h"
+#include "../vdp1.h"
+#include "../vdp2.h"
+#include "toolutil.h"
+
+#define PROG_NAME "STATEBENCH"
+#define VER_NAME "1.0"
+
+#define PROGRAM_ADDR 0x06004000
+#define SAVE_FILE "statebench.yss"
+
+SH2Interface_struct *SH2CoreList[] = {
+   &SH2Interpreter,
+   NULL
+};
+
+PerInterface_struct *PERCoreList[] = {
+   &PERDummy,
+   NULL
+};
+
+CDInterface *CDCoreList[] = {
+   &DummyCD,
+   &ISOCD,
+   NULL
+};
+
+SoundInterface_struct *SNDCoreList[] = {
+   &SNDDummy,
+   NULL
+};
+
+VideoInterface_struct *VIDCoreList[] = {
+   &VIDDummy,
+   NULL
+};
+
+M68K_struct * M68KCoreList[] = {
+   &M68KDummy,
+   NULL
+};
+
+void YuiErrorMsg(const char *string) { printf("Error: %s\n", string); }
+
+void YuiSwapBuffers() { }
+
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct
+{
+   const char *name;
+   int (*save)(FILE *fp);
+   int (*load)(FILE *fp, int version, int size);
+   double save_usec;
+   double load_usec;
+   size_t bytes;
+} Subsystem;
+
+static int MSH2SaveState(FILE *fp) { return SH2SaveState(MSH2, fp); }
+static int MSH2LoadState(FILE *fp, int version, int size) { return SH2LoadState(MSH2, fp, version, size); }
+static int SSH2SaveState(FILE *fp) { return SH2SaveState(SSH2, fp); }
+static int SSH2LoadState(FILE *fp, int version, int size) { return SH2LoadState(SSH2, fp, version, size); }
+
+static Subsystem subsystems[] = {
+   { "CART", CartSaveState, CartLoadState },
+   { "CS2 ", Cs2SaveState, Cs2LoadState },
+   { "MSH2", MSH2SaveState, MSH2LoadState },
+   { "SSH2", SSH2SaveState, SSH2LoadState },
+   { "SCSP", SoundSaveState, SoundLoadState },
+   { "SCU ", ScuSaveState, ScuLoadState },
+   { "SMPC", SmpcSaveState, SmpcLoadState },
+   { "VDP1", Vdp1SaveState, Vdp1LoadState },
+   { "VDP2", Vdp2SaveState, Vdp2LoadState },
+};
+
+#define NUM_SUBSYSTEMS (sizeof(subsystems) / sizeof(subsystems[0]))
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int BenchSubsystems(int iterations)
+{
+   YabMemStream ms;
+   FILE *fp;
+   int i, n;
+
+   for (n = 0; n < iterations; n++)
+   {
+      if (YabMemStreamInit(&ms, 0x400000) != 0)
+         return -1;
+      if ((fp = YabMemStreamOpen(&ms, "wb+")) == NULL)
+      {
+         printf("in-memory streams are not supported on this platform\n");
+         YabMemStreamFree(&ms);
+         return -1;
+      }
+
+      for (i = 0; i < NUM_SUBSYSTEMS; i++)
+      {
+         long start = ftell(fp);
+         s64 t = YabauseGetTicks();
+         subsystems[i].save(fp);
+         subsystems[i].save_usec += TicksToUsec(YabauseGetTicks() - t);
+         subsystems[i].bytes = ftell(fp) - start;
+      }
+
+      fseek(fp, 0, SEEK_SET);
+
+      for (i = 0; i < NUM_SUBSYSTEMS; i++)
+      {
+         int version, size;
+         s64 t;
+
+         if (StateCheckRetrieveHeader(fp, subsystems[i].name, &version, &size) != 0)
+         {
+            printf("%s: bad chunk header\n", subsystems[i].name);
+            fclose(fp);
+            YabMemStreamFree(&ms);
+            return -1;
+         }
+         t = YabauseGetTicks();
+         subsystems[i].load(fp, version, size);
+         subsystems[i].load_usec += TicksToUsec(YabauseGetTicks() - t);
+      }
+
+      fclose(fp);
+      YabMemStreamFree(&ms);
+   }
+
+   printf("%-6s %10s %12s %12s\n", "chunk", "bytes", "save(us)", "load(us)");
+   for (i = 0; i < NUM_SUBSYSTEMS; i++)
+   {
+      printf("%-6s %10u %12.1f %12.1f\n", subsystems[i].name, (unsigned)subsystems[i].bytes,
+         subsystems[i].save_usec / iterations, subsystems[i].load_usec / iterations);
+   }
+
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int BenchFullState(int iterations)
+{
+   double save_usec = 0, load_usec = 0;
+   void *buffer;
+   size_t size = 0;
+   int n;
+
+   for (n = 0; n < iterations; n++)
+   {
+      s64 t = YabauseGetTicks();
+      if (YabSaveStateBuffer(&buffer, &size) != 0)
+         return -1;
+      save_usec += TicksToUsec(YabauseGetTicks() - t);
+
+      t = YabauseGetTicks();
+      if (YabLoadStateBuffer(buffer, size) != 0)
+      {
+         free(buffer);
+         return -1;
+      }
+      load_usec += TicksToUsec(YabauseGetTicks() - t);
+      free(buffer);
+   }
+
+   printf("%-6s %10u %12.1f %12.1f\n", "TOTAL", (unsigned)size,
+      save_usec / iterations, load_usec / iterations);
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+   yabauseinit_struct yinit;
+   int iterations = 100;
+   FILE *fp;
+   int i;
+
+   printf("%s v%s\n", PROG_NAME, VER_NAME);
+
+   memset(&yinit, 0, sizeof(yinit));
+   yinit.percoretype = PERCORE_DUMMY;
+   yinit.sh2coretype = SH2CORE_INTERPRETER;
+   yinit.vidcoretype = VIDCORE_DUMMY;
+   yinit.m68kcoretype = M68KCORE_DUMMY;
+   yinit.sndcoretype = SNDCORE_DUMMY;
+   yinit.cdcoretype = CDCORE_DUMMY;
+   yinit.carttype = CART_NONE;
+   yinit.regionid = REGION_AUTODETECT;
+   yinit.videoformattype = VIDEOFORMATTYPE_NTSC;
+   yinit.framelimit = 1;
+   yinit.scsp_main_mode = 1; // the sound thread runs on its own, as in libretro
+
+   if (argc > 1 && argv[1][0] != '\0')
+      yinit.biospath = argv[1];
+   if (argc > 2 && argv[2][0] != '\0')
+   {
+      yinit.cdcoretype = CDCORE_ISO;
+      yinit.cdpath = argv[2];
+   }
+   else
+      yinit.skip_load = 1; // the emulated bios refuses to start without a game
+   if (argc > 3)
+      iterations = atoi(argv[3]);
+   if (iterations <= 0)
+      iterations = 1;
+
+   if (YabauseInit(&yinit) != 0)
+   {
+      printf("YabauseInit failed\n");
+      return 1;
+   }
+
+   if (yinit.skip_load)
+      LoadCounterProgram(PROGRAM_ADDR);
+
+   // Get the machine into a non trivial state before measuring
+   for (i = 0; i < 120; i++)
+      YabauseEmulate();
+
+   if (BenchSubsystems(iterations) != 0 || BenchFullState(iterations) != 0)
+   {
+      YabauseDeInit();
+      return 1;
+   }
+
+   // A save still being written at shutdown has to be finished by
+   // YabauseDeInit, not dropped
+   if (YabSaveCompressedState(SAVE_FILE) != 0)
+   {
+      printf("YabSaveCompressedState failed\n");
+      YabauseDeInit();
+      return 1;
+   }
+   YabauseDeInit();
+   fp = fopen(SAVE_FILE, "rb");
+   if (fp == NULL || fseek(fp, 0, SEEK_END) != 0 || ftell(fp) <= 0)
+   {
+      printf("compressed save not written by YabauseDeInit\n");
+      if (fp != NULL)
+         fclose(fp);
+      remove(SAVE_FILE);
+      return 1;
+   }
+   fclose(fp);
+   remove(SAVE_FILE);
+   printf("compressed save written by YabauseDeInit: OK\n");
+   return 0;
+}
@@ -0,0 +1,266 @@
+/*******************************************************************************
+  STATEDETTEST - Yabause save state determinism tester
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+*******************************************************************************/
+
+// Takes a fixed size state the way the libretro core does, runs some frames
+// while hashing the RAM areas after each one, loads the state back and runs
+// the same frames again. Every hash must match, and saving twice at the same
+// point must give the same bytes. Also reports how long a capture takes,
+// run-ahead pays for one save and one load every frame. The sound thread
+// keeps its own time like in libretro, so the SCSP chunk of a state taken
+// after a load isn't expected to match the one loaded.
+
+// example: statedettest [bios path] [cd image path] [frames]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../core.h"
+#include "../yabause.h"
+#include "../yui.h"
+#include "../memory.h"
+#include "../cdbase.h"
+#include "../cs0.h"
+#include "../m68kcore.h"
+#include "../peripheral.h"
+#include "../sh2core.h"
+#include "../sh2int.h"
+#include "../scsp.h"
+#include "../smpc.h"
+#include "../vdp1.h"
+#include "../vdp2.h"
+#include "toolutil.h"
+
+#define PROG_NAME "STATEDETTEST"
+#define VER_NAME "1.0"
+
+#define MAX_FRAMES 600
+#define PROGRAM_ADDR 0x06004000
+
+SH2Interface_struct *SH2CoreList[] = {
+   &SH2Interpreter,
+   NULL
+};
+
+PerInterface_struct *PERCoreList[] = {
+   &PERDummy,
+   NULL
+};
+
+CDInterface *CDCoreList[] = {
+   &DummyCD,
+   &ISOCD,
+   NULL
+};
+
+SoundInterface_struct *SNDCoreList[] = {
+   &SNDDummy,
+   NULL
+};
+
+VideoInterface_struct *VIDCoreList[] = {
+   &VIDDummy,
+   NULL
+};
+
+M68K_struct * M68KCoreList[] = {
+   &M68KDummy,
+   NULL
+};
+
+void YuiErrorMsg(const char *string) { printf("Error: %s\n", string); }
+
+void YuiSwapBuffers() { }
+
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct
+{
+   const char *name;
+   u8 **ptr;
+   u32 size;
+} Region;
+
+static Region regions[] = {
+   { "HighWram", &HighWram, 0x100000 },
+   { "LowWram", &LowWram, 0x100000 },
+   { "Vdp1Ram", &Vdp1Ram, 0x80000 },
+   { "Vdp2Ram", &Vdp2Ram, 0x80000 },
+   { "Vdp2ColorRam", &Vdp2ColorRam, 0x1000 },
+   { "SoundRam", &SoundRam, 0x80000 },
+};
+
+#define NUM_REGIONS (sizeof(regions) / sizeof(regions[0]))
+
+static u64 hashes[MAX_FRAMES][NUM_REGIONS];
+
+static void HashFrame(u64 *out)
+{
+   int i;
+
+   for (i = 0; i < NUM_REGIONS; i++)
+      out[i] = Hash(HASH_INIT, *regions[i].ptr, regions[i].size);
+}
+
+static int CompareFrame(int frame, const u64 *expected)
+{
+   u64 h[NUM_REGIONS];
+   int i, ret = 0;
+
+   HashFrame(h);
+   for (i = 0; i < NUM_REGIONS; i++)
+   {
+      if (h[i] != expected[i])
+      {
+         printf("frame %d: %s differs\n", frame, regions[i].name);
+         ret = -1;
+      }
+   }
+
+   return ret;
+}
+
+static int CompareUsec(const void *a, const void *b)
+{
+   double x = *(const double *)a, y = *(const double *)b;
+   return (x > y) - (x < y);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+   yabauseinit_struct yinit;
+   size_t size;
+   u8 *state, *again;
+   s64 t;
+   static double save_usec[MAX_FRAMES], load_usec[MAX_FRAMES];
+   int frames = 120;
+   int frame, i, failed = 0;
+
+   printf("%s v%s\n", PROG_NAME, VER_NAME);
+
+   memset(&yinit, 0, sizeof(yinit));
+   yinit.percoretype = PERCORE_DUMMY;
+   yinit.sh2coretype = SH2CORE_INTERPRETER;
+   yinit.vidcoretype = VIDCORE_DUMMY;
+   yinit.m68kcoretype = M68KCORE_DUMMY;
+   yinit.sndcoretype = SNDCORE_DUMMY;
+   yinit.cdcoretype = CDCORE_DUMMY;
+   yinit.carttype = CART_NONE;
+   yinit.regionid = REGION_AUTODETECT;
+   yinit.videoformattype = VIDEOFORMATTYPE_NTSC;
+   yinit.framelimit = 1;
+   yinit.scsp_main_mode = 1; // the sound thread runs on its own, as in libretro
+
+   if (argc > 1 && argv[1][0] != '\0')
+      yinit.biospath = argv[1];
+   if (argc > 2 && argv[2][0] != '\0')
+   {
+      yinit.cdcoretype = CDCORE_ISO;
+      yinit.cdpath = argv[2];
+   }
+   else
+      yinit.skip_load = 1; // the emulated bios refuses to start without a game
+   if (argc > 3)
+      frames = atoi(argv[3]);
+   if (frames <= 0 || frames > MAX_FRAMES)
+      frames = 120;
+
+   if (YabauseInit(&yinit) != 0)
+   {
+      printf("YabauseInit failed\n");
+      return 1;
+   }
+
+   if (yinit.skip_load)
+      LoadCounterProgram(PROGRAM_ADDR);
+
+   for (frame = 0; frame < 60; frame++)
+      YabauseEmulate();
+
+   size = YabSaveStateMaxSize();
+   if (size == 0 || YabSaveStateMaxSize() != size)
+   {
+      printf("bad state size %u\n", (unsigned)size);
+      return 1;
+   }
+   state = (u8 *)malloc(size);
+   again = (u8 *)malloc(size);
+
+   if (YabSaveStateFixed(state, size) != 0 || YabSaveStateFixed(again, size) != 0)
+   {
+      printf("YabSaveStateFixed failed\n");
+      return 1;
+   }
+   if (memcmp(state, again, size) != 0)
+   {
+      printf("two saves of the same frame differ\n");
+      failed++;
+   }
+   if (YabSaveStateFixed(again, 0x1000) == 0)
+   {
+      printf("a state was written into a buffer too small for it\n");
+      failed++;
+   }
+
+   for (frame = 0; frame < frames; frame++)
+   {
+      YabauseEmulate();
+      HashFrame(hashes[frame]);
+   }
+
+   if (YabLoadStateFixed(state, size) != 0)
+   {
+      printf("YabLoadStateFixed failed\n");
+      return 1;
+   }
+
+   for (frame = 0; frame < frames; frame++)
+   {
+      YabauseEmulate();
+      if (CompareFrame(frame, hashes[frame]) != 0)
+         failed++;
+   }
+
+   // one save and one load per frame, what run-ahead costs
+   for (i = 0; i < frames; i++)
+   {
+      t = YabauseGetTicks();
+      YabSaveStateFixed(state, size);
+      save_usec[i] = TicksToUsec(YabauseGetTicks() - t);
+
+      t = YabauseGetTicks();
+      YabLoadStateFixed(state, size);
+      load_usec[i] = TicksToUsec(YabauseGetTicks() - t);
+
+      YabauseEmulate();
+   }
+
+   // the median, a frame the scheduler took away says nothing about capture
+   qsort(save_usec, frames, sizeof(double), CompareUsec);
+   qsort(load_usec, frames, sizeof(double), CompareUsec);
+   printf("%u byte states, %d frames replayed, save %.1f us, load %.1f us\n",
+      (unsigned)size, frames, save_usec[frames / 2], load_usec[frames / 2]);
+   printf("%s\n", failed ? "FAIL" : "OK");
+
+   free(state);
+   free(again);
+   YabauseDeInit();
+   return failed ? 1 : 0;
+}
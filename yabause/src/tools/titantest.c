@@ -0,0 +1,314 @@
+/*******************************************************************************
+  TITANTEST - Yabause Titan compositor tester
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+*******************************************************************************/
+
+// Checks that the batched Titan compositor is pixel exact against the per
+// pixel reference. Random layers are composited in every blending mode with
+// and without sprite self-shadowing. When a bios or a cd image is given the
+// software renderer also runs the game and every frame it drew is composited
+// again with both compositors and compared.
+
+// example: titantest [bios path] [cd image path] [frames]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../core.h"
+#include "../yabause.h"
+#include "../yui.h"
+#include "../cdbase.h"
+#include "../cs0.h"
+#include "../m68kcore.h"
+#include "../peripheral.h"
+#include "../sh2core.h"
+#include "../sh2int.h"
+#include "../scsp.h"
+#include "../vdp1.h"
+#include "../vdp2.h"
+#include "../vidsoft.h"
+#include "../titan/titan.h"
+
+#define PROG_NAME "TITANTEST"
+#define VER_NAME "1.0"
+
+#define NUM_ROUNDS 8
+#define BENCH_RENDERS 50
+
+SH2Interface_struct *SH2CoreList[] = {
+   &SH2Interpreter,
+   NULL
+};
+
+PerInterface_struct *PERCoreList[] = {
+   &PERDummy,
+   NULL
+};
+
+CDInterface *CDCoreList[] = {
+   &DummyCD,
+   &ISOCD,
+   NULL
+};
+
+SoundInterface_struct *SNDCoreList[] = {
+   &SNDDummy,
+   NULL
+};
+
+VideoInterface_struct *VIDCoreList[] = {
+   &VIDDummy,
+   &VIDSoft,
+   NULL
+};
+
+M68K_struct * M68KCoreList[] = {
+   &M68KDummy,
+   NULL
+};
+
+void YuiErrorMsg(const char *string) { printf("Error: %s\n", string); }
+
+void YuiSwapBuffers() { }
+
+static pixel_t reference[704 * 512];
+static pixel_t batch[704 * 512];
+
+//////////////////////////////////////////////////////////////////////////////
+
+static u32 RandomPixel(void)
+{
+   u32 pixel = ((u32)rand() << 16) ^ (u32)rand();
+
+   // favor opaque and fully black pixels, they take different paths
+   switch (rand() % 4)
+   {
+   case 0: return pixel | 0x3F000000;
+   case 1: return pixel & 0xFF000000;
+   default: return pixel;
+   }
+}
+
+static void FillRandomLayers(int width, int height)
+{
+   vdp2draw_struct info;
+   int layer, x, y;
+
+   memset(&info, 0, sizeof(info));
+   TitanErase();
+
+   for (y = 0; y < height; y++)
+   {
+      TitanPutBackHLine(y, RandomPixel());
+      TitanPutLineHLine(1 + rand() % 3, y, RandomPixel());
+   }
+
+   for (layer = 0; layer <= TITAN_SPRITE; layer++)
+   {
+      info.titan_which_layer = layer;
+
+      for (y = 0; y < height; y++)
+      {
+         for (x = 0; x < width; x++)
+         {
+            // leave some holes so the back screen shows through
+            if (rand() % 4 == 0)
+               continue;
+
+            info.titan_shadow_type = rand() % 3;
+            info.titan_shadow_enabled = rand() % 2;
+            TitanPutPixel(rand() % 8, x, y, RandomPixel(), rand() % 4, &info);
+         }
+      }
+   }
+}
+
+static int CompareFrames(int width, int height, const char *what)
+{
+   int i;
+
+   TitanSetCompositor(TITAN_COMPOSITOR_REFERENCE);
+   TitanRender(reference);
+   TitanSetCompositor(TITAN_COMPOSITOR_BATCH);
+   TitanRender(batch);
+
+   for (i = 0; i < width * height; i++)
+   {
+      if (reference[i] != batch[i])
+      {
+         printf("%s: mismatch at x=%d y=%d, reference 0x%08X batch 0x%08X\n",
+            what, i % width, i / width, (u32)reference[i], (u32)batch[i]);
+         return -1;
+      }
+   }
+
+   return 0;
+}
+
+static double TimeRenders(int compositor, pixel_t *buffer)
+{
+   s64 t;
+   int i;
+
+   TitanSetCompositor(compositor);
+   t = YabauseGetTicks();
+   for (i = 0; i < BENCH_RENDERS; i++)
+      TitanRender(buffer);
+   return (double)(YabauseGetTicks() - t) * 1000000.0 / (double)yabsys.tickfreq / BENCH_RENDERS;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int TestRandomLayers(void)
+{
+   static const int blend_modes[] = { TITAN_BLEND_TOP, TITAN_BLEND_BOTTOM, TITAN_BLEND_ADD };
+   static const int widths[] = { 320, 352, 704 };
+   u16 ccctl = Vdp2Regs->CCCTL;
+   u16 spctl = Vdp2Regs->SPCTL;
+   int failed = 0;
+   int mode, round;
+
+   // color calculation forces the full priority path, the simplified one
+   // does not go through the compositor
+   Vdp2Regs->CCCTL = 1;
+
+   for (mode = 0; mode < 3; mode++)
+   {
+      TitanSetBlendingMode(blend_modes[mode]);
+
+      for (round = 0; round < NUM_ROUNDS; round++)
+      {
+         char what[64];
+         int width = widths[round % 3];
+
+         Vdp2Regs->SPCTL = (round & 1) ? 0x10 : 0;
+         TitanSetResolution(width, 224);
+         FillRandomLayers(width, 224);
+
+         sprintf(what, "blend %d round %d", blend_modes[mode], round);
+         if (CompareFrames(width, 224, what) != 0)
+            failed++;
+      }
+
+      printf("blend mode %d: reference %.1f us, batch %.1f us per frame\n", blend_modes[mode],
+         TimeRenders(TITAN_COMPOSITOR_REFERENCE, reference), TimeRenders(TITAN_COMPOSITOR_BATCH, batch));
+   }
+
+   Vdp2Regs->CCCTL = ccctl;
+   Vdp2Regs->SPCTL = spctl;
+   return failed;
+}
+
+static int TestCapturedFrames(int frames)
+{
+   int failed = 0;
+   int frame;
+
+   for (frame = 0; frame < frames; frame++)
+   {
+      char what[32];
+      u16 ccctl;
+      int width, height;
+
+      YabauseEmulate();
+
+      // the layers of the frame just drawn are kept until the next one starts
+      TitanGetResolution(&width, &height);
+      ccctl = Vdp2Regs->CCCTL;
+      Vdp2Regs->CCCTL |= 1;
+      sprintf(what, "frame %d", frame);
+      if (CompareFrames(width, height, what) != 0)
+         failed++;
+      Vdp2Regs->CCCTL = ccctl;
+   }
+
+   printf("%d captured frames compared, %d mismatched\n", frames, failed);
+   return failed;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+   yabauseinit_struct yinit;
+   int frames = 600;
+   int captured = 0;
+   int failed;
+
+   printf("%s v%s\n", PROG_NAME, VER_NAME);
+
+   memset(&yinit, 0, sizeof(yinit));
+   yinit.percoretype = PERCORE_DUMMY;
+   yinit.sh2coretype = SH2CORE_INTERPRETER;
+   yinit.vidcoretype = VIDCORE_DUMMY;
+   yinit.m68kcoretype = M68KCORE_DUMMY;
+   yinit.sndcoretype = SNDCORE_DUMMY;
+   yinit.cdcoretype = CDCORE_DUMMY;
+   yinit.carttype = CART_NONE;
+   yinit.regionid = REGION_AUTODETECT;
+   yinit.videoformattype = VIDEOFORMATTYPE_NTSC;
+   yinit.framelimit = 1;
+
+   if (argc > 1 && argv[1][0] != '\0')
+   {
+      yinit.biospath = argv[1];
+      captured = 1;
+   }
+   if (argc > 2 && argv[2][0] != '\0')
+   {
+      yinit.cdcoretype = CDCORE_ISO;
+      yinit.cdpath = argv[2];
+      captured = 1;
+   }
+   if (argc > 3)
+      frames = atoi(argv[3]);
+
+   if (captured)
+      yinit.vidcoretype = VIDCORE_SOFT;
+   else
+      yinit.skip_load = 1; // the emulated bios refuses to start without a game
+
+   if (YabauseInit(&yinit) != 0)
+   {
+      printf("YabauseInit failed\n");
+      return 1;
+   }
+
+   if (TitanSetCompositor(TITAN_COMPOSITOR_BATCH) != 0)
+   {
+      printf("batched compositor not available on this target\n");
+      YabauseDeInit();
+      return 0;
+   }
+
+   if (!captured && TitanInit() != 0)
+   {
+      printf("TitanInit failed\n");
+      return 1;
+   }
+
+   srand(1);
+   failed = TestRandomLayers();
+
+   if (captured)
+      failed += TestCapturedFrames(frames);
+
+   printf("%s\n", failed ? "FAIL" : "OK");
+
+   YabauseDeInit();
+   return failed ? 1 : 0;
+}
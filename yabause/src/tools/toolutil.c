@@ -0,0 +1,108 @@
+/*******************************************************************************
+  TOOLUTIL - helpers shared by the Yabause tool tests
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+*******************************************************************************/
+
+#include "toolutil.h"
+#include "../yabause.h"
+#include "../memory.h"
+#include "../vdp2.h"
+
+//////////////////////////////////////////////////////////////////////////////
+
+u64 Hash(u64 h, const u8 *p, u32 size)
+{
+   u32 i;
+
+   for (i = 0; i < size; i++)
+      h = (h ^ p[i]) * 0x100000001B3ULL;
+   return h;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+u64 HashMachine(void)
+{
+   sh2regs_struct regs;
+   u64 h = HASH_INIT;
+
+   h = Hash(h, HighWram, 0x100000);
+   h = Hash(h, LowWram, 0x100000);
+   h = Hash(h, Vdp2Ram, 0x80000);
+   SH2GetRegisters(MSH2, &regs);
+   h = Hash(h, (const u8 *)regs.R, sizeof(regs.R));
+   h = Hash(h, (const u8 *)&regs.PC, sizeof(regs.PC));
+   SH2GetRegisters(SSH2, &regs);
+   h = Hash(h, (const u8 *)regs.R, sizeof(regs.R));
+   h = Hash(h, (const u8 *)&regs.PC, sizeof(regs.PC));
+   return h;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void LoadProgram(SH2_struct *context, u32 addr, const u16 *program, int len, const u32 *r)
+{
+   sh2regs_struct regs;
+   int i;
+
+   for (i = 0; i < len; i++)
+      MappedMemoryWriteWord(addr + i * 2, program[i], NULL);
+
+   SH2GetRegisters(context, &regs);
+   for (i = 0; i < 8; i++)
+      regs.R[i] = r[i];
+   regs.R[15] = context == MSH2 ? 0x06002000 : 0x06001000;
+   regs.PC = addr;
+   regs.SR.all = 0xF0;
+   SH2SetRegisters(context, &regs);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void LoadCounterProgram(u32 addr)
+{
+   enum { LIT_WRAM = 16, LIT_VDP2 = 18, LIT_MASK = 20 };
+   static const u16 program[14] = {
+      0xD107,     // mov.l @(LIT_WRAM),r1
+      0xD408,     // mov.l @(LIT_VDP2),r4
+      0xE200,     // mov #0,r2
+      0xD508,     // mov.l @(LIT_MASK),r5
+      0xE300,     // mov #0,r3
+      0x7201,     // loop: add #1,r2
+      0x6033,     // mov r3,r0
+      0x0126,     // mov.l r2,@(r0,r1)
+      0x0426,     // mov.l r2,@(r0,r4)
+      0x7304,     // add #4,r3
+      0x2359,     // and r5,r3
+      0xAFF8,     // bra loop
+      0x0009,     // nop
+      0x0009,
+   };
+   static const u32 r[8] = { 0 };
+
+   LoadProgram(MSH2, addr, program, 14, r);
+   MappedMemoryWriteLong(addr + LIT_WRAM * 2, 0x06010000, NULL);
+   MappedMemoryWriteLong(addr + LIT_VDP2 * 2, 0x25E00000, NULL);
+   MappedMemoryWriteLong(addr + LIT_MASK * 2, 0x0000FFFC, NULL);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+double TicksToUsec(s64 ticks)
+{
+   return (double)ticks * 1000000.0 / (double)yabsys.tickfreq;
+}
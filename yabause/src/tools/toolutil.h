@@ -0,0 +1,45 @@
+/*******************************************************************************
+  TOOLUTIL - helpers shared by the Yabause tool tests
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+*******************************************************************************/
+
+#ifndef TOOLUTIL_H
+#define TOOLUTIL_H
+
+#include "../core.h"
+#include "../sh2core.h"
+
+#define HASH_INIT 0xCBF29CE484222325ULL
+
+// Hash: FNV-1a of size bytes at p, going on from h
+u64 Hash(u64 h, const u8 *p, u32 size);
+
+// HashMachine: both work rams, VDP2 ram and the registers and PC of both cpus
+u64 HashMachine(void);
+
+// LoadProgram: copy len words of program to addr and start context there
+// with r0-r7 from r, its stack below the program and interrupts masked
+void LoadProgram(SH2_struct *context, u32 addr, const u16 *program, int len, const u32 *r);
+
+// LoadCounterProgram: what the master runs without a game, a counter stored
+// over a 64KB window of work ram and VDP2 ram, so every frame leaves
+// different bytes behind
+void LoadCounterProgram(u32 addr);
+
+double TicksToUsec(s64 ticks);
+
+#endif
@@ -0,0 +1,409 @@
+/*******************************************************************************
+  TRACETEST - Yabause timeline tracer tester
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+*******************************************************************************/
+
+// Records nested events from several threads at once, writes the Chrome
+// trace and reads it back: every event must be there, each thread under
+// its own name, begins and ends paired and time going forward. A ring that
+// overflows must keep its newest events and still write a trace that
+// nests. Then measures an event and counts the events a few emulated
+// frames record, the tracer has to stay under 1% of a 60Hz frame.
+
+// example: tracetest [trace file]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../core.h"
+#include "../yabause.h"
+#include "../yui.h"
+#include "../memory.h"
+#include "../cdbase.h"
+#include "../cs0.h"
+#include "../m68kcore.h"
+#include "../peripheral.h"
+#include "../sh2core.h"
+#include "../sh2int.h"
+#include "../scsp.h"
+#include "../threads.h"
+#include "../trace.h"
+#include "../vdp1.h"
+#include "../vdp2.h"
+#include "toolutil.h"
+
+#define PROG_NAME "TRACETEST"
+#define VER_NAME "1.0"
+
+#define THREADS 4
+#define PAIRS 5000
+#define RING_EVENTS 65536           // TRACE_EVENTS in trace.cpp
+#define BENCH_PAIRS 1000000
+#define FRAMES 3
+#define PROGRAM_ADDR 0x06004000
+
+SH2Interface_struct *SH2CoreList[] = {
+   &SH2Interpreter,
+   NULL
+};
+
+PerInterface_struct *PERCoreList[] = {
+   &PERDummy,
+   NULL
+};
+
+CDInterface *CDCoreList[] = {
+   &DummyCD,
+   NULL
+};
+
+SoundInterface_struct *SNDCoreList[] = {
+   &SNDDummy,
+   NULL
+};
+
+VideoInterface_struct *VIDCoreList[] = {
+   &VIDDummy,
+   NULL
+};
+
+M68K_struct * M68KCoreList[] = {
+   &M68KDummy,
+   NULL
+};
+
+void YuiErrorMsg(const char *string) { printf("Error: %s\n", string); }
+
+void YuiSwapBuffers() { }
+
+//////////////////////////////////////////////////////////////////////////////
+
+static const char *filename = "tracetest.json";
+
+static void Record(int pairs)
+{
+   int i;
+
+   for (i = 0; i < pairs; i++)
+   {
+      TRACE_BEGIN(TRACE_FRAME);
+      TRACE_BEGIN(TRACE_VIDSOFT_LAYER);
+      TRACE_END(TRACE_VIDSOFT_LAYER);
+      TRACE_END(TRACE_FRAME);
+   }
+}
+
+static void *Worker(void *arg)
+{
+   char name[32];
+
+   sprintf(name, "worker %d", (int)(pointer)arg);
+   TraceThreadName(name);
+   Record(PAIRS);
+   return NULL;
+}
+
+typedef struct
+{
+   int begins;
+   int ends;
+   int unpaired;       // an end with nothing open
+   int backwards;      // a time stamp before the one above it
+   int names;
+   char name_found[THREADS + 1];
+} Summary;
+
+// The writer puts one event per line, which keeps this from needing a
+// JSON parser
+static int ReadTrace(Summary *sum)
+{
+   static int depth[256];
+   static double last[256];
+   char line[512];
+   FILE *fp;
+   int i;
+
+   memset(sum, 0, sizeof(*sum));
+   memset(depth, 0, sizeof(depth));
+   for (i = 0; i < 256; i++)
+      last[i] = -1.0;
+
+   if ((fp = fopen(filename, "r")) == NULL)
+      return -1;
+
+   if (fgets(line, sizeof(line), fp) == NULL || strncmp(line, "{", 1) != 0)
+   {
+      fclose(fp);
+      return -1;
+   }
+
+   while (fgets(line, sizeof(line), fp) != NULL)
+   {
+      char *p;
+      int tid = 0;
+      double ts = 0;
+
+      if ((p = strstr(line, "\"tid\":")) != NULL)
+         tid = atoi(p + 6) & 0xFF;
+
+      if (strstr(line, "\"ph\":\"M\"") != NULL)
+      {
+         sum->names++;
+         for (i = 0; i < THREADS; i++)
+         {
+            char name[32];
+            sprintf(name, "\"worker %d\"", i);
+            if (strstr(line, name) != NULL)
+               sum->name_found[i] = 1;
+         }
+         if (strstr(line, "\"main\"") != NULL)
+            sum->name_found[THREADS] = 1;
+         continue;
+      }
+
+      if ((p = strstr(line, "\"ts\":")) != NULL)
+         ts = atof(p + 5);
+      if (ts < last[tid])
+         sum->backwards++;
+      last[tid] = ts;
+
+      if (strstr(line, "\"ph\":\"B\"") != NULL)
+      {
+         sum->begins++;
+         depth[tid]++;
+      }
+      else if (strstr(line, "\"ph\":\"E\"") != NULL)
+      {
+         sum->ends++;
+         if (--depth[tid] < 0)
+         {
+            sum->unpaired++;
+            depth[tid] = 0;
+         }
+      }
+   }
+
+   fclose(fp);
+   return 0;
+}
+
+static int TestThreads(void)
+{
+   Summary sum;
+   int i, failed = 0, expected = (THREADS + 1) * PAIRS * 4;
+
+   TraceStart();
+   for (i = 0; i < THREADS; i++)
+      YabThreadStart(YAB_THREAD_VIDSOFT_WORKER_0 + i, "trace worker", Worker, (void *)(pointer)i);
+   TraceThreadName("main");
+   Record(PAIRS);
+   for (i = 0; i < THREADS; i++)
+      YabThreadWait(YAB_THREAD_VIDSOFT_WORKER_0 + i);
+   TraceStop();
+
+   // stopped, nothing more goes in
+   Record(10);
+
+   if (TraceCount() != expected)
+   {
+      printf("threads: %d events kept, expected %d\n", TraceCount(), expected);
+      failed++;
+   }
+
+   if (TraceWriteChrome(filename) != 0 || ReadTrace(&sum) != 0)
+   {
+      printf("threads: couldn't write or read back %s\n", filename);
+      return failed + 1;
+   }
+
+   if (sum.begins != expected / 2 || sum.ends != expected / 2 || sum.unpaired)
+   {
+      printf("threads: %d begins, %d ends, %d unpaired, expected %d of each\n", sum.begins, sum.ends,
+         sum.unpaired, expected / 2);
+      failed++;
+   }
+   if (sum.backwards)
+   {
+      printf("threads: %d time stamps go backwards\n", sum.backwards);
+      failed++;
+   }
+   for (i = 0; i <= THREADS; i++)
+   {
+      if (!sum.name_found[i])
+      {
+         printf("threads: thread %d has no name\n", i);
+         failed++;
+      }
+   }
+
+   return failed;
+}
+
+static int TestOverflow(void)
+{
+   Summary sum;
+   int failed = 0;
+
+   TraceStart();
+   if (TraceCount() != 0)
+   {
+      printf("overflow: %d events left over from the last trace\n", TraceCount());
+      failed++;
+   }
+
+   // an odd number of events past the end, so the oldest kept is an end
+   TRACE_END(TRACE_FRAME);
+   Record(RING_EVENTS / 4 + 1000);
+   TRACE_BEGIN(TRACE_FRAME);
+   TraceStop();
+
+   if (TraceCount() != RING_EVENTS)
+   {
+      printf("overflow: %d events kept, expected %d\n", TraceCount(), RING_EVENTS);
+      failed++;
+   }
+
+   if (TraceWriteChrome(filename) != 0 || ReadTrace(&sum) != 0)
+   {
+      printf("overflow: couldn't write or read back %s\n", filename);
+      return failed + 1;
+   }
+
+   if (sum.unpaired || sum.backwards || sum.begins < RING_EVENTS / 2 - 2)
+   {
+      printf("overflow: %d begins, %d ends, %d unpaired, %d backwards\n", sum.begins, sum.ends,
+         sum.unpaired, sum.backwards);
+      failed++;
+   }
+
+   return failed;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static double BenchEvent(int enable)
+{
+   double best = 0;
+   s64 t;
+   int round;
+
+   // best of a few rounds
+   for (round = 0; round < 3; round++)
+   {
+      double ns;
+
+      if (enable)
+         TraceStart();
+      t = YabauseGetTicks();
+      Record(BENCH_PAIRS / 2);
+      ns = TicksToUsec(YabauseGetTicks() - t) * 1000.0 / (BENCH_PAIRS * 2);
+      TraceStop();
+      if (round == 0 || ns < best)
+         best = ns;
+   }
+
+   return best;
+}
+
+static int TestOverhead(void)
+{
+   static const u16 program[2] = {
+      0xAFFE,     // bra .
+      0x0009,     // nop
+   };
+   sh2regs_struct regs;
+   double on, off, percent;
+   int i, events;
+
+   on = BenchEvent(1);
+   off = BenchEvent(0);
+
+   for (i = 0; i < 2; i++)
+      MappedMemoryWriteWord(PROGRAM_ADDR + i * 2, program[i], NULL);
+   SH2GetRegisters(MSH2, &regs);
+   regs.PC = PROGRAM_ADDR;
+   regs.R[15] = 0x06002000;
+   regs.SR.all = 0xF0;
+   SH2SetRegisters(MSH2, &regs);
+
+   TraceStart();
+   for (i = 0; i < FRAMES; i++)
+      YabauseEmulate();
+   TraceStop();
+   events = TraceCount();
+
+   // what the events of one frame cost against a 60Hz frame
+   percent = (double)events / FRAMES * on / 16666666.0 * 100.0;
+   printf("event %.1f ns recording, %.1f ns off, %d events a frame, %.3f%% of a frame\n", on, off,
+      events / FRAMES, percent);
+
+   if (events < FRAMES * 2)
+   {
+      printf("overhead: the frames recorded %d events\n", events);
+      return 1;
+   }
+   if (percent >= 1.0)
+   {
+      printf("overhead: over 1%%\n");
+      return 1;
+   }
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+   yabauseinit_struct yinit;
+   int failed = 0;
+
+   printf("%s v%s\n", PROG_NAME, VER_NAME);
+
+   if (argc > 1)
+      filename = argv[1];
+
+   memset(&yinit, 0, sizeof(yinit));
+   yinit.percoretype = PERCORE_DUMMY;
+   yinit.sh2coretype = SH2CORE_INTERPRETER;
+   yinit.vidcoretype = VIDCORE_DUMMY;
+   yinit.m68kcoretype = M68KCORE_DUMMY;
+   yinit.sndcoretype = SNDCORE_DUMMY;
+   yinit.cdcoretype = CDCORE_DUMMY;
+   yinit.carttype = CART_NONE;
+   yinit.regionid = REGION_AUTODETECT;
+   yinit.videoformattype = VIDEOFORMATTYPE_NTSC;
+   yinit.framelimit = 1;
+   yinit.scsp_main_mode = 1; // the sound thread runs on its own, as in libretro
+   yinit.skip_load = 1;
+
+   if (YabauseInit(&yinit) != 0)
+   {
+      printf("YabauseInit failed\n");
+      return 1;
+   }
+
+   failed += TestThreads();
+   failed += TestOverflow();
+   failed += TestOverhead();
+
+   printf("%s\n", failed ? "FAIL" : "OK");
+
+   if (argc <= 1)
+      remove(filename);
+   YabauseDeInit();
+   return failed ? 1 : 0;
+}
@@ -0,0 +1,377 @@
+/*******************************************************************************
+  VDP1BENCH - Yabause software VDP1 tile binning benchmark
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+*******************************************************************************/
+
+// Draws VDP1 command lists serially, without and with the decoded sprite
+// cache, and then binned by framebuffer tile on a range of VDP1 worker
+// counts, checks every setup draws the same framebuffer and reports
+// primitives per second. Without arguments a few
+// typical frames are built: 2D sprites, textured Gouraud polygons, large
+// half transparent sprites and lines. Dumps written by dumpvram() in
+// vdp2.cpp can be given instead, their VDP1 registers and ram are drawn.
+
+// example: vdp1bench [vdp2vram.bin ...]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../core.h"
+#include "../yabause.h"
+#include "../yui.h"
+#include "../cdbase.h"
+#include "../cs0.h"
+#include "../m68kcore.h"
+#include "../peripheral.h"
+#include "../sh2core.h"
+#include "../sh2int.h"
+#include "../scsp.h"
+#include "../memory.h"
+#include "../vdp1.h"
+#include "../vdp2.h"
+#include "../vidsoft.h"
+#include "../vidsoftvdp1.h"
+
+#define PROG_NAME "VDP1BENCH"
+#define VER_NAME "1.0"
+
+#define BENCH_FRAMES 20
+
+SH2Interface_struct *SH2CoreList[] = {
+   &SH2Interpreter,
+   NULL
+};
+
+PerInterface_struct *PERCoreList[] = {
+   &PERDummy,
+   NULL
+};
+
+CDInterface *CDCoreList[] = {
+   &DummyCD,
+   NULL
+};
+
+SoundInterface_struct *SNDCoreList[] = {
+   &SNDDummy,
+   NULL
+};
+
+VideoInterface_struct *VIDCoreList[] = {
+   &VIDDummy,
+   &VIDSoft,
+   NULL
+};
+
+M68K_struct * M68KCoreList[] = {
+   &M68KDummy,
+   NULL
+};
+
+void YuiErrorMsg(const char *string) { printf("Error: %s\n", string); }
+
+void YuiSwapBuffers() { }
+
+extern u8 *vdp1backframebuffer;
+
+static const struct
+{
+   int workers;
+   int cache;
+} setups[] = {
+   { 0, 0 }, { 0, 1 }, { 1, 1 }, { 2, 1 }, { 4, 1 }, { 8, 1 }
+};
+#define NUM_SETUPS (sizeof(setups) / sizeof(setups[0]))
+
+static Vdp1 scene_regs;
+static u8 scene_ram[0x80000];
+static u8 reference[0x40000];
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int RandomRange(int low, int high)
+{
+   return low + rand() % (high - low + 1);
+}
+
+static void WriteCommand(u32 addr, u16 ctrl, u16 pmod, u16 size, const s16 * xy)
+{
+   int i;
+
+   T1WriteWord(scene_ram, addr + 0x00, ctrl);
+   T1WriteWord(scene_ram, addr + 0x02, 0);
+   T1WriteWord(scene_ram, addr + 0x04, pmod);
+   T1WriteWord(scene_ram, addr + 0x06, (u16)rand());      // CMDCOLR
+   T1WriteWord(scene_ram, addr + 0x08, 0x1000 + rand() % 0xE000); // CMDSRCA
+   T1WriteWord(scene_ram, addr + 0x0A, size);
+   for (i = 0; i < 8; i++)
+      T1WriteWord(scene_ram, addr + 0x0C + i * 2, (u16)xy[i]);
+   T1WriteWord(scene_ram, addr + 0x1C, (u16)(0x1000 + rand() % 0xE000)); // CMDGRDA
+}
+
+static void BeginScene(void)
+{
+   int i;
+
+   for (i = 0; i < 0x80000; i++)
+      scene_ram[i] = (u8)rand();
+
+   memset(&scene_regs, 0, sizeof(scene_regs));
+   scene_regs.FBCR = 2; // no automatic erase
+   scene_regs.systemclipX2 = 351;
+   scene_regs.systemclipY2 = 239;
+   scene_regs.userclipX2 = 351;
+   scene_regs.userclipY2 = 239;
+}
+
+// a 2D game frame: small 4bpp and 256 color sprites, some half transparent
+static void SpriteScene(void)
+{
+   u32 addr = 0;
+   int i;
+
+   BeginScene();
+   for (i = 0; i < 1500; i++, addr += 0x20)
+   {
+      s16 xy[8] = { 0 };
+      u16 pmod = (u16)(((i & 1) ? 4 : 0) << 3) | 0x80;
+
+      if (i % 10 == 0)
+         pmod |= 3;
+      xy[0] = (s16)RandomRange(-16, 336);
+      xy[1] = (s16)RandomRange(-16, 224);
+      WriteCommand(addr, (u16)(rand() & 0x30), pmod, (u16)((RandomRange(2, 4) << 8) | RandomRange(16, 32)), xy);
+   }
+   T1WriteWord(scene_ram, addr, 0x8000);
+}
+
+// a 3D game frame: textured distorted sprites with Gouraud shading
+static void PolygonScene(void)
+{
+   u32 addr = 0;
+   int i, j;
+
+   BeginScene();
+   for (i = 0; i < 800; i++, addr += 0x20)
+   {
+      int x = RandomRange(0, 320);
+      int y = RandomRange(0, 224);
+      s16 xy[8];
+
+      for (j = 0; j < 8; j += 2)
+      {
+         xy[j] = (s16)(x + RandomRange(-24, 24));
+         xy[j + 1] = (s16)(y + RandomRange(-24, 24));
+      }
+      WriteCommand(addr, 2, (u16)((5 << 3) | 0x80 | (i % 3 == 0 ? 4 : 0)), 0x0420, xy);
+   }
+   T1WriteWord(scene_ram, addr, 0x8000);
+}
+
+// backgrounds and effects made of a few large half transparent sprites
+static void LargeSpriteScene(void)
+{
+   u32 addr = 0;
+   int i;
+
+   BeginScene();
+   for (i = 0; i < 60; i++, addr += 0x20)
+   {
+      s16 xy[8] = { 0 };
+
+      xy[0] = (s16)RandomRange(-64, 288);
+      xy[1] = (s16)RandomRange(-64, 192);
+      xy[4] = (s16)(xy[0] + RandomRange(64, 200));
+      xy[5] = (s16)(xy[1] + RandomRange(64, 160));
+      WriteCommand(addr, 1, (u16)((1 << 3) | 0x80 | 3), 0x1040, xy);
+   }
+   T1WriteWord(scene_ram, addr, 0x8000);
+}
+
+// wireframes: lines and polylines with Gouraud shading
+static void LineScene(void)
+{
+   u32 addr = 0;
+   int i, j;
+
+   BeginScene();
+   for (i = 0; i < 2000; i++, addr += 0x20)
+   {
+      s16 xy[8];
+
+      for (j = 0; j < 8; j += 2)
+      {
+         xy[j] = (s16)RandomRange(-20, 340);
+         xy[j + 1] = (s16)RandomRange(-20, 240);
+      }
+      WriteCommand(addr, (u16)(i & 1 ? 5 : 6), (u16)((5 << 3) | 4), 0, xy);
+   }
+   T1WriteWord(scene_ram, addr, 0x8000);
+}
+
+// the vdp2vram.bin layout of dumpvram()
+static int LoadDump(const char * path)
+{
+   FILE * fp = fopen(path, "rb");
+   long skip = (long)(sizeof(Vdp2) + 0x80000 + 0x1000 + sizeof(Vdp2Internal_struct));
+   int ok;
+
+   if (fp == NULL)
+      return -1;
+
+   ok = fseek(fp, skip, SEEK_SET) == 0 &&
+      fread(&scene_regs, sizeof(Vdp1), 1, fp) == 1 &&
+      fread(scene_ram, 0x80000, 1, fp) == 1;
+   fclose(fp);
+
+   if (!ok)
+      return -1;
+
+   // the list starts at the top of the table like a frame change does
+   scene_regs.addr = 0;
+   scene_regs.FBCR &= ~0x3;
+   scene_regs.FBCR |= 2;
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void DrawScene(VIDSoftFrameStats * stats)
+{
+   memcpy(Vdp1Regs, &scene_regs, sizeof(Vdp1));
+   memset(vdp1backframebuffer, 0, 0x40000);
+   Vdp1External.manualerase = 0;
+   VIDCore->Vdp1DrawStart();
+   VIDSoftGetFrameStats(stats);
+}
+
+static int BenchScene(const char * name)
+{
+   VIDSoftFrameStats stats;
+   double base = 0;
+   int failed = 0;
+   int i, frame;
+
+   // the scene ram is written once, frames after the first can hit the cache
+   memcpy(Vdp1Ram, scene_ram, sizeof(scene_ram));
+   Vdp1RamDirty(0, 0x80000);
+
+   VIDSoftSetNumVdp1Threads(0);
+   VIDSoftSetVdp1CacheSize(0);
+   DrawScene(&stats);
+   memcpy(reference, vdp1backframebuffer, sizeof(reference));
+
+   printf("%s: %d primitives\n", name, stats.vdp1_primitives);
+
+   for (i = 0; i < NUM_SETUPS; i++)
+   {
+      double usec = 0;
+      int tiles;
+
+      VIDSoftSetNumVdp1Threads(setups[i].workers);
+      VIDSoftSetVdp1CacheSize(setups[i].cache ? VDP1_SPAN_CACHE_DEFAULT_LIMIT : 0);
+      DrawScene(&stats);
+      tiles = stats.vdp1_tiles;
+      if (memcmp(reference, vdp1backframebuffer, sizeof(reference)) != 0)
+      {
+         printf("  %d workers%s: framebuffer differs from the serial draw\n",
+            setups[i].workers, setups[i].cache ? ", cache" : "");
+         failed++;
+         continue;
+      }
+
+      for (frame = 0; frame < BENCH_FRAMES; frame++)
+      {
+         DrawScene(&stats);
+         usec += stats.vdp1_usec;
+      }
+      usec /= BENCH_FRAMES;
+      if (i == 0)
+         base = usec;
+
+      printf("  %d workers%s: %.1f us per frame, %.0f primitives/s, %d tile jobs, %d cache hits, speedup %.2fx\n",
+         setups[i].workers, setups[i].cache ? ", cache" : "", usec,
+         stats.vdp1_primitives * 1000000.0 / usec, tiles, stats.vdp1_cache_hits, base / usec);
+   }
+
+   VIDSoftSetNumVdp1Threads(0);
+   VIDSoftSetVdp1CacheSize(VDP1_SPAN_CACHE_DEFAULT_LIMIT);
+   return failed;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+   yabauseinit_struct yinit;
+   int failed = 0;
+   int i;
+
+   printf("%s v%s\n", PROG_NAME, VER_NAME);
+
+   memset(&yinit, 0, sizeof(yinit));
+   yinit.percoretype = PERCORE_DUMMY;
+   yinit.sh2coretype = SH2CORE_INTERPRETER;
+   yinit.vidcoretype = VIDCORE_SOFT;
+   yinit.m68kcoretype = M68KCORE_DUMMY;
+   yinit.sndcoretype = SNDCORE_DUMMY;
+   yinit.cdcoretype = CDCORE_DUMMY;
+   yinit.carttype = CART_NONE;
+   yinit.regionid = REGION_AUTODETECT;
+   yinit.videoformattype = VIDEOFORMATTYPE_NTSC;
+   yinit.skip_load = 1;
+
+   if (YabauseInit(&yinit) != 0)
+   {
+      printf("YabauseInit failed\n");
+      return 1;
+   }
+
+   VIDSoftSetVdp1ThreadEnable(0);
+   VIDSoftSetVdp1Rasterizer(VIDSOFT_VDP1_RASTER_SPAN);
+
+   if (argc > 1)
+   {
+      for (i = 1; i < argc; i++)
+      {
+         if (LoadDump(argv[i]) != 0)
+         {
+            printf("can't read %s\n", argv[i]);
+            failed++;
+            continue;
+         }
+         failed += BenchScene(argv[i]);
+      }
+   }
+   else
+   {
+      srand(1);
+      SpriteScene();
+      failed += BenchScene("2D sprites");
+      PolygonScene();
+      failed += BenchScene("Gouraud polygons");
+      LargeSpriteScene();
+      failed += BenchScene("large sprites");
+      LineScene();
+      failed += BenchScene("lines");
+   }
+
+   printf("%s\n", failed ? "FAIL" : "OK");
+
+   YabauseDeInit();
+   return failed ? 1 : 0;
+}
@@ -0,0 +1,430 @@
+/*******************************************************************************
+  VDP1RASTERTEST - Yabause software VDP1 rasterizer tester
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+*******************************************************************************/
+
+// Checks that the span rasterizer draws the same framebuffer as the per
+// pixel reference path. Random command lists with every sprite, polygon and
+// line command, color mode, draw mode, clipping mode and flip are drawn
+// over random framebuffer contents in 16 bit, 8 bit and interlaced modes,
+// every list also through the tile binning of the VDP1 worker threads and
+// once more from the decoded sprite cache. Some lists are drawn again after
+// their patterns were rewritten through Vdp1RamWriteWord, the cache has to
+// drop what it decoded. A frame of small sprites is then timed with both
+// rasterizers.
+
+// example: vdp1rastertest [rounds]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../core.h"
+#include "../yabause.h"
+#include "../yui.h"
+#include "../cdbase.h"
+#include "../cs0.h"
+#include "../m68kcore.h"
+#include "../peripheral.h"
+#include "../sh2core.h"
+#include "../sh2int.h"
+#include "../scsp.h"
+#include "../memory.h"
+#include "../vdp1.h"
+#include "../vdp2.h"
+#include "../vidsoft.h"
+
+#define PROG_NAME "VDP1RASTERTEST"
+#define VER_NAME "1.0"
+
+#define NUM_ROUNDS 300
+#define MAX_COMMANDS 48
+#define BENCH_SPRITES 600
+#define BENCH_FRAMES 20
+#define PRIME_ADDR 0x7FF00
+#define TILE_WORKERS 3
+
+SH2Interface_struct *SH2CoreList[] = {
+   &SH2Interpreter,
+   NULL
+};
+
+PerInterface_struct *PERCoreList[] = {
+   &PERDummy,
+   NULL
+};
+
+CDInterface *CDCoreList[] = {
+   &DummyCD,
+   NULL
+};
+
+SoundInterface_struct *SNDCoreList[] = {
+   &SNDDummy,
+   NULL
+};
+
+VideoInterface_struct *VIDCoreList[] = {
+   &VIDDummy,
+   &VIDSoft,
+   NULL
+};
+
+M68K_struct * M68KCoreList[] = {
+   &M68KDummy,
+   NULL
+};
+
+void YuiErrorMsg(const char *string) { printf("Error: %s\n", string); }
+
+void YuiSwapBuffers() { }
+
+extern u8 *vdp1backframebuffer;
+
+static u8 start_framebuffer[0x40000];
+static u8 reference[0x40000];
+static u8 span[0x40000];
+static u8 tiled[0x40000];
+static u8 cached[0x40000];
+static int cache_hits;
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int RandomRange(int low, int high)
+{
+   return low + rand() % (high - low + 1);
+}
+
+static void WriteCommand(u32 addr, u16 ctrl, u16 pmod, u16 size, const s16 * xy)
+{
+   int i;
+
+   T1WriteWord(Vdp1Ram, addr + 0x00, ctrl);
+   T1WriteWord(Vdp1Ram, addr + 0x02, 0);
+   T1WriteWord(Vdp1Ram, addr + 0x04, pmod);
+   T1WriteWord(Vdp1Ram, addr + 0x06, (u16)rand());      // CMDCOLR
+   T1WriteWord(Vdp1Ram, addr + 0x08, 0x1000 + rand() % 0xE000); // CMDSRCA
+   T1WriteWord(Vdp1Ram, addr + 0x0A, size);
+   for (i = 0; i < 8; i++)
+      T1WriteWord(Vdp1Ram, addr + 0x0C + i * 2, (u16)xy[i]);
+   T1WriteWord(Vdp1Ram, addr + 0x1C, (u16)(0x1000 + rand() % 0xE000)); // CMDGRDA
+}
+
+static void RandomCommandList(int count)
+{
+   u32 addr = 0;
+   int i, j;
+
+   // texture, palette and gouraud data
+   for (i = 0x8000; i < PRIME_ADDR; i++)
+      T1WriteByte(Vdp1Ram, i, (u8)rand());
+
+   for (i = 0; i < count; i++, addr += 0x20)
+   {
+      int type = rand() % 11;
+      u16 ctrl, pmod, size;
+      s16 xy[8];
+
+      for (j = 0; j < 8; j += 2)
+      {
+         xy[j] = (s16)RandomRange(-40, 380);
+         xy[j + 1] = (s16)RandomRange(-40, 260);
+      }
+
+      // the invalid color modes 6 and 7 always take the reference path
+      pmod = (u16)(rand() & 0x07C7) | (u16)((rand() % 6) << 3);
+      if (rand() % 8 == 0)
+         pmod |= 0x8000; // MSB on
+
+      size = (u16)((RandomRange(1, 8) << 8) | RandomRange(1, 48));
+      if (rand() % 8 == 0)
+         size = (u16)((RandomRange(1, 63) << 8) | RandomRange(1, 255));
+
+      switch (type)
+      {
+      case 7: // user clipping, the reference sets the bottom right corner itself
+         ctrl = 8;
+         xy[0] = (s16)RandomRange(0, 200);
+         xy[1] = (s16)RandomRange(0, 150);
+         break;
+      case 8: // system clipping
+         ctrl = 9;
+         xy[4] = (s16)RandomRange(100, 400);
+         xy[5] = (s16)RandomRange(100, 260);
+         break;
+      case 9: // local coordinates
+         ctrl = 10;
+         xy[0] = (s16)RandomRange(-30, 30);
+         xy[1] = (s16)RandomRange(-30, 30);
+         break;
+      case 10: // scaled sprite with a zoom point
+         ctrl = 1 | (RandomRange(0, 15) << 8);
+         xy[2] = (s16)RandomRange(1, 120);
+         xy[3] = (s16)RandomRange(1, 120);
+         break;
+      default: // sprites, polygon, polyline, line
+         ctrl = type;
+         break;
+      }
+
+      ctrl |= (rand() & 3) << 4; // flip
+      WriteCommand(addr, ctrl, pmod, size, xy);
+   }
+
+   T1WriteWord(Vdp1Ram, addr, 0x8000);
+   Vdp1RamDirty(0, 0x80000);
+}
+
+// the patterns drawn last change behind the cache, through the VDP1 ram port
+static void RewritePatterns(void)
+{
+   int i;
+
+   for (i = 0; i < 256; i++)
+      Vdp1RamWriteWord((u32)RandomRange(0x8000, PRIME_ADDR - 2) & ~1, (u16)rand());
+}
+
+// Lines take their Gouraud colors from the table of the previous command and
+// some pixel state is kept between commands, a small Gouraud polygon with a
+// zero table puts it in the same state before each draw
+static void PrimeState(const Vdp1 * regs)
+{
+   static const s16 xy[8] = { 0, 0, 1, 0, 1, 1, 0, 1 };
+   int i;
+
+   // written the same way every time, textures may read it
+   WriteCommand(PRIME_ADDR, 4, 0x4, 0x0101, xy);
+   T1WriteWord(Vdp1Ram, PRIME_ADDR + 0x06, 0);
+   T1WriteWord(Vdp1Ram, PRIME_ADDR + 0x08, 0);
+   T1WriteWord(Vdp1Ram, PRIME_ADDR + 0x1C, (PRIME_ADDR + 0x40) >> 3);
+   T1WriteWord(Vdp1Ram, PRIME_ADDR + 0x20, 0x8000);
+   for (i = 0; i < 8; i += 2)
+      T1WriteWord(Vdp1Ram, PRIME_ADDR + 0x40 + i, 0);
+   Vdp1RamDirty(PRIME_ADDR, 0x100);
+
+   VIDSoftSetVdp1Rasterizer(VIDSOFT_VDP1_RASTER_REFERENCE);
+   memcpy(Vdp1Regs, regs, sizeof(Vdp1));
+   Vdp1Regs->addr = PRIME_ADDR;
+   Vdp1External.manualerase = 0;
+   VIDCore->Vdp1DrawStart();
+}
+
+static void Draw(int rasterizer, const Vdp1 * regs, u8 * out)
+{
+   PrimeState(regs);
+
+   VIDSoftSetVdp1Rasterizer(rasterizer);
+   memcpy(Vdp1Regs, regs, sizeof(Vdp1));
+   memcpy(vdp1backframebuffer, start_framebuffer, sizeof(start_framebuffer));
+   Vdp1External.manualerase = 0;
+   VIDCore->Vdp1DrawStart();
+   memcpy(out, vdp1backframebuffer, sizeof(reference));
+}
+
+static int CompareBuffer(const u8 * out, const char * what, const char * name)
+{
+   int i;
+
+   for (i = 0; i < (int)sizeof(reference); i++)
+   {
+      if (reference[i] != out[i])
+      {
+         printf("%s: mismatch at byte 0x%05X, reference 0x%02X %s 0x%02X\n",
+            what, i, reference[i], name, out[i]);
+         return -1;
+      }
+   }
+
+   return 0;
+}
+
+static int CompareDraws(const Vdp1 * regs, const char * what)
+{
+   VIDSoftFrameStats stats;
+
+   Draw(VIDSOFT_VDP1_RASTER_REFERENCE, regs, reference);
+   Draw(VIDSOFT_VDP1_RASTER_SPAN, regs, span);
+
+   VIDSoftSetNumVdp1Threads(TILE_WORKERS);
+   Draw(VIDSOFT_VDP1_RASTER_SPAN, regs, tiled);
+   VIDSoftSetNumVdp1Threads(0);
+
+   // patterns seen twice by now are decoded
+   Draw(VIDSOFT_VDP1_RASTER_SPAN, regs, cached);
+   VIDSoftGetFrameStats(&stats);
+   cache_hits += stats.vdp1_cache_hits;
+
+   if (CompareBuffer(span, what, "span") != 0)
+      return -1;
+
+   if (CompareBuffer(tiled, what, "tiled") != 0)
+      return -1;
+
+   return CompareBuffer(cached, what, "cached");
+}
+
+static void RandomRegs(Vdp1 * regs, int round)
+{
+   memset(regs, 0, sizeof(Vdp1));
+
+   // 16 bit, 8 bit, 8 bit rotation, then the same interlaced
+   switch (round % 3)
+   {
+   case 0: regs->TVMR = 0; break;
+   case 1: regs->TVMR = 1; break;
+   default: regs->TVMR = 3; break;
+   }
+
+   regs->FBCR = 2; // no automatic erase
+   if ((round / 3) & 1)
+      regs->FBCR |= 0x8 | ((round / 6) & 1 ? 0x4 : 0);
+
+   regs->systemclipX2 = 351;
+   regs->systemclipY2 = 239;
+   regs->userclipX1 = (u16)RandomRange(0, 100);
+   regs->userclipY1 = (u16)RandomRange(0, 100);
+   regs->userclipX2 = (u16)RandomRange(150, 351);
+   regs->userclipY2 = (u16)RandomRange(120, 239);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int TestRandomCommands(int rounds)
+{
+   int failed = 0;
+   int round;
+
+   for (round = 0; round < rounds; round++)
+   {
+      Vdp1 regs;
+      char what[32];
+      int i;
+
+      for (i = 0; i < (int)sizeof(start_framebuffer); i++)
+         start_framebuffer[i] = (u8)rand();
+
+      RandomRegs(&regs, round);
+      RandomCommandList(RandomRange(1, MAX_COMMANDS));
+
+      sprintf(what, "round %d", round);
+      if (CompareDraws(&regs, what) != 0)
+         failed++;
+
+      if (round % 4 == 3)
+      {
+         RewritePatterns();
+         sprintf(what, "round %d rewritten", round);
+         if (CompareDraws(&regs, what) != 0)
+            failed++;
+      }
+   }
+
+   printf("%d random command lists compared, %d mismatched, %d commands drawn from the sprite cache\n",
+      rounds, failed, cache_hits);
+
+   if (rounds > 0 && cache_hits == 0)
+   {
+      printf("the sprite cache was never used\n");
+      failed++;
+   }
+
+   return failed;
+}
+
+static double TimeDraws(int rasterizer, const Vdp1 * regs)
+{
+   s64 t;
+   int i;
+
+   t = YabauseGetTicks();
+   for (i = 0; i < BENCH_FRAMES; i++)
+      Draw(rasterizer, regs, rasterizer == VIDSOFT_VDP1_RASTER_SPAN ? span : reference);
+   return (double)(YabauseGetTicks() - t) * 1000000.0 / (double)yabsys.tickfreq / BENCH_FRAMES;
+}
+
+static int BenchSprites(void)
+{
+   Vdp1 regs;
+   u32 addr = 0;
+   int i;
+
+   memset(start_framebuffer, 0, sizeof(start_framebuffer));
+   RandomRegs(&regs, 0);
+   RandomCommandList(0);
+
+   // a 2D game frame: small 4bpp and 256 color sprites, some half transparent
+   for (i = 0; i < BENCH_SPRITES; i++, addr += 0x20)
+   {
+      s16 xy[8] = { 0 };
+      u16 pmod = (u16)(((i & 1) ? 4 : 0) << 3) | 0x80;
+
+      if (i % 10 == 0)
+         pmod |= 3;
+      xy[0] = (s16)RandomRange(-16, 336);
+      xy[1] = (s16)RandomRange(-16, 224);
+      WriteCommand(addr, (u16)(rand() & 0x30), pmod, (u16)((RandomRange(2, 4) << 8) | RandomRange(16, 32)), xy);
+   }
+   T1WriteWord(Vdp1Ram, addr, 0x8000);
+   Vdp1RamDirty(0, addr + 2);
+
+   printf("%d sprites: reference %.1f us, span %.1f us per frame\n", BENCH_SPRITES,
+      TimeDraws(VIDSOFT_VDP1_RASTER_REFERENCE, &regs), TimeDraws(VIDSOFT_VDP1_RASTER_SPAN, &regs));
+
+   return CompareDraws(&regs, "sprite frame") != 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+   yabauseinit_struct yinit;
+   int rounds = NUM_ROUNDS;
+   int failed;
+
+   printf("%s v%s\n", PROG_NAME, VER_NAME);
+
+   if (argc > 1)
+      rounds = atoi(argv[1]);
+
+   memset(&yinit, 0, sizeof(yinit));
+   yinit.percoretype = PERCORE_DUMMY;
+   yinit.sh2coretype = SH2CORE_INTERPRETER;
+   yinit.vidcoretype = VIDCORE_SOFT;
+   yinit.m68kcoretype = M68KCORE_DUMMY;
+   yinit.sndcoretype = SNDCORE_DUMMY;
+   yinit.cdcoretype = CDCORE_DUMMY;
+   yinit.carttype = CART_NONE;
+   yinit.regionid = REGION_AUTODETECT;
+   yinit.videoformattype = VIDEOFORMATTYPE_NTSC;
+   yinit.skip_load = 1;
+
+   if (YabauseInit(&yinit) != 0)
+   {
+      printf("YabauseInit failed\n");
+      return 1;
+   }
+
+   VIDSoftSetVdp1ThreadEnable(0);
+
+   srand(1);
+   failed = TestRandomCommands(rounds);
+   failed += BenchSprites();
+
+   printf("%s\n", failed ? "FAIL" : "OK");
+
+   YabauseDeInit();
+   return failed ? 1 : 0;
+}
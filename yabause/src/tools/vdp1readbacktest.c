@@ -0,0 +1,288 @@
+/*******************************************************************************
+  VDP1READBACKTEST - Yabause VDP1 framebuffer readback tester
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+*******************************************************************************/
+
+// Draws the same VDP1 frames with the OpenGL core twice, the cpu reading the
+// framebuffer after each one, first with the synchronous readback and then
+// with the asynchronous one. Every pixel read must match and the async pass
+// must have been served from its copies. Then the framebuffer is rebuilt
+// while the cpu still has a copy mapped, the copy has to be unmapped.
+// Runs headless on a surfaceless EGL context (Mesa).
+
+// example: vdp1readbacktest
+
+#include <stdio.h>
+#include <string.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include "../core.h"
+#include "../yabause.h"
+#include "../yui.h"
+#include "../cdbase.h"
+#include "../cs0.h"
+#include "../m68kcore.h"
+#include "../peripheral.h"
+#include "../sh2core.h"
+#include "../sh2int.h"
+#include "../scsp.h"
+#include "../vdp1.h"
+#include "../vdp2.h"
+#include "../vidogl.h"
+#include "../ygl.h"
+
+#define PROG_NAME "VDP1READBACKTEST"
+#define VER_NAME "1.0"
+
+#define FRAMES 12
+#define SAMPLES 64
+
+SH2Interface_struct *SH2CoreList[] = {
+   &SH2Interpreter,
+   NULL
+};
+
+PerInterface_struct *PERCoreList[] = {
+   &PERDummy,
+   NULL
+};
+
+CDInterface *CDCoreList[] = {
+   &DummyCD,
+   NULL
+};
+
+SoundInterface_struct *SNDCoreList[] = {
+   &SNDDummy,
+   NULL
+};
+
+VideoInterface_struct *VIDCoreList[] = {
+   &VIDOGL,
+   NULL
+};
+
+M68K_struct * M68KCoreList[] = {
+   &M68KDummy,
+   NULL
+};
+
+void YuiErrorMsg(const char *string) { printf("Error: %s\n", string); }
+
+void YuiSwapBuffers() { }
+
+static u16 samples[2][FRAMES][SAMPLES];
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int CreateContext(void)
+{
+   static const EGLint attribs[] = {
+      EGL_CONTEXT_MAJOR_VERSION, 4,
+      EGL_CONTEXT_MINOR_VERSION, 3,
+      EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+      EGL_NONE
+   };
+   PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay;
+   EGLDisplay display;
+   EGLContext context;
+   EGLint major, minor;
+
+   getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+   if (getPlatformDisplay == NULL)
+      return -1;
+   display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+   if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+      return -1;
+   eglBindAPI(EGL_OPENGL_API);
+   context = eglCreateContext(display, NULL, EGL_NO_CONTEXT, attribs);
+   if (context == EGL_NO_CONTEXT)
+      return -1;
+   if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+      return -1;
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void WritePolygon(u32 addr, u16 ctrl, u16 colr, int x0, int y0, int x1, int y1)
+{
+   int i;
+
+   for (i = 0; i < 0x20; i += 2)
+      T1WriteWord(Vdp1Ram, addr + i, 0);
+   T1WriteWord(Vdp1Ram, addr + 0x00, ctrl);
+   T1WriteWord(Vdp1Ram, addr + 0x04, 0x00C0);
+   T1WriteWord(Vdp1Ram, addr + 0x06, colr);
+   T1WriteWord(Vdp1Ram, addr + 0x0C, x0);
+   T1WriteWord(Vdp1Ram, addr + 0x0E, y0);
+   T1WriteWord(Vdp1Ram, addr + 0x10, x1);
+   T1WriteWord(Vdp1Ram, addr + 0x12, y0);
+   T1WriteWord(Vdp1Ram, addr + 0x14, x1);
+   T1WriteWord(Vdp1Ram, addr + 0x16, y1);
+   T1WriteWord(Vdp1Ram, addr + 0x18, x0);
+   T1WriteWord(Vdp1Ram, addr + 0x1A, y1);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Draws a red background with a polygon moving across it, then reads a grid
+// of pixels back the way the cpu would
+static void DrawFrame(int frame, u16 * out)
+{
+   int i;
+
+   WritePolygon(0x00, 0x0009, 0, 0, 0, 319, 223); // system clip
+   T1WriteWord(Vdp1Ram, 0x14, 319);
+   T1WriteWord(Vdp1Ram, 0x16, 223);
+   WritePolygon(0x20, 0x000A, 0, 0, 0, 0, 0);     // local coordinates
+   WritePolygon(0x40, 0x0004, 0x8000 | 0x7C00, 0, 0, 319, 223);
+   WritePolygon(0x60, 0x0004, 0x8000 | (frame * 3 + 1), 10 + frame * 8, 10, 100 + frame * 8, 120);
+   T1WriteWord(Vdp1Ram, 0x80, 0x8000);
+
+   VIDCore->Vdp2DrawStart();
+   Vdp1External.disptoggle = 1;
+   Vdp1Draw();
+   VIDCore->Vdp1DrawEnd();
+   for (i = 0; i < SAMPLES; i++)
+   {
+      int x = (i % 8) * 24 + 4;
+      int y = (i / 8) * 14 + 4;
+
+      out[i] = 0;
+      VIDCore->Vdp1ReadFrameBuffer(1, (y * 512 + x) * 2, &out[i]);
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void RunFrames(int async)
+{
+   int frame;
+
+   VIDCore->SetSettingValue(VDP_SETTING_VDP1_ASYNC_READBACK, async);
+   for (frame = 0; frame < FRAMES; frame++)
+   {
+      DrawFrame(frame, samples[async][frame]);
+      VIDCore->Vdp2DrawEnd();
+      VIDCore->Sync();
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+   yabauseinit_struct yinit;
+   YglReadbackStats sync_stats, async_stats;
+   u16 extra[SAMPLES];
+   GLuint mapped_id;
+   GLint mapped = GL_TRUE;
+   int frame, i, drawn = 0, mismatches = 0, failed = 0;
+
+   printf("%s v%s\n", PROG_NAME, VER_NAME);
+
+   if (CreateContext() != 0)
+   {
+      printf("no surfaceless EGL context\n");
+      return 1;
+   }
+
+   memset(&yinit, 0, sizeof(yinit));
+   yinit.percoretype = PERCORE_DUMMY;
+   yinit.sh2coretype = SH2CORE_INTERPRETER;
+   yinit.vidcoretype = VIDCORE_OGL;
+   yinit.m68kcoretype = M68KCORE_DUMMY;
+   yinit.sndcoretype = SNDCORE_DUMMY;
+   yinit.cdcoretype = CDCORE_DUMMY;
+   yinit.carttype = CART_NONE;
+   yinit.regionid = REGION_AUTODETECT;
+   yinit.videoformattype = VIDEOFORMATTYPE_NTSC;
+   yinit.skip_load = 1;
+
+   if (YabauseInit(&yinit) != 0)
+   {
+      printf("YabauseInit failed\n");
+      return 1;
+   }
+
+   VIDCore->Resize(0, 0, 320, 224, 0, 0);
+   Vdp2WriteWord(0x000, 0x8000); // display on
+
+   RunFrames(0);
+   YglGetVdp1ReadbackStats(&sync_stats);
+   RunFrames(1);
+   YglGetVdp1ReadbackStats(&async_stats);
+   async_stats.async -= sync_stats.async;
+   async_stats.waited -= sync_stats.waited;
+   async_stats.sync -= sync_stats.sync;
+
+   for (frame = 0; frame < FRAMES; frame++)
+   {
+      for (i = 0; i < SAMPLES; i++)
+      {
+         if (samples[0][frame][i] != 0)
+            drawn++;
+         if (samples[0][frame][i] != samples[1][frame][i])
+            mismatches++;
+      }
+   }
+
+   printf("sync pass: %u sync reads, %u from copies\n", sync_stats.sync,
+      sync_stats.async + sync_stats.waited);
+   printf("async pass: %u from copies without waiting, %u waited, %u sync\n",
+      async_stats.async, async_stats.waited, async_stats.sync);
+   printf("%d of %d pixels drawn, %d differ: ", drawn, FRAMES * SAMPLES, mismatches);
+   if (drawn == 0 || mismatches != 0 || sync_stats.async + sync_stats.waited != 0 ||
+       async_stats.async + async_stats.waited == 0)
+   {
+      printf("FAIL\n");
+      failed++;
+   }
+   else
+      printf("OK\n");
+
+   // Leave the last copy mapped and rebuild the framebuffer under it
+   DrawFrame(FRAMES, extra);
+   mapped_id = _Ygl->pFrameBufferID;
+   printf("framebuffer rebuilt with a copy mapped: ");
+   if (_Ygl->pFrameBuffer == NULL)
+   {
+      printf("FAIL, nothing mapped\n");
+      failed++;
+   }
+   else
+   {
+      glGetError();
+      VIDCore->SetSettingValue(VDP_SETTING_RESOLUTION_MODE, RES_2x);
+      VIDCore->Vdp2DrawEnd();
+      VIDCore->Sync();
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, mapped_id);
+      glGetBufferParameteriv(GL_PIXEL_PACK_BUFFER, GL_BUFFER_MAPPED, &mapped);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+      if (_Ygl->pFrameBuffer != NULL || mapped != GL_FALSE || glGetError() != GL_NO_ERROR)
+      {
+         printf("FAIL, still mapped\n");
+         failed++;
+      }
+      else
+         printf("OK\n");
+   }
+
+   YabauseDeInit();
+   return failed ? 1 : 0;
+}
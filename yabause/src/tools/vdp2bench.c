@@ -0,0 +1,397 @@
+/*******************************************************************************
+  VDP2BENCH - Yabause software VDP2 renderer benchmark
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+*******************************************************************************/
+
+// Draws random VDP2 scenes with the software renderer, first on the calling
+// thread only and then on the worker pool, and checks both give the same
+// picture. Then times the layer drawing for a range of worker counts, frames
+// with a rotation screen are reported apart. When a bios or a cd image is
+// given the timing runs on the frames of the game instead.
+
+// example: vdp2bench [bios path] [cd image path] [frames]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../core.h"
+#include "../yabause.h"
+#include "../yui.h"
+#include "../cdbase.h"
+#include "../cs0.h"
+#include "../m68kcore.h"
+#include "../peripheral.h"
+#include "../sh2core.h"
+#include "../sh2int.h"
+#include "../scsp.h"
+#include "../vdp1.h"
+#include "../memory.h"
+#include "../vdp2.h"
+#include "../vidsoft.h"
+#include "../titan/titan.h"
+
+#define PROG_NAME "VDP2BENCH"
+#define VER_NAME "1.0"
+
+#define NUM_SCENES 64
+#define BENCH_FRAMES 30
+
+SH2Interface_struct *SH2CoreList[] = {
+   &SH2Interpreter,
+   NULL
+};
+
+PerInterface_struct *PERCoreList[] = {
+   &PERDummy,
+   NULL
+};
+
+CDInterface *CDCoreList[] = {
+   &DummyCD,
+   &ISOCD,
+   NULL
+};
+
+SoundInterface_struct *SNDCoreList[] = {
+   &SNDDummy,
+   NULL
+};
+
+VideoInterface_struct *VIDCoreList[] = {
+   &VIDDummy,
+   &VIDSoft,
+   NULL
+};
+
+M68K_struct * M68KCoreList[] = {
+   &M68KDummy,
+   NULL
+};
+
+void YuiErrorMsg(const char *string) { printf("Error: %s\n", string); }
+
+void YuiSwapBuffers() { }
+
+extern pixel_t *dispbuffer;
+extern u8 *vdp1framebuffer[2];
+
+static const int worker_counts[] = { 0, 1, 2, 4, 8 };
+#define NUM_WORKER_COUNTS (sizeof(worker_counts) / sizeof(worker_counts[0]))
+
+static pixel_t reference[704 * 512];
+
+//////////////////////////////////////////////////////////////////////////////
+
+static u16 Random16(void)
+{
+   return (u16)(((u32)rand() << 8) ^ (u32)rand());
+}
+
+static void RandomFill(u8 *buf, int size)
+{
+   int i;
+
+   for (i = 0; i < size; i++)
+      buf[i] = (u8)rand();
+}
+
+static void SetupScene(int rotation)
+{
+   u16 *regs = (u16 *)Vdp2Regs;
+   int i;
+
+   for (i = 0; i < (int)(sizeof(Vdp2) / sizeof(u16)); i++)
+      regs[i] = Random16();
+
+   // display on, any horizontal resolution, sometimes interlaced
+   Vdp2Regs->TVMD = 0x8000 | (rand() % 8) | ((rand() % 4) == 3 ? 0xC0 : 0);
+   Vdp2Regs->BGON = (Vdp2Regs->BGON & 0x1F0F) | (rotation ? 0x10 : 0);
+   if (!rotation)
+      Vdp2Regs->BGON &= ~0x30;
+
+   // the bad cycle setting switches NBG3 to the pipelined path
+   if (rand() % 8 == 0)
+   {
+      Vdp2Regs->CYCA0L = 0x5566;
+      Vdp2Regs->CYCA0U = 0x47ff;
+      Vdp2Regs->CYCA1L = 0xffff;
+      Vdp2Regs->CYCA1U = 0xffff;
+      Vdp2Regs->CYCB0L = 0x12ff;
+      Vdp2Regs->CYCB0U = 0x03ff;
+      Vdp2Regs->CYCB1L = 0xffff;
+      Vdp2Regs->CYCB1U = 0xffff;
+   }
+
+   // keep every table inside vram, real software does and the renderer
+   // does not wrap addresses
+   Vdp2Regs->VRSIZE = 0;
+   Vdp2Regs->VCSTA.all &= 0xFFFF;
+   Vdp2Regs->LSTA0.all &= 0xFFFF;
+   Vdp2Regs->LSTA1.all &= 0xFFFF;
+   Vdp2Regs->LCTA.all &= 0xFFFF;
+   Vdp2Regs->LWTA0.all &= 0xFFFF;
+   Vdp2Regs->LWTA1.all &= 0xFFFF;
+   Vdp2Regs->BKTAU &= 0x3;
+   Vdp2Regs->RPTA.all = 0x70000 >> 1;
+   Vdp2Regs->KTAOF = 0;
+
+   RandomFill(Vdp2Ram, 0x80000);
+   RandomFill(Vdp2ColorRam, 0x1000);
+
+   // coefficient tables start well inside vram and move slowly
+   for (i = 0; i < 2; i++)
+   {
+      u32 table = 0x70000 + i * 0x80;
+
+      T1WriteLong(Vdp2Ram, table + 84, (0x2000 + rand() % 0x1000) << 16);
+      T1WriteLong(Vdp2Ram, table + 88, (u32)((rand() % 0x10000) - 0x8000) & 0x03FFFFC0);
+      T1WriteLong(Vdp2Ram, table + 92, (u32)((rand() % 0x10000) - 0x8000) & 0x03FFFFC0);
+   }
+   RandomFill(vdp1framebuffer[0], 0x40000);
+   memcpy(vdp1framebuffer[1], vdp1framebuffer[0], 0x40000);
+   RandomFill((u8 *)cell_scroll_data, sizeof(struct CellScrollData) * 270);
+
+   // scrolling and priorities change every few lines like a raster effect
+   for (i = 0; i < 270; i++)
+   {
+      Vdp2Lines[i] = *Vdp2Regs;
+      if (i % 7 == 3)
+      {
+         Vdp2Lines[i].SCXIN0 = Random16();
+         Vdp2Lines[i].SCYIN0 = Random16();
+         Vdp2Lines[i].SCXIN1 = Random16();
+         Vdp2Lines[i].PRINA = Random16();
+         Vdp2Lines[i].CCRNA = Random16();
+      }
+   }
+
+   Vdp1External.disptoggle = 1;
+   Vdp1Regs->FBCR = 2;
+   Vdp1Regs->TVMR = 0;
+}
+
+static void DrawFrame(VIDSoftFrameStats *stats)
+{
+   VIDSoft.Vdp2DrawStart();
+   VIDSoft.Vdp2DrawScreens();
+   VIDSoft.Vdp2DrawEnd();
+   VIDSoftGetFrameStats(stats);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int TestScenes(void)
+{
+   VIDSoftFrameStats stats;
+   int failed = 0;
+   int scene, i;
+
+   for (scene = 0; scene < NUM_SCENES; scene++)
+   {
+      int width, height, j;
+
+      srand(scene + 1);
+      SetupScene(scene & 1);
+
+      // the back screen is drawn before the new resolution is applied, so
+      // the first frame of a scene still has the previous height
+      VIDSoftSetNumWorkerThreads(0);
+      DrawFrame(&stats);
+      DrawFrame(&stats);
+      TitanGetResolution(&width, &height);
+      memcpy(reference, dispbuffer, sizeof(pixel_t) * width * height);
+
+      for (i = 1; i < NUM_WORKER_COUNTS; i++)
+      {
+         VIDSoftSetNumWorkerThreads(worker_counts[i]);
+         DrawFrame(&stats);
+
+         for (j = 0; j < width * height; j++)
+         {
+            if (reference[j] != dispbuffer[j])
+            {
+               printf("scene %d, %d workers: mismatch at x=%d y=%d, 0x%08X instead of 0x%08X\n",
+                  scene, worker_counts[i], j % width, j / width, (u32)dispbuffer[j], (u32)reference[j]);
+               failed++;
+               break;
+            }
+         }
+      }
+   }
+
+   printf("%d scenes compared, %d mismatched\n", NUM_SCENES, failed);
+   return failed;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+typedef struct
+{
+   int frames;
+   double layer_usec;
+   double busy_usec;
+   double compose_usec;
+} BenchTotal;
+
+static void AddFrame(BenchTotal *total, const VIDSoftFrameStats *stats)
+{
+   total->frames++;
+   total->layer_usec += stats->layer_usec;
+   total->busy_usec += stats->layer_busy_usec;
+   total->compose_usec += stats->compose_usec;
+}
+
+static void PrintTotals(const char *what, BenchTotal *totals)
+{
+   double base;
+   int i;
+
+   if (totals[0].frames == 0)
+      return;
+
+   base = totals[0].layer_usec / totals[0].frames;
+   printf("%s:\n", what);
+   for (i = 0; i < NUM_WORKER_COUNTS; i++)
+   {
+      BenchTotal *t = &totals[i];
+
+      if (t->frames == 0)
+         continue;
+
+      printf("  %d workers: layers %.1f us (busy %.1f us), compose %.1f us, speedup %.2fx over %d frames\n",
+         worker_counts[i], t->layer_usec / t->frames, t->busy_usec / t->frames, t->compose_usec / t->frames,
+         base / (t->layer_usec / t->frames), t->frames);
+   }
+}
+
+static void BenchScenes(void)
+{
+   BenchTotal scroll[NUM_WORKER_COUNTS];
+   BenchTotal rotation[NUM_WORKER_COUNTS];
+   VIDSoftFrameStats stats;
+   int i, frame;
+
+   memset(scroll, 0, sizeof(scroll));
+   memset(rotation, 0, sizeof(rotation));
+
+   for (i = 0; i < NUM_WORKER_COUNTS; i++)
+   {
+      VIDSoftSetNumWorkerThreads(worker_counts[i]);
+
+      for (frame = 0; frame < BENCH_FRAMES; frame++)
+      {
+         srand(1000 + frame);
+         SetupScene(frame & 1);
+         DrawFrame(&stats);
+         AddFrame(stats.rbg0 ? &rotation[i] : &scroll[i], &stats);
+      }
+   }
+
+   PrintTotals("scroll screens only", scroll);
+   PrintTotals("with rotation screen", rotation);
+}
+
+static void BenchGame(int frames)
+{
+   BenchTotal scroll[NUM_WORKER_COUNTS];
+   BenchTotal rotation[NUM_WORKER_COUNTS];
+   VIDSoftFrameStats stats;
+   int i, frame;
+
+   memset(scroll, 0, sizeof(scroll));
+   memset(rotation, 0, sizeof(rotation));
+
+   // let the game reach something worth drawing
+   for (frame = 0; frame < frames; frame++)
+      YabauseEmulate();
+
+   for (i = 0; i < NUM_WORKER_COUNTS; i++)
+   {
+      VIDSoftSetNumWorkerThreads(worker_counts[i]);
+
+      for (frame = 0; frame < frames; frame++)
+      {
+         YabauseEmulate();
+         VIDSoftGetFrameStats(&stats);
+         AddFrame(stats.rbg0 ? &rotation[i] : &scroll[i], &stats);
+      }
+   }
+
+   PrintTotals("game frames without rotation screen", scroll);
+   PrintTotals("game frames with rotation screen", rotation);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+   yabauseinit_struct yinit;
+   int frames = 300;
+   int game = 0;
+   int failed = 0;
+
+   printf("%s v%s\n", PROG_NAME, VER_NAME);
+
+   memset(&yinit, 0, sizeof(yinit));
+   yinit.percoretype = PERCORE_DUMMY;
+   yinit.sh2coretype = SH2CORE_INTERPRETER;
+   yinit.vidcoretype = VIDCORE_SOFT;
+   yinit.m68kcoretype = M68KCORE_DUMMY;
+   yinit.sndcoretype = SNDCORE_DUMMY;
+   yinit.cdcoretype = CDCORE_DUMMY;
+   yinit.carttype = CART_NONE;
+   yinit.regionid = REGION_AUTODETECT;
+   yinit.videoformattype = VIDEOFORMATTYPE_NTSC;
+   yinit.framelimit = 1;
+
+   if (argc > 1 && argv[1][0] != '\0')
+   {
+      yinit.biospath = argv[1];
+      game = 1;
+   }
+   if (argc > 2 && argv[2][0] != '\0')
+   {
+      yinit.cdcoretype = CDCORE_ISO;
+      yinit.cdpath = argv[2];
+      game = 1;
+   }
+   if (argc > 3)
+      frames = atoi(argv[3]);
+
+   // the emulated bios refuses to start without a game, the random scenes
+   // only need the video core
+   yinit.skip_load = !game;
+
+   if (YabauseInit(&yinit) != 0)
+   {
+      printf("YabauseInit failed\n");
+      return 1;
+   }
+
+   if (game)
+      BenchGame(frames);
+   else
+   {
+      failed = TestScenes();
+      BenchScenes();
+   }
+
+   printf("%s\n", failed ? "FAIL" : "OK");
+
+   YabauseDeInit();
+   return failed ? 1 : 0;
+}
@@ -0,0 +1,217 @@
+/*******************************************************************************
+  VDP2LINETEST - Yabause per line VDP2 register snapshot tester
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+*******************************************************************************/
+
+// Plays a frame of raster effects into Vdp2HBlankOUT: scroll registers and
+// the cell scroll table change on some lines, the same values are written
+// again on others. Every line read back through Vdp2RestoreRegs and
+// Vdp2CopyLines must match a full copy of the registers taken at that line,
+// lines without a real change must share a snapshot.
+
+// example: vdp2linetest
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include "../core.h"
+#include "../yabause.h"
+#include "../yui.h"
+#include "../cdbase.h"
+#include "../cs0.h"
+#include "../m68kcore.h"
+#include "../peripheral.h"
+#include "../sh2core.h"
+#include "../sh2int.h"
+#include "../scsp.h"
+#include "../vdp1.h"
+#include "../vdp2.h"
+
+#define PROG_NAME "VDP2LINETEST"
+#define VER_NAME "1.0"
+
+#define NUM_LINES 224
+#define CELL_SCROLL_ADDR 0x20000
+
+SH2Interface_struct *SH2CoreList[] = {
+   &SH2Interpreter,
+   NULL
+};
+
+PerInterface_struct *PERCoreList[] = {
+   &PERDummy,
+   NULL
+};
+
+CDInterface *CDCoreList[] = {
+   &DummyCD,
+   NULL
+};
+
+SoundInterface_struct *SNDCoreList[] = {
+   &SNDDummy,
+   NULL
+};
+
+VideoInterface_struct *VIDCoreList[] = {
+   &VIDDummy,
+   NULL
+};
+
+M68K_struct * M68KCoreList[] = {
+   &M68KDummy,
+   NULL
+};
+
+void YuiErrorMsg(const char *string) { printf("Error: %s\n", string); }
+
+void YuiSwapBuffers() { }
+
+static Vdp2 reference[NUM_LINES];
+static struct CellScrollData cell_reference[NUM_LINES];
+static Vdp2 copy[270];
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int SameRegs(const Vdp2 *a, const Vdp2 *b)
+{
+   // the status registers are not kept per line
+   size_t start = offsetof(Vdp2, VCNT) + sizeof(u16);
+   return a->TVMD == b->TVMD && a->EXTEN == b->EXTEN && a->VRSIZE == b->VRSIZE &&
+      memcmp((const u8 *)a + start, (const u8 *)b + start, sizeof(Vdp2) - start) == 0;
+}
+
+static void PlayFrame(void)
+{
+   int line, i;
+
+   for (line = 0; line < NUM_LINES; line++)
+   {
+      if (line % 16 == 5)
+      {
+         Vdp2WriteWord(0x070, (u16)line);          // SCXIN0
+         Vdp2WriteWord(0x074, (u16)(line * 3));    // SCYIN0
+      }
+      else if (line % 8 == 2)
+         Vdp2WriteWord(0x070, Vdp2Regs->SCXIN0);   // same value again
+
+      if (line == 40 || line == 41 || line == 150)
+         Vdp2RamWriteWord(CELL_SCROLL_ADDR + 4 * (line % 88) + 2, (u16)(line * 7));
+      if (line == 120)
+         Vdp2RamWriteLong(CELL_SCROLL_ADDR + 0x400, 0x12345678); // outside the table
+
+      memcpy(&reference[line], Vdp2Regs, sizeof(Vdp2));
+      for (i = 0; i < 88; i++)
+         cell_reference[line].data[i] = Vdp2RamReadLong(CELL_SCROLL_ADDR + i * 4);
+
+      yabsys.LineCount = line;
+      Vdp2HBlankOUT();
+   }
+}
+
+static int CheckFrame(void)
+{
+   int failed = 0;
+   int snapshots = 0;
+   int line;
+
+   Vdp2CopyLines(copy);
+
+   for (line = 0; line < NUM_LINES; line++)
+   {
+      Vdp2 *regs = Vdp2RestoreRegs(line, Vdp2Lines);
+
+      if (Vdp2LineSource[line] == line)
+         snapshots++;
+      else if (line > 0 && !SameRegs(&reference[line], &reference[line - 1]))
+      {
+         printf("line %d: registers changed but the snapshot is shared\n", line);
+         failed++;
+      }
+
+      if (!SameRegs(regs, &reference[line]) || !SameRegs(&copy[line], &reference[line]))
+      {
+         printf("line %d: registers differ\n", line);
+         failed++;
+      }
+      if (memcmp(&cell_scroll_data[line], &cell_reference[line], sizeof(struct CellScrollData)) != 0)
+      {
+         printf("line %d: cell scroll data differs\n", line);
+         failed++;
+      }
+      if (Vdp2LineRunEnd(line, NUM_LINES) <= line)
+      {
+         printf("line %d: empty run\n", line);
+         failed++;
+      }
+   }
+
+   // line 0 and one per 16 lines for the scroll changes
+   printf("%d lines, %d snapshots taken\n", NUM_LINES, snapshots);
+   if (snapshots != 1 + (NUM_LINES - 5 + 15) / 16)
+   {
+      printf("expected %d snapshots\n", 1 + (NUM_LINES - 5 + 15) / 16);
+      failed++;
+   }
+
+   return failed;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+   yabauseinit_struct yinit;
+   int failed;
+
+   printf("%s v%s\n", PROG_NAME, VER_NAME);
+
+   memset(&yinit, 0, sizeof(yinit));
+   yinit.percoretype = PERCORE_DUMMY;
+   yinit.sh2coretype = SH2CORE_INTERPRETER;
+   yinit.vidcoretype = VIDCORE_DUMMY;
+   yinit.m68kcoretype = M68KCORE_DUMMY;
+   yinit.sndcoretype = SNDCORE_DUMMY;
+   yinit.cdcoretype = CDCORE_DUMMY;
+   yinit.carttype = CART_NONE;
+   yinit.regionid = REGION_AUTODETECT;
+   yinit.videoformattype = VIDEOFORMATTYPE_NTSC;
+   yinit.skip_load = 1;
+
+   if (YabauseInit(&yinit) != 0)
+   {
+      printf("YabauseInit failed\n");
+      return 1;
+   }
+
+   Vdp2WriteWord(0x000, 0x8000);                       // TVMD, 224 lines
+   Vdp2WriteWord(0x09C, (CELL_SCROLL_ADDR >> 1) >> 16); // VCSTA
+   Vdp2WriteWord(0x09E, (CELL_SCROLL_ADDR >> 1) & 0xFFFF);
+
+   PlayFrame();
+   failed = CheckFrame();
+
+   // a second frame starts from the state the first one left
+   PlayFrame();
+   failed += CheckFrame();
+
+   printf("%s\n", failed ? "FAIL" : "OK");
+
+   YabauseDeInit();
+   return failed ? 1 : 0;
+}
@@ -0,0 +1,333 @@
+/*
+        Copyright 2026 agent(agent@local)
+
+This file is part of YabaSanshiro.
+
+        YabaSanshiro is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+YabaSanshiro is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+along with YabaSanshiro; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*! \file trace.cpp
+    \brief Timeline of the emulation and worker threads.
+
+    Every thread that records an event gets its own ring the first time it
+    does, so recording takes no lock: a time stamp, a store and a bump of
+    the ring's head. Time stamps are the TSC on x86 and the monotonic clock
+    elsewhere, TraceStart and the writer take both clocks to convert them.
+    Rings stay around once made, threads come and go with the video
+    settings and a ring is small next to a frame buffer. TraceStart moves
+    every ring to a new generation and each thread empties its own ring on
+    its next event, so nothing but the owner ever writes a ring.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define TRACE_USE_TSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TRACE_USE_TSC
+#endif
+
+#include "trace.h"
+
+#define TRACE_MAX_THREADS 64
+#define TRACE_EVENTS (1 << 16)     // per thread, 1MB
+#define TRACE_NAME_LEN 32
+
+static const char * const tag_names[TRACE_NUM_TAGS] = {
+   "Frame",
+   "VBlankIn",
+   "VBlankOut",
+   "Vdp2VBlankIn",
+   "Vdp2VBlankOut",
+   "Vdp1Draw",
+   "ScspExec",
+   "ScspWait",
+   "VidsoftLayer",
+   "VidsoftVdp1",
+   "CdPrefetch",
+   "Ssh2Exec",
+   "Ssh2Wait",
+};
+
+typedef struct
+{
+   u64 time;
+   u32 tag;
+   u32 phase;
+} TraceRecord;
+
+typedef struct
+{
+   std::atomic<u32> head;
+   std::atomic<u32> generation;
+   char name[TRACE_NAME_LEN];
+   TraceRecord events[TRACE_EVENTS];
+} TraceBuffer;
+
+volatile int trace_enabled = 0;
+
+static std::atomic<TraceBuffer *> buffers[TRACE_MAX_THREADS];
+static std::atomic<int> num_buffers(0);
+static std::atomic<u32> generation(0);
+static u64 start_ticks, stop_ticks;
+static s64 start_ns, stop_ns;
+
+static thread_local TraceBuffer * local_buffer = NULL;
+static thread_local int local_full = 0;
+static thread_local char local_name[TRACE_NAME_LEN];
+
+//////////////////////////////////////////////////////////////////////////////
+
+static inline u64 TraceNow(void)
+{
+#ifdef TRACE_USE_TSC
+   return __rdtsc();
+#else
+   return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+static s64 TraceNowNs(void)
+{
+   return (s64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static TraceBuffer * TraceRegister(void)
+{
+   TraceBuffer * buf;
+   int slot;
+
+   if (local_full)
+      return NULL;
+
+   slot = num_buffers.fetch_add(1);
+   if (slot >= TRACE_MAX_THREADS || (buf = new (std::nothrow) TraceBuffer()) == NULL)
+   {
+      local_full = 1;
+      return NULL;
+   }
+
+   if (local_name[0] != '\0')
+      memcpy(buf->name, local_name, TRACE_NAME_LEN);
+   else
+      snprintf(buf->name, TRACE_NAME_LEN, "thread %d", slot + 1);
+   buf->generation.store(generation.load());
+
+   buffers[slot].store(buf, std::memory_order_release);
+   local_buffer = buf;
+   return buf;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+extern "C" {
+
+void TraceEvent(int tag, char phase)
+{
+   TraceBuffer * buf = local_buffer;
+   u32 gen = generation.load(std::memory_order_relaxed);
+   TraceRecord * e;
+   u32 head;
+
+   if (buf == NULL && (buf = TraceRegister()) == NULL)
+      return;
+
+   if (buf->generation.load(std::memory_order_relaxed) != gen)
+   {
+      buf->head.store(0, std::memory_order_relaxed);
+      buf->generation.store(gen, std::memory_order_release);
+   }
+
+   head = buf->head.load(std::memory_order_relaxed);
+   e = &buf->events[head & (TRACE_EVENTS - 1)];
+   e->time = TraceNow();
+   e->tag = tag;
+   e->phase = phase;
+   buf->head.store(head + 1, std::memory_order_release);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void TraceThreadName(const char * name)
+{
+   if (strncmp(local_name, name, TRACE_NAME_LEN - 1) == 0)
+      return;
+
+   strncpy(local_name, name, TRACE_NAME_LEN - 1);
+   local_name[TRACE_NAME_LEN - 1] = '\0';
+   if (local_buffer != NULL)
+      memcpy(local_buffer->name, local_name, TRACE_NAME_LEN);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void TraceStart(void)
+{
+   trace_enabled = 0;
+   generation.fetch_add(1);
+   start_ns = TraceNowNs();
+   start_ticks = TraceNow();
+   stop_ticks = 0;
+   trace_enabled = 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void TraceStop(void)
+{
+   if (!trace_enabled)
+      return;
+
+   trace_enabled = 0;
+   stop_ticks = TraceNow();
+   stop_ns = TraceNowNs();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// The events of one ring from this generation, oldest first. Events the
+// owner wrote over while they were copied are dropped.
+static void TraceCollect(TraceBuffer * buf, std::vector<TraceRecord> & out)
+{
+   u32 head, first, again, i;
+
+   out.clear();
+   if (buf->generation.load(std::memory_order_acquire) != generation.load())
+      return;
+
+   head = buf->head.load(std::memory_order_acquire);
+   first = head > TRACE_EVENTS ? head - TRACE_EVENTS : 0;
+   for (i = first; i != head; i++)
+      out.push_back(buf->events[i & (TRACE_EVENTS - 1)]);
+
+   again = buf->head.load(std::memory_order_acquire);
+   if (again - first > TRACE_EVENTS)
+   {
+      u32 lost = again - first - TRACE_EVENTS;
+      out.erase(out.begin(), out.begin() + (lost < out.size() ? lost : out.size()));
+   }
+}
+
+static int TraceNumBuffers(void)
+{
+   int count = num_buffers.load();
+   return count < TRACE_MAX_THREADS ? count : TRACE_MAX_THREADS;
+}
+
+int TraceCount(void)
+{
+   std::vector<TraceRecord> events;
+   int i, count = 0;
+
+   for (i = 0; i < TraceNumBuffers(); i++)
+   {
+      TraceBuffer * buf = buffers[i].load(std::memory_order_acquire);
+      if (buf == NULL)
+         continue;
+      TraceCollect(buf, events);
+      count += (int)events.size();
+   }
+
+   return count;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void TraceWriteString(FILE * fp, const char * s)
+{
+   fputc('"', fp);
+   for (; *s; s++)
+   {
+      if (*s == '"' || *s == '\\')
+         fputc('\\', fp);
+      if ((unsigned char)*s >= 0x20)
+         fputc(*s, fp);
+   }
+   fputc('"', fp);
+}
+
+int TraceWriteChrome(const char * filename)
+{
+   std::vector<TraceRecord> events;
+   u64 end_ticks = stop_ticks;
+   s64 end_ns = stop_ns;
+   double ticks_per_usec;
+   FILE * fp;
+   int i, first = 1;
+
+   if (end_ticks == 0)
+   {
+      end_ticks = TraceNow();
+      end_ns = TraceNowNs();
+   }
+   if (end_ns > start_ns && end_ticks > start_ticks)
+      ticks_per_usec = (double)(end_ticks - start_ticks) * 1000.0 / (double)(end_ns - start_ns);
+   else
+      ticks_per_usec = 1.0;
+
+   if ((fp = fopen(filename, "w")) == NULL)
+      return -1;
+
+   fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+   for (i = 0; i < TraceNumBuffers(); i++)
+   {
+      TraceBuffer * buf = buffers[i].load(std::memory_order_acquire);
+      size_t j;
+      int depth = 0;
+
+      if (buf == NULL)
+         continue;
+      TraceCollect(buf, events);
+      if (events.empty())
+         continue;
+
+      fprintf(fp, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":",
+         first ? "" : ",", i + 1);
+      TraceWriteString(fp, buf->name);
+      fprintf(fp, "}}");
+      first = 0;
+
+      for (j = 0; j < events.size(); j++)
+      {
+         const TraceRecord * e = &events[j];
+         double ts = e->time > start_ticks ? (double)(e->time - start_ticks) / ticks_per_usec : 0.0;
+
+         // the ring lost the begin of this one
+         if (e->phase == 'E' && depth == 0)
+            continue;
+         depth += e->phase == 'B' ? 1 : -1;
+
+         fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"yabause\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+            e->tag < TRACE_NUM_TAGS ? tag_names[e->tag] : "?", (char)e->phase, ts, i + 1);
+      }
+   }
+
+   fprintf(fp, "\n]}\n");
+   if (fclose(fp) != 0)
+      return -1;
+   return 0;
+}
+
+}
@@ -0,0 +1,88 @@
+/*
+        Copyright 2026 agent(agent@local)
+
+This file is part of YabaSanshiro.
+
+        YabaSanshiro is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+YabaSanshiro is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+along with YabaSanshiro; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*! \file trace.h
+    \brief Timeline of the emulation and worker threads, written out as a
+    Chrome trace (chrome://tracing, ui.perfetto.dev).
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Tags are fixed here so an event only stores a number. Keep the names in
+// trace.cpp in the same order.
+enum {
+   TRACE_FRAME = 0,           // YabauseEmulate
+   TRACE_VBLANK_IN,
+   TRACE_VBLANK_OUT,
+   TRACE_VDP2_VBLANK_IN,      // VdpProc
+   TRACE_VDP2_VBLANK_OUT,
+   TRACE_VDP1_DRAW,
+   TRACE_SCSP_EXEC,           // ScspAsynMain*
+   TRACE_SCSP_WAIT,
+   TRACE_VIDSOFT_LAYER,       // vidsoft worker pools
+   TRACE_VIDSOFT_VDP1,
+   TRACE_CD_PREFETCH,
+   TRACE_SSH2_EXEC,           // sh2thread
+   TRACE_SSH2_WAIT,
+   TRACE_NUM_TAGS
+};
+
+extern volatile int trace_enabled;
+
+#ifdef NO_TRACE
+#define TRACE_BEGIN(tag)
+#define TRACE_END(tag)
+#else
+#define TRACE_BEGIN(tag) do { if (trace_enabled) TraceEvent((tag), 'B'); } while (0)
+#define TRACE_END(tag) do { if (trace_enabled) TraceEvent((tag), 'E'); } while (0)
+#endif
+
+// TraceStart: drop what was recorded before and start recording
+void TraceStart(void);
+void TraceStop(void);
+
+// TraceEvent: record a begin ('B') or end ('E') of tag on the calling
+// thread. Each thread writes its own ring, the oldest events go first when
+// it fills up.
+void TraceEvent(int tag, char phase);
+
+// TraceThreadName: name the calling thread on the timeline, threads without
+// one show up as "thread n"
+void TraceThreadName(const char *name);
+
+// TraceCount: events recorded since TraceStart that are still in the rings
+int TraceCount(void);
+
+// TraceWriteChrome: write the rings as Chrome trace JSON. Returns 0 on
+// success.
+int TraceWriteChrome(const char *filename);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
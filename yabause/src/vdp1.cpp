@@ -52,6 +52,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 #include "vidsoft.h"
 #include "threads.h"
 #include "sh2core.h"
+#include "fastmem.h"
 #include <atomic>
 #include <condition_variable>
 #include <chrono>
@@ -63,6 +64,7 @@ namespace chrono = std::chrono;
 
 extern "C" {
 u8 * Vdp1Ram;
+u32 Vdp1RamPageWrites[VDP1_RAM_PAGES];
 u8 * Vdp1FrameBuffer[2];
 VideoInterface_struct *VIDCore = NULL;
 extern VideoInterface_struct *VIDCoreList[];
@@ -121,6 +123,7 @@ extern "C" u32 FASTCALL Vdp1RamReadLong(u32 addr) {
 extern "C" void FASTCALL Vdp1RamWriteByte(u32 addr, u8 val) {
    addr &= 0x7FFFF;
    T1WriteByte(Vdp1Ram, addr, val);
+   Vdp1RamPageWrites[addr >> VDP1_RAM_PAGE_SHIFT]++;
    vdp1_clock = 0;
 }
 
@@ -128,6 +131,7 @@ extern "C" void FASTCALL Vdp1RamWriteByte(u32 addr, u8 val) {
 extern "C" void FASTCALL Vdp1RamWriteWord(u32 addr, u16 val) {
    addr &= 0x7FFFF;
    T1WriteWord(Vdp1Ram, addr, val);
+   Vdp1RamPageWrites[addr >> VDP1_RAM_PAGE_SHIFT]++;
    vdp1_clock = 0;
 }
 
@@ -137,6 +141,25 @@ extern "C" void FASTCALL Vdp1RamWriteLong(u32 addr, u32 val) {
    //if(addr == 0x00000)
    //LOG("Vdp1RamWriteLong @ %08X", CurrentSH2->regs.PC);
    T1WriteLong(Vdp1Ram, addr, val);
+   Vdp1RamPageWrites[addr >> VDP1_RAM_PAGE_SHIFT]++;
+   vdp1_clock = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+extern "C" void Vdp1RamDirty(u32 addr, u32 size) {
+   u32 page = (addr & 0x7FFFF) >> VDP1_RAM_PAGE_SHIFT;
+   u32 count = (((addr & 0x7FFFF) & ((1 << VDP1_RAM_PAGE_SHIFT) - 1)) + size +
+      (1 << VDP1_RAM_PAGE_SHIFT) - 1) >> VDP1_RAM_PAGE_SHIFT;
+
+   if (count > VDP1_RAM_PAGES)
+      count = VDP1_RAM_PAGES;
+
+   while (count--) {
+      Vdp1RamPageWrites[page]++;
+      page = (page + 1) & (VDP1_RAM_PAGES - 1);
+   }
+
    vdp1_clock = 0;
 }
 
@@ -237,8 +260,9 @@ extern "C" int Vdp1Init(void) {
 
    memset(Vdp1Regs, 0, sizeof(Vdp1Regs));      
 
-   if ((Vdp1Ram = T1MemoryInit(0x80000)) == NULL)
+   if ((Vdp1Ram = FastmemMemoryInit(0x80000)) == NULL)
       return -1;
+   Vdp1RamDirty(0, 0x80000);
 
    // Allocate enough memory for two frames
    if ((Vdp1FrameBuffer[0] = T1MemoryInit(0x40000)) == NULL)
@@ -265,7 +289,7 @@ extern "C" void Vdp1DeInit(void) {
    Vdp1Regs = NULL;
 
    if (Vdp1Ram)
-      T1MemoryDeInit(Vdp1Ram);
+      FastmemMemoryDeInit(Vdp1Ram);
    Vdp1Ram = NULL;
 
    if (Vdp1FrameBuffer[0])
@@ -354,6 +378,7 @@ extern "C" void Vdp1Reset(void) {
 
    // Safe tarminator for Radient silvergun with no bios
    T1WriteWord(Vdp1Ram, 0x40000, 0x8000);
+   Vdp1RamDirty(0x40000, 2);
 
    vdp1_clock = 0;
 
@@ -852,7 +877,7 @@ extern "C" int Vdp1SaveState(FILE *fp)
    ywrite(&check, (void *)Vdp1Regs, sizeof(Vdp1), 1, fp);
 
    // Write VDP1 ram
-   ywrite(&check, (void *)Vdp1Ram, 0x80000, 1, fp);
+   StateWriteRam(&check, (void *)Vdp1Ram, 0x80000, fp);
 
 #ifdef IMPROVED_SAVESTATES
 
@@ -887,7 +912,8 @@ extern "C" int Vdp1LoadState(FILE *fp, UNUSED int version, int size)
    yread(&check, (void *)Vdp1Regs, sizeof(Vdp1), 1, fp);
 
    // Read VDP1 ram
-   yread(&check, (void *)Vdp1Ram, 0x80000, 1, fp);
+   StateReadRam(&check, (void *)Vdp1Ram, 0x80000, fp);
+   Vdp1RamDirty(0, 0x80000);
 
 #ifdef IMPROVED_SAVESTATES
 
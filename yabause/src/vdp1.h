@@ -125,6 +125,17 @@ extern VideoInterface_struct VIDDummy;
 
 extern u8 * Vdp1Ram;
 
+// Writes to each 4KB page of VDP1 ram. Renderers keeping data decoded from
+// the ram compare them to notice a change, code writing the ram without
+// Vdp1RamWrite* calls Vdp1RamDirty, which also holds the command drawing
+// back until the next line like a write does.
+#define VDP1_RAM_PAGE_SHIFT 12
+#define VDP1_RAM_PAGES (0x80000 >> VDP1_RAM_PAGE_SHIFT)
+
+extern u32 Vdp1RamPageWrites[VDP1_RAM_PAGES];
+
+void Vdp1RamDirty(u32 addr, u32 size);
+
 u8 FASTCALL	Vdp1RamReadByte(u32);
 u16 FASTCALL	Vdp1RamReadWord(u32);
 u32 FASTCALL	Vdp1RamReadLong(u32);
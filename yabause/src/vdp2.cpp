@@ -43,8 +43,10 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 */
 
 #include <stdlib.h>
+#include <stddef.h>
 #include "vdp2.h"
 #include "debug.h"
+#include "fastmem.h"
 #include "peripheral.h"
 #include "scu.h"
 #include "sh2core.h"
@@ -56,6 +58,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 #include "threads.h"
 #include "yui.h"
 #include "frameprofile.h"
+#include "trace.h"
 #include "vidogl.h"
 #include "vidsoft.h"
 #include <atomic>
@@ -64,6 +67,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 #endif
 
 u8 * Vdp2Ram;
+u32 Vdp2RamPageWrites[VDP2_RAM_PAGES];
 u8 * Vdp2ColorRam;
 Vdp2 * Vdp2Regs;
 Vdp2Internal_struct Vdp2Internal;
@@ -77,6 +81,16 @@ u8 B1_Updated = 0;
 
 struct CellScrollData cell_scroll_data[270];
 Vdp2 Vdp2Lines[270];
+u16 Vdp2LineSource[270];
+
+// Set by register writes and by vram writes to the cell scroll table, the
+// next line only takes a new snapshot when they are set
+static u8 Vdp2RegsUpdated = 1;
+static u8 CellScrollUpdated = 1;
+static u32 cell_scroll_addr = 0;
+
+#define CELL_SCROLL_TOUCHED(addr, size) \
+   ((u32)((addr) + (size) - 1 - cell_scroll_addr) < sizeof(struct CellScrollData) + (size) - 1)
 
 
 u32 skipped_frame = 0;
@@ -181,6 +195,10 @@ void FASTCALL Vdp2RamWriteByte(u32 addr, u8 val) {
      B1_Updated = 1;
    }
 
+   if (CELL_SCROLL_TOUCHED(addr, 1))
+     CellScrollUpdated = 1;
+   Vdp2RamPageWrites[addr >> VDP2_RAM_PAGE_SHIFT]++;
+
    T1WriteByte(Vdp2Ram, addr, val);
 }
 
@@ -210,6 +228,10 @@ void FASTCALL Vdp2RamWriteWord(u32 addr, u16 val) {
      B1_Updated = 1;
    }
 
+   if (CELL_SCROLL_TOUCHED(addr, 2))
+     CellScrollUpdated = 1;
+   Vdp2RamPageWrites[addr >> VDP2_RAM_PAGE_SHIFT]++;
+
    T1WriteWord(Vdp2Ram, addr, val);
 }
 
@@ -239,11 +261,51 @@ void FASTCALL Vdp2RamWriteLong(u32 addr, u32 val) {
      B1_Updated = 1;
    }
 
+   if (CELL_SCROLL_TOUCHED(addr, 4))
+     CellScrollUpdated = 1;
+   Vdp2RamPageWrites[addr >> VDP2_RAM_PAGE_SHIFT]++;
+
    T1WriteLong(Vdp2Ram, addr, val);
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
+void Vdp2RamDirty(u32 addr, u32 size) {
+   u32 page = (addr & 0x7FFFF) >> VDP2_RAM_PAGE_SHIFT;
+   u32 count = (((addr & 0x7FFFF) & ((1 << VDP2_RAM_PAGE_SHIFT) - 1)) + size +
+      (1 << VDP2_RAM_PAGE_SHIFT) - 1) >> VDP2_RAM_PAGE_SHIFT;
+
+   if (count > VDP2_RAM_PAGES)
+      count = VDP2_RAM_PAGES;
+
+   while (count--) {
+      Vdp2RamPageWrites[page]++;
+      page = (page + 1) & (VDP2_RAM_PAGES - 1);
+   }
+
+   // Same flags as Vdp2RamWrite*, for every bank the range reaches
+   addr &= 0x7FFFF;
+   if (size == 0)
+      return;
+   if (size > 0x80000 - addr) {
+      A0_Updated = A1_Updated = B0_Updated = B1_Updated = 1;
+      CellScrollUpdated = 1;
+      return;
+   }
+   if (addr < 0x20000)
+      A0_Updated = 1;
+   if (addr < 0x40000 && addr + size > 0x20000)
+      A1_Updated = 1;
+   if (addr < 0x60000 && addr + size > 0x40000)
+      B0_Updated = 1;
+   if (addr + size > 0x60000)
+      B1_Updated = 1;
+   if (CELL_SCROLL_TOUCHED(addr, size))
+      CellScrollUpdated = 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 u8 FASTCALL Vdp2ColorRamReadByte(u32 addr) {
    addr &= 0xFFF;
    return T2ReadByte(Vdp2ColorRam, addr);
@@ -336,13 +398,16 @@ int Vdp2Init(void) {
    if ((Vdp2Regs = (Vdp2 *) calloc(1, sizeof(Vdp2))) == NULL)
       return -1;
 
-   if ((Vdp2Ram = T1MemoryInit(0x80000)) == NULL)
+   if ((Vdp2Ram = FastmemMemoryInit(0x80000)) == NULL)
       return -1;
+   Vdp2RamDirty(0, 0x80000);
 
    if ((Vdp2ColorRam = T2MemoryInit(0x1000)) == NULL)
       return -1;
 
    memset(Vdp2Lines, 0, sizeof(Vdp2) * 270);
+   for (int i = 0; i < 270; i++)
+      Vdp2LineSource[i] = i;
 
    Vdp2Reset();
 
@@ -388,7 +453,7 @@ void Vdp2DeInit(void) {
    Vdp2Regs = NULL;
 
    if (Vdp2Ram)
-      T1MemoryDeInit(Vdp2Ram);
+      FastmemMemoryDeInit(Vdp2Ram);
    Vdp2Ram = NULL;
 
    if (Vdp2ColorRam)
@@ -402,6 +467,8 @@ void Vdp2DeInit(void) {
 //////////////////////////////////////////////////////////////////////////////
 
 void Vdp2Reset(void) {
+   Vdp2RegsUpdated = 1;
+   CellScrollUpdated = 1;
    Vdp2Regs->TVMD = 0x0000;
    Vdp2Regs->EXTEN = 0x0000;
    Vdp2Regs->TVSTAT = Vdp2Regs->TVSTAT & 0x1;
@@ -487,8 +554,8 @@ void Vdp2Reset(void) {
    Vdp2External.perline_alpha_b = 0;
    Vdp2External.perline_alpha = &Vdp2External.perline_alpha_a;
    Vdp2External.perline_alpha_draw = &Vdp2External.perline_alpha_b;
-   Vdp2External.cpu_cycle_a = 0;
-   Vdp2External.cpu_cycle_b = 0;
+   // the cpu wait states come from the cycle patterns just reset
+   VDP2genVRamCyclePattern();
 
 #if defined(YAB_ASYNC_RENDERING)
    if (rcv_evqueue != NULL){
@@ -519,25 +586,33 @@ extern "C" void * VdpProc( void *arg ){
     YabThreadSetCurrentThreadAffinityMask(YabThreadGetFastestCpuIndex());
   }
 
+  TraceThreadName("vdp");
+
   while( vdp_proc_running ){
     evcode = YabWaitEventQueue(evqueue);
     switch(evcode){
     case VDPEV_VBLANK_IN:
       FrameProfileAdd("VIN start");
+      TRACE_BEGIN(TRACE_VDP2_VBLANK_IN);
       vdp2VBlankIN();
+      TRACE_END(TRACE_VDP2_VBLANK_IN);
       FrameProfileAdd("VIN end");
       break;
     case VDPEV_VBLANK_OUT:
       FrameProfileAdd("VOUT start");
+      TRACE_BEGIN(TRACE_VDP2_VBLANK_OUT);
       vdp2VBlankOUT();
+      TRACE_END(TRACE_VDP2_VBLANK_OUT);
       FrameProfileAdd("VOUT end");
       //YabAddEventQueue(vout_rcv_evqueue, 0);
       break;
     case VDPEV_DIRECT_DRAW:
       FrameProfileAdd("DirectDraw start");
       FRAMELOG("VDP1: VDPEV_DIRECT_DRAW(T)");
+      TRACE_BEGIN(TRACE_VDP1_DRAW);
       Vdp1Draw();
       VIDCore->Vdp1DrawEnd();
+      TRACE_END(TRACE_VDP1_DRAW);
       Vdp1External.frame_change_plot = 0;
       FrameProfileAdd("DirectDraw end");
       YabAddEventQueue(vdp1_rcv_evqueue, 0);
@@ -550,6 +625,9 @@ extern "C" void * VdpProc( void *arg ){
       YuiRevokeOGLOnThisThread();
       YabAddEventQueue(command_,0);
       break;
+    case VDPEV_QUIESCE:
+      YabAddEventQueue(command_,0);
+      break;
     case VDPEV_FINSH:
       vdp_proc_running = 0;
       break;
@@ -893,6 +971,14 @@ using std::atomic;
 extern atomic<int> vdp1_clock;
 
 
+// TVSTAT, HCNT and VCNT change on every line but are only read from Vdp2Regs
+static int Vdp2LineRegsChanged(const Vdp2 * prev) {
+  const size_t start = offsetof(Vdp2, VCNT) + sizeof(u16);
+  if (Vdp2Regs->TVMD != prev->TVMD || Vdp2Regs->EXTEN != prev->EXTEN || Vdp2Regs->VRSIZE != prev->VRSIZE)
+    return 1;
+  return memcmp((const u8 *)Vdp2Regs + start, (const u8 *)prev + start, sizeof(Vdp2) - start) != 0;
+}
+
 void Vdp2HBlankOUT(void) {
   int i;
   if (yabsys.LineCount < yabsys.VBlankLineCount)
@@ -900,81 +986,102 @@ void Vdp2HBlankOUT(void) {
     ScuRemoveHBlankIN();
     
     Vdp2Regs->TVSTAT &= ~0x0004;
-    u32 cell_scroll_table_start_addr = (Vdp2Regs->VCSTA.all & 0x7FFFE) << 1;
-    memcpy(Vdp2Lines + yabsys.LineCount, Vdp2Regs, sizeof(Vdp2));
-    for (i = 0; i < 88; i++)
-    {
-      cell_scroll_data[yabsys.LineCount].data[i] = Vdp2RamReadLong(cell_scroll_table_start_addr + i * 4);
-    }
+    u32 cell_scroll_table_start_addr = ((Vdp2Regs->VCSTA.all & 0x7FFFE) << 1) & 0x7FFFF;
 
-
-    if ((Vdp2Lines[0].BGON & 0x01) != (Vdp2Lines[yabsys.LineCount].BGON & 0x01)){
-      *Vdp2External.perline_alpha |= 0x1;
+    // Lines nobody wrote registers for share the snapshot of the line before
+    if (yabsys.LineCount == 0 || (Vdp2RegsUpdated && Vdp2LineRegsChanged(&Vdp2Lines[Vdp2LineSource[yabsys.LineCount - 1]]))) {
+      memcpy(Vdp2Lines + yabsys.LineCount, Vdp2Regs, sizeof(Vdp2));
+      Vdp2LineSource[yabsys.LineCount] = yabsys.LineCount;
     }
-    else if ((Vdp2Lines[0].CCRNA & 0x00FF) != (Vdp2Lines[yabsys.LineCount].CCRNA & 0x00FF)){
-      *Vdp2External.perline_alpha |= 0x1;
+    else {
+      Vdp2LineSource[yabsys.LineCount] = Vdp2LineSource[yabsys.LineCount - 1];
     }
+    Vdp2RegsUpdated = 0;
 
-    if ((Vdp2Lines[0].BGON & 0x02) != (Vdp2Lines[yabsys.LineCount].BGON & 0x02)){
-      *Vdp2External.perline_alpha |= 0x2;
+    if (yabsys.LineCount == 0 || CellScrollUpdated ||
+        cell_scroll_table_start_addr != cell_scroll_addr ||
+        cell_scroll_table_start_addr + sizeof(struct CellScrollData) > 0x80000) {
+      for (i = 0; i < 88; i++)
+      {
+        cell_scroll_data[yabsys.LineCount].data[i] = Vdp2RamReadLong(cell_scroll_table_start_addr + i * 4);
+      }
+      cell_scroll_addr = cell_scroll_table_start_addr;
+      CellScrollUpdated = 0;
     }
-    else if ((Vdp2Lines[0].CCRNA & 0xFF00) != (Vdp2Lines[yabsys.LineCount].CCRNA & 0xFF00)){
-      *Vdp2External.perline_alpha |= 0x2;
+    else {
+      cell_scroll_data[yabsys.LineCount] = cell_scroll_data[yabsys.LineCount - 1];
     }
 
-    if ((Vdp2Lines[0].BGON & 0x04) != (Vdp2Lines[yabsys.LineCount].BGON & 0x04)){
-      *Vdp2External.perline_alpha |= 0x4;
-    }
-    else if ((Vdp2Lines[0].CCRNB & 0xFF00) != (Vdp2Lines[yabsys.LineCount].CCRNB & 0xFF00)){
-      *Vdp2External.perline_alpha |= 0x4;
-    }
+    // a shared snapshot was already compared when it was taken
+    if (Vdp2LineSource[yabsys.LineCount] == yabsys.LineCount) {
+      if ((Vdp2Lines[0].BGON & 0x01) != (Vdp2Lines[yabsys.LineCount].BGON & 0x01)){
+        *Vdp2External.perline_alpha |= 0x1;
+      }
+      else if ((Vdp2Lines[0].CCRNA & 0x00FF) != (Vdp2Lines[yabsys.LineCount].CCRNA & 0x00FF)){
+        *Vdp2External.perline_alpha |= 0x1;
+      }
 
-    if ((Vdp2Lines[0].BGON & 0x08) != (Vdp2Lines[yabsys.LineCount].BGON & 0x08)){
-      *Vdp2External.perline_alpha |= 0x8;
-    }
-    else if ((Vdp2Lines[0].CCRNB & 0x00FF) != (Vdp2Lines[yabsys.LineCount].CCRNB & 0x00FF)){
-      *Vdp2External.perline_alpha |= 0x8;
-    }
+      if ((Vdp2Lines[0].BGON & 0x02) != (Vdp2Lines[yabsys.LineCount].BGON & 0x02)){
+        *Vdp2External.perline_alpha |= 0x2;
+      }
+      else if ((Vdp2Lines[0].CCRNA & 0xFF00) != (Vdp2Lines[yabsys.LineCount].CCRNA & 0xFF00)){
+        *Vdp2External.perline_alpha |= 0x2;
+      }
 
-    if ((Vdp2Lines[0].BGON & 0x10) != (Vdp2Lines[yabsys.LineCount].BGON & 0x10)){
-      *Vdp2External.perline_alpha |= 0x10;
-    }
-    else if (Vdp2Lines[0].CCRR != Vdp2Lines[yabsys.LineCount].CCRR){
-      *Vdp2External.perline_alpha |= 0x10;
-    }
+      if ((Vdp2Lines[0].BGON & 0x04) != (Vdp2Lines[yabsys.LineCount].BGON & 0x04)){
+        *Vdp2External.perline_alpha |= 0x4;
+      }
+      else if ((Vdp2Lines[0].CCRNB & 0xFF00) != (Vdp2Lines[yabsys.LineCount].CCRNB & 0xFF00)){
+        *Vdp2External.perline_alpha |= 0x4;
+      }
 
-    if (Vdp2Lines[0].COBR != Vdp2Lines[yabsys.LineCount].COBR){
+      if ((Vdp2Lines[0].BGON & 0x08) != (Vdp2Lines[yabsys.LineCount].BGON & 0x08)){
+        *Vdp2External.perline_alpha |= 0x8;
+      }
+      else if ((Vdp2Lines[0].CCRNB & 0x00FF) != (Vdp2Lines[yabsys.LineCount].CCRNB & 0x00FF)){
+        *Vdp2External.perline_alpha |= 0x8;
+      }
 
-      *Vdp2External.perline_alpha |= Vdp2Lines[yabsys.LineCount].CLOFEN;
-    }
-    if (Vdp2Lines[0].COAR != Vdp2Lines[yabsys.LineCount].COAR){
+      if ((Vdp2Lines[0].BGON & 0x10) != (Vdp2Lines[yabsys.LineCount].BGON & 0x10)){
+        *Vdp2External.perline_alpha |= 0x10;
+      }
+      else if (Vdp2Lines[0].CCRR != Vdp2Lines[yabsys.LineCount].CCRR){
+        *Vdp2External.perline_alpha |= 0x10;
+      }
 
-      *Vdp2External.perline_alpha |= Vdp2Lines[yabsys.LineCount].CLOFEN;
-    }
+      if (Vdp2Lines[0].COBR != Vdp2Lines[yabsys.LineCount].COBR){
+
+        *Vdp2External.perline_alpha |= Vdp2Lines[yabsys.LineCount].CLOFEN;
+      }
+      if (Vdp2Lines[0].COAR != Vdp2Lines[yabsys.LineCount].COAR){
 
-    if (Vdp2Lines[0].CLOFSL != Vdp2Lines[yabsys.LineCount].CLOFSL) {
+        *Vdp2External.perline_alpha |= Vdp2Lines[yabsys.LineCount].CLOFEN;
+      }
 
-      *Vdp2External.perline_alpha |= Vdp2Lines[yabsys.LineCount].CLOFEN;
-    }
+      if (Vdp2Lines[0].CLOFSL != Vdp2Lines[yabsys.LineCount].CLOFSL) {
 
-    if (Vdp2Lines[0].PRISA != Vdp2Lines[yabsys.LineCount].PRISA) {
+        *Vdp2External.perline_alpha |= Vdp2Lines[yabsys.LineCount].CLOFEN;
+      }
 
-      *Vdp2External.perline_alpha |= 0x40;
-    }
+      if (Vdp2Lines[0].PRISA != Vdp2Lines[yabsys.LineCount].PRISA) {
 
-    if ( Vdp2Lines[0].SCYN2 != Vdp2Lines[yabsys.LineCount].SCYN2  ||  Vdp2Lines[0].SCXN2 != Vdp2Lines[yabsys.LineCount].SCXN2 ) {
+        *Vdp2External.perline_alpha |= 0x40;
+      }
 
-      *Vdp2External.perline_alpha |= 0x100;
-    }
+      if ( Vdp2Lines[0].SCYN2 != Vdp2Lines[yabsys.LineCount].SCYN2  ||  Vdp2Lines[0].SCXN2 != Vdp2Lines[yabsys.LineCount].SCXN2 ) {
 
-    if ( Vdp2Lines[0].SCYN3 != Vdp2Lines[yabsys.LineCount].SCYN3  ||  Vdp2Lines[0].SCXN3 != Vdp2Lines[yabsys.LineCount].SCXN3 ) {
+        *Vdp2External.perline_alpha |= 0x100;
+      }
 
-      *Vdp2External.perline_alpha |= 0x80;
-    }
+      if ( Vdp2Lines[0].SCYN3 != Vdp2Lines[yabsys.LineCount].SCYN3  ||  Vdp2Lines[0].SCXN3 != Vdp2Lines[yabsys.LineCount].SCXN3 ) {
+
+        *Vdp2External.perline_alpha |= 0x80;
+      }
 
 
-    if (Vdp2Lines[0].PRINA != Vdp2Lines[yabsys.LineCount].PRINA) {
-      //printf("Perline priority");
+      if (Vdp2Lines[0].PRINA != Vdp2Lines[yabsys.LineCount].PRINA) {
+        //printf("Perline priority");
+      }
     }
   }
 
@@ -1082,7 +1189,31 @@ void Vdp2HBlankOUT(void) {
 //////////////////////////////////////////////////////////////////////////////
 
 Vdp2 * Vdp2RestoreRegs(int line, Vdp2* lines) {
-   return line > 270 ? NULL : lines + line;
+   if (line >= 270) return NULL;
+   return lines == Vdp2Lines ? lines + Vdp2LineSource[line] : lines + line;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int Vdp2LineRunEnd(int line, int end) {
+   int next = line + 1;
+   if (end > 270) end = 270;
+   while (next < end && Vdp2LineSource[next] == Vdp2LineSource[line])
+      next++;
+   return next;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void Vdp2CopyLines(Vdp2 * dst) {
+   int line = 0;
+   while (line < 270) {
+      int end = Vdp2LineRunEnd(line, 270);
+      memcpy(dst + line, Vdp2Lines + Vdp2LineSource[line], sizeof(Vdp2));
+      for (int i = line + 1; i < end; i++)
+         memcpy(dst + i, dst + line, sizeof(Vdp2));
+      line = end;
+   }
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -1180,10 +1311,12 @@ void restorevram() {
   FILE * fp = fopen("vdp2vram.bin", "rb");
   fread(Vdp2Regs, sizeof(Vdp2), 1, fp);
   fread(Vdp2Ram, 0x80000, 1, fp);
+  Vdp2RamDirty(0, 0x80000);
   fread(Vdp2ColorRam, 0x1000, 1, fp);
   fread(&Vdp2Internal, sizeof(Vdp2Internal_struct), 1, fp);
   fread((void *)Vdp1Regs, sizeof(Vdp1), 1, fp);
   fread((void *)Vdp1Ram, 0x80000, 1, fp);
+  Vdp1RamDirty(0, 0x80000);
   fread(&Vdp1External, sizeof(Vdp1External_struct), 1, fp);
   fclose(fp);
 
@@ -1964,6 +2097,7 @@ void FASTCALL Vdp2WriteByte(u32 addr, UNUSED u8 val) {
 
 void FASTCALL Vdp2WriteWord(u32 addr, u16 val) {
    addr &= 0x1FF;
+   Vdp2RegsUpdated = 1;
 
    switch (addr)
    {
@@ -2465,7 +2599,7 @@ int Vdp2SaveState(FILE *fp)
    ywrite(&check, (void *)Vdp2Regs, sizeof(Vdp2), 1, fp);
 
    // Write VDP2 ram
-   ywrite(&check, (void *)Vdp2Ram, 0x80000, 1, fp);
+   StateWriteRam(&check, (void *)Vdp2Ram, 0x80000, fp);
 
    // Write CRAM
    ywrite(&check, (void *)Vdp2ColorRam, 0x1000, 1, fp);
@@ -2484,9 +2618,12 @@ int Vdp2LoadState(FILE *fp, UNUSED int version, int size)
 
    // Read registers
    yread(&check, (void *)Vdp2Regs, sizeof(Vdp2), 1, fp);
+   Vdp2RegsUpdated = 1;
+   CellScrollUpdated = 1;
 
    // Read VDP2 ram
-   yread(&check, (void *)Vdp2Ram, 0x80000, 1, fp);
+   StateReadRam(&check, (void *)Vdp2Ram, 0x80000, fp);
+   Vdp2RamDirty(0, 0x80000);
 
    // Read CRAM
    yread(&check, (void *)Vdp2ColorRam, 0x1000, 1, fp);
@@ -2494,6 +2631,9 @@ int Vdp2LoadState(FILE *fp, UNUSED int version, int size)
    // Read internal variables
    yread(&check, (void *)&Vdp2Internal, sizeof(Vdp2Internal_struct), 1, fp);
 
+   // not saved, the wait states of the loaded cycle patterns
+   VDP2genVRamCyclePattern();
+
    //if(VIDCore) VIDCore->Resize(0,0,-1,-1,0,0);
 
    for (int i = 0; i < 0x1000; i += 2) {
@@ -2583,6 +2723,14 @@ void VdpRevoke( void ){
 #endif
 }
 
+void VdpQuiesce( void ){
+#if defined(YAB_ASYNC_RENDERING)
+  if (vdp_proc_running == 0) return;
+  YabAddEventQueue(evqueue,VDPEV_QUIESCE);
+  YabWaitEventQueue(command_);
+#endif
+}
+
 
 
 //////////////////////////////////////////////////////////////////////////////
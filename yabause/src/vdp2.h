@@ -64,6 +64,16 @@ void FASTCALL   Vdp2RamWriteByte(u32, u8);
 void FASTCALL   Vdp2RamWriteWord(u32, u16);
 void FASTCALL   Vdp2RamWriteLong(u32, u32);
 
+// Writes to each 4KB page of VDP2 ram, kept like Vdp1RamPageWrites. Code
+// writing the ram without Vdp2RamWrite* calls Vdp2RamDirty, which also sets
+// the bank and cell scroll flags a write sets.
+#define VDP2_RAM_PAGE_SHIFT 12
+#define VDP2_RAM_PAGES (0x80000 >> VDP2_RAM_PAGE_SHIFT)
+
+extern u32 Vdp2RamPageWrites[VDP2_RAM_PAGES];
+
+void Vdp2RamDirty(u32 addr, u32 size);
+
 u8 FASTCALL     Vdp2ColorRamReadByte(u32);
 u16 FASTCALL    Vdp2ColorRamReadWord(u32);
 u32 FASTCALL    Vdp2ColorRamReadLong(u32);
@@ -393,6 +403,11 @@ extern s64 lastticks;
 extern int vdp2_is_odd_frame;
 extern Vdp2 Vdp2Lines[270];
 
+// Index of the entry of Vdp2Lines holding the registers of each line. A line
+// whose registers did not change since the line before shares its entry, so
+// read Vdp2Lines through Vdp2RestoreRegs.
+extern u16 Vdp2LineSource[270];
+
 struct CellScrollData
 {
    u32 data[88];//(352/8) * 2 screens
@@ -450,6 +465,10 @@ void VdpResume(void);
 void VDP2SetFrameLimit(int mode);
 
 Vdp2 * Vdp2RestoreRegs(int line, Vdp2* lines);
+// first line after line, at most end, whose registers differ from line's
+int Vdp2LineRunEnd(int line, int end);
+// expands Vdp2Lines into 270 entries, one per line
+void Vdp2CopyLines(Vdp2 * dst);
 
 #include "threads.h"
 void * VdpProc( void *arg );
@@ -460,6 +479,7 @@ void * VdpProc( void *arg );
 #define VDPEV_DIRECT_DRAW 0x200
 #define VDPEV_MAKECURRENT 0x300
 #define VDPEV_REVOKE 0x400
+#define VDPEV_QUIESCE 0x500
 #define VDPEV_FINSH 0xFF00
 
 extern YabEventQueue * evqueue;
@@ -475,6 +495,9 @@ void YglOnUpdateColorRamWord(u32 addr);
 void YglUpdateColorRam();
 void VdpResume( void );
 void VdpRevoke( void );
+// VdpQuiesce: returns once the rendering thread has run every event queued
+// so far. It stays idle until the emulation thread queues more.
+void VdpQuiesce( void );
 
 #ifdef __cplusplus
 }
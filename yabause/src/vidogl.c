@@ -2568,6 +2568,33 @@ static void FASTCALL Vdp2DrawBitmapCoordinateInc(vdp2draw_struct *info, YglTextu
   }
 }
 
+// Everything Vdp2DrawCell reads besides the character pattern. Cells whose
+// context and pattern are unchanged are drawn from texels of earlier frames.
+static u64 Vdp2CellContext(vdp2draw_struct *info, u32 size)
+{
+  u64 context = 14695981039346656037ULL;
+#define CELL_CONTEXT(v) context = (context ^ (u64)(u32)(v)) * 1099511628211ULL
+  CELL_CONTEXT(info->colornumber);
+  CELL_CONTEXT(info->cellw);
+  CELL_CONTEXT(info->cellh);
+  CELL_CONTEXT(info->patternwh);
+  CELL_CONTEXT(info->transparencyenable);
+  CELL_CONTEXT(info->coloroffset);
+  CELL_CONTEXT(info->paladdr);
+  CELL_CONTEXT(info->alpha);
+  CELL_CONTEXT(info->specialprimode);
+  CELL_CONTEXT(info->specialprimode == 2 ? info->priority : 0);
+  CELL_CONTEXT(info->specialfunction);
+  CELL_CONTEXT(info->specialcode);
+  CELL_CONTEXT(info->specialcolormode);
+  CELL_CONTEXT(info->specialcolorfunction);
+  CELL_CONTEXT((fixVdp2Regs->CCCTL >> 8) & 0x01);
+  CELL_CONTEXT(info->char_bank[(info->charaddr >> 17) & 0x03]);
+  CELL_CONTEXT(info->char_bank[((info->charaddr + size - 1) >> 17) & 0x03]);
+#undef CELL_CONTEXT
+  return context;
+}
+
 static void Vdp2DrawPatternPos(vdp2draw_struct *info, YglTexture *texture, int x, int y, int cx, int cy, int lines )
 {
   u64 cacheaddr = (((u64)(info->priority&0xF))<<35) | ((u32)(info->alpha >> 3) << 27) |
@@ -2631,16 +2658,33 @@ static void Vdp2DrawPatternPos(vdp2draw_struct *info, YglTexture *texture, int x
   tile.cob = info->cob;
 
 
-  if (1 == YglIsCached(_Ygl->texture_manager, cacheaddr, &c))
-  {
-    //printf("x=%d,y=%d %lx cached\n",x,y,cacheaddr);
-    YglCachedQuadOffset(&tile, &c, cx, cy, info->coordincx, info->coordincy);
-    return;
+  // special color mode 3 reads color ram, those cells last one frame
+  if (info->specialcolormode != 3) {
+    static const int cell_bits[] = { 4, 8, 16, 16, 32, 32, 32, 32 };
+    u32 charaddr = info->charaddr & 0x7FFFF;
+    u32 size = (info->cellw * info->cellh * cell_bits[info->colornumber & 0x07] / 8) * info->patternwh * info->patternwh;
+    u64 context = Vdp2CellContext(info, size);
+
+    if (1 == YglIsCachedVram(_Ygl->texture_manager, cacheaddr, charaddr, size, context, &c))
+    {
+      YglCachedQuadOffset(&tile, &c, cx, cy, info->coordincx, info->coordincy);
+      return;
+    }
+    YglQuadOffset(&tile, texture, &c, cx, cy, info->coordincx, info->coordincy);
+    YglCacheAddVram(_Ygl->texture_manager, cacheaddr, charaddr, size, context, &c);
   }
+  else {
+    if (1 == YglIsCached(_Ygl->texture_manager, cacheaddr, &c))
+    {
+      //printf("x=%d,y=%d %lx cached\n",x,y,cacheaddr);
+      YglCachedQuadOffset(&tile, &c, cx, cy, info->coordincx, info->coordincy);
+      return;
+    }
 
-  //printf("x=%d,y=%d %lx not cached\n",x,y,cacheaddr);
-  YglQuadOffset(&tile, texture, &c, cx, cy, info->coordincx, info->coordincy);
-  YglCacheAdd(_Ygl->texture_manager, cacheaddr, &c);
+    //printf("x=%d,y=%d %lx not cached\n",x,y,cacheaddr);
+    YglQuadOffset(&tile, texture, &c, cx, cy, info->coordincx, info->coordincy);
+    YglCacheAdd(_Ygl->texture_manager, cacheaddr, &c);
+  }
 
   switch (info->patternwh)
   {
@@ -6321,12 +6365,14 @@ void Vdp2GeneratePerLineColorCalcuration(vdp2draw_struct * info, int id) {
 
     linebuf = YglGetPerlineBuf(&_Ygl->bg[id], _Ygl->rheight, 1);
     for (line = 0; line < _Ygl->rheight; line++) {
-      if ((Vdp2Lines[line >> line_shift].BGON & bit) == 0x00) {
+      Vdp2 * lVdp2Regs = Vdp2RestoreRegs(line >> line_shift, Vdp2Lines);
+      int run_end;
+      if ((lVdp2Regs->BGON & bit) == 0x00) {
         linebuf[line] = 0x00;
       }
       else {
         info->enable = 1;
-        if (Vdp2Lines[line >> line_shift].CCCTL & bit)
+        if (lVdp2Regs->CCCTL & bit)
         {
           if (fixVdp2Regs->CCCTL&0x100) { // Add Color
             info->blendmode |= VDP2_CC_ADD;
@@ -6337,19 +6383,19 @@ void Vdp2GeneratePerLineColorCalcuration(vdp2draw_struct * info, int id) {
  
          switch            (id) {
           case NBG0:
-            linebuf[line] = (((~Vdp2Lines[line >> line_shift].CCRNA & 0x1F) << 3) + 0x7) << 24;
+            linebuf[line] = (((~lVdp2Regs->CCRNA & 0x1F) << 3) + 0x7) << 24;
             break;
           case NBG1:
-            linebuf[line] = (((~Vdp2Lines[line >> line_shift].CCRNA & 0x1F00) >> 5) + 0x7) << 24;
+            linebuf[line] = (((~lVdp2Regs->CCRNA & 0x1F00) >> 5) + 0x7) << 24;
             break;
           case NBG2:
-            linebuf[line] = (((~Vdp2Lines[line >> line_shift].CCRNB & 0x1F) << 3) + 0x7) << 24;
+            linebuf[line] = (((~lVdp2Regs->CCRNB & 0x1F) << 3) + 0x7) << 24;
             break;
           case NBG3:
-            linebuf[line] = (((~Vdp2Lines[line >> line_shift].CCRNB & 0x1F00) >> 5) + 0x7) << 24;
+            linebuf[line] = (((~lVdp2Regs->CCRNB & 0x1F00) >> 5) + 0x7) << 24;
             break;
           case RBG0:
-            linebuf[line] = (((~Vdp2Lines[line >> line_shift].CCRR & 0x1F) << 3) + 0x7) << 24;
+            linebuf[line] = (((~lVdp2Regs->CCRR & 0x1F) << 3) + 0x7) << 24;
             break;
           }
 
@@ -6358,8 +6404,8 @@ void Vdp2GeneratePerLineColorCalcuration(vdp2draw_struct * info, int id) {
           linebuf[line] = 0xFF000000;
         }
 
-        if ( (Vdp2Lines[line >> line_shift].CLOFEN  & bit) != 0) {
-          ReadVdp2ColorOffset(&Vdp2Lines[line >> line_shift], info, bit);
+        if ( (lVdp2Regs->CLOFEN  & bit) != 0) {
+          ReadVdp2ColorOffset(lVdp2Regs, info, bit);
           linebuf[line] |= ((int)(128.0f + (info->cor / 2.0)) & 0xFF) << 0;
           linebuf[line] |= ((int)(128.0f + (info->cog / 2.0)) & 0xFF) << 8;
           linebuf[line] |= ((int)(128.0f + (info->cob / 2.0)) & 0xFF) << 16;
@@ -6368,7 +6414,13 @@ void Vdp2GeneratePerLineColorCalcuration(vdp2draw_struct * info, int id) {
           linebuf[line] |= 0x00808080;
         }
 
-      }
+      }
+
+      // the lines sharing these registers get the same value
+      run_end = Vdp2LineRunEnd(line >> line_shift, 270) << line_shift;
+      for (; line + 1 < run_end && line + 1 < _Ygl->rheight; line++) {
+        linebuf[line + 1] = linebuf[line];
+      }
     }
     YglSetPerlineBuf(&_Ygl->bg[id], linebuf, _Ygl->rheight, 1);
     info->lineTexture = _Ygl->bg[id].lincolor_tex;
@@ -8421,6 +8473,9 @@ void VIDOGLSetSettingValueMode(int type, int value) {
   case VDP_SETTING_ROTATE_SCREEN:
     _Ygl->rotate_screen = value;
     break;
+  case VDP_SETTING_VDP1_ASYNC_READBACK:
+    _Ygl->vdp1_async_readback = value;
+    break;
   }
 
   return;
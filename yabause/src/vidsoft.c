@@ -30,6 +30,7 @@
 #include "debug.h"
 #include "vdp2.h"
 #include "titan/titan.h"
+#include "vidsoftvdp1.h"
 
 #ifdef HAVE_LIBGL
 #define USE_OPENGL
@@ -41,6 +42,7 @@
 
 #include "yui.h"
 #include "threads.h"
+#include "trace.h"
 
 #include <stdlib.h>
 #include <limits.h>
@@ -103,7 +105,7 @@ void VIDSoftVdp1SwapFrameBuffer(void);
 void VIDSoftVdp1EraseFrameBuffer(Vdp1* regs, u8 * back_framebuffer);
 void VIDSoftSetSettingValueMode(int type, int value){};
 void VIDSoftSync(){};
-void VIDSoftVdp2DispOff(void);void VidsoftDrawSprite(Vdp2 * vdp2_regs, u8 * sprite_window_mask, u8* vdp1_front_framebuffer, u8 * vdp2_ram, Vdp1* vdp1_regs, Vdp2* vdp2_lines, u8*color_ram);
+void VIDSoftVdp2DispOff(void);void VidsoftDrawSprite(Vdp2 * vdp2_regs, u8 * sprite_window_mask, u8* vdp1_front_framebuffer, u8 * vdp2_ram, Vdp1* vdp1_regs, Vdp2* vdp2_lines, u8*color_ram, int band_start, int band_end);
 void VIDSoftGetNativeResolution(int *width, int *height, int*interlace);
 void VIDSoftVdp2DispOff(void);void VIDSoftVdp2DispOff(void);
 void VIDSoftOnUpdateColorRamWord(u32 addr) {}
@@ -177,6 +179,10 @@ int vdp2_interlace = 0;
 static int rbg0height = 0;
 int bilinear = 0;
 int vidsoft_num_layer_threads = 0;
+
+// layers are cut in bands of this many lines for the worker pool
+#define VIDSOFT_BAND_LINES 16
+#define VIDSOFT_ALL_LINES 1024
 int bad_cycle_setting[6] = { 0 };
 
 struct VidsoftVdp1ThreadContext
@@ -190,6 +196,8 @@ struct VidsoftVdp1ThreadContext
 
 int vidsoft_vdp1_thread_enabled = 0;
 
+static int vidsoft_vdp1_rasterizer = VIDSOFT_VDP1_RASTER_SPAN;
+
 typedef struct { s16 x; s16 y; } vdp1vertex;
 
 typedef struct
@@ -829,7 +837,23 @@ void Vdp2GetInterlaceInfo(int * start_line, int * line_increment)
 
 //////////////////////////////////////////////////////////////////////////////
 
-static void FASTCALL Vdp2DrawScroll(vdp2draw_struct *info, Vdp2* lines, Vdp2* regs, u8* ram, u8* color_ram, struct CellScrollData * cell_data)
+static int mosaic_table[16][1024];
+
+static void VidsoftBuildMosaicTable(void)
+{
+   int i, j;
+
+   for(i=0;i<16;i++)
+   {
+      int m = i+1;
+      for(j=0;j<1024;j++)
+         mosaic_table[i][j] = j/m*m;
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void FASTCALL Vdp2DrawScroll(vdp2draw_struct *info, Vdp2* lines, Vdp2* regs, u8* ram, u8* color_ram, struct CellScrollData * cell_data, int band_start, int band_end)
 {
    int i, j;
    int x, y;
@@ -849,6 +873,15 @@ static void FASTCALL Vdp2DrawScroll(vdp2draw_struct *info, Vdp2* lines, Vdp2* re
    float lineszoom_table[512] = { 0 };
    int num_vertical_cell_scroll_enabled = 0;
 
+   // the bad cycle emulation pipelines tiles from one line into the next, so
+   // such a layer is drawn in one piece by the job owning the first band
+   if (bad_cycle)
+   {
+      if (band_start > 0)
+         return;
+      band_end = VIDSOFT_ALL_LINES;
+   }
+
    SetupScreenVars(info, &sinfo, info->PlaneAddr, regs);
 
    scrolly = info->y;
@@ -862,22 +895,8 @@ static void FASTCALL Vdp2DrawScroll(vdp2draw_struct *info, Vdp2* lines, Vdp2* re
    line_window_base[1] = linewnd1addr;
    /* color calculation window: in => no color calc, out => color calc */
    ReadWindowData(regs->WCTLD >> 8, colorcalcwindow, regs);
-   {
-	   static int tables_initialized = 0;
-	   static int mosaic_table[16][1024];
-	   if(!tables_initialized)
-	   {
-		   tables_initialized = 1;
-			for(i=0;i<16;i++)
-			{
-				int m = i+1;
-				for(j=0;j<1024;j++)
-					mosaic_table[i][j] = j/m*m;
-			}
-	   }
-	   mosaic_x = mosaic_table[info->mosaicxmask-1];
-	   mosaic_y = mosaic_table[info->mosaicymask-1];
-   }
+   mosaic_x = mosaic_table[info->mosaicxmask-1];
+   mosaic_y = mosaic_table[info->mosaicymask-1];
 
    Vdp2GetInterlaceInfo(&start_line, &line_increment);
 
@@ -1005,6 +1024,13 @@ static void FASTCALL Vdp2DrawScroll(vdp2draw_struct *info, Vdp2* lines, Vdp2* re
       if (!info->enable)
          continue;
 
+      // lines of other bands only need the per line state above
+      if (output_y < band_start || output_y >= band_end)
+      {
+         output_y++;
+         continue;
+      }
+
       for (i = 0; i < vdp2width; i++)
       {
          u32 color, dot;
@@ -1139,7 +1165,7 @@ int Rbg0CheckRam(Vdp2* regs)
    return 0;
 }
 
-static void FASTCALL Vdp2DrawRotationFP(vdp2draw_struct *info, vdp2rotationparameterfp_struct *parameter, Vdp2* lines, Vdp2* regs, u8* ram, u8* color_ram, struct CellScrollData * cell_data)
+static void FASTCALL Vdp2DrawRotationFP(vdp2draw_struct *info, vdp2rotationparameterfp_struct *parameter, Vdp2* lines, Vdp2* regs, u8* ram, u8* color_ram, struct CellScrollData * cell_data, int band_start, int band_end)
 {
    int i, j;
    int x, y;
@@ -1183,6 +1209,14 @@ static void FASTCALL Vdp2DrawRotationFP(vdp2draw_struct *info, vdp2rotationparam
             info->LoadLineParams(info, &sinfo, j, lines);
             ReadLineWindowClip(info->islinewindow, clip, &linewnd0addr, &linewnd1addr, ram, regs);
 
+            // lines of other bands only advance the per line state
+            if (j < band_start || j >= band_end)
+            {
+               xmul += p->deltaXst;
+               ymul += p->deltaYst;
+               continue;
+            }
+
             for (i = 0; i < rbg0width; i++)
             {
                u32 color, dot;
@@ -1222,6 +1256,7 @@ static void FASTCALL Vdp2DrawRotationFP(vdp2draw_struct *info, vdp2rotationparam
       u32 rcoefx, rcoefy;
       u32 lineAddr, lineColor, lineInc;
       u16 lineColorAddr;
+      int line_end;
 
       fixed32 xmul2, ymul2, C2, F2;
       u32 coefx2, coefy2;
@@ -1314,7 +1349,8 @@ static void FASTCALL Vdp2DrawRotationFP(vdp2draw_struct *info, vdp2rotationparam
             lineColorAddr = (T1ReadWord(ram, lineAddr) & 0x780) | p->linescreen;
             lineColor = Vdp2ColorRamGetColor(lineColorAddr, (int)(uintptr_t)color_ram);
             lineAddr += lineInc;
-            TitanPutLineHLine(info->linescreen, j, COLSAT2YAB32(0x3F, lineColor));
+            if (j >= band_start && j < band_end)
+               TitanPutLineHLine(info->linescreen, j, COLSAT2YAB32(0x3F, lineColor));
          }
 
          info->LoadLineParams(info, &sinfo, j, lines);
@@ -1323,7 +1359,31 @@ static void FASTCALL Vdp2DrawRotationFP(vdp2draw_struct *info, vdp2rotationparam
          if (userpwindow)
             ReadLineWindowClip(isrplinewindow, rpwindow, &rplinewnd0addr, &rplinewnd1addr, ram, regs);
 
-         for (i = 0; i < rbg0width; i++)
+         line_end = rbg0width;
+
+         // lines of other bands only advance the per line state, plus the
+         // coefficients read for the last dot which carry over to the next line
+         if (j < band_start || j >= band_end)
+         {
+            line_end = 0;
+
+            if (p->deltaKAx != 0)
+            {
+               Vdp2ReadCoefficientFP(p,
+                                     p->coeftbladdr +
+                                     (coefy + (rbg0width - 1) * toint(p->deltaKAx) + toint((rbg0width - 1) * decipart(p->deltaKAx) + rcoefy)) *
+                                     p->coefdatasize, ram);
+            }
+            if ((p2 != NULL) && p2->coefenab && (p2->deltaKAx != 0))
+            {
+               Vdp2ReadCoefficientFP(p2,
+                                     p2->coeftbladdr +
+                                     (coefy2 + (rbg0width - 1) * toint(p2->deltaKAx) + toint((rbg0width - 1) * decipart(p2->deltaKAx) + rcoefy2)) *
+                                     p2->coefdatasize, ram);
+            }
+         }
+
+         for (i = 0; i < line_end; i++)
          {
             u32 color, dot;
 
@@ -1442,7 +1502,7 @@ static void FASTCALL Vdp2DrawRotationFP(vdp2draw_struct *info, vdp2rotationparam
       return;
    }
 
-   Vdp2DrawScroll(info, lines, regs, ram, color_ram, cell_data);
+   Vdp2DrawScroll(info, lines, regs, ram, color_ram, cell_data, band_start, band_end);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -1553,7 +1613,7 @@ static void LoadLineParamsNBG0(vdp2draw_struct * info, screeninfo_struct * sinfo
 
 //////////////////////////////////////////////////////////////////////////////
 
-static void Vdp2DrawNBG0(Vdp2* lines, Vdp2* regs, u8* ram, u8* color_ram, struct CellScrollData * cell_data)
+static void Vdp2DrawNBG0(Vdp2* lines, Vdp2* regs, u8* ram, u8* color_ram, struct CellScrollData * cell_data, int band_start, int band_end)
 {
    vdp2draw_struct info = { 0 };
    vdp2rotationparameterfp_struct parameter[2];
@@ -1678,12 +1738,12 @@ static void Vdp2DrawNBG0(Vdp2* lines, Vdp2* regs, u8* ram, u8* color_ram, struct
    if (info.enable == 1)
    {
       // NBG0 draw
-      Vdp2DrawScroll(&info, lines, regs, ram, color_ram, cell_data);
+      Vdp2DrawScroll(&info, lines, regs, ram, color_ram, cell_data, band_start, band_end);
    }
    else
    {
       // RBG1 draw
-      Vdp2DrawRotationFP(&info, parameter, lines, regs, ram, color_ram, cell_data);
+      Vdp2DrawRotationFP(&info, parameter, lines, regs, ram, color_ram, cell_data, band_start, band_end);
    }
 }
 
@@ -1703,7 +1763,7 @@ static void LoadLineParamsNBG1(vdp2draw_struct * info, screeninfo_struct * sinfo
 
 //////////////////////////////////////////////////////////////////////////////
 
-static void Vdp2DrawNBG1(Vdp2* lines, Vdp2* regs, u8* ram, u8* color_ram, struct CellScrollData * cell_data)
+static void Vdp2DrawNBG1(Vdp2* lines, Vdp2* regs, u8* ram, u8* color_ram, struct CellScrollData * cell_data, int band_start, int band_end)
 {
    vdp2draw_struct info = { 0 };
 
@@ -1790,7 +1850,7 @@ static void Vdp2DrawNBG1(Vdp2* lines, Vdp2* regs, u8* ram, u8* color_ram, struct
 
    info.LoadLineParams = (void(*)(void *, void*, int, Vdp2*)) LoadLineParamsNBG1;
 
-   Vdp2DrawScroll(&info, lines, regs, ram, color_ram, cell_data);
+   Vdp2DrawScroll(&info, lines, regs, ram, color_ram, cell_data, band_start, band_end);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -1809,7 +1869,7 @@ static void LoadLineParamsNBG2(vdp2draw_struct * info, screeninfo_struct * sinfo
 
 //////////////////////////////////////////////////////////////////////////////
 
-static void Vdp2DrawNBG2(Vdp2* lines, Vdp2* regs, u8* ram, u8* color_ram, struct CellScrollData * cell_data)
+static void Vdp2DrawNBG2(Vdp2* lines, Vdp2* regs, u8* ram, u8* color_ram, struct CellScrollData * cell_data, int band_start, int band_end)
 {
    vdp2draw_struct info = { 0 };
 
@@ -1862,7 +1922,7 @@ static void Vdp2DrawNBG2(Vdp2* lines, Vdp2* regs, u8* ram, u8* color_ram, struct
 
    info.LoadLineParams = (void(*)(void *,void*, int, Vdp2*)) LoadLineParamsNBG2;
 
-   Vdp2DrawScroll(&info, lines, regs, ram, color_ram, cell_data);
+   Vdp2DrawScroll(&info, lines, regs, ram, color_ram, cell_data, band_start, band_end);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -1881,7 +1941,7 @@ static void LoadLineParamsNBG3(vdp2draw_struct * info, screeninfo_struct * sinfo
 
 //////////////////////////////////////////////////////////////////////////////
 
-static void Vdp2DrawNBG3(Vdp2* lines, Vdp2* regs, u8* ram, u8* color_ram, struct CellScrollData * cell_data)
+static void Vdp2DrawNBG3(Vdp2* lines, Vdp2* regs, u8* ram, u8* color_ram, struct CellScrollData * cell_data, int band_start, int band_end)
 {
    vdp2draw_struct info = { 0 };
 
@@ -1936,7 +1996,7 @@ static void Vdp2DrawNBG3(Vdp2* lines, Vdp2* regs, u8* ram, u8* color_ram, struct
 
    info.LoadLineParams = (void(*)(void *, void*, int, Vdp2*)) LoadLineParamsNBG3;
 
-   Vdp2DrawScroll(&info, lines, regs, ram, color_ram, cell_data);
+   Vdp2DrawScroll(&info, lines, regs, ram, color_ram, cell_data, band_start, band_end);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -1953,7 +2013,7 @@ static void LoadLineParamsRBG0(vdp2draw_struct * info, screeninfo_struct * sinfo
 
 //////////////////////////////////////////////////////////////////////////////
 
-static void Vdp2DrawRBG0(Vdp2* lines, Vdp2* regs, u8* ram, u8* color_ram, struct CellScrollData * cell_data)
+static void Vdp2DrawRBG0(Vdp2* lines, Vdp2* regs, u8* ram, u8* color_ram, struct CellScrollData * cell_data, int band_start, int band_end)
 {
    vdp2draw_struct info = { 0 };
    vdp2rotationparameterfp_struct parameter[2];
@@ -2060,7 +2120,7 @@ static void Vdp2DrawRBG0(Vdp2* lines, Vdp2* regs, u8* ram, u8* color_ram, struct
 
    info.LoadLineParams = (void(*)(void *, void*, int, Vdp2*)) LoadLineParamsRBG0;
 
-   Vdp2DrawRotationFP(&info, parameter, lines, regs, ram, color_ram, cell_data);
+   Vdp2DrawRotationFP(&info, parameter, lines, regs, ram, color_ram, cell_data, band_start, band_end);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -2076,9 +2136,9 @@ static void LoadLineParamsSprite(vdp2draw_struct * info, int line, Vdp2* lines)
 
 //////////////////////////////////////////////////////////////////////////////
 
+// Copy of the VDP2 state the layer jobs draw from, emulation goes on while
+// they run between Vdp2DrawScreens and Vdp2DrawEnd
 struct {
-   volatile int need_draw[6];
-   volatile int draw_finished[6];
    Vdp2 lines[270];
    Vdp2 regs;
    u8 ram[0x80000];
@@ -2086,44 +2146,246 @@ struct {
    struct CellScrollData cell_scroll_data[270];
 }vidsoft_thread_context;
 
-#define DECLARE_THREAD(NAME, LAYER, FUNC) \
-void * NAME(void * data) \
-{ \
-   for (;;) \
-   { \
-      if (vidsoft_thread_context.need_draw[LAYER]) \
-      { \
-         vidsoft_thread_context.need_draw[LAYER] = 0; \
-         FUNC(vidsoft_thread_context.lines, &vidsoft_thread_context.regs, vidsoft_thread_context.ram, vidsoft_thread_context.color_ram, vidsoft_thread_context.cell_scroll_data); \
-         vidsoft_thread_context.draw_finished[LAYER] = 1; \
-      } \
-      YabThreadSleep(); \
-   } return NULL; \
-}
-
-DECLARE_THREAD(VidsoftRbg0Thread, TITAN_RBG0, Vdp2DrawRBG0)
-DECLARE_THREAD(VidsoftNbg0Thread, TITAN_NBG0, Vdp2DrawNBG0)
-DECLARE_THREAD(VidsoftNbg1Thread, TITAN_NBG1, Vdp2DrawNBG1)
-DECLARE_THREAD(VidsoftNbg2Thread, TITAN_NBG2, Vdp2DrawNBG2)
-DECLARE_THREAD(VidsoftNbg3Thread, TITAN_NBG3, Vdp2DrawNBG3)
+//////////////////////////////////////////////////////////////////////////////
+
+#define VIDSOFT_POOL_QUIT -1
+
+typedef struct VidsoftPool VidsoftPool;
+
+typedef struct
+{
+   VidsoftPool * pool;
+   int id;
+} VidsoftWorker;
+
+// One batch of jobs can be in flight per pool, and each pool has a single
+// caller: the VDP2 layers and the compositor share one pool on the
+// emulation thread, the VDP1 tiles have their own on the VDP1 thread since
+// it draws at the same time as the layers. Nothing but that caller starts,
+// waits for or resizes a pool.
+struct VidsoftPool
+{
+   const char * name;
+   int first_thread;           // YAB_THREAD_* id of the first worker
+   int trace_tag;
+   YabMutex * mtx;
+   YabEventQueue * wake[VIDSOFT_MAX_WORKERS];
+   YabEventQueue * done;
+   VidsoftWorker workers[VIDSOFT_MAX_WORKERS];
+   int running;
+   int wanted;
+   int busy;
+   VidsoftJob * jobs;
+   int num_jobs;
+   int next_job;
+   s64 busy_ticks;
+   s64 last_finish;
+};
+
+static VidsoftPool vidsoft_pool = { "vdp worker", YAB_THREAD_VIDSOFT_WORKER_0, TRACE_VIDSOFT_LAYER };
+static VidsoftPool vidsoft_vdp1_pool = { "vdp1 worker", YAB_THREAD_VIDSOFT_VDP1_WORKER_0, TRACE_VIDSOFT_VDP1 };
+
+static VidsoftJob vidsoft_layer_jobs[6 * (512 / VIDSOFT_BAND_LINES)];
+static VIDSoftFrameStats vidsoft_frame_stats;
+static s64 vidsoft_layers_submitted;
+
+static double VidsoftTicksToUsec(s64 ticks)
+{
+   return (double)ticks * 1000000.0 / (double)yabsys.tickfreq;
+}
+
+static void VidsoftDrainJobs(VidsoftPool * pool)
+{
+   for (;;)
+   {
+      VidsoftJob * job;
+      s64 start, end;
+
+      YabThreadLock(pool->mtx);
+      if (pool->next_job >= pool->num_jobs)
+      {
+         YabThreadUnLock(pool->mtx);
+         return;
+      }
+      job = &pool->jobs[pool->next_job++];
+      YabThreadUnLock(pool->mtx);
+
+      TRACE_BEGIN(pool->trace_tag);
+      start = YabauseGetTicks();
+      job->func(job->arg, job->start, job->end);
+      end = YabauseGetTicks();
+      TRACE_END(pool->trace_tag);
+
+      YabThreadLock(pool->mtx);
+      pool->busy_ticks += end - start;
+      if (end > pool->last_finish)
+         pool->last_finish = end;
+      YabThreadUnLock(pool->mtx);
+   }
+}
+
+static void * VidsoftWorkerThread(void * data)
+{
+   VidsoftWorker * worker = (VidsoftWorker *)data;
+   VidsoftPool * pool = worker->pool;
+   char name[32];
+
+   sprintf(name, "%s %d", pool->name, worker->id);
+   TraceThreadName(name);
+
+   while (YabWaitEventQueue(pool->wake[worker->id]) != VIDSOFT_POOL_QUIT)
+   {
+      VidsoftDrainJobs(pool);
+      YabAddEventQueue(pool->done, worker->id);
+   }
+   return NULL;
+}
+
+static void VidsoftPoolInit(VidsoftPool * pool)
+{
+   int i;
+
+   if (pool->mtx)
+      return;
+
+   pool->mtx = YabThreadCreateMutex();
+   pool->done = YabThreadCreateQueue(VIDSOFT_MAX_WORKERS);
+   for (i = 0; i < VIDSOFT_MAX_WORKERS; i++)
+   {
+      pool->wake[i] = YabThreadCreateQueue(2);
+      pool->workers[i].pool = pool;
+      pool->workers[i].id = i;
+   }
+}
+
+// Called with no batch in flight
+static void VidsoftPoolResize(VidsoftPool * pool)
+{
+   int i;
+
+   for (i = 0; i < pool->running; i++)
+   {
+      YabAddEventQueue(pool->wake[i], VIDSOFT_POOL_QUIT);
+      YabThreadWait(pool->first_thread + i);
+   }
+
+   pool->running = 0;
+
+   for (i = 0; i < pool->wanted; i++)
+   {
+      if (YabThreadStart(pool->first_thread + i, pool->name, VidsoftWorkerThread, &pool->workers[i]) != 0)
+         break;
+      pool->running++;
+   }
+}
+
+static void VidsoftWaitJobs(VidsoftPool * pool);
+
+// VidsoftStartJobs: hand the jobs to the workers and return at once. jobs
+// must stay valid until VidsoftWaitJobs, one batch can be in flight so a
+// pending one is finished first.
+static void VidsoftStartJobs(VidsoftPool * pool, VidsoftJob * jobs, int count)
+{
+   int i;
+
+   VidsoftPoolInit(pool);
+   VidsoftWaitJobs(pool);
+
+   if (pool->running != pool->wanted)
+      VidsoftPoolResize(pool);
+
+   pool->jobs = jobs;
+   pool->num_jobs = count;
+   pool->next_job = 0;
+   pool->busy_ticks = 0;
+   pool->last_finish = 0;
+   pool->busy = 1;
+
+   for (i = 0; i < pool->running; i++)
+      YabAddEventQueue(pool->wake[i], 0);
+}
+
+// VidsoftWaitJobs: the caller takes whatever jobs are left, then waits
+static void VidsoftWaitJobs(VidsoftPool * pool)
+{
+   int i;
+
+   if (!pool->busy)
+      return;
+
+   VidsoftDrainJobs(pool);
+
+   for (i = 0; i < pool->running; i++)
+      YabWaitEventQueue(pool->done);
+
+   pool->busy = 0;
+}
+
+void VidsoftRunJobs(VidsoftJob * jobs, int count)
+{
+   VidsoftStartJobs(&vidsoft_pool, jobs, count);
+   VidsoftWaitJobs(&vidsoft_pool);
+}
+
+static void VidsoftPoolSetSize(VidsoftPool * pool, int num)
+{
+   if (num < 0)
+      num = 0;
+   if (num > VIDSOFT_MAX_WORKERS)
+      num = VIDSOFT_MAX_WORKERS;
+
+   pool->wanted = num;
+}
+
+void VIDSoftSetNumWorkerThreads(int num)
+{
+   VidsoftPoolSetSize(&vidsoft_pool, num);
+}
+
+int VIDSoftGetNumWorkerThreads(void)
+{
+   return vidsoft_pool.wanted;
+}
+
+void VIDSoftGetFrameStats(VIDSoftFrameStats * stats)
+{
+   *stats = vidsoft_frame_stats;
+}
+
+static void VidsoftPoolDeInit(VidsoftPool * pool)
+{
+   if (!pool->mtx)
+      return;
+
+   VidsoftWaitJobs(pool);
+   pool->wanted = 0;
+   VidsoftPoolResize(pool);
+}
 
 //////////////////////////////////////////////////////////////////////////////
 
 void VIDSoftSetNumLayerThreads(int num)
 {
    vidsoft_num_layer_threads = num;
+   VIDSoftSetNumWorkerThreads(num);
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
+static void VidsoftVdp1DrawCommands(u8 * ram, Vdp1 * regs, u8 * back_framebuffer);
+
 void * VidsoftVdp1Thread(void* data)
 {
+   TraceThreadName("vdp soft");
+
    for (;;)
    {
       if (vidsoft_vdp1_thread_context.need_draw)
       {
          vidsoft_vdp1_thread_context.need_draw = 0;
-         Vdp1DrawCommands(vidsoft_vdp1_thread_context.ram, &vidsoft_vdp1_thread_context.regs, vidsoft_vdp1_thread_context.back_framebuffer);
+         TRACE_BEGIN(TRACE_VDP1_DRAW);
+         VidsoftVdp1DrawCommands(vidsoft_vdp1_thread_context.ram, &vidsoft_vdp1_thread_context.regs, vidsoft_vdp1_thread_context.back_framebuffer);
+         TRACE_END(TRACE_VDP1_DRAW);
          memcpy(vdp1backframebuffer, vidsoft_vdp1_thread_context.back_framebuffer, 0x40000);
          vidsoft_vdp1_thread_context.draw_finished = 1;
       }
@@ -2151,22 +2413,15 @@ void VIDSoftSetVdp1ThreadEnable(int b)
 
 }
 
-void * VidsoftSpriteThread(void * data)
+//////////////////////////////////////////////////////////////////////////////
+
+void VIDSoftSetVdp1Rasterizer(int rasterizer)
 {
-   for (;;)
-   {
-      if (vidsoft_thread_context.need_draw[TITAN_SPRITE])
-      {
-         vidsoft_thread_context.need_draw[TITAN_SPRITE] = 0;
-         VidsoftDrawSprite(&vidsoft_thread_context.regs, sprite_window_mask, vdp1frontframebuffer, vidsoft_thread_context.ram, Vdp1Regs,vidsoft_thread_context.lines, vidsoft_thread_context.color_ram);
-         vidsoft_thread_context.draw_finished[TITAN_SPRITE] = 1;
-      }
-      YabThreadSleep();
-   }
-   return NULL;
-}
+   if (vidsoft_vdp1_thread_enabled)
+      VidsoftWaitForVdp1Thread();
 
-//////////////////////////////////////////////////////////////////////////////
+   vidsoft_vdp1_rasterizer = rasterizer;
+}
 
 int VIDSoftInit(void)
 {
@@ -2195,23 +2450,14 @@ int VIDSoftInit(void)
    VIDSoftSetupGL();
 #endif
 
-   for (i = 0; i < 6; i++)
-   {
-      vidsoft_thread_context.draw_finished[i] = 1;
-      vidsoft_thread_context.need_draw[i] = 0;
-   }
+   VidsoftBuildMosaicTable();
+   VidsoftPoolInit(&vidsoft_pool);
+   VidsoftPoolInit(&vidsoft_vdp1_pool);
 
    vidsoft_vdp1_thread_context.need_draw = 0;
    vidsoft_vdp1_thread_context.draw_finished = 1;
    YabThreadStart(YAB_THREAD_VIDSOFT_VDP1, "vdp soft", VidsoftVdp1Thread, 0);
 
-   YabThreadStart(YAB_THREAD_VIDSOFT_LAYER_RBG0, "vdp rbg0", VidsoftRbg0Thread, 0);
-   YabThreadStart(YAB_THREAD_VIDSOFT_LAYER_NBG0, "vdp nbg0",VidsoftNbg0Thread, 0);
-   YabThreadStart(YAB_THREAD_VIDSOFT_LAYER_NBG1, "vdp nbg1",VidsoftNbg1Thread, 0);
-   YabThreadStart(YAB_THREAD_VIDSOFT_LAYER_NBG2, "vdp nbg2",VidsoftNbg2Thread, 0);
-   YabThreadStart(YAB_THREAD_VIDSOFT_LAYER_NBG3, "vdp nbg3",VidsoftNbg3Thread, 0);
-   YabThreadStart(YAB_THREAD_VIDSOFT_LAYER_SPRITE, "vdp sprite",VidsoftSpriteThread, 0);
-
    return 0;
 }
 
@@ -2329,6 +2575,10 @@ void VIDSoftSetupGL(void)
 
 void VIDSoftDeInit(void)
 {
+   VidsoftPoolDeInit(&vidsoft_pool);
+   VidsoftPoolDeInit(&vidsoft_vdp1_pool);
+   Vdp1SpanCacheClear();
+
    if (dispbuffer)
    {
       free(dispbuffer);
@@ -2450,7 +2700,7 @@ void VIDSoftVdp1DrawStart()
    else
    {
       VIDSoftVdp1DrawStartBody(Vdp1Regs, vdp1backframebuffer);
-      Vdp1DrawCommands(Vdp1Ram, Vdp1Regs, vdp1backframebuffer);
+      VidsoftVdp1DrawCommands(Vdp1Ram, Vdp1Regs, vdp1backframebuffer);
    }
 }
 
@@ -2951,10 +3201,82 @@ static int DrawLineCallback(int x, int y, int i, void *data, Vdp1* regs, vdp1cmd
 	return 0;
 }
 
-static int DrawLine(int x1, int y1, int x2, int y2, int greedy, double linenumber, double texturestep, double xredstep, double xgreenstep, double xbluestep, Vdp1* regs, vdp1cmd_struct *cmd, u8 * ram, u8* back_framebuffer)
+//the pixel state the reference path keeps in globals, so both paths can
+//draw parts of a frame
+static void LoadSpanState(Vdp1SpanContext * span)
+{
+   span->r = leftColumnColor.r;
+   span->g = leftColumnColor.g;
+   span->b = leftColumnColor.b;
+   span->pixel = currentPixel;
+   span->visible = currentPixelIsVisible;
+}
+
+static void StoreSpanState(const Vdp1SpanContext * span)
+{
+   leftColumnColor.r = span->r;
+   leftColumnColor.g = span->g;
+   leftColumnColor.b = span->b;
+   currentPixel = span->pixel;
+   currentPixelIsVisible = span->visible;
+}
+
+//set up the span rasterizer for a command, 0 if the reference path draws it
+static int BeginSpans(Vdp1SpanContext * span, Vdp1* regs, vdp1cmd_struct * cmd, u8 * ram, u8* back_framebuffer)
+{
+   if (vidsoft_vdp1_rasterizer != VIDSOFT_VDP1_RASTER_SPAN)
+      return 0;
+
+   span->ram = ram;
+   span->framebuffer = back_framebuffer;
+   span->regs = regs;
+   span->cmd = cmd;
+   span->width = vdp1width;
+   span->interlace = vdp1interlace;
+   span->pixel_size = vdp1pixelsize;
+   span->character_width = characterWidth;
+   span->character_height = characterHeight;
+
+   if (!Vdp1SpanBegin(span))
+      return 0;
+
+   LoadSpanState(span);
+   return 1;
+}
+
+static int DrawSpan(Vdp1SpanContext * span, int x1, int y1, int x2, int y2, int greedy, double linenumber, double texturestep, double xredstep, double xgreenstep, double xbluestep)
+{
+   Vdp1SpanLine line;
+
+   line.x1 = x1;
+   line.y1 = y1;
+   line.x2 = x2;
+   line.y2 = y2;
+   line.greedy = greedy;
+   line.linenumber = (int)linenumber;
+   line.texturestep = texturestep;
+   line.redstep = xredstep;
+   line.greenstep = xgreenstep;
+   line.bluestep = xbluestep;
+
+   return Vdp1SpanDraw(span, &line);
+}
+
+static int DrawLine(int x1, int y1, int x2, int y2, int greedy, double linenumber, double texturestep, double xredstep, double xgreenstep, double xbluestep, Vdp1* regs, vdp1cmd_struct *cmd, u8 * ram, u8* back_framebuffer, Vdp1SpanContext * span)
 {
 	DrawLineData data;
 
+   int drawn;
+
+   if (span != NULL)
+   {
+      drawn = DrawSpan(span, x1, y1, x2, y2, greedy, linenumber, texturestep, xredstep, xgreenstep, xbluestep);
+      if (drawn >= 0)
+         return drawn;
+
+      StoreSpanState(span);
+   }
+
 	data.linenumber = linenumber;
 	data.texturestep = texturestep;
 	data.xredstep = xredstep;
@@ -2963,7 +3285,12 @@ static int DrawLine(int x1, int y1, int x2, int y2, int greedy, double linenumbe
 	data.endcodesdetected = 0;
 	data.previousStep = 123456789;
 
-   return iterateOverLine(x1, y1, x2, y2, greedy, &data, DrawLineCallback, regs, cmd, ram, back_framebuffer);
+   drawn = iterateOverLine(x1, y1, x2, y2, greedy, &data, DrawLineCallback, regs, cmd, ram, back_framebuffer);
+
+   if (span != NULL)
+      LoadSpanState(span);
+
+   return drawn;
 }
 
 static INLINE double interpolate(double start, double end, int numberofsteps) {
@@ -3014,10 +3341,15 @@ static void gouraudTable(u8* ram, Vdp1* regs, vdp1cmd_struct * cmd)
    gouraudD.value = T1ReadWord(ram, gouraudTableAddress + 6);
 }
 
-int xleft[1000];
-int yleft[1000];
-int xright[1000];
-int yright[1000];
+typedef struct
+{
+   int xleft[1000];
+   int yleft[1000];
+   int xright[1000];
+   int yright[1000];
+} VidsoftQuadEdges;
+
+static VidsoftQuadEdges vidsoft_quad_edges;
 
 static int
 storeLineCoords(int x, int y, int i, void *arrays, Vdp1* regs, vdp1cmd_struct * cmd, u8* ram, u8* back_framebuffer) {
@@ -3068,11 +3400,184 @@ int is_pre_clipped(s16 tl_x, s16 tl_y, s16 bl_x, s16 bl_y, s16 tr_x, s16 tr_y, s
    return 0;
 }
 
+//////////////////////////////////////////////////////////////////////////////
+
+// With VDP1 worker threads a frame is drawn in two phases. The command list
+// is walked first and every drawing command is queued with its clipping,
+// local coordinates and gouraud colors resolved, in the bins of the
+// framebuffer tiles it can touch. Then the tiles are drawn on the pool, each
+// one running its commands in order so blending and mesh see the same
+// framebuffer as a serial draw. A tile is a band of whole framebuffer lines,
+// x past the framebuffer width wraps to the next line and stays inside its
+// band or the next one. Commands the span rasterizer can't draw end the
+// phase: the tiles queued so far are drawn, then the command on its own.
+
+#define VIDSOFT_VDP1_TILE_LINES 32
+#define VIDSOFT_VDP1_MAX_TILES (512 / VIDSOFT_VDP1_TILE_LINES)
+#define VIDSOFT_VDP1_MAX_PRIMS 4096
+
+typedef struct
+{
+   Vdp1SpanContext span;
+   vdp1cmd_struct cmd;
+   int num_lines;             // 0 for a quad
+   s16 x[4], y[4];            // quad corners, tl bl tr br
+   COLOR colors[4];           // quad gouraud colors
+   Vdp1SpanLine lines[4];
+   double r[4], g[4], b[4];   // gouraud color at the start of each line
+   int xmin, ymin, xmax, ymax;
+} VidsoftVdp1Prim;
+
+static struct
+{
+   int active;
+   Vdp1 * regs;
+   u8 * ram;
+   int tile_size;             // framebuffer pixels per tile
+   int num_prims;
+   u16 bins[VIDSOFT_VDP1_MAX_TILES][VIDSOFT_VDP1_MAX_PRIMS];
+   int bin_size[VIDSOFT_VDP1_MAX_TILES];
+   VidsoftJob jobs[VIDSOFT_VDP1_MAX_TILES];
+   int tiles_drawn;
+} vidsoft_vdp1_bins;
+
+static VidsoftVdp1Prim vidsoft_vdp1_prims[VIDSOFT_VDP1_MAX_PRIMS];
+static int vidsoft_vdp1_primitives;
+
+static void VidsoftVdp1Flush(void);
+
+static VidsoftVdp1Prim * VidsoftNewPrim(const Vdp1SpanContext * span, const vdp1cmd_struct * cmd)
+{
+   VidsoftVdp1Prim * prim;
+
+   if (vidsoft_vdp1_bins.num_prims == VIDSOFT_VDP1_MAX_PRIMS)
+      VidsoftVdp1Flush();
+
+   prim = &vidsoft_vdp1_prims[vidsoft_vdp1_bins.num_prims];
+   prim->span = *span;
+   prim->cmd = *cmd;
+   prim->span.cmd = &prim->cmd;
+   prim->span.regs = NULL;
+   prim->num_lines = 0;
+   prim->xmin = prim->ymin = INT_MAX;
+   prim->xmax = prim->ymax = INT_MIN;
+   return prim;
+}
+
+static void VidsoftBinExtend(VidsoftVdp1Prim * prim, int x, int y)
+{
+   if (x < prim->xmin) prim->xmin = x;
+   if (x > prim->xmax) prim->xmax = x;
+   if (y < prim->ymin) prim->ymin = y;
+   if (y > prim->ymax) prim->ymax = y;
+}
+
+//put the primitive in the bins of the tiles its box reaches
+static void VidsoftBinPrim(VidsoftVdp1Prim * prim)
+{
+   const Vdp1SpanContext * span = &prim->span;
+   int il = span->interlace == 2 ? 2 : 1;
+   int xmin = prim->xmin < 0 ? 0 : prim->xmin;
+   int ymin = prim->ymin < 0 ? 0 : prim->ymin;
+   int xmax = prim->xmax > span->system_x2 ? span->system_x2 : prim->xmax;
+   int ymax = prim->ymax > span->system_y2 ? span->system_y2 : prim->ymax;
+   int first, last, tile;
+
+   //every pixel outside the system clipping is dropped
+   if (xmin > xmax || ymin > ymax)
+      return;
+
+   first = (ymin / il) * span->width + xmin;
+   last = (ymax / il) * span->width + xmax;
+   if (first >= span->tile_end)
+      return;
+   if (last >= span->tile_end)
+      last = span->tile_end - 1;
+
+   for (tile = first / vidsoft_vdp1_bins.tile_size; tile <= last / vidsoft_vdp1_bins.tile_size; tile++)
+      vidsoft_vdp1_bins.bins[tile][vidsoft_vdp1_bins.bin_size[tile]++] = (u16)vidsoft_vdp1_bins.num_prims;
+
+   vidsoft_vdp1_bins.num_prims++;
+}
+
+//queue a quad while binning, 0 when it has to be drawn now
+static int VidsoftBinQuad(const Vdp1SpanContext * span, const vdp1cmd_struct * cmd, s16 tl_x, s16 tl_y, s16 bl_x, s16 bl_y, s16 tr_x, s16 tr_y, s16 br_x, s16 br_y, const COLOR * colors)
+{
+   VidsoftVdp1Prim * prim;
+   int i;
+
+   if (!vidsoft_vdp1_bins.active)
+      return 0;
+
+   prim = VidsoftNewPrim(span, cmd);
+   prim->x[0] = tl_x; prim->y[0] = tl_y;
+   prim->x[1] = bl_x; prim->y[1] = bl_y;
+   prim->x[2] = tr_x; prim->y[2] = tr_y;
+   prim->x[3] = br_x; prim->y[3] = br_y;
+
+   //the lines of a quad run between points of its edges
+   for (i = 0; i < 4; i++)
+   {
+      prim->colors[i] = colors[i];
+      VidsoftBinExtend(prim, prim->x[i], prim->y[i]);
+   }
+
+   VidsoftBinPrim(prim);
+   return 1;
+}
+
+//start queueing a line or polyline command, NULL when it is drawn now
+static VidsoftVdp1Prim * VidsoftBinLines(const Vdp1SpanContext * span, const vdp1cmd_struct * cmd)
+{
+   if (!vidsoft_vdp1_bins.active)
+      return NULL;
+
+   if (span == NULL)
+   {
+      VidsoftVdp1Flush();
+      return NULL;
+   }
+
+   return VidsoftNewPrim(span, cmd);
+}
+
+static void VidsoftBinLine(VidsoftVdp1Prim * prim, const Vdp1SpanContext * span, int x1, int y1, int x2, int y2, double redstep, double greenstep, double bluestep)
+{
+   Vdp1SpanLine * line = &prim->lines[prim->num_lines];
+
+   line->x1 = x1;
+   line->y1 = y1;
+   line->x2 = x2;
+   line->y2 = y2;
+   line->greedy = 0;
+   line->linenumber = 0;
+   line->texturestep = 0;
+   line->redstep = redstep;
+   line->greenstep = greenstep;
+   line->bluestep = bluestep;
+
+   prim->r[prim->num_lines] = span->r;
+   prim->g[prim->num_lines] = span->g;
+   prim->b[prim->num_lines] = span->b;
+   prim->num_lines++;
+
+   VidsoftBinExtend(prim, x1, y1);
+   VidsoftBinExtend(prim, x2, y2);
+}
+
+static void VidsoftEndLines(VidsoftVdp1Prim * prim, const Vdp1SpanContext * span)
+{
+   if (prim)
+      VidsoftBinPrim(prim);
+   else if (span)
+      StoreSpanState(span);
+}
+
 //a real vdp1 draws with arbitrary lines
 //this is why endcodes are possible
 //this is also the reason why half-transparent shading causes moire patterns
 //and the reason why gouraud shading can be applied to a single line draw command
-static void drawQuad(s16 tl_x, s16 tl_y, s16 bl_x, s16 bl_y, s16 tr_x, s16 tr_y, s16 br_x, s16 br_y, u8 * ram, Vdp1* regs, vdp1cmd_struct * cmd, u8* back_framebuffer){
+static void drawQuadLines(s16 tl_x, s16 tl_y, s16 bl_x, s16 bl_y, s16 tr_x, s16 tr_y, s16 br_x, s16 br_y, const COLOR * colors, int character_width, int character_height, VidsoftQuadEdges * edges, Vdp1SpanContext * span, u8 * ram, Vdp1* regs, vdp1cmd_struct * cmd, u8* back_framebuffer){
 
 	int totalleft;
 	int totalright;
@@ -3086,33 +3591,16 @@ static void drawQuad(s16 tl_x, s16 tl_y, s16 bl_x, s16 bl_y, s16 tr_x, s16 tr_y,
 	double leftLineStep = 1;
 	double rightLineStep = 1; 
 
-	//a lookup table for the gouraud colors
-	COLOR colors[4];
-
-   if (is_pre_clipped(tl_x, tl_y, bl_x, bl_y, tr_x, tr_y, br_x, br_y, regs))
-      return;
-
-	characterWidth = ((cmd->CMDSIZE >> 8) & 0x3F) * 8;
-   characterHeight = cmd->CMDSIZE & 0xFF;
-
-	intarrays[0] = xleft; intarrays[1] = yleft;
+	intarrays[0] = edges->xleft; intarrays[1] = edges->yleft;
    totalleft = iterateOverLine(tl_x, tl_y, bl_x, bl_y, 0, intarrays, storeLineCoords, regs, cmd, ram, back_framebuffer);
-	intarrays[0] = xright; intarrays[1] = yright;
+	intarrays[0] = edges->xright; intarrays[1] = edges->yright;
    totalright = iterateOverLine(tr_x, tr_y, br_x, br_y, 0, intarrays, storeLineCoords, regs, cmd, ram, back_framebuffer);
 
-	//just for now since burning rangers will freeze up trying to draw huge shapes
-	if(totalleft == INT_MAX || totalright == INT_MAX)
-		return;
-
 	total = totalleft > totalright ? totalleft : totalright;
 
 
    if (cmd->CMDPMOD & (1 << 2)) {
 
-		gouraudTable(ram, regs, cmd);
-
-		{ colors[0] = gouraudA; colors[1] = gouraudD; colors[2] = gouraudB; colors[3] = gouraudC; }
-
 		topLeftToBottomLeftColorStep.r = interpolate(colors[0].r,colors[1].r,total);
 		topLeftToBottomLeftColorStep.g = interpolate(colors[0].g,colors[1].g,total);
 		topLeftToBottomLeftColorStep.b = interpolate(colors[0].b,colors[1].b,total);
@@ -3142,23 +3630,27 @@ static void drawQuad(s16 tl_x, s16 tl_y, s16 bl_x, s16 bl_y, s16 tr_x, s16 tr_y,
 		double xtexturestep;
 		double ytexturestep;
 
+		COLOR_PARAMS lineColor;
 		COLOR_PARAMS rightColumnColor;
 
 		COLOR_PARAMS leftToRightStep = {0,0,0};
 
+		int x1 = edges->xleft[(int)(i*leftLineStep)];
+		int y1 = edges->yleft[(int)(i*leftLineStep)];
+		int x2 = edges->xright[(int)(i*rightLineStep)];
+		int y2 = edges->yright[(int)(i*rightLineStep)];
+
 		//get the length of the line we are about to draw
-		xlinelength = iterateOverLine(
-			xleft[(int)(i*leftLineStep)],
-			yleft[(int)(i*leftLineStep)],
-			xright[(int)(i*rightLineStep)],
-			yright[(int)(i*rightLineStep)],
-         1, NULL, NULL, regs, cmd, ram, back_framebuffer);
+		if (span)
+			xlinelength = Vdp1SpanLineLength(x1, y1, x2, y2, 1);
+		else
+			xlinelength = iterateOverLine(x1, y1, x2, y2, 1, NULL, NULL, regs, cmd, ram, back_framebuffer);
 
 		//so from 0 to the width of the texture / the length of the line is how far we need to step
-		xtexturestep=interpolate(0,characterWidth,xlinelength);
+		xtexturestep=interpolate(0,character_width,xlinelength);
 
 		//now we need to interpolate the y texture coordinate across multiple lines
-		ytexturestep=interpolate(0,characterHeight,total);
+		ytexturestep=interpolate(0,character_height,total);
 
 		//gouraud interpolation
 		if(cmd->CMDPMOD & (1 << 2)) {
@@ -3167,25 +3659,33 @@ static void drawQuad(s16 tl_x, s16 tl_y, s16 bl_x, s16 bl_y, s16 tr_x, s16 tr_y,
 			//and add the orignal color + the number of steps taken times the step value to the bottom of the shape
 			//to get the current colors to use to interpolate across the line
 
-			leftColumnColor.r = colors[0].r +(topLeftToBottomLeftColorStep.r*i);
-			leftColumnColor.g = colors[0].g +(topLeftToBottomLeftColorStep.g*i);
-			leftColumnColor.b = colors[0].b +(topLeftToBottomLeftColorStep.b*i);
+			lineColor.r = colors[0].r +(topLeftToBottomLeftColorStep.r*i);
+			lineColor.g = colors[0].g +(topLeftToBottomLeftColorStep.g*i);
+			lineColor.b = colors[0].b +(topLeftToBottomLeftColorStep.b*i);
 
 			rightColumnColor.r = colors[2].r +(topRightToBottomRightColorStep.r*i);
 			rightColumnColor.g = colors[2].g +(topRightToBottomRightColorStep.g*i);
 			rightColumnColor.b = colors[2].b +(topRightToBottomRightColorStep.b*i);
 
 			//interpolate colors across to get the right step values
-			leftToRightStep.r = interpolate(leftColumnColor.r,rightColumnColor.r,xlinelength);
-			leftToRightStep.g = interpolate(leftColumnColor.g,rightColumnColor.g,xlinelength);
-			leftToRightStep.b = interpolate(leftColumnColor.b,rightColumnColor.b,xlinelength);
+			leftToRightStep.r = interpolate(lineColor.r,rightColumnColor.r,xlinelength);
+			leftToRightStep.g = interpolate(lineColor.g,rightColumnColor.g,xlinelength);
+			leftToRightStep.b = interpolate(lineColor.b,rightColumnColor.b,xlinelength);
+
+			if (span) {
+				span->r = lineColor.r;
+				span->g = lineColor.g;
+				span->b = lineColor.b;
+			}
+			else
+				leftColumnColor = lineColor;
 		}
 
 		DrawLine(
-			xleft[(int)(i*leftLineStep)],
-			yleft[(int)(i*leftLineStep)],
-			xright[(int)(i*rightLineStep)],
-			yright[(int)(i*rightLineStep)],
+			x1,
+			y1,
+			x2,
+			y2,
 			1,
 			ytexturestep*i, 
 			xtexturestep,
@@ -3194,11 +3694,55 @@ static void drawQuad(s16 tl_x, s16 tl_y, s16 bl_x, s16 bl_y, s16 tr_x, s16 tr_y,
 			leftToRightStep.b,
          regs,
          cmd,
-         ram, back_framebuffer
+         ram, back_framebuffer,
+         span
 			);
 	}
 }
 
+static void drawQuad(s16 tl_x, s16 tl_y, s16 bl_x, s16 bl_y, s16 tr_x, s16 tr_y, s16 br_x, s16 br_y, u8 * ram, Vdp1* regs, vdp1cmd_struct * cmd, u8* back_framebuffer){
+
+	Vdp1SpanContext span;
+
+	//a lookup table for the gouraud colors
+	COLOR colors[4];
+
+   vidsoft_vdp1_primitives++;
+
+   if (is_pre_clipped(tl_x, tl_y, bl_x, bl_y, tr_x, tr_y, br_x, br_y, regs))
+      return;
+
+	characterWidth = ((cmd->CMDSIZE >> 8) & 0x3F) * 8;
+   characterHeight = cmd->CMDSIZE & 0xFF;
+
+	//just for now since burning rangers will freeze up trying to draw huge shapes
+	if (Vdp1SpanLineLength(tl_x, tl_y, bl_x, bl_y, 0) == INT_MAX || Vdp1SpanLineLength(tr_x, tr_y, br_x, br_y, 0) == INT_MAX)
+		return;
+
+	memset(colors, 0, sizeof(colors));
+
+   if (cmd->CMDPMOD & (1 << 2)) {
+
+		gouraudTable(ram, regs, cmd);
+
+		{ colors[0] = gouraudA; colors[1] = gouraudD; colors[2] = gouraudB; colors[3] = gouraudC; }
+	}
+
+   if (BeginSpans(&span, regs, cmd, ram, back_framebuffer))
+   {
+      if (VidsoftBinQuad(&span, cmd, tl_x, tl_y, bl_x, bl_y, tr_x, tr_y, br_x, br_y, colors))
+         return;
+
+      drawQuadLines(tl_x, tl_y, bl_x, bl_y, tr_x, tr_y, br_x, br_y, colors, characterWidth, characterHeight, &vidsoft_quad_edges, &span, ram, regs, cmd, back_framebuffer);
+      StoreSpanState(&span);
+   }
+   else
+   {
+      VidsoftVdp1Flush();
+      drawQuadLines(tl_x, tl_y, bl_x, bl_y, tr_x, tr_y, br_x, br_y, colors, characterWidth, characterHeight, &vidsoft_quad_edges, NULL, ram, regs, cmd, back_framebuffer);
+   }
+}
+
 void VIDSoftVdp1NormalSpriteDraw(u8 * ram, Vdp1 * regs, u8 * back_framebuffer) {
 
 	s16 topLeftx,topLefty,topRightx,topRighty,bottomRightx,bottomRighty,bottomLeftx,bottomLefty;
@@ -3342,7 +3886,7 @@ void VIDSoftVdp1DistortedSpriteDraw(u8* ram, Vdp1*regs, u8 * back_framebuffer) {
     drawQuad(xa, ya, xd, yd, xb, yb, xc, yc, ram, regs, &cmd, back_framebuffer);
 }
 
-static void gouraudLineSetup(double * redstep, double * greenstep, double * bluestep, int length, COLOR table1, COLOR table2, u8* ram, Vdp1* regs, vdp1cmd_struct * cmd, u8 * back_framebuffer) {
+static void gouraudLineSetup(double * redstep, double * greenstep, double * bluestep, int length, COLOR table1, COLOR table2, u8* ram, Vdp1* regs, vdp1cmd_struct * cmd, u8 * back_framebuffer, Vdp1SpanContext * span) {
 
 	gouraudTable(ram ,regs, cmd);
 
@@ -3353,6 +3897,21 @@ static void gouraudLineSetup(double * redstep, double * greenstep, double * blue
 	leftColumnColor.r = table1.r;
 	leftColumnColor.g = table1.g;
 	leftColumnColor.b = table1.b;
+
+	if (span) {
+		span->r = table1.r;
+		span->g = table1.g;
+		span->b = table1.b;
+	}
+}
+
+//draw a line of a line or polyline command, or queue it in prim
+static void DrawCommandLine(VidsoftVdp1Prim * prim, int x1, int y1, int x2, int y2, double redstep, double greenstep, double bluestep, Vdp1* regs, vdp1cmd_struct *cmd, u8 * ram, u8* back_framebuffer, Vdp1SpanContext * span)
+{
+   if (prim)
+      VidsoftBinLine(prim, span, x1, y1, x2, y2, redstep, greenstep, bluestep);
+   else
+      DrawLine(x1, y1, x2, y2, 0, 0, 0, redstep, greenstep, bluestep, regs, cmd, ram, back_framebuffer, span);
 }
 
 void VIDSoftVdp1PolylineDraw(u8* ram, Vdp1*regs, u8 * back_framebuffer)
@@ -3362,8 +3921,15 @@ void VIDSoftVdp1PolylineDraw(u8* ram, Vdp1*regs, u8 * back_framebuffer)
 	double redstep = 0, greenstep = 0, bluestep = 0;
 	int length;
    vdp1cmd_struct cmd;
+   Vdp1SpanContext span;
+   Vdp1SpanContext * spans;
+   VidsoftVdp1Prim * prim;
+
+   vidsoft_vdp1_primitives++;
 
    Vdp1ReadCommand(&cmd, regs->addr, ram);
+   spans = BeginSpans(&span, regs, &cmd, ram, back_framebuffer) ? &span : NULL;
+   prim = VidsoftBinLines(spans, &cmd);
 
 	X[0] = (int)regs->localX + (int)((s16)T1ReadWord(ram, regs->addr + 0x0C));
 	Y[0] = (int)regs->localY + (int)((s16)T1ReadWord(ram, regs->addr + 0x0E));
@@ -3375,20 +3941,22 @@ void VIDSoftVdp1PolylineDraw(u8* ram, Vdp1*regs, u8 * back_framebuffer)
 	Y[3] = (int)regs->localY + (int)((s16)T1ReadWord(ram, regs->addr + 0x1A));
 
    length = iterateOverLine(X[0], Y[0], X[1], Y[1], 1, NULL, NULL, regs, &cmd, ram, back_framebuffer);
-   gouraudLineSetup(&redstep, &greenstep, &bluestep, length, gouraudA, gouraudB, ram, regs, &cmd, back_framebuffer);
-   DrawLine(X[0], Y[0], X[1], Y[1], 0, 0, 0, redstep, greenstep, bluestep, regs, &cmd, ram, back_framebuffer);
+   gouraudLineSetup(&redstep, &greenstep, &bluestep, length, gouraudA, gouraudB, ram, regs, &cmd, back_framebuffer, spans);
+   DrawCommandLine(prim, X[0], Y[0], X[1], Y[1], redstep, greenstep, bluestep, regs, &cmd, ram, back_framebuffer, spans);
 
    length = iterateOverLine(X[1], Y[1], X[2], Y[2], 1, NULL, NULL, regs, &cmd, ram, back_framebuffer);
-   gouraudLineSetup(&redstep, &greenstep, &bluestep, length, gouraudB, gouraudC, ram, regs, &cmd, back_framebuffer);
-   DrawLine(X[1], Y[1], X[2], Y[2], 0, 0, 0, redstep, greenstep, bluestep, regs, &cmd, ram, back_framebuffer);
+   gouraudLineSetup(&redstep, &greenstep, &bluestep, length, gouraudB, gouraudC, ram, regs, &cmd, back_framebuffer, spans);
+   DrawCommandLine(prim, X[1], Y[1], X[2], Y[2], redstep, greenstep, bluestep, regs, &cmd, ram, back_framebuffer, spans);
 
    length = iterateOverLine(X[2], Y[2], X[3], Y[3], 1, NULL, NULL, regs, &cmd, ram, back_framebuffer);
-   gouraudLineSetup(&redstep, &greenstep, &bluestep, length, gouraudD, gouraudC, ram, regs, &cmd, back_framebuffer);
-   DrawLine(X[3], Y[3], X[2], Y[2], 0, 0, 0, redstep, greenstep, bluestep, regs, &cmd, ram, back_framebuffer);
+   gouraudLineSetup(&redstep, &greenstep, &bluestep, length, gouraudD, gouraudC, ram, regs, &cmd, back_framebuffer, spans);
+   DrawCommandLine(prim, X[3], Y[3], X[2], Y[2], redstep, greenstep, bluestep, regs, &cmd, ram, back_framebuffer, spans);
 
    length = iterateOverLine(X[3], Y[3], X[0], Y[0], 1, NULL, NULL, regs, &cmd, ram, back_framebuffer);
-   gouraudLineSetup(&redstep, &greenstep, &bluestep, length, gouraudA, gouraudD, ram, regs, &cmd, back_framebuffer);
-   DrawLine(X[0], Y[0], X[3], Y[3], 0, 0, 0, redstep, greenstep, bluestep, regs, &cmd, ram, back_framebuffer);
+   gouraudLineSetup(&redstep, &greenstep, &bluestep, length, gouraudA, gouraudD, ram, regs, &cmd, back_framebuffer, spans);
+   DrawCommandLine(prim, X[0], Y[0], X[3], Y[3], redstep, greenstep, bluestep, regs, &cmd, ram, back_framebuffer, spans);
+
+   VidsoftEndLines(prim, spans);
 }
 
 void VIDSoftVdp1LineDraw(u8* ram, Vdp1*regs, u8* back_framebuffer)
@@ -3397,8 +3965,15 @@ void VIDSoftVdp1LineDraw(u8* ram, Vdp1*regs, u8* back_framebuffer)
 	double redstep = 0, greenstep = 0, bluestep = 0;
 	int length;
    vdp1cmd_struct cmd;
+   Vdp1SpanContext span;
+   Vdp1SpanContext * spans;
+   VidsoftVdp1Prim * prim;
+
+   vidsoft_vdp1_primitives++;
 
    Vdp1ReadCommand(&cmd, regs->addr, ram);
+   spans = BeginSpans(&span, regs, &cmd, ram, back_framebuffer) ? &span : NULL;
+   prim = VidsoftBinLines(spans, &cmd);
 
 	x1 = (int)regs->localX + (int)((s16)T1ReadWord(ram, regs->addr + 0x0C));
 	y1 = (int)regs->localY + (int)((s16)T1ReadWord(ram, regs->addr + 0x0E));
@@ -3406,8 +3981,127 @@ void VIDSoftVdp1LineDraw(u8* ram, Vdp1*regs, u8* back_framebuffer)
 	y2 = (int)regs->localY + (int)((s16)T1ReadWord(ram, regs->addr + 0x12));
 
    length = iterateOverLine(x1, y1, x2, y2, 1, NULL, NULL, regs, &cmd, ram, back_framebuffer);
-   gouraudLineSetup(&redstep, &bluestep, &greenstep, length, gouraudA, gouraudB, ram, regs, &cmd, back_framebuffer);
-   DrawLine(x1, y1, x2, y2, 0, 0, 0, redstep, greenstep, bluestep, regs, &cmd, ram, back_framebuffer);
+   gouraudLineSetup(&redstep, &bluestep, &greenstep, length, gouraudA, gouraudB, ram, regs, &cmd, back_framebuffer, spans);
+   DrawCommandLine(prim, x1, y1, x2, y2, redstep, greenstep, bluestep, regs, &cmd, ram, back_framebuffer, spans);
+
+   VidsoftEndLines(prim, spans);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void VidsoftVdp1TileJob(void * arg, int start, int end)
+{
+   VidsoftQuadEdges edges;
+   int tile, i, j;
+
+   for (tile = start; tile < end; tile++)
+   {
+      for (i = 0; i < vidsoft_vdp1_bins.bin_size[tile]; i++)
+      {
+         VidsoftVdp1Prim * prim = &vidsoft_vdp1_prims[vidsoft_vdp1_bins.bins[tile][i]];
+         Vdp1SpanContext span = prim->span;
+
+         span.tile_start = tile * vidsoft_vdp1_bins.tile_size;
+         if (span.tile_end > span.tile_start + vidsoft_vdp1_bins.tile_size)
+            span.tile_end = span.tile_start + vidsoft_vdp1_bins.tile_size;
+
+         //Vdp1SpanDraw only turns down commands Vdp1SpanBegin turned down,
+         //so tiles never reach the reference path and its globals
+         if (prim->num_lines == 0)
+            drawQuadLines(prim->x[0], prim->y[0], prim->x[1], prim->y[1], prim->x[2], prim->y[2], prim->x[3], prim->y[3],
+               prim->colors, span.character_width, span.character_height, &edges, &span,
+               vidsoft_vdp1_bins.ram, vidsoft_vdp1_bins.regs, &prim->cmd, span.framebuffer);
+
+         for (j = 0; j < prim->num_lines; j++)
+         {
+            span.r = prim->r[j];
+            span.g = prim->g[j];
+            span.b = prim->b[j];
+            Vdp1SpanDraw(&span, &prim->lines[j]);
+         }
+      }
+   }
+}
+
+//draw the queued tiles and empty the bins
+static void VidsoftVdp1Flush(void)
+{
+   int num_jobs = 0;
+   int tile;
+
+   if (!vidsoft_vdp1_bins.active || vidsoft_vdp1_bins.num_prims == 0)
+      return;
+
+   for (tile = 0; tile < VIDSOFT_VDP1_MAX_TILES; tile++)
+   {
+      if (vidsoft_vdp1_bins.bin_size[tile] > 0)
+      {
+         VidsoftJob * job = &vidsoft_vdp1_bins.jobs[num_jobs++];
+
+         job->func = VidsoftVdp1TileJob;
+         job->arg = NULL;
+         job->start = tile;
+         job->end = tile + 1;
+      }
+   }
+
+   VidsoftStartJobs(&vidsoft_vdp1_pool, vidsoft_vdp1_bins.jobs, num_jobs);
+   VidsoftWaitJobs(&vidsoft_vdp1_pool);
+
+   vidsoft_vdp1_bins.tiles_drawn += num_jobs;
+   vidsoft_vdp1_bins.num_prims = 0;
+   memset(vidsoft_vdp1_bins.bin_size, 0, sizeof(vidsoft_vdp1_bins.bin_size));
+}
+
+static void VidsoftVdp1DrawCommands(u8 * ram, Vdp1 * regs, u8 * back_framebuffer)
+{
+   s64 start = YabauseGetTicks();
+   Vdp1SpanCacheStats cache;
+
+   Vdp1SpanCacheNewFrame();
+   vidsoft_vdp1_primitives = 0;
+   vidsoft_vdp1_bins.tiles_drawn = 0;
+
+   if (vidsoft_vdp1_pool.wanted > 0 && vidsoft_vdp1_rasterizer == VIDSOFT_VDP1_RASTER_SPAN)
+   {
+      vidsoft_vdp1_bins.active = 1;
+      vidsoft_vdp1_bins.regs = regs;
+      vidsoft_vdp1_bins.ram = ram;
+      vidsoft_vdp1_bins.tile_size = vdp1width * VIDSOFT_VDP1_TILE_LINES;
+
+      Vdp1DrawCommands(ram, regs, back_framebuffer);
+      VidsoftVdp1Flush();
+
+      vidsoft_vdp1_bins.active = 0;
+   }
+   else
+      Vdp1DrawCommands(ram, regs, back_framebuffer);
+
+   vidsoft_frame_stats.vdp1_workers = vidsoft_vdp1_pool.wanted;
+   vidsoft_frame_stats.vdp1_primitives = vidsoft_vdp1_primitives;
+   vidsoft_frame_stats.vdp1_tiles = vidsoft_vdp1_bins.tiles_drawn;
+   vidsoft_frame_stats.vdp1_usec = VidsoftTicksToUsec(YabauseGetTicks() - start);
+
+   Vdp1SpanCacheGetStats(&cache);
+   vidsoft_frame_stats.vdp1_cache_hits = cache.hits;
+   vidsoft_frame_stats.vdp1_cache_misses = cache.misses;
+   vidsoft_frame_stats.vdp1_cache_bytes = cache.bytes;
+}
+
+void VIDSoftSetNumVdp1Threads(int num)
+{
+   if (vidsoft_vdp1_thread_enabled)
+      VidsoftWaitForVdp1Thread();
+
+   VidsoftPoolSetSize(&vidsoft_vdp1_pool, num);
+}
+
+void VIDSoftSetVdp1CacheSize(int bytes)
+{
+   if (vidsoft_vdp1_thread_enabled)
+      VidsoftWaitForVdp1Thread();
+
+   Vdp1SpanCacheSetLimit(bytes > 0 ? (u32)bytes : 0);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -3543,7 +4237,7 @@ void VIDSoftVdp2DrawStart(void)
 //////////////////////////////////////////////////////////////////////////////
 
 
-void VidsoftDrawSprite(Vdp2 * vdp2_regs, u8 * spr_window_mask, u8* vdp1_front_framebuffer, u8 * vdp2_ram, Vdp1* vdp1_regs, Vdp2* vdp2_lines, u8*color_ram)
+void VidsoftDrawSprite(Vdp2 * vdp2_regs, u8 * spr_window_mask, u8* vdp1_front_framebuffer, u8 * vdp2_ram, Vdp1* vdp1_regs, Vdp2* vdp2_lines, u8*color_ram, int band_start, int band_end)
 {
    int i, i2;
    u16 pixel;
@@ -3561,11 +4255,6 @@ void VidsoftDrawSprite(Vdp2 * vdp2_regs, u8 * spr_window_mask, u8* vdp1_front_fr
    int sprite_window_enabled = vdp2_regs->SPCTL & 0x10;
    int vdp1spritetype = 0;
 
-   if (sprite_window_enabled)
-   {
-      memset(spr_window_mask, 0, 704 * 512);
-   }
-
    // Figure out whether to draw vdp1 framebuffer or vdp2 framebuffer pixels
    // based on priority
    if (Vdp1External.disptoggle && (vdp2_regs->TVMD & 0x8000))
@@ -3639,6 +4328,13 @@ void VidsoftDrawSprite(Vdp2 * vdp2_regs, u8 * spr_window_mask, u8* vdp1_front_fr
             y = i2;
          }
 
+         // lines of other bands only need the per line state above
+         if (output_y < band_start || output_y >= band_end)
+         {
+            output_y++;
+            continue;
+         }
+
          for (i = 0; i < vdp2width; i++)
          {
 
@@ -3864,17 +4560,18 @@ void VidsoftDrawSprite(Vdp2 * vdp2_regs, u8 * spr_window_mask, u8* vdp1_front_fr
 
 void VIDSoftVdp2DrawEnd(void)
 {
-   if (vidsoft_num_layer_threads > 0)
+   s64 start;
+
+   if (vidsoft_pool.busy)
    {
-      while (!vidsoft_thread_context.draw_finished[TITAN_NBG0]){}
-      while (!vidsoft_thread_context.draw_finished[TITAN_NBG1]){}
-      while (!vidsoft_thread_context.draw_finished[TITAN_NBG2]){}
-      while (!vidsoft_thread_context.draw_finished[TITAN_NBG3]){}
-      while (!vidsoft_thread_context.draw_finished[TITAN_RBG0]){}
-      while (!vidsoft_thread_context.draw_finished[TITAN_SPRITE]){}
+      VidsoftWaitJobs(&vidsoft_pool);
+      vidsoft_frame_stats.layer_usec = VidsoftTicksToUsec(vidsoft_pool.last_finish - vidsoft_layers_submitted);
+      vidsoft_frame_stats.layer_busy_usec = VidsoftTicksToUsec(vidsoft_pool.busy_ticks);
    }
 
+   start = YabauseGetTicks();
    TitanRender(dispbuffer);
+   vidsoft_frame_stats.compose_usec = VidsoftTicksToUsec(YabauseGetTicks() - start);
 
    VIDSoftVdp1SwapFrameBuffer();
 
@@ -3897,24 +4594,6 @@ void VIDSoftVdp2DrawEnd(void)
 
 //////////////////////////////////////////////////////////////////////////////
 
-void VidsoftStartLayerThread(int * layer_priority, int * draw_priority_0, int * num_threads_dispatched, int which_layer, void(*layer_func) (Vdp2* lines, Vdp2* regs, u8* ram, u8* color_ram, struct CellScrollData * cell_data))
-{
-   if (layer_priority[which_layer] > 0 || draw_priority_0[which_layer])
-   {
-      if (*num_threads_dispatched < vidsoft_num_layer_threads)
-      {
-         vidsoft_thread_context.need_draw[which_layer] = 1;
-         vidsoft_thread_context.draw_finished[which_layer] = 0;
-         YabThreadWake(YAB_THREAD_VIDSOFT_LAYER_NBG3 + which_layer);
-         *num_threads_dispatched = *num_threads_dispatched + 1;
-      }
-      else
-      {
-        (*layer_func) (Vdp2Lines, Vdp2Regs, Vdp2Ram, Vdp2ColorRam, cell_scroll_data);
-      }
-   }
-}
-
 //////////////////////////////////////////////////////////////////////////////
 
 int IsSpriteWindowEnabled(u16 wtcl)
@@ -3926,6 +4605,45 @@ int IsSpriteWindowEnabled(u16 wtcl)
    return 1;
 }
 
+//////////////////////////////////////////////////////////////////////////////
+
+typedef void (*VidsoftLayerFunc)(Vdp2* lines, Vdp2* regs, u8* ram, u8* color_ram, struct CellScrollData * cell_data, int band_start, int band_end);
+
+static const VidsoftLayerFunc vidsoft_layer_funcs[] = {
+   Vdp2DrawNBG3, Vdp2DrawNBG2, Vdp2DrawNBG1, Vdp2DrawNBG0, Vdp2DrawRBG0
+};
+
+static void VidsoftLayerJob(void * arg, int start, int end)
+{
+   (*(const VidsoftLayerFunc *)arg)(vidsoft_thread_context.lines, &vidsoft_thread_context.regs, vidsoft_thread_context.ram, vidsoft_thread_context.color_ram, vidsoft_thread_context.cell_scroll_data, start, end);
+}
+
+static void VidsoftSpriteJob(void * arg, int start, int end)
+{
+   VidsoftDrawSprite(&vidsoft_thread_context.regs, sprite_window_mask, vdp1frontframebuffer, vidsoft_thread_context.ram, Vdp1Regs, vidsoft_thread_context.lines, vidsoft_thread_context.color_ram, start, end);
+}
+
+// Cut one layer into line bands, the last one is open ended so lines past
+// vdp2height (interlace, odd resolutions) still get drawn
+static int VidsoftQueueBands(int num_jobs, VidsoftJobFunc func, void * arg)
+{
+   int line;
+
+   for (line = 0; line < vdp2height; line += VIDSOFT_BAND_LINES)
+   {
+      VidsoftJob * job = &vidsoft_layer_jobs[num_jobs++];
+
+      job->func = func;
+      job->arg = arg;
+      job->start = line;
+      job->end = line + VIDSOFT_BAND_LINES < vdp2height ? line + VIDSOFT_BAND_LINES : VIDSOFT_ALL_LINES;
+   }
+
+   return num_jobs;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 int CanUseSpriteThread()
 {
    //check if sprite window is enabled
@@ -3949,7 +4667,10 @@ void VIDSoftVdp2DrawScreens(void)
 {
    int draw_priority_0[6] = { 0 };
    int layer_priority[6] = { 0 };
-   int num_threads_dispatched = 0;
+   int num_jobs;
+
+   // a frame that was never ended still has jobs reading the old state
+   VidsoftWaitJobs(&vidsoft_pool);
 
    VIDSoftVdp2SetResolution(Vdp2Regs->TVMD);
    layer_priority[TITAN_NBG0] = Vdp2Regs->PRINA & 0x7;
@@ -3969,44 +4690,61 @@ void VIDSoftVdp2DrawScreens(void)
       draw_priority_0[TITAN_RBG0] = (Vdp2Regs->SFPRMD >> 8) & 0x3;
    }
 
-   if (vidsoft_num_layer_threads > 0)
-   {
-      memcpy(vidsoft_thread_context.lines, Vdp2Lines, sizeof(Vdp2) * 270);
-      memcpy(&vidsoft_thread_context.regs, Vdp2Regs, sizeof(Vdp2));
-      memcpy(vidsoft_thread_context.ram, Vdp2Ram, 0x80000);
-      memcpy(vidsoft_thread_context.color_ram, Vdp2ColorRam, 0x1000);
-      memcpy(vidsoft_thread_context.cell_scroll_data, cell_scroll_data, sizeof(struct CellScrollData) * 270);
-   }
+   // the layers read the sprite window while the sprite layer writes it
+   if (Vdp2Regs->SPCTL & 0x10)
+      memset(sprite_window_mask, 0, 704 * 512);
 
-   //draw vdp2 sprite layer on a thread if sprite window is not enabled
-   if (CanUseSpriteThread() && vidsoft_num_layer_threads > 0)
-   {
-      vidsoft_thread_context.need_draw[TITAN_SPRITE] = 1;
-      vidsoft_thread_context.draw_finished[TITAN_SPRITE] = 0;
-      YabThreadWake(YAB_THREAD_VIDSOFT_LAYER_SPRITE);
-      num_threads_dispatched++;
-   }
-   else
-   {
-      VidsoftDrawSprite(Vdp2Regs, sprite_window_mask, vdp1frontframebuffer, Vdp2Ram, Vdp1Regs, Vdp2Lines, Vdp2ColorRam);
-   }
+   vidsoft_frame_stats.workers = vidsoft_pool.wanted;
+   vidsoft_frame_stats.rbg0 = (Vdp2Regs->BGON & 0x30) && (layer_priority[TITAN_RBG0] > 0 || draw_priority_0[TITAN_RBG0]);
+   vidsoft_frame_stats.layer_usec = 0;
+   vidsoft_frame_stats.layer_busy_usec = 0;
 
-   if (vidsoft_num_layer_threads > 0)
+   if (vidsoft_pool.wanted == 0)
    {
-      VidsoftStartLayerThread(layer_priority, draw_priority_0, &num_threads_dispatched, TITAN_NBG0, Vdp2DrawNBG0);
-      VidsoftStartLayerThread(layer_priority, draw_priority_0, &num_threads_dispatched, TITAN_RBG0, Vdp2DrawRBG0);
-      VidsoftStartLayerThread(layer_priority, draw_priority_0, &num_threads_dispatched, TITAN_NBG1, Vdp2DrawNBG1);
-      VidsoftStartLayerThread(layer_priority, draw_priority_0, &num_threads_dispatched, TITAN_NBG2, Vdp2DrawNBG2);
-      VidsoftStartLayerThread(layer_priority, draw_priority_0, &num_threads_dispatched, TITAN_NBG3, Vdp2DrawNBG3);
+      s64 start = YabauseGetTicks();
+
+      VidsoftDrawSprite(Vdp2Regs, sprite_window_mask, vdp1frontframebuffer, Vdp2Ram, Vdp1Regs, Vdp2Lines, Vdp2ColorRam, 0, VIDSOFT_ALL_LINES);
+      Vdp2DrawNBG0(Vdp2Lines, Vdp2Regs, Vdp2Ram, Vdp2ColorRam, cell_scroll_data, 0, VIDSOFT_ALL_LINES);
+      Vdp2DrawNBG1(Vdp2Lines, Vdp2Regs, Vdp2Ram, Vdp2ColorRam, cell_scroll_data, 0, VIDSOFT_ALL_LINES);
+      Vdp2DrawNBG2(Vdp2Lines, Vdp2Regs, Vdp2Ram, Vdp2ColorRam, cell_scroll_data, 0, VIDSOFT_ALL_LINES);
+      Vdp2DrawNBG3(Vdp2Lines, Vdp2Regs, Vdp2Ram, Vdp2ColorRam, cell_scroll_data, 0, VIDSOFT_ALL_LINES);
+      Vdp2DrawRBG0(Vdp2Lines, Vdp2Regs, Vdp2Ram, Vdp2ColorRam, cell_scroll_data, 0, VIDSOFT_ALL_LINES);
+
+      vidsoft_frame_stats.layer_jobs = 0;
+      vidsoft_frame_stats.layer_usec = vidsoft_frame_stats.layer_busy_usec = VidsoftTicksToUsec(YabauseGetTicks() - start);
+      return;
    }
+
+   Vdp2CopyLines(vidsoft_thread_context.lines);
+   memcpy(&vidsoft_thread_context.regs, Vdp2Regs, sizeof(Vdp2));
+   memcpy(vidsoft_thread_context.ram, Vdp2Ram, 0x80000);
+   memcpy(vidsoft_thread_context.color_ram, Vdp2ColorRam, 0x1000);
+   memcpy(vidsoft_thread_context.cell_scroll_data, cell_scroll_data, sizeof(struct CellScrollData) * 270);
+
+   num_jobs = 0;
+
+   // a layer using the sprite window needs the whole mask before it starts
+   if (!CanUseSpriteThread())
+      VidsoftDrawSprite(Vdp2Regs, sprite_window_mask, vdp1frontframebuffer, Vdp2Ram, Vdp1Regs, Vdp2Lines, Vdp2ColorRam, 0, VIDSOFT_ALL_LINES);
    else
-   {
-      Vdp2DrawNBG0(Vdp2Lines, Vdp2Regs, Vdp2Ram, Vdp2ColorRam, cell_scroll_data);
-      Vdp2DrawNBG1(Vdp2Lines, Vdp2Regs, Vdp2Ram, Vdp2ColorRam, cell_scroll_data);
-      Vdp2DrawNBG2(Vdp2Lines, Vdp2Regs, Vdp2Ram, Vdp2ColorRam, cell_scroll_data);
-      Vdp2DrawNBG3(Vdp2Lines, Vdp2Regs, Vdp2Ram, Vdp2ColorRam, cell_scroll_data);
-      Vdp2DrawRBG0(Vdp2Lines, Vdp2Regs, Vdp2Ram, Vdp2ColorRam, cell_scroll_data);
-   }
+      num_jobs = VidsoftQueueBands(num_jobs, VidsoftSpriteJob, NULL);
+
+   // rotation is by far the most expensive layer, queue it first so its
+   // bands are spread out before the cheap ones
+   if (vidsoft_frame_stats.rbg0)
+      num_jobs = VidsoftQueueBands(num_jobs, VidsoftLayerJob, (void *)&vidsoft_layer_funcs[TITAN_RBG0]);
+   if (layer_priority[TITAN_NBG0] > 0 || draw_priority_0[TITAN_NBG0])
+      num_jobs = VidsoftQueueBands(num_jobs, VidsoftLayerJob, (void *)&vidsoft_layer_funcs[TITAN_NBG0]);
+   if (layer_priority[TITAN_NBG1] > 0 || draw_priority_0[TITAN_NBG1])
+      num_jobs = VidsoftQueueBands(num_jobs, VidsoftLayerJob, (void *)&vidsoft_layer_funcs[TITAN_NBG1]);
+   if (layer_priority[TITAN_NBG2] > 0 || draw_priority_0[TITAN_NBG2])
+      num_jobs = VidsoftQueueBands(num_jobs, VidsoftLayerJob, (void *)&vidsoft_layer_funcs[TITAN_NBG2]);
+   if (layer_priority[TITAN_NBG3] > 0 || draw_priority_0[TITAN_NBG3])
+      num_jobs = VidsoftQueueBands(num_jobs, VidsoftLayerJob, (void *)&vidsoft_layer_funcs[TITAN_NBG3]);
+
+   vidsoft_frame_stats.layer_jobs = num_jobs;
+   vidsoft_layers_submitted = YabauseGetTicks();
+   VidsoftStartJobs(&vidsoft_pool, vidsoft_layer_jobs, num_jobs);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -4018,19 +4756,19 @@ void VIDSoftVdp2DrawScreen(int screen)
    switch(screen)
    {
       case 0:
-         Vdp2DrawNBG0(Vdp2Lines, Vdp2Regs, Vdp2Ram, Vdp2ColorRam, cell_scroll_data);
+         Vdp2DrawNBG0(Vdp2Lines, Vdp2Regs, Vdp2Ram, Vdp2ColorRam, cell_scroll_data, 0, VIDSOFT_ALL_LINES);
          break;
       case 1:
-         Vdp2DrawNBG1(Vdp2Lines, Vdp2Regs, Vdp2Ram, Vdp2ColorRam, cell_scroll_data);
+         Vdp2DrawNBG1(Vdp2Lines, Vdp2Regs, Vdp2Ram, Vdp2ColorRam, cell_scroll_data, 0, VIDSOFT_ALL_LINES);
          break;
       case 2:
-         Vdp2DrawNBG2(Vdp2Lines, Vdp2Regs, Vdp2Ram, Vdp2ColorRam, cell_scroll_data);
+         Vdp2DrawNBG2(Vdp2Lines, Vdp2Regs, Vdp2Ram, Vdp2ColorRam, cell_scroll_data, 0, VIDSOFT_ALL_LINES);
          break;
       case 3:
-         Vdp2DrawNBG3(Vdp2Lines, Vdp2Regs, Vdp2Ram, Vdp2ColorRam, cell_scroll_data);
+         Vdp2DrawNBG3(Vdp2Lines, Vdp2Regs, Vdp2Ram, Vdp2ColorRam, cell_scroll_data, 0, VIDSOFT_ALL_LINES);
          break;
       case 4:
-         Vdp2DrawRBG0(Vdp2Lines, Vdp2Regs, Vdp2Ram, Vdp2ColorRam, cell_scroll_data);
+         Vdp2DrawRBG0(Vdp2Lines, Vdp2Regs, Vdp2Ram, Vdp2ColorRam, cell_scroll_data, 0, VIDSOFT_ALL_LINES);
          break;
    }
 }
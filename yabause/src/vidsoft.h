@@ -43,8 +43,67 @@ void Vdp2GetInterlaceInfo(int * start_line, int * line_increment);
 
 void VIDSoftSetNumLayerThreads(int num);
 
+// Worker pool shared by the layer renderers and the Titan compositor. Work is
+// cut into line band jobs that idle workers pick up in order, so a single
+// heavy layer is spread over every core instead of one thread per layer.
+#define VIDSOFT_MAX_WORKERS 16
+
+typedef void (*VidsoftJobFunc)(void * arg, int start, int end);
+
+typedef struct
+{
+   VidsoftJobFunc func;
+   void * arg;
+   int start;
+   int end;
+} VidsoftJob;
+
+typedef struct
+{
+   int workers;              // worker threads in the pool
+   int layer_jobs;           // VDP2 layer jobs queued this frame
+   int rbg0;                 // RBG0 (or RBG1) was drawn
+   double layer_usec;        // from queueing the layers to the last job done
+   double layer_busy_usec;   // sum of the layer job times, the serial cost
+   double compose_usec;      // Titan priority compositing
+   int vdp1_workers;         // VDP1 worker threads, 0 draws serially
+   int vdp1_primitives;      // VDP1 drawing commands of the last frame
+   int vdp1_tiles;           // VDP1 tile jobs of the last frame
+   double vdp1_usec;         // walking and drawing the VDP1 command list
+   int vdp1_cache_hits;      // VDP1 commands drawn from decoded patterns
+   int vdp1_cache_misses;    // VDP1 commands reading their pattern from ram
+   int vdp1_cache_bytes;     // decoded patterns held
+} VIDSoftFrameStats;
+
+// VIDSoftSetNumWorkerThreads: can be changed at any time, takes effect at
+// the next batch of jobs. 0 runs everything on the emulation thread.
+void VIDSoftSetNumWorkerThreads(int num);
+int VIDSoftGetNumWorkerThreads(void);
+
+// VidsoftRunJobs: run jobs on the pool, the calling thread helps, and
+// return once all of them are done
+void VidsoftRunJobs(VidsoftJob * jobs, int count);
+
+void VIDSoftGetFrameStats(VIDSoftFrameStats * stats);
+
 void VIDSoftSetVdp1ThreadEnable(int b);
 
+// VDP1 rasterizers: the per pixel reference path or the span loops of
+// vidsoftvdp1.cpp, both draw the same pixels
+#define VIDSOFT_VDP1_RASTER_REFERENCE 0
+#define VIDSOFT_VDP1_RASTER_SPAN      1
+
+void VIDSoftSetVdp1Rasterizer(int rasterizer);
+
+// VIDSoftSetNumVdp1Threads: with workers the VDP1 commands of a frame are
+// binned by framebuffer tile and the tiles drawn on their own pool, 0 draws
+// them one after the other. Needs the span rasterizer.
+void VIDSoftSetNumVdp1Threads(int num);
+
+// VIDSoftSetVdp1CacheSize: memory for character patterns the span
+// rasterizer keeps decoded while their VDP1 ram is unchanged, 0 turns it off
+void VIDSoftSetVdp1CacheSize(int bytes);
+
 void VidsoftWaitForVdp1Thread();
 
 void VIDSoftVdp2DrawStart(void);
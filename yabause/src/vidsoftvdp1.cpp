@@ -0,0 +1,930 @@
+/*
+        Copyright 2026 agent(agent@local)
+
+This file is part of YabaSanshiro.
+
+        YabaSanshiro is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+YabaSanshiro is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+along with YabaSanshiro; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*! \file vidsoftvdp1.cpp
+    \brief Span based VDP1 rasterizer of the software renderer.
+
+    Draws the lines DrawLine in vidsoft.c draws, pixel for pixel, without a
+    callback and the getpixel/putpixel switches per pixel. The color mode,
+    the draw mode, mesh and the framebuffer depth select a span loop built
+    for that combination; flipping, clipping and interlacing are resolved to
+    plain integers once per command.
+
+    The reference path reads texel (int)(i * step) with a double step. The
+    span loops walk it in fixed point: the step is split into its 53 bit
+    mantissa and its exponent, i * mantissa is then the exact product and
+    the few cases where the double multiplication rounds that product up to
+    the next texel are caught, so the texel picked is always the same.
+
+    Character patterns drawn again are served from a cache of decoded
+    texels, see LookupSprite.
+*/
+
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "vidsoftvdp1.h"
+#include "memory.h"
+
+namespace {
+
+// (int)(i * step) for i = 0, 1, 2...
+struct TexelWalk
+{
+   u64 pos;     // i * mantissa, exact
+   u64 step;    // mantissa of step
+   int shift;   // pos >> shift is the texel
+
+   int Setup(double value)
+   {
+      int exponent;
+
+      pos = 0;
+      if (value == 0.0)
+      {
+         step = 0;
+         shift = 63;
+         return 1;
+      }
+
+      if (!(value > 0.0 && value < 65536.0))
+         return 0;
+
+      step = (u64)ldexp(frexp(value, &exponent), 53);
+      shift = 53 - exponent;
+
+      // below 2^-11 every product of a line is under one texel
+      if (shift > 63)
+      {
+         step = 0;
+         shift = 63;
+      }
+
+      // lines are shorter than 2048 pixels so i * mantissa fits 64 bits and
+      // rounding drops at most 11 bits, which must be fraction bits
+      return shift >= 11;
+   }
+
+   INLINE int Get() const
+   {
+      u64 whole = pos >> shift;
+
+      // a double keeps 53 significant bits of the product, rounding adds at
+      // most half of the 11 dropped bits
+      if (((pos + 1024) >> shift) != whole)
+         return Rounded();
+
+      return (int)whole;
+   }
+
+   int Rounded() const
+   {
+      int bits = 64;
+      u64 value = pos;
+
+      while (!(pos >> (bits - 1)))
+         bits--;
+
+      if (bits > 53)
+      {
+         int drop = bits - 53;
+         u64 low = pos & ((1ULL << drop) - 1);
+         u64 half = 1ULL << (drop - 1);
+
+         // round to nearest, ties to even
+         value = pos >> drop;
+         if (low > half || (low == half && (value & 1)))
+            value++;
+         value <<= drop;
+      }
+
+      return (int)(value >> shift);
+   }
+
+   INLINE void Next()
+   {
+      pos += step;
+   }
+};
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Same walk as iterateOverLine, pixels are handed to plot
+template <class Plot>
+static INLINE int WalkLine(int x1, int y1, int x2, int y2, int greedy, Plot & plot)
+{
+   int i, a, ax, ay, dx, dy;
+
+   a = i = 0;
+   dx = x2 - x1;
+   dy = y2 - y1;
+   ax = (dx >= 0) ? 1 : -1;
+   ay = (dy >= 0) ? 1 : -1;
+
+   if (abs(dx) > 999 || abs(dy) > 999)
+      return INT_MAX;
+
+   if (abs(dx) > abs(dy)) {
+      if (ax != ay) dx = -dx;
+
+      for (; x1 != x2; x1 += ax, i++) {
+         if (plot(x1, y1)) return i + 1;
+
+         a += dy;
+         if (abs(a) >= abs(dx)) {
+            a -= dx;
+            y1 += ay;
+
+            if (greedy) {
+               i++;
+               if (ax == ay) {
+                  if (plot(x1 + ax, y1 - ay)) return i + 1;
+               } else {
+                  if (plot(x1, y1)) return i + 1;
+               }
+            }
+         }
+      }
+   } else {
+      if (ax != ay) dy = -dy;
+
+      for (; y1 != y2; y1 += ay, i++) {
+         if (plot(x1, y1)) return i + 1;
+
+         a += dx;
+         if (abs(a) >= abs(dy)) {
+            a -= dy;
+            x1 += ax;
+
+            if (greedy) {
+               i++;
+               if (ay == ax) {
+                  if (plot(x1, y1)) return i + 1;
+               } else {
+                  if (plot(x1 - ax, y1 + ay)) return i + 1;
+               }
+            }
+         }
+      }
+   }
+
+   plot(x2, y2);
+   return i + 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+#define COLOR(r,g,b)    (((r)&0x1F)|(((g)&0x1F)<<5)|(((b)&0x1F)<<10) |0x8000 )
+
+static INLINE u32 AlphaBlend16(u32 d, u32 s, u32 level)
+{
+   int r, g, b, sr, sg, sb, dr, dg, db;
+
+   int invlevel = 256 - level;
+   sr = s & 0x001f; dr = d & 0x001f;
+   r = (sr*level + dr*invlevel) >> 8; r &= 0x1f;
+   sg = s & 0x03e0; dg = d & 0x03e0;
+   g = (sg*level + dg*invlevel) >> 8; g &= 0x03e0;
+   sb = s & 0x7c00; db = d & 0x7c00;
+   b = (sb*level + db*invlevel) >> 8; b &= 0x7c00;
+   return r | g | b;
+}
+
+static INLINE int GouraudAdjust(int color, int tableValue)
+{
+   color += (tableValue - 0x10);
+
+   if (color < 0) color = 0;
+   if (color > 0x1f) color = 0x1f;
+
+   return color;
+}
+
+static INLINE int IsClipped(const Vdp1SpanContext * ctx, int x, int y)
+{
+   int system_clipped = !(x >= 0 && x <= ctx->system_x2 && y >= 0 && y <= ctx->system_y2);
+
+   if (ctx->user_clip)
+   {
+      int user_clipped = !(x >= ctx->user_x1 && x <= ctx->user_x2 &&
+         y >= ctx->user_y1 && y <= ctx->user_y2);
+
+      if (ctx->user_outside)
+         user_clipped = !user_clipped;
+
+      return user_clipped || system_clipped;
+   }
+
+   return system_clipped;
+}
+
+#define UNTEXTURED 6
+
+// Texel of getpixel in vidsoft.c. Returns 1 on an end code, pixel is left
+// at the raw end code like the reference path does.
+template <int ColorMode>
+static INLINE int FetchTexel(const Vdp1SpanContext * ctx, u32 row, u32 index, int & pixel, int & visible)
+{
+   u8 * ram = ctx->ram;
+
+   switch (ColorMode)
+   {
+   case 0: // 4bpp bank
+      pixel = T1ReadByte(ram, (row + (index >> 1)) & 0x7FFFF);
+      pixel = (index & 1) ? (pixel & 0xF) : (pixel >> 4);
+      if (ctx->endcodes && pixel == 0xf)
+         return 1;
+      if (!(pixel == 0 && !ctx->spd))
+         pixel = (ctx->colorbank & 0xfff0) | pixel;
+      visible = 0xf;
+      break;
+   case 1: // 4bpp lut
+      pixel = T1ReadByte(ram, (row + (index >> 1)) & 0x7FFFF);
+      pixel = (index & 1) ? (pixel & 0xF) : (pixel >> 4);
+      if (ctx->endcodes && pixel == 0xf)
+         return 1;
+      if (!(pixel == 0 && !ctx->spd))
+         pixel = T1ReadWord(ram, (pixel * 2 + ctx->colorlut) & 0x7FFFF);
+      visible = 0xffff;
+      break;
+   case 2: // 64 color, the end code is drawn transparent
+      pixel = T1ReadByte(ram, (row + index) & 0x7FFFF) & 0x3F;
+      if (ctx->endcodes && pixel == 63)
+         pixel = 0;
+      if (!(pixel == 0 && !ctx->spd))
+         pixel = (ctx->colorbank & 0xffc0) | pixel;
+      visible = 0x3f;
+      break;
+   case 3: // 128 color, its end code can't be read
+      pixel = T1ReadByte(ram, (row + index) & 0x7FFFF) & 0x7F;
+      if (!(pixel == 0 && !ctx->spd))
+         pixel = (ctx->colorbank & 0xff80) | pixel;
+      visible = 0x7f;
+      break;
+   case 4: // 256 color
+      pixel = T1ReadByte(ram, (row + index) & 0x7FFFF);
+      if (ctx->endcodes && pixel == 0xff)
+         return 1;
+      visible = 0xff;
+      if (!(pixel == 0 && !ctx->spd))
+         pixel = (ctx->colorbank & 0xff00) | pixel;
+      break;
+   case 5: // 16bpp
+      pixel = T1ReadWord(ram, (row + 2 * index) & 0x7FFFF);
+      if (ctx->endcodes && pixel == 0x7fff)
+         return 1;
+      if (!(pixel & 0x8000) && !ctx->spd)
+         pixel = 0;
+      visible = 0xffff;
+      break;
+   default: // polygons and lines, the visibility still follows the color mode
+      pixel = ctx->untextured_color;
+      visible = ctx->visible_mask;
+      break;
+   }
+
+   return 0;
+}
+
+// putpixel of vidsoft.c for a 16 bit framebuffer
+template <int ColorMode, int DrawMode, int Mesh>
+static INLINE void PutPixel16(const Vdp1SpanContext * ctx, int x, int y, int & pixel, int visible, double r, double g, double b)
+{
+   u16 * fb = (u16 *)ctx->framebuffer;
+   int y2, offset;
+
+   if ((y & 1) == ctx->dil_parity)
+      return;
+
+   y2 = ctx->interlace == 2 ? y / 2 : y;
+   offset = y2 * ctx->width + x;
+
+   // other tiles own these, below 0 everything is clipped anyway
+   if (offset < ctx->tile_start || offset >= ctx->tile_end)
+      return;
+
+   if (Mesh && ((x ^ y2) & 1))
+      return;
+
+   if (IsClipped(ctx, x, y))
+      return;
+
+   if (ctx->msb_on && pixel)
+   {
+      fb[offset] |= 0x8000;
+      return;
+   }
+
+   if (!ctx->spd && !(pixel & visible))
+      return;
+
+   switch (DrawMode)
+   {
+   case 0: // replace
+      if (!(pixel == 0 && !ctx->spd))
+         fb[offset] = pixel;
+      break;
+   case 1: // shadow
+      if (fb[offset] & 0x8000)
+         fb[offset] = AlphaBlend16(fb[offset], 0, 0x80) | 0x8000;
+      break;
+   case 2: // half luminance
+      fb[offset] = ((pixel & ~0x8421) >> 1) | 0x8000;
+      break;
+   case 3: // half transparent
+      if (fb[offset] & 0x8000)
+         fb[offset] = AlphaBlend16(fb[offset], pixel, 0x80) | 0x8000;
+      else
+         fb[offset] = pixel;
+      break;
+   case 4: // gouraud
+   {
+      int color_mode = ColorMode == UNTEXTURED ? ctx->color_mode : ColorMode;
+
+      // paletted bank modes with only red in the table step the index,
+      // see the sgl chrome demo
+      if (color_mode != 5 && color_mode != 1 && (int)g == 16 && (int)b == 16)
+      {
+         int c = (int)(r - 0x10);
+         if (c < 0) c = 0;
+         pixel = pixel + c;
+         fb[offset] = pixel;
+         break;
+      }
+      fb[offset] = COLOR(
+         GouraudAdjust(pixel & 0x001F, (int)r),
+         GouraudAdjust((pixel & 0x03e0) >> 5, (int)g),
+         GouraudAdjust((pixel & 0x7c00) >> 10, (int)b));
+      break;
+   }
+   default: // gouraud and half transparent
+      fb[offset] = AlphaBlend16(COLOR((int)r, (int)g, (int)b), pixel, 0x80) | 0x8000;
+      break;
+   }
+}
+
+// putpixel8 of vidsoft.c, every draw mode replaces
+template <int Mesh>
+static INLINE void PutPixel8(const Vdp1SpanContext * ctx, int x, int y, int & pixel, int visible)
+{
+   int y2 = ctx->interlace == 2 ? y / 2 : y;
+   int offset = y2 * ctx->width + x;
+
+   if (offset < ctx->tile_start || offset >= ctx->tile_end)
+      return;
+
+   if ((y & 1) == ctx->dil_parity)
+      return;
+
+   pixel &= 0xFF;
+
+   if (Mesh && ((x ^ y2) & 1))
+      return;
+
+   if (IsClipped(ctx, x, y))
+      return;
+
+   if (ctx->spd || (pixel & visible))
+   {
+      if (!(pixel == 0 && !ctx->spd))
+         ctx->framebuffer[offset] = pixel;
+   }
+}
+
+// first byte of a pattern line
+template <int ColorMode>
+static INLINE u32 RowAddress(const Vdp1SpanContext * ctx, int linenumber)
+{
+   switch (ColorMode)
+   {
+   case 0:
+   case 1:
+      return ctx->character_address + (linenumber * (ctx->character_width >> 1));
+   case 5:
+      return ctx->character_address + (linenumber * ctx->character_width * 2);
+   default:
+      return ctx->character_address + (linenumber * ctx->character_width);
+   }
+}
+
+// decoded texels: the pixel FetchTexel returns, with this bit for end codes
+#define TEXEL_END_CODE 0x10000
+
+// The pixel loop of one span, DrawLineCallback of vidsoft.c
+template <int ColorMode, int DrawMode, int Mesh, int PixelSize>
+struct SpanPlot
+{
+   Vdp1SpanContext span;   // a copy, stores to the framebuffer can't alias it
+   TexelWalk texel;
+   double r, g, b;
+   double redstep, greenstep, bluestep;
+   int pixel;
+   int visible;
+   int endcodes;
+   int previous;
+   int width;
+   int skip_outside;
+   u32 row;
+   const u32 * texels;     // decoded row of the pattern, NULL reads the ram
+
+   INLINE int operator()(int x, int y)
+   {
+      int step = texel.Get();
+      texel.Next();
+
+      if (PixelSize == 2 && DrawMode >= 4)
+      {
+         r += redstep;
+         g += greenstep;
+         b += bluestep;
+      }
+
+      // no end code can stop the line, pixels of other tiles need no texel
+      if (skip_outside)
+      {
+         int offset = (span.interlace == 2 ? y / 2 : y) * span.width + x;
+         if (offset < span.tile_start || offset >= span.tile_end)
+            return 0;
+      }
+
+      u32 index = (u32)(span.flip_x ? width - step - 1 : step);
+      int end;
+
+      if (ColorMode != UNTEXTURED && texels && index < (u32)width)
+      {
+         u32 texel = texels[index];
+
+         pixel = texel & 0xFFFF;
+         end = (texel & TEXEL_END_CODE) != 0;
+         if (!end)
+            visible = span.visible_mask;
+      }
+      else
+         end = FetchTexel<ColorMode>(&span, row, index, pixel, visible);
+
+      if (end)
+      {
+         if (step != previous)
+         {
+            previous = step;
+            endcodes++;
+         }
+         return endcodes == 2;
+      }
+
+      if (PixelSize == 2)
+         PutPixel16<ColorMode, DrawMode, Mesh>(&span, x, y, pixel, visible, r, g, b);
+      else
+         PutPixel8<Mesh>(&span, x, y, pixel, visible);
+
+      return 0;
+   }
+};
+
+template <int ColorMode, int DrawMode, int Mesh, int PixelSize>
+static int DrawSpan(Vdp1SpanContext * ctx, const Vdp1SpanLine * line, const TexelWalk & texel)
+{
+   SpanPlot<ColorMode, DrawMode, Mesh, PixelSize> plot;
+   int linenumber = line->linenumber;
+   int count;
+
+   plot.span = *ctx;
+   plot.texel = texel;
+   plot.r = ctx->r;
+   plot.g = ctx->g;
+   plot.b = ctx->b;
+   plot.redstep = line->redstep;
+   plot.greenstep = line->greenstep;
+   plot.bluestep = line->bluestep;
+   plot.pixel = ctx->pixel;
+   plot.visible = ctx->visible;
+   plot.endcodes = 0;
+   plot.previous = 123456789;
+   plot.width = ctx->character_width;
+
+   // a serial draw fetches every texel, the pixel state it leaves behind is
+   // read by the commands of the reference path
+   plot.skip_outside = !ctx->endcodes &&
+      (ctx->tile_start > 0 || ctx->tile_end < (PixelSize == 2 ? 0x20000 : 0x40000));
+
+   if (ctx->flip_y)
+      linenumber = ctx->character_height - linenumber - 1;
+
+   plot.row = RowAddress<ColorMode>(ctx, linenumber);
+   plot.texels = NULL;
+   if (ctx->texels && linenumber >= 0 && linenumber < ctx->character_height)
+      plot.texels = ctx->texels + linenumber * plot.width;
+
+   count = WalkLine(line->x1, line->y1, line->x2, line->y2, line->greedy, plot);
+
+   ctx->r = plot.r;
+   ctx->g = plot.g;
+   ctx->b = plot.b;
+   ctx->pixel = plot.pixel;
+   ctx->visible = plot.visible;
+   return count;
+}
+
+typedef int (*SpanFunc)(Vdp1SpanContext * ctx, const Vdp1SpanLine * line, const TexelWalk & texel);
+
+#define SPAN16(color, mesh) \
+   DrawSpan<color, 0, mesh, 2>, DrawSpan<color, 1, mesh, 2>, DrawSpan<color, 2, mesh, 2>, DrawSpan<color, 3, mesh, 2>, \
+   DrawSpan<color, 4, mesh, 2>, DrawSpan<color, 5, mesh, 2>, DrawSpan<color, 6, mesh, 2>, DrawSpan<color, 7, mesh, 2>
+
+#define SPAN_COLOR(color) \
+   SPAN16(color, 0), SPAN16(color, 1), DrawSpan<color, 0, 0, 1>, DrawSpan<color, 0, 1, 1>
+
+// per color mode: 8 draw modes without mesh, 8 with mesh, then the 8 bit
+// framebuffer without and with mesh
+#define SPANS_PER_COLOR 18
+
+static const SpanFunc span_funcs[] = {
+   SPAN_COLOR(0), SPAN_COLOR(1), SPAN_COLOR(2), SPAN_COLOR(3),
+   SPAN_COLOR(4), SPAN_COLOR(5), SPAN_COLOR(UNTEXTURED)
+};
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Decoded sprite cache. Entries are keyed by everything FetchTexel reads
+// from the command and carry the sum of Vdp1RamPageWrites over the pages
+// of the pattern and its color table; any write there changes the sum.
+// A pattern is only decoded when it is seen a second time with the same
+// sum, sprites drawn once or rewritten every frame keep reading the ram.
+//
+// Lookups happen on the thread walking the command list. Tile workers
+// read the texels of binned commands until the end of the frame, so an
+// entry looked up in the current frame is never freed: rewritten patterns
+// retire their texels until the next frame and eviction skips them.
+struct CachedSprite
+{
+   u32 stamp;     // page writes under the pattern when it was decoded
+   u32 frame;     // last frame that looked it up
+   u32 bytes;
+   u32 * texels;  // NULL until the pattern is seen twice
+};
+
+typedef std::unordered_map<u64, CachedSprite> SpriteMap;
+
+// patterns seen once are forgotten after this many frames
+#define SPRITE_CACHE_FORGET_FRAMES 60
+
+static SpriteMap sprite_cache;
+static std::vector<std::pair<u32 *, u32> > sprite_cache_retired;
+static u32 sprite_cache_limit = VDP1_SPAN_CACHE_DEFAULT_LIMIT;
+static u32 sprite_cache_bytes;
+static u32 sprite_cache_frame;
+static Vdp1SpanCacheStats sprite_cache_stats;
+
+static u32 PageStamp(u32 addr, u32 size)
+{
+   u32 page = (addr & 0x7FFFF) >> VDP1_RAM_PAGE_SHIFT;
+   u32 count = (((addr & 0x7FFFF) & ((1 << VDP1_RAM_PAGE_SHIFT) - 1)) + size +
+      (1 << VDP1_RAM_PAGE_SHIFT) - 1) >> VDP1_RAM_PAGE_SHIFT;
+   u32 stamp = 0;
+
+   if (count > VDP1_RAM_PAGES)
+      count = VDP1_RAM_PAGES;
+
+   while (count--)
+   {
+      stamp += Vdp1RamPageWrites[page];
+      page = (page + 1) & (VDP1_RAM_PAGES - 1);
+   }
+
+   return stamp;
+}
+
+template <int ColorMode>
+static void DecodeSprite(const Vdp1SpanContext * ctx, u32 * texels)
+{
+   int x, y;
+
+   for (y = 0; y < ctx->character_height; y++)
+   {
+      u32 row = RowAddress<ColorMode>(ctx, y);
+
+      for (x = 0; x < ctx->character_width; x++)
+      {
+         int pixel = 0;
+         int visible = 0;
+         u32 end = FetchTexel<ColorMode>(ctx, row, (u32)x, pixel, visible) ? TEXEL_END_CODE : 0;
+
+         *texels++ = (u32)(pixel & 0xFFFF) | end;
+      }
+   }
+}
+
+typedef void (*DecodeFunc)(const Vdp1SpanContext * ctx, u32 * texels);
+
+static const DecodeFunc decode_funcs[] = {
+   DecodeSprite<0>, DecodeSprite<1>, DecodeSprite<2>,
+   DecodeSprite<3>, DecodeSprite<4>, DecodeSprite<5>
+};
+
+static void FreeRetired(void)
+{
+   size_t i;
+
+   for (i = 0; i < sprite_cache_retired.size(); i++)
+   {
+      free(sprite_cache_retired[i].first);
+      sprite_cache_bytes -= sprite_cache_retired[i].second;
+   }
+   sprite_cache_retired.clear();
+}
+
+// evict the least recently used patterns not drawn this frame
+static int MakeRoom(u32 bytes)
+{
+   if (bytes > sprite_cache_limit)
+      return 0;
+
+   while (sprite_cache_bytes + bytes > sprite_cache_limit)
+   {
+      CachedSprite * oldest = NULL;
+      SpriteMap::iterator it;
+
+      for (it = sprite_cache.begin(); it != sprite_cache.end(); ++it)
+      {
+         CachedSprite & entry = it->second;
+
+         if (entry.texels && entry.frame != sprite_cache_frame &&
+            (oldest == NULL || entry.frame < oldest->frame))
+            oldest = &entry;
+      }
+
+      if (oldest == NULL)
+         return 0;
+
+      free(oldest->texels);
+      sprite_cache_bytes -= oldest->bytes;
+      oldest->texels = NULL;
+      oldest->bytes = 0;
+      sprite_cache_stats.evictions++;
+   }
+
+   return 1;
+}
+
+static const u32 * LookupSprite(const Vdp1SpanContext * ctx)
+{
+   int width = ctx->character_width;
+   int height = ctx->character_height;
+   u32 pattern_bytes;
+   u32 stamp;
+   u64 key;
+   SpriteMap::iterator it;
+
+   if (sprite_cache_limit == 0 || width <= 0 || width > 504 || (width & 7) ||
+      height <= 0 || height > 255)
+      return NULL;
+
+   switch (ctx->color_mode)
+   {
+   case 0:
+   case 1: pattern_bytes = width / 2 * height; break;
+   case 5: pattern_bytes = width * 2 * height; break;
+   default: pattern_bytes = width * height; break;
+   }
+
+   stamp = PageStamp(ctx->character_address, pattern_bytes);
+   if (ctx->color_mode == 1)
+      stamp += PageStamp(ctx->colorlut, 32);
+
+   key = (u64)(ctx->character_address & 0x7FFFF) |
+      ((u64)(width >> 3) << 19) | ((u64)height << 25) |
+      ((u64)ctx->color_mode << 33) | ((u64)(ctx->colorbank & 0xFFFF) << 36) |
+      ((u64)ctx->spd << 52) | ((u64)ctx->endcodes << 53);
+
+   it = sprite_cache.find(key);
+   if (it == sprite_cache.end())
+   {
+      CachedSprite entry = { stamp, sprite_cache_frame, 0, NULL };
+
+      sprite_cache.insert(std::make_pair(key, entry));
+      sprite_cache_stats.misses++;
+      return NULL;
+   }
+
+   CachedSprite & entry = it->second;
+
+   entry.frame = sprite_cache_frame;
+
+   if (entry.stamp != stamp)
+   {
+      if (entry.texels)
+      {
+         sprite_cache_retired.push_back(std::make_pair(entry.texels, entry.bytes));
+         entry.texels = NULL;
+         entry.bytes = 0;
+         sprite_cache_stats.invalidations++;
+      }
+      entry.stamp = stamp;
+      sprite_cache_stats.misses++;
+      return NULL;
+   }
+
+   if (entry.texels)
+   {
+      sprite_cache_stats.hits++;
+      return entry.texels;
+   }
+
+   // second sighting, decode it
+   sprite_cache_stats.misses++;
+
+   if (!MakeRoom(width * height * 4))
+      return NULL;
+
+   if ((entry.texels = (u32 *)malloc(width * height * 4)) == NULL)
+      return NULL;
+
+   entry.bytes = width * height * 4;
+   sprite_cache_bytes += entry.bytes;
+   decode_funcs[ctx->color_mode](ctx, entry.texels);
+   return entry.texels;
+}
+
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+extern "C" int Vdp1SpanBegin(Vdp1SpanContext * ctx)
+{
+   vdp1cmd_struct * cmd = ctx->cmd;
+   Vdp1 * regs = ctx->regs;
+   int shape = cmd->CMDCTRL & 0x7;
+   int color;
+   int mesh = (cmd->CMDPMOD & 0x0100) != 0;
+
+   ctx->draw = -1;
+
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD != 0
+   // the texel walk reproduces double precision products, the reference
+   // path computes them with more precision here
+   return 0;
+#endif
+
+   ctx->color_mode = (cmd->CMDPMOD >> 3) & 0x7;
+
+   // getpixel leaves the previous pixel in place for these
+   if (ctx->color_mode > 5)
+      return 0;
+
+   switch (ctx->color_mode)
+   {
+   case 0: ctx->visible_mask = 0xf; break;
+   case 2: ctx->visible_mask = 0x3f; break;
+   case 3: ctx->visible_mask = 0x7f; break;
+   case 4: ctx->visible_mask = 0xff; break;
+   default: ctx->visible_mask = 0xffff; break;
+   }
+
+   color = (shape == 4 || shape == 5 || shape == 6) ? UNTEXTURED : ctx->color_mode;
+
+   if (ctx->pixel_size == 2)
+      ctx->draw = color * SPANS_PER_COLOR + mesh * 8 + (cmd->CMDPMOD & 0x7);
+   else
+      ctx->draw = color * SPANS_PER_COLOR + 16 + mesh;
+
+   ctx->flip_x = (cmd->CMDCTRL & 0x10) != 0;
+   ctx->flip_y = (cmd->CMDCTRL & 0x20) != 0;
+   ctx->spd = (cmd->CMDPMOD & 0x40) != 0;
+   ctx->endcodes = color != UNTEXTURED && (cmd->CMDPMOD & 0x80) == 0;
+   ctx->msb_on = (cmd->CMDPMOD & 0x8000) != 0;
+   ctx->character_address = cmd->CMDSRCA << 3;
+   ctx->colorbank = cmd->CMDCOLR;
+   ctx->colorlut = (u32)cmd->CMDCOLR << 3;
+   ctx->untextured_color = cmd->CMDCOLR;
+
+   if (ctx->interlace == 2)
+      ctx->dil_parity = (regs->FBCR & 0x4) ? 0 : 1;
+   else
+      ctx->dil_parity = -1;
+
+   ctx->system_x2 = regs->systemclipX2;
+   ctx->system_y2 = regs->systemclipY2;
+   ctx->user_clip = (cmd->CMDPMOD & 0x0400) != 0;
+   ctx->user_outside = ((cmd->CMDPMOD >> 9) & 0x3) == 0x3;
+   ctx->user_x1 = regs->userclipX1;
+   ctx->user_y1 = regs->userclipY1;
+   ctx->user_x2 = regs->userclipX2;
+   ctx->user_y2 = regs->userclipY2;
+
+   ctx->tile_start = 0;
+   ctx->tile_end = ctx->pixel_size == 2 ? 0x20000 : 0x40000;
+
+   // page writes are only counted for VDP1 ram
+   ctx->texels = NULL;
+   if (color != UNTEXTURED && ctx->ram == Vdp1Ram)
+      ctx->texels = LookupSprite(ctx);
+
+   return 1;
+}
+
+extern "C" int Vdp1SpanDraw(Vdp1SpanContext * ctx, const Vdp1SpanLine * line)
+{
+   TexelWalk texel;
+
+   int il = ctx->interlace == 2 ? 2 : 1;
+   int xmin = line->x1 < line->x2 ? line->x1 : line->x2;
+   int xmax = line->x1 < line->x2 ? line->x2 : line->x1;
+   int ymin = line->y1 < line->y2 ? line->y1 : line->y2;
+   int ymax = line->y1 < line->y2 ? line->y2 : line->y1;
+
+   if (ctx->draw < 0 || !texel.Setup(line->texturestep))
+      return -1;
+
+   // greedy steps stay inside the box of the end points
+   if ((ymax / il) * ctx->width + xmax < ctx->tile_start ||
+      (ymin / il) * ctx->width + xmin >= ctx->tile_end)
+      return Vdp1SpanLineLength(line->x1, line->y1, line->x2, line->y2, line->greedy);
+
+   return span_funcs[ctx->draw](ctx, line, texel);
+}
+
+extern "C" int Vdp1SpanLineLength(int x1, int y1, int x2, int y2, int greedy)
+{
+   int dx = abs(x2 - x1);
+   int dy = abs(y2 - y1);
+
+   if (dx > 999 || dy > 999)
+      return INT_MAX;
+
+   // the walk takes one pixel per step along the major axis plus the end
+   // point, a greedy walk adds one more for every minor axis step
+   if (dx > dy)
+      return dx + 1 + (greedy ? dy : 0);
+   else
+      return dy + 1 + (greedy ? dx : 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+extern "C" void Vdp1SpanCacheNewFrame(void)
+{
+   SpriteMap::iterator it;
+
+   FreeRetired();
+   sprite_cache_frame++;
+
+   for (it = sprite_cache.begin(); it != sprite_cache.end();)
+   {
+      if (it->second.texels == NULL &&
+         sprite_cache_frame - it->second.frame > SPRITE_CACHE_FORGET_FRAMES)
+         it = sprite_cache.erase(it);
+      else
+         ++it;
+   }
+
+   sprite_cache_stats.hits = 0;
+   sprite_cache_stats.misses = 0;
+   sprite_cache_stats.invalidations = 0;
+   sprite_cache_stats.evictions = 0;
+}
+
+extern "C" void Vdp1SpanCacheClear(void)
+{
+   SpriteMap::iterator it;
+
+   FreeRetired();
+   for (it = sprite_cache.begin(); it != sprite_cache.end(); ++it)
+      free(it->second.texels);
+   sprite_cache.clear();
+   sprite_cache_bytes = 0;
+}
+
+extern "C" void Vdp1SpanCacheSetLimit(u32 bytes)
+{
+   Vdp1SpanCacheClear();
+   sprite_cache_limit = bytes;
+}
+
+extern "C" void Vdp1SpanCacheGetStats(Vdp1SpanCacheStats * stats)
+{
+   *stats = sprite_cache_stats;
+   stats->entries = (u32)sprite_cache.size();
+   stats->bytes = sprite_cache_bytes;
+   stats->limit = sprite_cache_limit;
+}
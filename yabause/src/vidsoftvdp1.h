@@ -0,0 +1,132 @@
+/*
+        Copyright 2026 agent(agent@local)
+
+This file is part of YabaSanshiro.
+
+        YabaSanshiro is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+YabaSanshiro is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+along with YabaSanshiro; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*! \file vidsoftvdp1.h
+    \brief Span based VDP1 rasterizer of the software renderer.
+*/
+
+#ifndef VIDSOFTVDP1_H
+#define VIDSOFTVDP1_H
+
+#include "core.h"
+#include "vdp1.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+   // set by the caller before Vdp1SpanBegin, regs and cmd are only read
+   // by Vdp1SpanBegin
+   u8 * ram;
+   u8 * framebuffer;
+   Vdp1 * regs;
+   vdp1cmd_struct * cmd;
+   int width;              // vdp1width
+   int interlace;          // vdp1interlace, 1 or 2
+   int pixel_size;         // vdp1pixelsize, 1 or 2
+   int character_width;
+   int character_height;
+
+   // resolved from the command by Vdp1SpanBegin
+   int draw;               // span loop, -1 when only the reference path can draw it
+   int color_mode;
+   int visible_mask;       // visibility mask of the color mode
+   int flip_x, flip_y;
+   int spd, endcodes, msb_on;
+   u32 character_address;
+   u32 colorlut;
+   int colorbank;
+   int untextured_color;
+   int dil_parity;         // lines with this parity are skipped, -1 for none
+   int system_x2, system_y2;
+   int user_clip, user_outside;
+   int user_x1, user_y1, user_x2, user_y2;
+   const u32 * texels;     // decoded pattern from the cache, NULL reads the ram
+
+   // framebuffer pixels the spans may write, the whole framebuffer after
+   // Vdp1SpanBegin. The caller narrows it to draw one tile of a frame.
+   int tile_start, tile_end;
+
+   // pixel state the reference path keeps in globals, loaded before and
+   // stored after every span so both paths can draw parts of a frame. The
+   // color is only carried by the Gouraud modes, the only ones reading it.
+   double r, g, b;
+   int pixel;
+   int visible;
+} Vdp1SpanContext;
+
+typedef struct
+{
+   int x1, y1, x2, y2;
+   int greedy;
+   int linenumber;         // texture line, before flipping
+   double texturestep;
+   double redstep, greenstep, bluestep;
+} Vdp1SpanLine;
+
+// Vdp1SpanBegin: pick the span loop for ctx->cmd. Returns 0 when the command
+// has to go through the reference path (invalid color modes).
+int Vdp1SpanBegin(Vdp1SpanContext * ctx);
+
+// Vdp1SpanDraw: draw one line of a command like DrawLine in vidsoft.c and
+// return the same count, or -1 when the line has to be drawn by the
+// reference path instead. That only happens for commands Vdp1SpanBegin
+// turned down or texture steps no command produces. A line that can't
+// reach the tile is skipped and its full length returned.
+int Vdp1SpanDraw(Vdp1SpanContext * ctx, const Vdp1SpanLine * line);
+
+// Vdp1SpanLineLength: number of pixels of the line, what iterateOverLine
+// returns without a callback.
+int Vdp1SpanLineLength(int x1, int y1, int x2, int y2, int greedy);
+
+// Decoded sprite cache of the span loops. Character patterns read from VDP1
+// ram are decoded once and kept until a write to their pages, see
+// Vdp1RamPageWrites. Only touched from the thread calling Vdp1SpanBegin.
+#define VDP1_SPAN_CACHE_DEFAULT_LIMIT (4 * 1024 * 1024)
+
+typedef struct
+{
+   u32 hits;               // commands drawn from decoded texels
+   u32 misses;             // commands reading the ram, decodes included
+   u32 invalidations;      // decoded patterns whose ram was written
+   u32 evictions;          // decoded patterns dropped for the memory limit
+   u32 entries;            // patterns seen
+   u32 bytes;              // decoded texels held
+   u32 limit;
+} Vdp1SpanCacheStats;
+
+// Vdp1SpanCacheNewFrame: called before the commands of a frame, the
+// counters restart and texels nothing reads any more are freed
+void Vdp1SpanCacheNewFrame(void);
+
+// Vdp1SpanCacheSetLimit: memory for decoded texels, 0 turns the cache off.
+// Empties the cache, as does Vdp1SpanCacheClear.
+void Vdp1SpanCacheSetLimit(u32 bytes);
+void Vdp1SpanCacheClear(void);
+
+void Vdp1SpanCacheGetStats(Vdp1SpanCacheStats * stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
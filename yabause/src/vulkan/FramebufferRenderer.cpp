@@ -300,7 +300,7 @@ void FramebufferRenderer::updateVdp2Reg(Vdp2 * fixVdp2Regs) {
     linebuf = perline.dynamicBuf;
     for (line = 0; line < vulkan->vdp2height; line++) {
       linebuf[line] = 0xFF000000;
-      Vdp2 * lVdp2Regs = &Vdp2Lines[line >> line_shift];
+      Vdp2 * lVdp2Regs = Vdp2RestoreRegs(line >> line_shift, Vdp2Lines);
 
       u8 *cclist = (u8 *)&lVdp2Regs->CCRSA;
       u8 *prilist = (u8 *)&lVdp2Regs->PRISA;
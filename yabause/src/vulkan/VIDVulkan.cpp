@@ -4571,11 +4571,13 @@ void VIDVulkan::generatePerLineColorCalcuration(vdp2draw_struct *info, int id) {
     }
     linebuf = perline[id].dynamicBuf;
     for (line = 0; line < vdp2height; line++) {
-      if ((Vdp2Lines[line >> line_shift].BGON & bit) == 0x00) {
+      Vdp2 * lVdp2Regs = Vdp2RestoreRegs(line >> line_shift, Vdp2Lines);
+      int run_end;
+      if ((lVdp2Regs->BGON & bit) == 0x00) {
         linebuf[line] = 0x00;
       } else {
         info->enable = 1;
-        if (Vdp2Lines[line >> line_shift].CCCTL & bit) {
+        if (lVdp2Regs->CCCTL & bit) {
           if (fixVdp2Regs->CCCTL & 0x100) { // Add Color
             info->blendmode |= VDP2_CC_ADD;
           } else {
@@ -4584,27 +4586,27 @@ void VIDVulkan::generatePerLineColorCalcuration(vdp2draw_struct *info, int id) {
 
           switch (id) {
           case NBG0:
-            linebuf[line] = (((~Vdp2Lines[line >> line_shift].CCRNA & 0x1F) << 3) + 0x7) << 24;
+            linebuf[line] = (((~lVdp2Regs->CCRNA & 0x1F) << 3) + 0x7) << 24;
             break;
           case NBG1:
-            linebuf[line] = (((~Vdp2Lines[line >> line_shift].CCRNA & 0x1F00) >> 5) + 0x7) << 24;
+            linebuf[line] = (((~lVdp2Regs->CCRNA & 0x1F00) >> 5) + 0x7) << 24;
             break;
           case NBG2:
-            linebuf[line] = (((~Vdp2Lines[line >> line_shift].CCRNB & 0x1F) << 3) + 0x7) << 24;
+            linebuf[line] = (((~lVdp2Regs->CCRNB & 0x1F) << 3) + 0x7) << 24;
             break;
           case NBG3:
-            linebuf[line] = (((~Vdp2Lines[line >> line_shift].CCRNB & 0x1F00) >> 5) + 0x7) << 24;
+            linebuf[line] = (((~lVdp2Regs->CCRNB & 0x1F00) >> 5) + 0x7) << 24;
             break;
           case RBG0:
-            linebuf[line] = (((~Vdp2Lines[line >> line_shift].CCRR & 0x1F) << 3) + 0x7) << 24;
+            linebuf[line] = (((~lVdp2Regs->CCRR & 0x1F) << 3) + 0x7) << 24;
             break;
           }
         } else {
           linebuf[line] = 0xFF000000;
         }
 
-        if ((Vdp2Lines[line >> line_shift].CLOFEN & bit) != 0) {
-          readVdp2ColorOffset(&Vdp2Lines[line >> line_shift], info, bit);
+        if ((lVdp2Regs->CLOFEN & bit) != 0) {
+          readVdp2ColorOffset(lVdp2Regs, info, bit);
           linebuf[line] |= ((int)(128.0f + (info->cor / 2.0)) & 0xFF) << 0;
           linebuf[line] |= ((int)(128.0f + (info->cog / 2.0)) & 0xFF) << 8;
           linebuf[line] |= ((int)(128.0f + (info->cob / 2.0)) & 0xFF) << 16;
@@ -4612,6 +4614,12 @@ void VIDVulkan::generatePerLineColorCalcuration(vdp2draw_struct *info, int id) {
           linebuf[line] |= 0x00808080;
         }
       }
+
+      // the lines sharing these registers get the same value
+      run_end = Vdp2LineRunEnd(line >> line_shift, 270) << line_shift;
+      for (; line + 1 < run_end && line + 1 < vdp2height; line++) {
+        linebuf[line + 1] = linebuf[line];
+      }
     }
     info->lineTexture = (u64)(perline[id].imageView);
   } else {
@@ -54,6 +54,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 #include "cs2.h"
 #include "debug.h"
 #include "error.h"
+#include "fastmem.h"
 #include "memory.h"
 #include "m68kcore.h"
 #include "peripheral.h"
@@ -61,6 +62,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 #include "scspdsp.h"
 #include "scu.h"
 #include "sh2core.h"
+#include "sh2thread.h"
 #include "smpc.h"
 #include "ygl.h"
 #include "vidsoft.h"
@@ -69,6 +71,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 #include "bios.h"
 //#include "movie.h"
 #include "osdcore.h"
+#include "rewind.h"
+#include "trace.h"
 #ifdef HAVE_LIBSDL
 #if defined(__APPLE__) || defined(GEKKO)
  #ifdef HAVE_LIBSDL2
@@ -99,8 +103,16 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 #ifdef SYS_PROFILE_H
  #include SYS_PROFILE_H
 #else
- #define DONT_PROFILE
  #include "profile.h"
+ #ifndef DONT_PROFILE
+ // every tag costs two clock() calls, so the tags only run when a frontend
+ // asks for them with YabauseSetProfiling
+ static int profiling = 0;
+ #undef PROFILE_START
+ #undef PROFILE_STOP
+ #define PROFILE_START(t) do { if (profiling) ProfileStart(t); } while (0)
+ #define PROFILE_STOP(t) do { if (profiling) ProfileStop(t); } while (0)
+ #endif
 #endif
 
 #if defined(SH2_DYNAREC)
@@ -194,6 +206,10 @@ int YabauseInit(yabauseinit_struct *init)
   yabsys.use_cpu_affinity = init->use_cpu_affinity;
 
   yabsys.use_sh2_cache = init->use_sh2_cache;
+  yabsys.use_sh2_block_cache = init->use_sh2_block_cache;
+  yabsys.use_ssh2_thread = init->use_ssh2_thread;
+  yabsys.use_fastmem = init->use_fastmem;
+  yabsys.ssh2_quantum = init->ssh2_quantum;
 
   q_scsp_frame_start = YabThreadCreateQueue(1);
   q_scsp_finish = YabThreadCreateQueue(1);
@@ -217,13 +233,13 @@ int YabauseInit(yabauseinit_struct *init)
       return -1;
    }
 
-   if ((BiosRom = T2MemoryInit(0x80000)) == NULL)
+   if ((BiosRom = FastmemMemoryInit(0x80000)) == NULL)
       return -1;
 
-   if ((HighWram = T2MemoryInit(0x100000)) == NULL)
+   if ((HighWram = FastmemMemoryInit(0x100000)) == NULL)
       return -1;
 
-   if ((LowWram = T2MemoryInit(0x100000)) == NULL)
+   if ((LowWram = FastmemMemoryInit(0x100000)) == NULL)
       return -1;
 
    yabsys.extend_backup = init->extend_backup;
@@ -276,6 +292,13 @@ int YabauseInit(yabauseinit_struct *init)
 
    MappedMemoryInit();
 
+   // falls back to running both cpus here when the sh2 core can't
+   if (yabsys.use_ssh2_thread && SH2ThreadInit() != 0)
+      yabsys.use_ssh2_thread = 0;
+   // the block cache is shared by both cpus and not thread safe
+   if (yabsys.use_ssh2_thread)
+      yabsys.use_sh2_block_cache = 0;
+
    VideoSetSetting(VDP_SETTING_RBG_USE_COMPUTESHADER, init->rbg_use_compute_shader);
    VideoSetSetting(VDP_SETTING_RBG_RESOLUTION_MODE, init->rbg_resolution_mode);
 
@@ -342,6 +365,8 @@ int YabauseInit(yabauseinit_struct *init)
       return -1;
    }
 
+   MappedMemoryMapFastmem();
+
    if (SmpcInit(init->regionid, init->clocksync, init->basetime) != 0)
    {
       YabSetError(YAB_ERR_CANNOTINIT, _("SMPC"));
@@ -488,22 +513,25 @@ void YabFlushBackups(void)
 
 void YabauseDeInit(void) {
    
+  YabSaveCompressedStateWait();
+  RewindDeInit();
   OSDDeInit();
    Vdp2DeInit();
    Vdp1DeInit();
    
+   SH2ThreadDeInit();
    SH2DeInit();
 
    if (BiosRom)
-      T2MemoryDeInit(BiosRom);
+      FastmemMemoryDeInit(BiosRom);
    BiosRom = NULL;
 
    if (HighWram)
-      T2MemoryDeInit(HighWram);
+      FastmemMemoryDeInit(HighWram);
    HighWram = NULL;
 
    if (LowWram)
-      T2MemoryDeInit(LowWram);
+      FastmemMemoryDeInit(LowWram);
    LowWram = NULL;
 
    if (BupRam)
@@ -537,11 +565,24 @@ void YabauseSetDecilineMode(int on) {
 
 //////////////////////////////////////////////////////////////////////////////
 
+void YabauseSetProfiling(int on) {
+#if !defined(SYS_PROFILE_H) && !defined(DONT_PROFILE)
+   // the tags count from the moment they are turned on
+   if (on && !profiling)
+      ProfileReset();
+   profiling = (on != 0);
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 void YabauseResetNoLoad(void) {
    SH2Reset(MSH2);
    YabauseStopSlave();
    memset(HighWram, 0, 0x100000);
    memset(LowWram, 0, 0x100000);
+   SH2WriteNotify(0x06000000, 0x100000);
+   SH2WriteNotify(0x00200000, 0x100000);
 
    // Reset CS0 area here
    // Reset CS1 area here
@@ -551,6 +592,7 @@ void YabauseResetNoLoad(void) {
    Vdp1Reset();
    Vdp2Reset();
    SmpcReset();
+   RewindReset();
 
    SH2PowerOn(MSH2);
 }
@@ -630,6 +672,46 @@ u32 get_cycles_per_line_division(u32 clock, int frames, int lines, int divisions
    return ((u64)(clock / frames) << SCSP_FRACTIONAL_BITS) / (lines * divisions_per_line);
 }
 
+static int ssh2_steps_left = 0;
+
+// Hands the slave its next quantum, starting with the step of sh2cycles.
+// The steps after it get the cycles the loop in YabauseEmulate will give
+// the master for them.
+static void YabauseStartSlaveQuantum(u32 sh2cycles, u32 cyclesinc)
+{
+   static u32 steps[4096];
+   u32 frac = yabsys.SH2CycleFrac;
+   u32 count;
+   int left, i;
+
+   if (yabsys.ssh2_quantum == 0)
+      count = 10; // a line
+   else if ((cyclesinc >> YABSYS_TIMING_BITS) != 0)
+      count = yabsys.ssh2_quantum / (cyclesinc >> YABSYS_TIMING_BITS);
+   else
+      count = 1;
+   if (count < 1)
+      count = 1;
+
+   // never past the end of the frame
+   left = (yabsys.MaxLineCount - yabsys.LineCount) * 10 - yabsys.DecilineCount;
+   if ((int)count > left)
+      count = left > 0 ? left : 1;
+   if (count > 4096)
+      count = 4096;
+
+   steps[0] = sh2cycles;
+   for (i = 1; i < (int)count; i++)
+   {
+      frac += cyclesinc;
+      steps[i] = (frac >> (YABSYS_TIMING_BITS + 1)) << 1;
+      frac &= ((YABSYS_TIMING_MASK << 1) | 1);
+   }
+
+   ssh2_steps_left = count;
+   SH2ThreadRun(steps, count);
+}
+
 #if defined(SH2_DYNAREC)
 int master_cc_dmy = 0;
 #endif
@@ -662,9 +744,15 @@ u64 g_m68K_dec_cycle = 0;
 
 int YabauseEmulate(void) {
   int oneframeexec = 0;
+   if (trace_enabled)
+      TraceThreadName("emulation");
+   TRACE_BEGIN(TRACE_FRAME);
    yabsys.frame_count++;
    PlayRecorder_proc(yabsys.frame_count);
 
+   if (RewindIsEnabled())
+      RewindCapture();
+
    const u32 cyclesinc =
       yabsys.DecilineMode ? yabsys.DecilineStop : yabsys.DecilineStop * 10;
    const u32 usecinc =
@@ -750,7 +838,14 @@ int YabauseEmulate(void) {
 #ifdef YAB_STATICS
       s64 current_cpu_clock = YabauseGetTicks();
 #endif
-      if( sync_shift != 0 ){
+      if (yabsys.use_ssh2_thread && (SH2ThreadActive() || !SH2ThreadTalking())) {
+        if (!SH2ThreadActive() && yabsys.IsSSH2Running)
+          YabauseStartSlaveQuantum(sh2cycles, cyclesinc);
+        SH2ThreadExec(MSH2, sh2cycles);
+        if (SH2ThreadActive() && --ssh2_steps_left == 0)
+          SH2ThreadJoin();
+      }
+      else if( sync_shift != 0 ){
         u32 i;
         const u32 div = sync_shift;
         const u32 step  = sh2cycles >> div;
@@ -801,12 +896,14 @@ int YabauseEmulate(void) {
             setM68kCounter((u64)(44100 * 256 / 60) << SCSP_FRACTIONAL_BITS);
 #endif
             PROFILE_START("vblankin");
+            TRACE_BEGIN(TRACE_VBLANK_IN);
             // VBlankIN
             SmpcINTBACKEnd();
             Vdp2VBlankIN();
 #if defined(ASYNC_SCSP)
             SyncCPUtoSCSP();
 #endif
+            TRACE_END(TRACE_VBLANK_IN);
             PROFILE_STOP("vblankin");
             CheatDoPatches();
          }
@@ -814,9 +911,11 @@ int YabauseEmulate(void) {
          {
             // VBlankOUT
             PROFILE_START("VDP1/VDP2");
+            TRACE_BEGIN(TRACE_VBLANK_OUT);
             Vdp2VBlankOUT();
             yabsys.LineCount = 0;
             oneframeexec = 1;
+            TRACE_END(TRACE_VBLANK_OUT);
             PROFILE_STOP("VDP1/VDP2");
 
          }
@@ -924,6 +1023,7 @@ int YabauseEmulate(void) {
    SSH2->onchip.cache.write_count = 0;
 #endif
 
+   TRACE_END(TRACE_FRAME);
    return 0;
 }
 
@@ -945,6 +1045,9 @@ void SyncCPUtoSCSP() {
 void YabauseStartSlave(void) {
 
   LOG("YabauseStartSlave");
+   SH2ThreadSync();
+   if (yabsys.use_ssh2_thread)
+      SH2ThreadTalk();
 
    if (yabsys.emulatebios)
    {
@@ -1002,6 +1105,7 @@ void YabauseStartSlave(void) {
 //////////////////////////////////////////////////////////////////////////////
 
 void YabauseStopSlave(void) {
+   SH2ThreadSync();
    SH2Reset(SSH2);
    yabsys.IsSSH2Running = 0;
 }
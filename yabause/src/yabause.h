@@ -89,6 +89,10 @@ typedef struct
    const char *playRecordPath;
    int use_cpu_affinity;
    int use_sh2_cache;
+   int use_sh2_block_cache;
+   int use_ssh2_thread;
+   int use_fastmem;
+   u32 ssh2_quantum;
 } yabauseinit_struct;
 
 #define CLKTYPE_26MHZ           0
@@ -106,6 +110,8 @@ int YabauseInit(yabauseinit_struct *init);
 void YabFlushBackups(void);
 void YabauseDeInit(void);
 void YabauseSetDecilineMode(int on);
+// times the PROFILE_START/PROFILE_STOP tags in YabauseEmulate, see profile.h
+void YabauseSetProfiling(int on);
 void YabauseResetNoLoad(void);
 void YabauseReset(void);
 void YabauseResetButton(void);
@@ -147,6 +153,10 @@ typedef struct
    u32 sync_shift;
    int use_cpu_affinity;
    int use_sh2_cache;
+   int use_sh2_block_cache;
+   int use_ssh2_thread;  // experimental: slave sh2 on its own thread, see sh2thread.h
+   int use_fastmem;      // host pointers for the ram pages, see fastmem.h
+   u32 ssh2_quantum;     // sh2 cycles between the two cpus meeting, 0 for a line
    int Hcount;
 } yabsys_struct;
 
@@ -168,7 +178,8 @@ typedef enum {
   VDP_SETTING_RBG_USE_COMPUTESHADER,
   VDP_SETTING_ROTATE_SCREEN,
   VDP_SETTING_FRAMELIMIT_MODE,
-  VDP_SETTING_ASPECT_RATE_MODE
+  VDP_SETTING_ASPECT_RATE_MODE,
+  VDP_SETTING_VDP1_ASYNC_READBACK
 } enSettings;
 
 int VideoSetSetting(int type, int value);
@@ -249,29 +249,80 @@ typedef struct {
 	float y;
 } YglCache;
 
+typedef struct {
+	u32 async;    // framebuffer reads served from a finished copy, stalls avoided
+	u32 waited;   // the copy was still in flight, waited for its fence
+	u32 sync;     // no usable copy, synchronous round trip
+} YglReadbackStats;
+
 typedef struct {
 	unsigned int * textdata;
 	unsigned int w;
 } YglTexture;
 
-#define HASHSIZE  (0xFFFF)
-typedef struct _YglCacheHash {
-	u64 addr;
+// Texture cache entry. Entries added by YglCacheAdd live until the next
+// YglCacheReset. Entries added by YglCacheAddVram keep their texels in the
+// atlas across frames, as long as the VDP2 ram they were decoded from
+// holds the same data.
+typedef struct {
+	u64 key;
 	float x;
 	float y;
-	struct _YglCacheHash * next;
-} YglCacheHash;
+	u32 frame;       // last frame the texels were used
+	u32 addr;        // VDP2 ram the texels were decoded from
+	u32 size;
+	u64 context;     // what the decoder read besides the ram
+	u32 stamp;       // Vdp2RamPageWrites summed over the range
+	u32 hash;        // content of the range
+	int persistent;
+	unsigned int shelf_y;
+	int next;        // hash chain
+	int link;        // YglCacheReset list, or the shelf list when persistent
+} YglCacheEntry;
+
+// Rows of the atlas filled left to right by YglTMAllocate. A shelf nothing
+// used in the current frame can be handed out again.
+typedef struct {
+	unsigned int y;
+	unsigned int h;
+	unsigned int x;        // first free column
+	u32 frame;             // last frame allocating or drawing from it
+	unsigned int dirty_x0; // columns written in the current frame
+	unsigned int dirty_x1;
+	int entries;           // persistent cache entries of the shelf
+} YglShelf;
+
+typedef struct {
+	u32 hits;
+	u32 misses;
+	u32 kept;           // hits on texels decoded in an earlier frame, uploads avoided
+	u32 rehashed;       // kept although their pages were written
+	u32 invalidated;    // dropped because their ram changed
+	u32 evicted;        // shelves reused for new texels
+	u32 uploaded;       // texels sent by YglTmPush
+} YglCacheStats;
+
+#define YGL_CACHE_BUCKETS 0x4000
+#define YGL_SHELF_ALIGN 8
 
 typedef struct {
-	unsigned int currentX;
-	unsigned int currentY;
-	unsigned int yMax;
+	unsigned int yMax;     // rows used by shelves
 	unsigned int * texture;
 	unsigned int width;
 	unsigned int height;
-	YglCacheHash *HashTable[HASHSIZE];
-	YglCacheHash CashLink[HASHSIZE * 2];
-	u32 CashLink_index;
+	u32 frame;
+	YglShelf * shelves;    // sorted by y
+	int num_shelves;
+	int max_shelves;
+	int last_shelf;        // shelf of the last allocation, tried first
+
+	YglCacheEntry * entries;
+	int max_entries;
+	int free_entry;
+	int frame_entries;
+	int buckets[YGL_CACHE_BUCKETS];
+	YglCacheStats stats;       // current frame
+	YglCacheStats last_stats;  // previous frame
 
 	//GLuint textureID;
 	//GLuint pixelBufferID;
@@ -292,6 +343,7 @@ void YglTMReset( YglTextureManager * tm );
 void YglTMRealloc(YglTextureManager * tm, unsigned int width, unsigned int height);
 void YglTMReserve(YglTextureManager * tm, unsigned int w, unsigned int h);
 void YglTMAllocate(YglTextureManager * tm, YglTexture *, unsigned int, unsigned int, unsigned int *, unsigned int *);
+int YglTMShelfAt(YglTextureManager * tm, unsigned int y);
 void YglTmPush(YglTextureManager * tm);
 void YglTmPull(YglTextureManager * tm, u32 flg);
 
@@ -301,6 +353,12 @@ void YglCacheDeInit(YglTextureManager * tm);
 int YglIsCached(YglTextureManager * tm, u64, YglCache *);
 void YglCacheAdd(YglTextureManager * tm, u64, YglCache *);
 void YglCacheReset(YglTextureManager * tm);
+int YglIsCachedVram(YglTextureManager * tm, u64 key, u32 addr, u32 size, u64 context, YglCache * c);
+void YglCacheAddVram(YglTextureManager * tm, u64 key, u32 addr, u32 size, u64 context, YglCache * c);
+void YglCacheDropShelf(YglTextureManager * tm, int shelf);
+void YglCacheClear(YglTextureManager * tm);
+void YglCacheGetStats(YglTextureManager * tm, YglCacheStats * stats);
+void YglGetVdp1ReadbackStats(YglReadbackStats * stats);
 
 #define VDP1_COLOR_CL_REPLACE 0x00
 #define VDP1_COLOR_CL_SHADOW 0x10
@@ -603,6 +661,20 @@ typedef struct {
    GLuint smallfbotex;
    GLuint vdp1pixelBufferID;
    void * pFrameBuffer;
+   GLuint pFrameBufferID;           // buffer pFrameBuffer is mapped from
+
+   // Asynchronous VDP1 framebuffer readback: while the cpu reads the
+   // framebuffer, each VDP1 render is copied to one of the pixel buffers
+   // and reads are served from the copy once its fence has signaled.
+   int vdp1_async_readback;
+   int vdp1_read_recent;            // renders left to copy since the last read
+   u32 vdp1_render_serial;          // changes whenever the framebuffers do
+   GLuint vdp1_readback_pbo[2];
+   GLsync vdp1_readback_sync[2];
+   u32 vdp1_readback_serial[2];     // vdp1_render_serial of the copy
+   int vdp1_readback_frame[2];      // drawframe of the copy
+   int vdp1_readback_next;
+   YglReadbackStats vdp1_readback_stats;
 
    GLuint fxaa_fbo;
    GLuint fxaa_fbotex;
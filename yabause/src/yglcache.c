@@ -42,95 +42,296 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 #include "ygl.h"
 #include "yui.h"
 #include "vidshared.h"
+#include "vdp2.h"
 
+#define YGL_CACHE_MIN_ENTRIES 0x1000
 
-
-static u32 YglgetHash(u64 addr)
+static u32 YglgetHash(u64 key)
 {
-  return ((addr>>4) & HASHSIZE);
+  return (u32)((key * 0x9E3779B97F4A7C15ULL) >> 50) & (YGL_CACHE_BUCKETS - 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void YglCacheInit(YglTextureManager * tm) {
+  int i;
+  for (i = 0; i < YGL_CACHE_BUCKETS; i++)
+    tm->buckets[i] = -1;
+  tm->entries = NULL;
+  tm->max_entries = 0;
+  tm->free_entry = -1;
+  tm->frame_entries = -1;
 }
 
-static YglCacheHash * YglgetNewCash(YglTextureManager * tm) {
+//////////////////////////////////////////////////////////////////////////////
+
+void YglCacheDeInit(YglTextureManager * tm) {
+  free(tm->entries);
+  YglCacheInit(tm);
+}
+
+//////////////////////////////////////////////////////////////////////////////
 
-  YglCacheHash * rtn;
+static int YglgetNewCash(YglTextureManager * tm) {
+  int i;
 
-  if (tm->CashLink_index >= HASHSIZE * 2){
-    printf("not enough cash");
-    return NULL;
+  if (tm->free_entry < 0) {
+    int count = tm->max_entries ? tm->max_entries * 2 : YGL_CACHE_MIN_ENTRIES;
+    YglCacheEntry * entries = (YglCacheEntry *)realloc(tm->entries, count * sizeof(YglCacheEntry));
+    if (entries == NULL) {
+      printf("not enough cash");
+      return -1;
+    }
+    for (i = tm->max_entries; i < count; i++)
+      entries[i].next = (i + 1 < count) ? i + 1 : -1;
+    tm->free_entry = tm->max_entries;
+    tm->entries = entries;
+    tm->max_entries = count;
   }
-  rtn = &tm->CashLink[tm->CashLink_index];
-  tm->CashLink_index++;
-  return rtn;
+
+  i = tm->free_entry;
+  tm->free_entry = tm->entries[i].next;
+  return i;
 }
 
-int YglIsCached(YglTextureManager * tm, u64 addr, YglCache * c) {
+static void YglFreeCash(YglTextureManager * tm, int i) {
+  tm->entries[i].next = tm->free_entry;
+  tm->free_entry = i;
+}
 
-  u32 hashkey;
-  hashkey = YglgetHash(addr);  /* get hash */
+static int YglFindCash(YglTextureManager * tm, u64 key) {
+  int i = tm->buckets[YglgetHash(key)];
+  while (i >= 0 && tm->entries[i].key != key)
+    i = tm->entries[i].next;
+  return i;
+}
+
+static void YglUnlinkCash(YglTextureManager * tm, int i) {
+  int * at = &tm->buckets[YglgetHash(tm->entries[i].key)];
+  while (*at != i)
+    at = &tm->entries[*at].next;
+  *at = tm->entries[i].next;
+}
+
+static void YglUnlinkList(YglTextureManager * tm, int * at, int i) {
+  while (*at >= 0 && *at != i)
+    at = &tm->entries[*at].link;
+  if (*at == i)
+    *at = tm->entries[i].link;
+}
 
-  if (tm->HashTable[hashkey] == NULL) {  /* Empty Hash */
-    return 0;        /* Not Found */
+// Takes an entry out of the cache, the texels stay in the atlas until their
+// shelf is handed out again.
+static void YglRemoveCash(YglTextureManager * tm, int i) {
+  YglCacheEntry * e = &tm->entries[i];
+
+  YglUnlinkCash(tm, i);
+  if (e->persistent) {
+    int shelf = YglTMShelfAt(tm, e->shelf_y);
+    if (shelf >= 0)
+      YglUnlinkList(tm, &tm->shelves[shelf].entries, i);
   }
-  else {  /* needs liner search */
-	  YglCacheHash *at = tm->HashTable[hashkey];
-    while (at != NULL) {
-      if (at->addr == addr) {  /* Find! */
-        c->x = at->x;
-        c->y = at->y;
-        return 1;
-      }
-      at = at->next; 
-    }
-    return 0;  /* Not found */
+  else {
+    YglUnlinkList(tm, &tm->frame_entries, i);
+  }
+  YglFreeCash(tm, i);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Sum of the page write counters, it changes with any write to the range.
+static u32 YglVramStamp(u32 addr, u32 size) {
+  u32 page = (addr & 0x7FFFF) >> VDP2_RAM_PAGE_SHIFT;
+  u32 last = ((addr & 0x7FFFF) + (size ? size - 1 : 0)) >> VDP2_RAM_PAGE_SHIFT;
+  u32 stamp = 0;
+
+  for (;;) {
+    stamp += Vdp2RamPageWrites[page & (VDP2_RAM_PAGES - 1)];
+    if (page == last)
+      break;
+    page++;
+  }
+  return stamp;
+}
+
+static u32 YglVramHash(u32 addr, u32 size) {
+  u32 hash = 2166136261u;
+  u32 i;
+
+  for (i = 0; i < size; i++)
+    hash = (hash ^ Vdp2Ram[(addr + i) & 0x7FFFF]) * 16777619u;
+  return hash;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int YglIsCached(YglTextureManager * tm, u64 addr, YglCache * c) {
+  int i = YglFindCash(tm, addr);
+
+  if (i < 0 || tm->entries[i].persistent) {
+    tm->stats.misses++;
+    return 0;
   }
 
+  c->x = tm->entries[i].x;
+  c->y = tm->entries[i].y;
+  tm->stats.hits++;
   return 1;
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
 void YglCacheAdd(YglTextureManager * tm, u64 addr, YglCache * c) {
+  int i = YglFindCash(tm, addr);
+
+  if (i >= 0 && tm->entries[i].persistent) {
+    YglRemoveCash(tm, i);
+    i = -1;
+  }
+
+  if (i < 0) {
+    if ((i = YglgetNewCash(tm)) < 0)
+      return;
+    tm->entries[i].key = addr;
+    tm->entries[i].persistent = 0;
+    tm->entries[i].next = tm->buckets[YglgetHash(addr)];
+    tm->buckets[YglgetHash(addr)] = i;
+    tm->entries[i].link = tm->frame_entries;
+    tm->frame_entries = i;
+  }
+
+  tm->entries[i].x = c->x;
+  tm->entries[i].y = c->y;
+  tm->entries[i].frame = tm->frame;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int YglIsCachedVram(YglTextureManager * tm, u64 key, u32 addr, u32 size, u64 context, YglCache * c) {
+  int i = YglFindCash(tm, key);
+  int shelf;
+  YglCacheEntry * e;
 
-  u32 hashkey;
-  YglCacheHash *add;
-  hashkey = YglgetHash(addr);
-
-  if (tm->HashTable[hashkey] == NULL){
-	add = YglgetNewCash(tm);
-    add->addr = addr;
-    add->x = c->x;
-    add->y = c->y;
-    add->next = NULL;
-	tm->HashTable[hashkey] = add;
+  if (i < 0 || !tm->entries[i].persistent) {
+    tm->stats.misses++;
+    return 0;
   }
-  else{
-	  YglCacheHash *at = tm->HashTable[hashkey];
-    while (at != NULL) {
-      if (at->addr == addr  ) { 
-        at->addr = addr;
-        at->x = c->x;
-        at->y = c->y;
-        return;
+
+  e = &tm->entries[i];
+  if (e->addr != addr || e->size != size || e->context != context) {
+    YglRemoveCash(tm, i);
+    tm->stats.misses++;
+    return 0;
+  }
+
+  // checked once a frame, pages written since then are hashed again
+  if (e->frame != tm->frame) {
+    u32 stamp = YglVramStamp(addr, size);
+    if (stamp != e->stamp) {
+      if (YglVramHash(addr, size) != e->hash) {
+        YglRemoveCash(tm, i);
+        tm->stats.invalidated++;
+        tm->stats.misses++;
+        return 0;
       }
-      at = at->next; 
+      e->stamp = stamp;
+      tm->stats.rehashed++;
     }
+    e->frame = tm->frame;
+    if ((shelf = YglTMShelfAt(tm, e->shelf_y)) >= 0)
+      tm->shelves[shelf].frame = tm->frame;
+    tm->stats.kept++;
+  }
+
+  c->x = e->x;
+  c->y = e->y;
+  tm->stats.hits++;
+  return 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
 
-	add = YglgetNewCash(tm);
-    add->addr = addr;
-    add->x = c->x;
-    add->y = c->y;
-	add->next = tm->HashTable[hashkey];
-	tm->HashTable[hashkey] = add;
+void YglCacheAddVram(YglTextureManager * tm, u64 key, u32 addr, u32 size, u64 context, YglCache * c) {
+  int shelf = YglTMShelfAt(tm, (unsigned int)c->y);
+  YglCacheEntry * e;
+  int i;
+
+  // texels not placed by YglTMAllocate can't be kept
+  if (shelf < 0) {
+    YglCacheAdd(tm, key, c);
+    return;
   }
 
+  if ((i = YglFindCash(tm, key)) >= 0)
+    YglRemoveCash(tm, i);
+  if ((i = YglgetNewCash(tm)) < 0)
+    return;
+
+  e = &tm->entries[i];
+  e->key = key;
+  e->x = c->x;
+  e->y = c->y;
+  e->frame = tm->frame;
+  e->addr = addr;
+  e->size = size;
+  e->context = context;
+  e->stamp = YglVramStamp(addr, size);
+  e->hash = YglVramHash(addr, size);
+  e->persistent = 1;
+  e->shelf_y = tm->shelves[shelf].y;
+  e->next = tm->buckets[YglgetHash(key)];
+  tm->buckets[YglgetHash(key)] = i;
+  e->link = tm->shelves[shelf].entries;
+  tm->shelves[shelf].entries = i;
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
 void YglCacheReset(YglTextureManager * tm) {
-	memset(tm->HashTable, 0, sizeof(tm->HashTable));
-	tm->CashLink_index = 0;
+  int i = tm->frame_entries;
+
+  while (i >= 0) {
+    int link = tm->entries[i].link;
+    YglUnlinkCash(tm, i);
+    YglFreeCash(tm, i);
+    i = link;
+  }
+  tm->frame_entries = -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void YglCacheDropShelf(YglTextureManager * tm, int shelf) {
+  int i = tm->shelves[shelf].entries;
+
+  while (i >= 0) {
+    int link = tm->entries[i].link;
+    YglUnlinkCash(tm, i);
+    YglFreeCash(tm, i);
+    i = link;
+  }
+  tm->shelves[shelf].entries = -1;
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
+void YglCacheClear(YglTextureManager * tm) {
+  int i;
+
+  for (i = 0; i < YGL_CACHE_BUCKETS; i++)
+    tm->buckets[i] = -1;
+  for (i = 0; i < tm->num_shelves; i++)
+    tm->shelves[i].entries = -1;
+  for (i = 0; i < tm->max_entries; i++)
+    tm->entries[i].next = (i + 1 < tm->max_entries) ? i + 1 : -1;
+  tm->free_entry = tm->max_entries ? 0 : -1;
+  tm->frame_entries = -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void YglCacheGetStats(YglTextureManager * tm, YglCacheStats * stats) {
+  *stats = tm->last_stats;
+}
+
+//////////////////////////////////////////////////////////////////////////////
@@ -494,7 +494,9 @@ YglTextureManager * YglTMInit(unsigned int w, unsigned int h) {
   tm->width = w;
   tm->height = h;
   tm->current = 0;
+  tm->last_shelf = -1;
 
+  YglCacheInit(tm);
   YglTMReset(tm);
 
   for (int i = 0; i < NUM_TEXTURE_BUFFER; i++) {
@@ -551,15 +553,22 @@ void YglTMDeInit(YglTextureManager * tm) {
     tm->pixelBufferID_in[i] = 0;
   }
 
+  YglCacheDeInit(tm);
+  free(tm->shelves);
   free(tm);
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
+// Starts a frame. The atlas keeps its texels, shelves the new frame doesn't
+// use are handed out again by YglTMAllocate once the atlas is full.
 void YglTMReset(YglTextureManager * tm  ) {
-  tm->currentX = 0;
-  tm->currentY = 0;
-  tm->yMax = 0;
+  int i;
+  for (i = 0; i < tm->num_shelves; i++)
+    tm->shelves[i].dirty_x0 = tm->shelves[i].dirty_x1 = 0;
+  tm->frame++;
+  tm->last_stats = tm->stats;
+  memset(&tm->stats, 0, sizeof(tm->stats));
 }
 
 #if 0
@@ -569,7 +578,7 @@ void YglTMReserve(YglTextureManager * tm, unsigned int w, unsigned int h){
     YGLDEBUG("can't allocate texture: %dx%d\n", w, h);
     YglTMRealloc(tm, w, tm->height);
   }
-  if ((tm->height - tm->currentY) < h) {
+  if ((tm->height - tm->yMax) < h) {
     YGLDEBUG("can't allocate texture: %dx%d\n", w, h);
     YglTMRealloc(tm, tm->width, tm->height + (h * 2));
     return;
@@ -581,9 +590,20 @@ void YglTmPush(YglTextureManager * tm){
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_2D, tm->textureID_in[tm->current] );
   if (tm->texture != NULL ) {
+    int i;
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, tm->pixelBufferID_in[tm->current] );
     glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tm->width, tm->yMax, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    // only the texels written in this frame, the texture still holds the rest
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, tm->width);
+    for (i = 0; i < tm->num_shelves; i++) {
+      YglShelf * shelf = &tm->shelves[i];
+      if (shelf->dirty_x1 > shelf->dirty_x0) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, shelf->dirty_x0, shelf->y, shelf->dirty_x1 - shelf->dirty_x0, shelf->h,
+          GL_RGBA, GL_UNSIGNED_BYTE, (void *)(((uintptr_t)shelf->y * tm->width + shelf->dirty_x0) * 4));
+        tm->stats.uploaded += (shelf->dirty_x1 - shelf->dirty_x0) * shelf->h;
+      }
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
     tm->texture = NULL;
   }
@@ -596,12 +616,9 @@ void YglTmPull(YglTextureManager * tm, u32 flg){
     glBindTexture(GL_TEXTURE_2D, tm->textureID_in[tm->current]);
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, tm->pixelBufferID_in[tm->current]);
 
-    if (flg) {
-      tm->texture_in[tm->current] = (int*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, tm->width * tm->height * 4, GL_MAP_WRITE_BIT /*| GL_MAP_INVALIDATE_BUFFER_BIT*/ );
-    }
-    else {
-      tm->texture_in[tm->current] = (int*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, tm->width * tm->height * 4, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
-    }
+    // never invalidated, the buffer mirrors the whole atlas so that
+    // YglTMRealloc can copy texels kept from earlier frames
+    tm->texture_in[tm->current] = (int*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, tm->width * tm->height * 4, GL_MAP_WRITE_BIT /*| GL_MAP_INVALIDATE_BUFFER_BIT*/ );
     if (tm->texture_in[tm->current] == NULL) {
       int error = glGetError();
       YGLLOG("Fail to glMapBufferRange %X", error );
@@ -699,6 +716,19 @@ void YglTMRealloc(YglTextureManager * tm, unsigned int width, unsigned int heigh
 
   }
 
+  // the copy keeps rows, not columns: a new width starts an empty atlas
+  if (width != tm->width) {
+    YglCacheClear(tm);
+    tm->num_shelves = 0;
+    tm->yMax = 0;
+    tm->last_shelf = -1;
+  }
+  // the new texture is empty, upload everything from the copied buffer
+  for (int i = 0; i < tm->num_shelves; i++) {
+    tm->shelves[i].dirty_x0 = 0;
+    tm->shelves[i].dirty_x1 = tm->shelves[i].x;
+  }
+
   // user new texture
   tm->width = width;
   tm->height = height;
@@ -711,34 +741,137 @@ void YglTMRealloc(YglTextureManager * tm, unsigned int width, unsigned int heigh
 }
 
 //////////////////////////////////////////////////////////////////////////////
+int YglTMShelfAt(YglTextureManager * tm, unsigned int y) {
+  int lo = 0;
+  int hi = tm->num_shelves - 1;
+  while (lo <= hi) {
+    int mid = (lo + hi) >> 1;
+    if (y < tm->shelves[mid].y)
+      hi = mid - 1;
+    else if (y >= tm->shelves[mid].y + tm->shelves[mid].h)
+      lo = mid + 1;
+    else
+      return mid;
+  }
+  return -1;
+}
+
+static YglShelf * YglTMInsertShelf(YglTextureManager * tm, int index) {
+  if (tm->num_shelves == tm->max_shelves) {
+    int count = tm->max_shelves ? tm->max_shelves * 2 : 64;
+    YglShelf * shelves = (YglShelf *)realloc(tm->shelves, count * sizeof(YglShelf));
+    if (shelves == NULL) {
+      YGLDEBUG("not enough shelves\n");
+      abort();
+    }
+    tm->shelves = shelves;
+    tm->max_shelves = count;
+  }
+  memmove(&tm->shelves[index + 1], &tm->shelves[index], (tm->num_shelves - index) * sizeof(YglShelf));
+  tm->num_shelves++;
+  memset(&tm->shelves[index], 0, sizeof(YglShelf));
+  tm->shelves[index].entries = -1;
+  return &tm->shelves[index];
+}
+
+// Least recently used run of shelves the current frame doesn't draw from,
+// at least h rows high. Merged into a single shelf of h rows, their cache
+// entries dropped.
+static int YglTMEvictShelves(YglTextureManager * tm, unsigned int h) {
+  int best = -1, best_end = 0;
+  u32 best_age = 0;
+  int i, j;
+
+  for (i = 0; i < tm->num_shelves; i++) {
+    unsigned int rows = 0;
+    u32 age = 0;
+    for (j = i; j < tm->num_shelves && rows < h; j++) {
+      if (tm->shelves[j].frame == tm->frame)
+        break;
+      // a run is as old as its most recently used shelf
+      if (j == i || tm->frame - tm->shelves[j].frame < age)
+        age = tm->frame - tm->shelves[j].frame;
+      rows += tm->shelves[j].h;
+    }
+    if (rows >= h && (best < 0 || age > best_age)) {
+      best = i;
+      best_end = j;
+      best_age = age;
+    }
+  }
+  if (best < 0)
+    return -1;
+
+  for (j = best; j < best_end; j++)
+    YglCacheDropShelf(tm, j);
+  tm->shelves[best].h = tm->shelves[best_end - 1].y + tm->shelves[best_end - 1].h - tm->shelves[best].y;
+  memmove(&tm->shelves[best + 1], &tm->shelves[best_end], (tm->num_shelves - best_end) * sizeof(YglShelf));
+  tm->num_shelves -= best_end - best - 1;
+
+  if (tm->shelves[best].h > h) {
+    YglShelf * rest = YglTMInsertShelf(tm, best + 1);
+    rest->y = tm->shelves[best].y + h;
+    rest->h = tm->shelves[best].h - h;
+    tm->shelves[best].h = h;
+  }
+  tm->shelves[best].x = 0;
+  tm->shelves[best].dirty_x0 = tm->shelves[best].dirty_x1 = 0;
+  tm->stats.evicted++;
+  return best;
+}
+
+static int YglTMFindShelf(YglTextureManager * tm, unsigned int w, unsigned int h) {
+  YglShelf * shelf;
+  int i;
+
+  if (tm->last_shelf >= 0 && tm->last_shelf < tm->num_shelves &&
+      tm->shelves[tm->last_shelf].h == h && tm->width - tm->shelves[tm->last_shelf].x >= w)
+    return tm->last_shelf;
+
+  for (i = 0; i < tm->num_shelves; i++) {
+    if (tm->shelves[i].h == h && tm->width - tm->shelves[i].x >= w)
+      return i;
+  }
+
+  if (tm->height - tm->yMax >= h) {
+    shelf = YglTMInsertShelf(tm, tm->num_shelves);
+    shelf->y = tm->yMax;
+    shelf->h = h;
+    tm->yMax += h;
+    return tm->num_shelves - 1;
+  }
+
+  return YglTMEvictShelves(tm, h);
+}
+
 void YglTMAllocate(YglTextureManager * tm, YglTexture * output, unsigned int w, unsigned int h, unsigned int * x, unsigned int * y) {
+  unsigned int rows = (h + YGL_SHELF_ALIGN - 1) & ~(YGL_SHELF_ALIGN - 1);
+  YglShelf * shelf;
+  int i;
+
+  if (rows == 0)
+    rows = YGL_SHELF_ALIGN;
   if( tm->width < w ){
     YGLDEBUG("can't allocate texture: %dx%d\n", w, h);
     YglTMRealloc( tm, w, tm->height);
-    YglTMAllocate(tm, output, w, h, x, y);
   }
-  if ((tm->height - tm->currentY) < h) {
+  if ((i = YglTMFindShelf(tm, w, rows)) < 0) {
     YGLDEBUG("can't allocate texture: %dx%d\n", w, h);
-    YglTMRealloc( tm, tm->width, tm->height+(h*2));
-    YglTMAllocate(tm, output, w, h, x, y);
-    return;
-  }
-
-  if ((tm->width - tm->currentX) >= w) {
-    *x = tm->currentX;
-    *y = tm->currentY;
-    output->w = tm->width - w;
-    output->textdata = tm->texture + tm->currentY * tm->width + tm->currentX;
-    tm->currentX += w;
-
-    if ((tm->currentY + h) > tm->yMax){
-      tm->yMax = tm->currentY + h;
-    }
-   } else {
-     tm->currentX = 0;
-     tm->currentY = tm->yMax;
-     YglTMAllocate(tm, output, w, h, x, y);
-   }
+    YglTMRealloc( tm, tm->width, tm->height+(rows*2));
+    i = YglTMFindShelf(tm, w, rows);
+  }
+
+  shelf = &tm->shelves[i];
+  *x = shelf->x;
+  *y = shelf->y;
+  output->w = tm->width - w;
+  output->textdata = tm->texture + shelf->y * tm->width + shelf->x;
+  if (shelf->dirty_x1 == shelf->dirty_x0)
+    shelf->dirty_x0 = shelf->x;
+  shelf->x += w;
+  shelf->dirty_x1 = shelf->x;
+  shelf->frame = tm->frame;
+  tm->last_shelf = i;
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -995,6 +1128,103 @@ void YglDrawCpuFramebufferWrite(int target) {
 
 
 
+// renders copied for the cpu after its last framebuffer read
+#define YGL_READBACK_RENDERS 8
+
+// Copies the framebuffer just rendered to a pixel buffer without waiting
+// for it, while the cpu keeps reading the framebuffer.
+static void YglVdp1ReadbackStart(void) {
+  int i = _Ygl->vdp1_readback_next;
+  int params[4];
+
+  if (!_Ygl->vdp1_async_readback || _Ygl->vdp1_read_recent == 0 || _Ygl->smallfbo == 0) return;
+  _Ygl->vdp1_read_recent--;
+
+  if (_Ygl->vdp1_readback_pbo[0] == 0) {
+    glGenBuffers(2, _Ygl->vdp1_readback_pbo);
+    for (int j = 0; j < 2; j++) {
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, _Ygl->vdp1_readback_pbo[j]);
+      glBufferData(GL_PIXEL_PACK_BUFFER, _Ygl->rwidth * _Ygl->rheight * 4, NULL, GL_STREAM_READ);
+    }
+  }
+  if (_Ygl->vdp1_readback_sync[i] != 0) {
+    glDeleteSync(_Ygl->vdp1_readback_sync[i]);
+    _Ygl->vdp1_readback_sync[i] = 0;
+  }
+
+  glGetIntegerv(GL_VIEWPORT, params);
+  glViewport(0, 0, _Ygl->rwidth, _Ygl->rheight);
+  glScissor(0, 0, _Ygl->rwidth, _Ygl->rheight);
+  glDisable(GL_SCISSOR_TEST);
+  YglBlitFramebuffer(_Ygl->vdp1FrameBuff[_Ygl->drawframe], _Ygl->smallfbo, (float)_Ygl->rwidth / (float)_Ygl->width, (float)_Ygl->rheight / (float)_Ygl->height);
+  glBindFramebuffer(GL_FRAMEBUFFER, _Ygl->smallfbo);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, _Ygl->vdp1_readback_pbo[i]);
+  glReadPixels(0, 0, _Ygl->rwidth, _Ygl->rheight, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  _Ygl->vdp1_readback_sync[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  _Ygl->vdp1_readback_serial[i] = _Ygl->vdp1_render_serial;
+  _Ygl->vdp1_readback_frame[i] = _Ygl->drawframe;
+  _Ygl->vdp1_readback_next = i ^ 1;
+  glBindFramebuffer(GL_FRAMEBUFFER, _Ygl->default_fbo);
+  glViewport(params[0], params[1], params[2], params[3]);
+}
+
+// Maps the copy of the framebuffer the cpu reads, NULL when there is none
+// or the framebuffer changed after it was taken.
+static void * YglVdp1ReadbackMap(void) {
+  void * pixels;
+  GLenum status;
+  int waited = 0;
+  int i;
+
+  if (!_Ygl->vdp1_async_readback) return NULL;
+  for (i = 0; i < 2; i++) {
+    if (_Ygl->vdp1_readback_sync[i] != 0 &&
+        _Ygl->vdp1_readback_serial[i] == _Ygl->vdp1_render_serial &&
+        _Ygl->vdp1_readback_frame[i] == _Ygl->drawframe)
+      break;
+  }
+  if (i == 2) return NULL;
+
+  status = glClientWaitSync(_Ygl->vdp1_readback_sync[i], 0, 0);
+  if (status == GL_TIMEOUT_EXPIRED) {
+    status = glClientWaitSync(_Ygl->vdp1_readback_sync[i], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    waited = 1;
+  }
+  glDeleteSync(_Ygl->vdp1_readback_sync[i]);
+  _Ygl->vdp1_readback_sync[i] = 0;
+  if (status == GL_WAIT_FAILED) return NULL;
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, _Ygl->vdp1_readback_pbo[i]);
+  pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, _Ygl->rwidth * _Ygl->rheight * 4, GL_MAP_READ_BIT);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  if (pixels == NULL) return NULL; // counted as sync by the caller
+
+  _Ygl->pFrameBufferID = _Ygl->vdp1_readback_pbo[i];
+  if (waited)
+    _Ygl->vdp1_readback_stats.waited++;
+  else
+    _Ygl->vdp1_readback_stats.async++;
+  return pixels;
+}
+
+static void YglVdp1ReadbackDeInit(void) {
+  for (int i = 0; i < 2; i++) {
+    if (_Ygl->vdp1_readback_sync[i] != 0) {
+      glDeleteSync(_Ygl->vdp1_readback_sync[i]);
+      _Ygl->vdp1_readback_sync[i] = 0;
+    }
+  }
+  if (_Ygl->vdp1_readback_pbo[0] != 0) {
+    glDeleteBuffers(2, _Ygl->vdp1_readback_pbo);
+    _Ygl->vdp1_readback_pbo[0] = _Ygl->vdp1_readback_pbo[1] = 0;
+  }
+}
+
+void YglGetVdp1ReadbackStats(YglReadbackStats * stats) {
+  *stats = _Ygl->vdp1_readback_stats;
+}
+
 void VIDOGLVdp1ReadFrameBuffer(u32 type, u32 addr, void * out) {
   u32 x = 0;
   u32 y = 0;
@@ -1094,8 +1324,13 @@ void VIDOGLVdp1ReadFrameBuffer(u32 type, u32 addr, void * out) {
   while (_Ygl->vpd1_running){ YabThreadYield(); }
 
   YabThreadLock(_Ygl->mutex);
+  _Ygl->vdp1_read_recent = YGL_READBACK_RENDERS;
+  if (_Ygl->pFrameBuffer == NULL) {
+    _Ygl->pFrameBuffer = YglVdp1ReadbackMap();
+  }
   if (_Ygl->pFrameBuffer == NULL){
     FrameProfileAdd("ReadFrameBuffer start");
+    _Ygl->vdp1_readback_stats.sync++;
     FRAMELOG("READ FRAME");
     if (_Ygl->sync != 0){
       glWaitSync(_Ygl->sync, 0, GL_TIMEOUT_IGNORED);
@@ -1124,6 +1359,7 @@ void VIDOGLVdp1ReadFrameBuffer(u32 type, u32 addr, void * out) {
     glBindBuffer(GL_PIXEL_PACK_BUFFER, _Ygl->vdp1pixelBufferID);
     glReadPixels(0, 0, _Ygl->rwidth, _Ygl->rheight, GL_RGBA, GL_UNSIGNED_BYTE, 0);
     _Ygl->pFrameBuffer = (unsigned int *)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, _Ygl->rwidth * (_Ygl->rheight)* 4, GL_MAP_READ_BIT);
+    _Ygl->pFrameBufferID = _Ygl->vdp1pixelBufferID;
     glBindFramebuffer(GL_FRAMEBUFFER,_Ygl->default_fbo);
     glViewport(params[0], params[1], params[2], params[3]);
 
@@ -1208,7 +1444,15 @@ int YglGenFrameBuffer() {
   if (rebuild_frame_buffer == 0){
     return 0;
   }
+  _Ygl->vdp1_render_serial++;
   glBindFramebuffer(GL_FRAMEBUFFER, _Ygl->default_fbo);
+  // the cpu's view of the old framebuffer goes with it
+  if (_Ygl->pFrameBuffer != NULL) {
+    _Ygl->pFrameBuffer = NULL;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, _Ygl->pFrameBufferID);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  }
   glFinish();
   glGetError();
 
@@ -1244,8 +1488,6 @@ int YglGenFrameBuffer() {
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-  _Ygl->pFrameBuffer = NULL;
-
    if(1) //strstr((const char*)glGetString(GL_EXTENSIONS),"packed_depth_stencil") != NULL )
   {
     if (_Ygl->rboid_depth != 0) glDeleteRenderbuffers(1, &_Ygl->rboid_depth);
@@ -2914,6 +3156,7 @@ void YglEraseWriteVDP1(void) {
   int priority;
   u32 alpha = 0;
   if (_Ygl->vdp1FrameBuff[0] == 0) return;
+  if (_Ygl->readframe == _Ygl->drawframe) _Ygl->vdp1_render_serial++;
 
   glBindFramebuffer(GL_FRAMEBUFFER, _Ygl->vdp1fbo);
   glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _Ygl->vdp1FrameBuff[_Ygl->readframe], 0);
@@ -3039,10 +3282,11 @@ void YglRenderVDP1(void) {
   if (_Ygl->pFrameBuffer != NULL) {
     _Ygl->pFrameBuffer = NULL;
     glBindTexture(GL_TEXTURE_2D, _Ygl->smallfbotex);
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, _Ygl->vdp1pixelBufferID);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, _Ygl->pFrameBufferID);
     glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
     glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
   }
+  _Ygl->vdp1_render_serial++;
   YabThreadUnLock(_Ygl->mutex);
   YGLLOG("YglRenderVDP1 %d, PTMR = %d\n", _Ygl->drawframe, Vdp1Regs->PTMR);
 
@@ -3128,7 +3372,7 @@ void YglRenderVDP1(void) {
   }
 
   _Ygl->sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE,0);
-
+  YglVdp1ReadbackStart();
 
   glBindFramebuffer(GL_FRAMEBUFFER, _Ygl->default_fbo);
   glEnable(GL_DEPTH_TEST);
@@ -3234,11 +3478,11 @@ void YglUpdateVdp2Reg() {
 
     linebuf = YglGetPerlineBuf(&_Ygl->bg[SPRITE], _Ygl->rheight, 1 + 8 + 8);
     for (line = 0; line < _Ygl->rheight; line++) {
-      linebuf[line] = 0xFF000000;
-      Vdp2 * lVdp2Regs = &Vdp2Lines[line >> line_shift];
-
+      Vdp2 * lVdp2Regs = Vdp2RestoreRegs(line >> line_shift, Vdp2Lines);
       u8 *cclist = (u8 *)&lVdp2Regs->CCRSA;
       u8 *prilist = (u8 *)&lVdp2Regs->PRISA;
+
+      linebuf[line] = 0xFF000000;
       for (i = 0; i < 8; i++) {
         linebuf[line + _Ygl->rheight * (1 + i)] = (prilist[i] & 0x7) << 24;
         linebuf[line + _Ygl->rheight * (1 + 8 + i)] = (0xFF - (((cclist[i] & 0x1F) << 3) & 0xF8)) << 24;
@@ -4661,6 +4905,7 @@ void YglChangeResolution(int w, int h) {
          _Ygl->vdp1pixelBufferID = 0;
          _Ygl->pFrameBuffer = NULL;
        }
+       YglVdp1ReadbackDeInit();
 
      if (_Ygl->tmpfbo != 0){
        glDeleteFramebuffers(1, &_Ygl->tmpfbo);